@@ -0,0 +1,229 @@
+# compares the benchmarks against perf_baseline.json and fails on significant slowdowns, with --update-baseline it
+# records a new baseline instead, run it from the root of the repository so the benchmarks find the resources
+#
+# a metric is a set of samples, one per run of LearnOpenGL_bench and LearnOpenGL_microbench: the median and 95th
+# percentile frame time of the flight and the median time of every microbenchmark, it regressed if its median is
+# slower than the baseline by more than its threshold and a one-sided Mann-Whitney U test says the slowdown is
+# significant, the threshold of a metric is the larger of its minimum and a multiple of the spread the baseline itself
+# had, so noisy metrics get more room
+import argparse
+import json
+import math
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+
+DEFAULT_BASELINE = 'perf_baseline.json'
+# what a new baseline runs, a baseline keeps its own settings so later checks run the same
+DEFAULT_SETTINGS = {
+    'runs': 7,
+    'bench_arguments': ['--frames', '300', '--warmup', '30', '--size', '400x400'],
+    'microbench_arguments': ['--repetitions', '7', '--repetition-ms', '10', '--warmup-ms', '50'],
+    # a relative slowdown below this never fails
+    'min_threshold': 0.15,
+    # how many times the relative median absolute deviation of the baseline is added to the room
+    'noise_factor': 3.0,
+    # the significance level of the Mann-Whitney U test
+    'alpha': 0.05,
+    # per metric minimums instead of min_threshold
+    'thresholds': {},
+}
+# the baseline only says something about the machine and build it was recorded with
+CONTEXT_KEYS = ['renderer', 'cpu', 'cpu_count', 'build']
+EXIT_REGRESSION = 1
+EXIT_USAGE = 2
+EXIT_FAILED = 3
+# the baseline was recorded on another renderer, CPU or build, so nothing was checked, CTest reports it as skipped
+EXIT_NOT_COMPARABLE = 4
+
+
+def median(samples):
+    ordered = sorted(samples)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+
+# the median absolute deviation over the median
+def relative_spread(samples):
+    center = median(samples)
+    if center == 0:
+        return 0.0
+    return median([abs(sample - center) for sample in samples]) / center
+
+
+# the p-value of current being larger than baseline, from the normal approximation of U with ties and continuity
+# corrected
+def mann_whitney_greater(baseline, current):
+    n1, n2 = len(current), len(baseline)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    values = sorted([(value, 0) for value in current] + [(value, 1) for value in baseline])
+    ranks = [0.0] * len(values)
+    tie_term = 0.0
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        ties = j - i + 1
+        tie_term += ties ** 3 - ties
+        i = j + 1
+    rank_sum = sum(rank for rank, (_, group) in zip(ranks, values) if group == 0)
+    u = rank_sum - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (u - n1 * n2 / 2 - 0.5) / math.sqrt(variance)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+# the model name of the CPU, platform.processor() is empty on many Linux distributions
+def cpu_model():
+    try:
+        with open('/proc/cpuinfo') as file:
+            for line in file:
+                if line.startswith('model name'):
+                    return line.split(':', 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor() or platform.machine()
+
+
+def run(command):
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    # 1 is a blown frame budget of the bench, which is not what this checks
+    if result.returncode not in (0, 1):
+        raise RuntimeError('{} exited with {}:\n{}'.format(' '.join(command), result.returncode, result.stderr))
+    return result.stdout
+
+
+# every metric of the benchmarks as {name: samples} and what they ran on, a run is a flight and a process of the
+# microbenchmarks, whose repetitions share the state of the machine, so each run gives one sample per metric: the
+# median of the run
+def measure(bench, microbench, settings):
+    metrics = {}
+    context = {'cpu': cpu_model(), 'cpu_count': os.cpu_count()}
+    handle, path = tempfile.mkstemp(suffix='.json')
+    os.close(handle)
+    try:
+        for i in range(settings['runs']):
+            flight = json.loads(run([bench] + settings['bench_arguments']))
+            context['renderer'] = flight['renderer']
+            for percentile in ('p50', 'p95'):
+                metrics.setdefault('flythrough/frame_ms_' + percentile, []).append(flight['frame_ms'][percentile])
+            run([microbench, '--output', path] + settings['microbench_arguments'])
+            with open(path) as file:
+                micro = json.load(file)
+            context['build'] = micro['context']['build']
+            for benchmark in micro['benchmarks']:
+                metrics.setdefault(benchmark['name'], []).append(benchmark['ns_per_op'])
+            print('run {} of {}: flight p50 {:.3f} ms'.format(i + 1, settings['runs'], flight['frame_ms']['p50']),
+                  file=sys.stderr)
+    finally:
+        os.remove(path)
+    return metrics, context
+
+
+def compare(baseline, metrics, settings):
+    rows = []
+    regressed = False
+    for name in sorted(set(baseline) | set(metrics)):
+        if name not in metrics or name not in baseline:
+            rows.append((name, baseline.get(name), metrics.get(name), None, None, None,
+                         'missing' if name in baseline else 'new'))
+            continue
+        before, after = median(baseline[name]), median(metrics[name])
+        change = after / before - 1 if before > 0 else 0.0
+        threshold = max(settings['thresholds'].get(name, settings['min_threshold']),
+                        settings['noise_factor'] * relative_spread(baseline[name]))
+        p_value = mann_whitney_greater(baseline[name], metrics[name])
+        if change > threshold and p_value < settings['alpha']:
+            status = 'SLOWER'
+            regressed = True
+        elif change < -threshold and mann_whitney_greater(metrics[name], baseline[name]) < settings['alpha']:
+            status = 'faster'
+        else:
+            status = 'ok'
+        rows.append((name, baseline[name], metrics[name], change, threshold, p_value, status))
+    return rows, regressed
+
+
+def print_table(rows):
+    width = max([len('metric')] + [len(row[0]) for row in rows])
+    print('{:<{}} {:>12} {:>12} {:>9} {:>9} {:>8}  {}'.format('metric', width, 'baseline', 'current', 'change',
+                                                              'allowed', 'p', 'status'))
+    for name, before, after, change, threshold, p_value, status in rows:
+        print('{:<{}} {:>12} {:>12} {:>9} {:>9} {:>8}  {}'.format(
+            name, width,
+            '{:.3f}'.format(median(before)) if before else '-',
+            '{:.3f}'.format(median(after)) if after else '-',
+            '{:+.1%}'.format(change) if change is not None else '-',
+            '{:.1%}'.format(threshold) if threshold is not None else '-',
+            '{:.4f}'.format(p_value) if p_value is not None else '-',
+            status))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Checks the benchmarks against a baseline.')
+    parser.add_argument('--bench', required=True, help='LearnOpenGL_bench')
+    parser.add_argument('--microbench', required=True, help='LearnOpenGL_microbench')
+    parser.add_argument('--baseline', default=DEFAULT_BASELINE)
+    parser.add_argument('--update-baseline', action='store_true',
+                        help='record the baseline anew, with the settings of the old one if there is one')
+    parser.add_argument('--strict', action='store_true',
+                        help='fail instead of skipping when the baseline was recorded on another renderer, CPU or '
+                             'build')
+    try:
+        arguments = parser.parse_args()
+    except SystemExit as exit:
+        return exit.code and EXIT_USAGE
+
+    baseline = None
+    if os.path.exists(arguments.baseline):
+        with open(arguments.baseline) as file:
+            baseline = json.load(file)
+    elif not arguments.update_baseline:
+        print('there is no baseline at {}, record one with --update-baseline'.format(arguments.baseline),
+              file=sys.stderr)
+        return EXIT_FAILED
+    settings = dict(DEFAULT_SETTINGS)
+    if baseline:
+        settings.update(baseline['settings'])
+
+    try:
+        metrics, context = measure(arguments.bench, arguments.microbench, settings)
+    except (RuntimeError, OSError, ValueError, KeyError) as error:
+        print(error, file=sys.stderr)
+        return EXIT_FAILED
+
+    if arguments.update_baseline:
+        with open(arguments.baseline, 'w') as file:
+            json.dump({'context': context, 'settings': settings, 'metrics': metrics}, file, indent=2,
+                      sort_keys=True)
+            file.write('\n')
+        print('recorded {} metrics on {} to {}'.format(len(metrics), context['renderer'], arguments.baseline))
+        return 0
+
+    rows, regressed = compare(baseline['metrics'], metrics, settings)
+    print_table(rows)
+    mismatched = [key for key in CONTEXT_KEYS if baseline['context'].get(key) != context.get(key)]
+    if mismatched:
+        for key in mismatched:
+            print('the baseline {} is {}, this one is {}'.format(key, baseline['context'].get(key), context.get(key)))
+        if not arguments.strict:
+            print('not comparable, record a baseline on this machine with --update-baseline')
+            return EXIT_NOT_COMPARABLE
+    if regressed:
+        print('slower than the baseline, if that is intended record a new one with --update-baseline')
+        return EXIT_REGRESSION
+    print('no significant slowdowns')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,9 @@
+#version 330 core
+
+out vec4 final_color;
+
+void main()
+{
+    // only the samples passed count matters, color writes are masked off
+    final_color = vec4(1.0, 0.0, 1.0, 1.0);
+}
\ No newline at end of file
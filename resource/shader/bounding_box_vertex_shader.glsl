@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec3 in_pos;
+
+uniform mat4 view_projection_matrix;
+uniform vec3 box_center;
+uniform vec3 box_extent;
+
+void main()
+{
+    // the unit cube spans [-0.5, 0.5], so scale it by the full size of the box
+    gl_Position = view_projection_matrix * vec4(box_center + in_pos * 2.0 * box_extent, 1.0);
+}
\ No newline at end of file
@@ -6,8 +6,16 @@ layout (location = 1) in vec2 in_tex_coords;
 out vec2 tex_coords;
 
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+
+// the layout must match FrameData in Scene.cpp
+layout (std140) uniform FrameData {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+};
+
+// must match depth_vertex_shader.glsl for the GL_EQUAL test after a depth pre-pass
+invariant gl_Position;
 
 void main()
 {
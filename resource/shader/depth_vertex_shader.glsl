@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 in_pos;
+
+uniform mat4 model_matrix;
+
+// the layout must match FrameData in Scene.cpp
+layout (std140) uniform FrameData {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+};
+
+// the color pass tests GL_EQUAL against what this writes, so both must compute the position the same way
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection_matrix * view_matrix * model_matrix * vec4(in_pos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 330 core
+
+// the previous level, it is the only level that can be sampled while the next one is rendered
+uniform sampler2D source;
+
+out float max_depth;
+
+void main()
+{
+    ivec2 last = textureSize(source, 0) - 1;
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+    // the last texel of an odd sized level also covers the leftover row or column so nothing gets lost
+    int size_x = base.x + 2 == last.x ? 3 : 2;
+    int size_y = base.y + 2 == last.y ? 3 : 2;
+    float depth = 0.0;
+    for (int y = 0; y != size_y; ++y) {
+        for (int x = 0; x != size_x; ++x) {
+            depth = max(depth, texelFetch(source, min(base + ivec2(x, y), last), 0).r);
+        }
+    }
+    max_depth = depth;
+}
\ No newline at end of file
@@ -8,7 +8,13 @@ in vec3 position;
 uniform vec3 object_color;
 uniform vec3 light_color;
 uniform vec3 light_position;
-uniform vec3 view_position;
+
+// the layout must match FrameData in Scene.cpp
+layout (std140) uniform FrameData {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+};
 
 void main()
 {
@@ -23,7 +29,7 @@ void main()
 
     // specular lighting
     float specular_strength = 0.5;
-    vec3 view_direction = normalize(view_position - position);
+    vec3 view_direction = normalize(view_position.xyz - position);
     // the first vector should point from the light source toward the fragment's position
     vec3 reflect_direction = reflect(-light_direction, normal);
     float specular_factor = pow(max(dot(view_direction, reflect_direction), 0.0), 32);
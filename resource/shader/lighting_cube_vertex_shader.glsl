@@ -7,10 +7,18 @@ out vec3 normal;
 out vec3 position;
 
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
 uniform mat3 normal_matrix;
 
+// the layout must match FrameData in Scene.cpp
+layout (std140) uniform FrameData {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+};
+
+// must match depth_vertex_shader.glsl for the GL_EQUAL test after a depth pre-pass
+invariant gl_Position;
+
 void main()
 {
     // transform the normal vector to the view space
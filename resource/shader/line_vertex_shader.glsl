@@ -5,8 +5,13 @@ layout (location = 0) in vec3 in_pos;
 out vec4 color;
 
 uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+
+// the layout must match FrameData in Scene.cpp
+layout (std140) uniform FrameData {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 view_position;
+};
 
 void main()
 {
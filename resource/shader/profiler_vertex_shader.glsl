@@ -0,0 +1,15 @@
+#version 330 core
+
+layout (location = 0) in vec2 in_pos;
+layout (location = 1) in vec3 in_color;
+
+out vec3 color;
+
+// in pixels, the positions are in pixels from the top left corner
+uniform vec2 viewport_size;
+
+void main()
+{
+    gl_Position = vec4(in_pos.x / viewport_size.x * 2.0 - 1.0, 1.0 - in_pos.y / viewport_size.y * 2.0, 0.0, 1.0);
+    color = in_color;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 330 core
+
+// the scene at the lower resolution, its texels are fetched directly since render targets are not filtered
+uniform sampler2D source;
+// and its depth, which goes to the output unfiltered so what is drawn on top is still hidden behind the scene
+uniform sampler2D depth_source;
+uniform vec2 output_size;
+// 0 for the least and 1 for the most sharpening
+uniform float sharpness;
+
+out vec4 color;
+
+vec3 fetch(ivec2 texel)
+{
+    return texelFetch(source, clamp(texel, ivec2(0), textureSize(source, 0) - 1), 0).rgb;
+}
+
+void main()
+{
+    // bilinear filtering of the source
+    vec2 position = gl_FragCoord.xy * vec2(textureSize(source, 0)) / output_size - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 weight = position - vec2(base);
+    vec3 bilinear = mix(mix(fetch(base), fetch(base + ivec2(1, 0)), weight.x),
+                        mix(fetch(base + ivec2(0, 1)), fetch(base + ivec2(1, 1)), weight.x), weight.y);
+
+    // contrast adaptive sharpening around the nearest texel: the cross of neighbours is subtracted from the filtered
+    // color, less where the local contrast is already high so edges do not ring
+    ivec2 center = ivec2(floor(position + 0.5));
+    vec3 north = fetch(center + ivec2(0, 1));
+    vec3 south = fetch(center - ivec2(0, 1));
+    vec3 east = fetch(center + ivec2(1, 0));
+    vec3 west = fetch(center - ivec2(1, 0));
+    vec3 minimum = min(fetch(center), min(min(north, south), min(east, west)));
+    vec3 maximum = max(fetch(center), max(max(north, south), max(east, west)));
+    vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, vec3(1e-4)), 0.0, 1.0));
+    vec3 neighbour_weight = -amount / mix(8.0, 5.0, sharpness);
+    color = vec4(clamp((bilinear + neighbour_weight * (north + south + east + west)) / (1.0 + 4.0 * neighbour_weight),
+                       0.0, 1.0), 1.0);
+    gl_FragDepth = texelFetch(depth_source, clamp(center, ivec2(0), textureSize(depth_source, 0) - 1), 0).r;
+}
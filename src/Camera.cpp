@@ -9,12 +9,16 @@ Camera::Camera(vec3 position_v, vec3 direction_v, vec3 up_v, float yaw_f, float
     this->update();
 }
 
-void Camera::update() {
+vec3 Camera::get_direction(float yaw, float pitch) {
     glm::vec3 new_direction;
-    new_direction.x = cosf(glm::radians(this->yaw)) * cosf(glm::radians(this->pitch));
-    new_direction.y = sinf(glm::radians(this->pitch));
-    new_direction.z = sinf(glm::radians(this->yaw)) * cosf(glm::radians(this->pitch));
-    this->direction = glm::normalize(new_direction);
+    new_direction.x = cosf(glm::radians(yaw)) * cosf(glm::radians(pitch));
+    new_direction.y = sinf(glm::radians(pitch));
+    new_direction.z = sinf(glm::radians(yaw)) * cosf(glm::radians(pitch));
+    return glm::normalize(new_direction);
+}
+
+void Camera::update() {
+    this->direction = get_direction(this->yaw, this->pitch);
     this->right = glm::normalize(glm::cross(this->direction, this->world_up));
     this->up = glm::normalize(glm::cross(this->right, this->direction));
 }
@@ -50,14 +54,23 @@ void Camera::process_keyboard_input(CameraMovement movement, float delta_time) {
 }
 
 void Camera::process_mouse_input(float delta_x, float delta_y) {
-    this->yaw += delta_x * MOUSE_SENSITIVITY;
-    this->pitch += delta_y * MOUSE_SENSITIVITY;
+    turn(this->yaw, this->pitch, delta_x, delta_y);
+    this->update();
+}
+
+void Camera::turn(float &yaw, float &pitch, float delta_x, float delta_y) {
+    yaw += delta_x * MOUSE_SENSITIVITY;
+    pitch += delta_y * MOUSE_SENSITIVITY;
 
-    if (this->pitch > 89.0F) {
-        this->pitch = 89.0F;
-    } else if (this->pitch < -89.0F) {
-        this->pitch = -89.0F;
+    if (pitch > 89.0F) {
+        pitch = 89.0F;
+    } else if (pitch < -89.0F) {
+        pitch = -89.0F;
     }
+}
 
-    this->update();
+mat4 Camera::get_view_matrix(const vec3 &position, float yaw, float pitch, const vec3 &world_up) {
+    vec3 direction = get_direction(yaw, pitch);
+    vec3 right = glm::normalize(glm::cross(direction, world_up));
+    return glm::lookAt(position, position + direction, glm::normalize(glm::cross(right, direction)));
 }
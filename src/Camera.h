@@ -42,8 +42,14 @@ public:
     void process_keyboard_input(CameraMovement movement, float delta_time);
     void process_mouse_input(float delta_x, float delta_y);
 
+    // what process_mouse_input() does to yaw and pitch
+    static void turn(float &yaw, float &pitch, float delta_x, float delta_y);
+    // the view matrix of a camera at position with yaw and pitch, the same get_view_matrix() computes
+    static mat4 get_view_matrix(const vec3 &position, float yaw, float pitch, const vec3 &world_up);
+
 private:
     void update();
+    static vec3 get_direction(float yaw, float pitch);
 };
 
 
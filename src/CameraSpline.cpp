@@ -0,0 +1,78 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "CameraSpline.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+
+static vec3 catmull_rom(const vec3 &p0, const vec3 &p1, const vec3 &p2, const vec3 &p3, float t) {
+    float t2 = t * t, t3 = t2 * t;
+    return 0.5F * (2.0F * p1 + (p2 - p0) * t + (2.0F * p0 - 5.0F * p1 + 4.0F * p2 - p3) * t2 +
+                   (3.0F * p1 - p0 - 3.0F * p2 + p3) * t3);
+}
+
+CameraSpline::CameraSpline(const std::vector<Key> &keys_i) : keys(keys_i) {
+    if (this->keys.size() < 2) {
+        throw std::runtime_error("A camera spline needs at least two keys!");
+    }
+}
+
+CameraSpline CameraSpline::get_default() {
+    // the cubes go up the diagonal from the origin, the light source is at (2, 3, -10)
+    return CameraSpline({
+            {vec3(12.0F, 2.0F, 0.0F), vec3(2.0F, 2.0F, 2.0F)},
+            {vec3(8.0F, 5.0F, 10.0F), vec3(2.0F, 2.0F, 2.0F)},
+            {vec3(-4.0F, 3.0F, 9.0F), vec3(2.0F, 1.0F, 0.0F)},
+            {vec3(-9.0F, 1.0F, -2.0F), vec3(2.0F, 3.0F, -10.0F)},
+            {vec3(-2.0F, 6.0F, -16.0F), vec3(2.0F, 2.0F, 2.0F)},
+            {vec3(6.0F, 2.5F, -4.0F), vec3(0.0F, 0.0F, 0.0F)},
+            {vec3(14.0F, 8.0F, -6.0F), vec3(2.0F, 2.0F, 2.0F)}
+    });
+}
+
+CameraSpline CameraSpline::load(const string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    std::vector<Key> keys;
+    string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream numbers(line);
+        Key key;
+        if (!(numbers >> key.position.x >> key.position.y >> key.position.z
+                      >> key.target.x >> key.target.y >> key.target.z)) {
+            throw std::runtime_error("Malformed camera key \"" + line + "\" in " + path + "!");
+        }
+        keys.push_back(key);
+    }
+    return CameraSpline(keys);
+}
+
+void CameraSpline::sample(double t, vec3 &position, vec3 &target) const {
+    auto count = static_cast<double>(this->keys.size());
+    double along = (t - std::floor(t)) * count;
+    auto segment = static_cast<size_t>(along);
+    auto local = static_cast<float>(along - static_cast<double>(segment));
+    size_t n = this->keys.size();
+    const Key &k0 = this->keys[(segment + n - 1) % n];
+    const Key &k1 = this->keys[segment % n];
+    const Key &k2 = this->keys[(segment + 1) % n];
+    const Key &k3 = this->keys[(segment + 2) % n];
+    position = catmull_rom(k0.position, k1.position, k2.position, k3.position, local);
+    target = catmull_rom(k0.target, k1.target, k2.target, k3.target, local);
+}
+
+mat4 CameraSpline::get_view_matrix(double t) const {
+    vec3 position, target;
+    this->sample(t, position, target);
+    return glm::lookAt(position, target, vec3(0.0F, 1.0F, 0.0F));
+}
@@ -0,0 +1,44 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_CAMERASPLINE_H
+#define LEARNOPENGL_CAMERASPLINE_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+using std::string;
+using glm::vec3;
+using glm::mat4;
+
+// a closed camera flight through key points, the position and the point looked at are both Catmull-Rom splines
+// through the keys, which are passed at equal steps of the parameter
+class CameraSpline {
+
+public:
+    struct Key {
+        vec3 position;
+        vec3 target;
+    };
+
+    // at least two keys
+    explicit
+    CameraSpline(const std::vector<Key> &keys);
+
+    // a loop around and through the default scene
+    static CameraSpline get_default();
+    // a key per line of six numbers, the position and the target, empty lines and lines starting with # are skipped
+    static CameraSpline load(const string &path);
+
+    // t in [0, 1) is one loop, it wraps around outside of it
+    void sample(double t, vec3 &position, vec3 &target) const;
+    mat4 get_view_matrix(double t) const;
+
+private:
+    std::vector<Key> keys;
+};
+
+
+#endif //LEARNOPENGL_CAMERASPLINE_H
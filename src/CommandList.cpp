@@ -0,0 +1,115 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "CommandList.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include "MemoryTracker.h"
+
+void CommandArena::BlockDeleter::operator()(unsigned char *memory) const {
+    MemoryTracker::deallocate(memory);
+}
+
+CommandArena::CommandArena(size_t block_size) : block_size(block_size) {
+}
+
+void *CommandArena::allocate(size_t size, size_t alignment) {
+    while (true) {
+        if (this->current_block < this->blocks.size()) {
+            Block &block = this->blocks[this->current_block];
+            auto base = reinterpret_cast<uintptr_t>(block.memory.get());
+            size_t start = ((base + this->offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (start + size <= block.size) {
+                this->used += start + size - this->offset;
+                this->offset = start + size;
+                return block.memory.get() + start;
+            }
+            // the rest of this block is wasted until the next reset
+            ++this->current_block;
+            this->offset = 0;
+            continue;
+        }
+        Block block;
+        block.size = std::max(this->block_size, size + alignment);
+        block.memory.reset(static_cast<unsigned char *>(MemoryTracker::allocate(MEMORY_CPU_COMMANDS, block.size)));
+        this->blocks.push_back(std::move(block));
+    }
+}
+
+void CommandArena::reset() {
+    this->current_block = 0;
+    this->offset = 0;
+    this->used = 0;
+}
+
+size_t CommandArena::get_used() const {
+    return this->used;
+}
+
+size_t CommandArena::get_capacity() const {
+    size_t capacity = 0;
+    for (const auto &block : this->blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+CommandList::CommandList(size_t block_size) : arena(block_size) {
+}
+
+UniformValue *CommandList::record(const DrawItem &item, unsigned uniform_count) {
+    auto *packet = new(this->arena.allocate(sizeof(DrawPacket), alignof(DrawPacket))) DrawPacket();
+    packet->item = item;
+    packet->uniform_count = uniform_count;
+    packet->uniforms = nullptr;
+    packet->next = nullptr;
+    if (uniform_count) {
+        auto *uniforms = static_cast<UniformValue *>(
+                this->arena.allocate(sizeof(UniformValue) * uniform_count, alignof(UniformValue)));
+        for (unsigned i = 0; i != uniform_count; ++i) {
+            new(uniforms + i) UniformValue();
+        }
+        packet->uniforms = uniforms;
+    }
+    if (this->last) {
+        this->last->next = packet;
+    } else {
+        this->first = packet;
+    }
+    this->last = packet;
+    ++this->count;
+    return packet->uniforms;
+}
+
+void CommandList::record(const DrawItem &item, const UniformValue *uniforms, unsigned uniform_count) {
+    UniformValue *destination = this->record(item, uniform_count);
+    std::copy(uniforms, uniforms + uniform_count, destination);
+}
+
+void CommandList::reset() {
+    // packets and uniforms are trivially destructible, so dropping the memory is enough
+    this->arena.reset();
+    this->first = nullptr;
+    this->last = nullptr;
+    this->count = 0;
+}
+
+const DrawPacket *CommandList::get_first() const {
+    return this->first;
+}
+
+const DrawPacket *CommandList::get_last() const {
+    return this->last;
+}
+
+unsigned CommandList::get_count() const {
+    return this->count;
+}
+
+size_t CommandList::get_memory_used() const {
+    return this->arena.get_used();
+}
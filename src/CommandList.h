@@ -0,0 +1,121 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_COMMANDLIST_H
+#define LEARNOPENGL_COMMANDLIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+enum RenderPass {
+    // depth only, with color writes masked off, before the world
+    PASS_DEPTH = 0,
+    PASS_WORLD = 1,
+    // drawn after everything in the world, e.g. the crosshair
+    PASS_OVERLAY = 2
+};
+
+struct DrawItem {
+    RenderPass pass = PASS_WORLD;
+    bool translucent = false;
+    // distance to the camera, opaque items are drawn front to back and translucent ones back to front
+    float depth = 0;
+    const Shader *shader = nullptr;
+    unsigned vao = 0;
+    // bound to texture units 0 and 1, 0 means the unit is left alone
+    unsigned textures[2] = {0, 0};
+    GLenum mode = GL_TRIANGLES;
+    int first = 0;
+    int count = 0;
+    // draw inside glBeginConditionalRender with GL_QUERY_NO_WAIT if not 0
+    unsigned condition_query = 0;
+    // the views that draw it, bit i for view i, see RenderQueue::execute_view()
+    uint32_t view_mask = 1;
+    // an item of PASS_DEPTH already put its depth into the depth buffer, so it is drawn with GL_EQUAL and without
+    // depth writes, every fragment that is shaded is then one that ends up on screen
+    bool depth_prepassed = false;
+};
+
+// a linear allocator that hands out memory from a few large blocks and frees all of it at once, the blocks are kept
+// across reset() so a steady frame does not allocate at all
+class CommandArena {
+
+public:
+    explicit
+    CommandArena(size_t block_size = 64 * 1024);
+
+    CommandArena(const CommandArena &) = delete;
+    CommandArena &operator=(const CommandArena &) = delete;
+    CommandArena(CommandArena &&) = default;
+    CommandArena &operator=(CommandArena &&) = default;
+
+    void *allocate(size_t size, size_t alignment);
+    void reset();
+    size_t get_used() const;
+    size_t get_capacity() const;
+
+private:
+    // the blocks come from the memory tracker
+    struct BlockDeleter {
+        void operator()(unsigned char *memory) const;
+    };
+
+    struct Block {
+        std::unique_ptr<unsigned char, BlockDeleter> memory;
+        size_t size;
+    };
+
+    size_t block_size;
+    std::vector<Block> blocks;
+    size_t current_block = 0;
+    size_t offset = 0;
+    size_t used = 0;
+};
+
+// a recorded draw and its uniforms, both live in the arena of the list that recorded them
+struct DrawPacket {
+    DrawItem item;
+    UniformValue *uniforms;
+    unsigned uniform_count;
+    const DrawPacket *next;
+};
+
+// draws recorded without touching the device, so any thread can fill one, each thread owns its own list and the render
+// thread hands the finished lists to RenderQueue::submit()
+class CommandList {
+
+public:
+    explicit
+    CommandList(size_t block_size = 64 * 1024);
+
+    CommandList(const CommandList &) = delete;
+    CommandList &operator=(const CommandList &) = delete;
+    CommandList(CommandList &&) = default;
+    CommandList &operator=(CommandList &&) = default;
+
+    // returns room for uniform_count uniforms that belong to the draw, to be filled in by the caller
+    UniformValue *record(const DrawItem &item, unsigned uniform_count);
+    void record(const DrawItem &item, const UniformValue *uniforms, unsigned uniform_count);
+    // forgets every packet, the memory is reused by the next recording
+    void reset();
+
+    const DrawPacket *get_first() const;
+    const DrawPacket *get_last() const;
+    unsigned get_count() const;
+    size_t get_memory_used() const;
+
+private:
+    CommandArena arena;
+    DrawPacket *first = nullptr;
+    DrawPacket *last = nullptr;
+    unsigned count = 0;
+};
+
+
+#endif //LEARNOPENGL_COMMANDLIST_H
@@ -0,0 +1,200 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(CPU_PROFILER_RDTSC) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+#include "Json.h"
+
+// zones a thread keeps, a power of two, older ones are overwritten
+#define CPU_PROFILER_RING_SIZE (1U << 16)
+// how long the ticks are compared with the steady clock
+#define CPU_PROFILER_CALIBRATION_SECONDS 0.02
+
+struct Event {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// written by its thread only, the exporter reads the count first and checks it again after copying the events, so
+// it never needs a lock, events overwritten meanwhile are left out
+struct ThreadRing {
+    unsigned id;
+    string name;
+    std::vector<Event> events;
+    std::atomic<uint64_t> written{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    // never shrinks, the rings of threads that are gone are still exported
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    // a tick and the steady clock at the same time, and the ticks per microsecond
+    uint64_t base_tick = 0;
+    double ticks_per_microsecond = 0;
+};
+
+static Registry &get_registry() {
+    static Registry registry;
+    return registry;
+}
+
+static thread_local ThreadRing *thread_ring = nullptr;
+// set before the thread has a ring, which only the first zone it records creates
+static thread_local string thread_name;
+
+static ThreadRing &get_thread_ring() {
+    if (!thread_ring) {
+        Registry &registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.emplace_back(new ThreadRing());
+        thread_ring = registry.rings.back().get();
+        thread_ring->id = static_cast<unsigned>(registry.rings.size());
+        thread_ring->name = thread_name.empty() ? "thread " + std::to_string(thread_ring->id) : thread_name;
+        thread_ring->events.resize(CPU_PROFILER_RING_SIZE);
+    }
+    return *thread_ring;
+}
+
+std::atomic<bool> CpuProfiler::enabled{false};
+std::atomic<bool> CpuProfiler::use_tsc{false};
+
+// whether the TSC ticks at a constant rate through frequency and power state changes, CPUID leaf 0x80000007 EDX bit 8
+static bool has_invariant_tsc() {
+#if defined(CPU_PROFILER_RDTSC) && defined(_MSC_VER)
+    int registers[4];
+    __cpuid(registers, 0x80000000);
+    if (static_cast<unsigned>(registers[0]) < 0x80000007U) {
+        return false;
+    }
+    __cpuid(registers, 0x80000007);
+    return (registers[3] & (1 << 8)) != 0;
+#elif defined(CPU_PROFILER_RDTSC)
+    unsigned eax, ebx, ecx, edx;
+    // fails if the leaf is beyond the highest extended one
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+void CpuProfiler::enable() {
+    Registry &registry = get_registry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.ticks_per_microsecond == 0) {
+            use_tsc.store(has_invariant_tsc(), std::memory_order_relaxed);
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t start = now();
+            auto end_time = start_time;
+            while (std::chrono::duration<double>(end_time - start_time).count() < CPU_PROFILER_CALIBRATION_SECONDS) {
+                end_time = std::chrono::steady_clock::now();
+            }
+            uint64_t end = now();
+            registry.base_tick = start;
+            registry.ticks_per_microsecond = static_cast<double>(end - start) /
+                                             std::chrono::duration<double, std::micro>(end_time - start_time).count();
+        }
+    }
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::disable() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void CpuProfiler::set_thread_name(const string &name) {
+    thread_name = name;
+    if (thread_ring) {
+        std::lock_guard<std::mutex> lock(get_registry().mutex);
+        thread_ring->name = name;
+    }
+}
+
+uint64_t CpuProfiler::steady_ticks() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CpuProfiler::record(const char *name, uint64_t start, uint64_t end) {
+    ThreadRing &ring = get_thread_ring();
+    uint64_t written = ring.written.load(std::memory_order_relaxed);
+    ring.events[written & (CPU_PROFILER_RING_SIZE - 1)] = {name, start, end};
+    ring.written.store(written + 1, std::memory_order_release);
+}
+
+void CpuProfiler::write_chrome_trace(const string &path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    Registry &registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    // microseconds with nanoseconds, never in scientific notation
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<Event> events;
+    for (const auto &ring : registry.rings) {
+        file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->id
+             << ",\"args\":{\"name\":";
+        file << json_string(ring->name);
+        file << "}}";
+        first = false;
+
+        uint64_t end = ring->written.load(std::memory_order_acquire);
+        uint64_t begin = end > CPU_PROFILER_RING_SIZE ? end - CPU_PROFILER_RING_SIZE : 0;
+        events.clear();
+        for (uint64_t i = begin; i != end; ++i) {
+            events.push_back(ring->events[i & (CPU_PROFILER_RING_SIZE - 1)]);
+        }
+        // whatever the thread wrote while copying may have overwritten the oldest ones, and with a full ring it may be
+        // halfway through overwriting the oldest one
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t overwritten = written - begin >= CPU_PROFILER_RING_SIZE ?
+                               written - begin - CPU_PROFILER_RING_SIZE + 1 : 0;
+        auto skipped = static_cast<size_t>(std::min(overwritten, end - begin));
+        for (size_t i = skipped; i < events.size(); ++i) {
+            const Event &event = events[i];
+            double start_us = static_cast<double>(static_cast<int64_t>(event.start - registry.base_tick)) /
+                              registry.ticks_per_microsecond;
+            double duration_us = static_cast<double>(event.end - event.start) / registry.ticks_per_microsecond;
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id << ",\"ts\":" << start_us << ",\"dur\":"
+                 << duration_us << ",\"name\":";
+            file << json_string(event.name);
+            file << "}";
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path + "!");
+    }
+}
+
+CpuProfiler::Stats CpuProfiler::get_stats() {
+    Stats stats;
+    Registry &registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto &ring : registry.rings) {
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        ++stats.threads;
+        stats.zones += written;
+        stats.overwritten_zones += written > CPU_PROFILER_RING_SIZE ? written - CPU_PROFILER_RING_SIZE : 0;
+    }
+    return stats;
+}
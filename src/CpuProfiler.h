@@ -0,0 +1,102 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_CPUPROFILER_H
+#define LEARNOPENGL_CPUPROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPU_PROFILER_RDTSC
+#endif
+
+using std::string;
+
+// scoped zones of CPU time on any thread, exported as a Chrome trace (chrome://tracing, ui.perfetto.dev): a zone is
+// named by a string literal, so recording one copies a pointer and two timestamps into a ring buffer of the calling
+// thread that only that thread writes, the timestamps are raw TSC ticks if CPUID says the TSC is invariant and steady
+// clock nanoseconds otherwise, which is decided and calibrated against the steady clock once when the profiler is first
+// enabled, while it is disabled a zone costs a relaxed atomic load
+class CpuProfiler {
+
+public:
+    struct Stats {
+        unsigned threads = 0;
+        unsigned long long zones = 0;
+        // zones overwritten in the rings before they were exported
+        unsigned long long overwritten_zones = 0;
+    };
+
+    // times the enclosing scope, use CPU_PROFILE_ZONE
+    class Zone {
+
+    public:
+        // only string literals, the name is kept as a pointer
+        template<size_t N>
+        explicit
+        Zone(const char (&name_i)[N]) : name(CpuProfiler::is_enabled() ? name_i : nullptr),
+                                        start(name ? CpuProfiler::now() : 0) {}
+
+        ~Zone() {
+            if (this->name) {
+                CpuProfiler::record(this->name, this->start, CpuProfiler::now());
+            }
+        }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *name;
+        uint64_t start;
+    };
+
+    CpuProfiler() = delete;
+
+    // the first call calibrates the timestamps, which takes a few milliseconds
+    static void enable();
+    static void disable();
+    static bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    // the name of the calling thread in the trace, threads without one are named by their number
+    static void set_thread_name(const string &name);
+
+    // the zones that are still in the rings, of every thread that recorded one so far, throws if it cannot write
+    static void write_chrome_trace(const string &path);
+    static Stats get_stats();
+
+    // a timestamp in ticks
+    static uint64_t now() {
+#ifdef CPU_PROFILER_RDTSC
+        if (use_tsc.load(std::memory_order_relaxed)) {
+            return __rdtsc();
+        }
+#endif
+        return steady_ticks();
+    }
+    static void record(const char *name, uint64_t start, uint64_t end);
+
+private:
+    static std::atomic<bool> enabled;
+    // set before the first enable, never changes afterwards
+    static std::atomic<bool> use_tsc;
+
+    static uint64_t steady_ticks();
+};
+
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing scope as a zone named by the string literal name
+#define CPU_PROFILE_ZONE(name) CpuProfiler::Zone CPU_PROFILE_CONCAT(cpu_profile_zone_, __LINE__)(name)
+
+
+#endif //LEARNOPENGL_CPUPROFILER_H
@@ -0,0 +1,93 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "DepthPrepassController.h"
+
+// every this many frames the automatic mode tries the way it does not prefer for one frame
+#define PREPASS_PROBE_INTERVAL 30
+// the other way has to be this much cheaper before the automatic mode switches to it
+#define PREPASS_SWITCH_MARGIN 0.9
+// weight of a new sample in the smoothed timings
+#define PREPASS_SMOOTHING 0.2
+
+DepthPrepassController::DepthPrepassController(bool timed) {
+    if (timed) {
+        this->timer.reset(new GpuTimer());
+    }
+}
+
+void DepthPrepassController::set_mode(Mode new_mode) {
+    this->mode = new_mode;
+}
+
+DepthPrepassController::Mode DepthPrepassController::get_mode() const {
+    return this->mode;
+}
+
+bool DepthPrepassController::decide() {
+    bool prepass = this->mode == MODE_ON;
+    if (this->mode == MODE_AUTO && this->timer) {
+        // measure both ways first, then mostly the preferred one
+        if (this->stats.prepass_ms < 0 || this->stats.direct_ms < 0) {
+            prepass = this->stats.prepass_ms < 0;
+        } else if (++this->frames_since_probe >= PREPASS_PROBE_INTERVAL) {
+            this->frames_since_probe = 0;
+            prepass = !this->preferred;
+        } else {
+            prepass = this->preferred;
+        }
+    }
+    ++this->stats.frames;
+    this->stats.prepass_frames += prepass;
+    return prepass;
+}
+
+void DepthPrepassController::begin_timing(bool used) {
+    if (this->timer) {
+        this->timer->begin(used);
+    }
+}
+
+void DepthPrepassController::end_timing() {
+    if (this->timer) {
+        this->timer->end();
+    }
+}
+
+void DepthPrepassController::poll() {
+    if (this->timer) {
+        this->timer->poll([this](unsigned prepass, double milliseconds) {
+            this->add_sample(prepass != 0, milliseconds);
+        });
+    }
+}
+
+void DepthPrepassController::add_sample(bool prepass, double milliseconds) {
+    double &smoothed = prepass ? this->stats.prepass_ms : this->stats.direct_ms;
+    smoothed = smoothed < 0 ? milliseconds : smoothed + (milliseconds - smoothed) * PREPASS_SMOOTHING;
+    if (this->stats.prepass_ms < 0 || this->stats.direct_ms < 0) {
+        return;
+    }
+    double preferred_ms = this->preferred ? this->stats.prepass_ms : this->stats.direct_ms;
+    double other_ms = this->preferred ? this->stats.direct_ms : this->stats.prepass_ms;
+    if (other_ms < preferred_ms * PREPASS_SWITCH_MARGIN) {
+        this->preferred = !this->preferred;
+        ++this->stats.switches;
+    }
+}
+
+const DepthPrepassController::Stats &DepthPrepassController::get_stats() const {
+    return this->stats;
+}
+
+const char *DepthPrepassController::get_mode_name(Mode mode) {
+    switch (mode) {
+        case MODE_OFF:
+            return "off";
+        case MODE_ON:
+            return "on";
+        default:
+            return "auto";
+    }
+}
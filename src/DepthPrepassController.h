@@ -0,0 +1,66 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_DEPTHPREPASSCONTROLLER_H
+#define LEARNOPENGL_DEPTHPREPASSCONTROLLER_H
+
+#include <memory>
+
+#include "GpuTimer.h"
+
+// decides frame by frame whether the opaque objects get a depth pre-pass: the pre-pass costs a second geometry pass
+// and saves the shading of every fragment that is overwritten later, so which way wins depends on the overdraw of the
+// view, in the automatic mode both ways are timed on the GPU with timestamp queries, the cheaper one is used and the
+// other one is tried again every so often to follow the view
+class DepthPrepassController {
+
+public:
+    enum Mode {
+        MODE_OFF, MODE_ON, MODE_AUTO
+    };
+
+    struct Stats {
+        unsigned long long frames = 0;
+        unsigned long long prepass_frames = 0;
+        // smoothed GPU milliseconds of the opaque pass with and without the pre-pass, negative until measured
+        double prepass_ms = -1;
+        double direct_ms = -1;
+        unsigned long long switches = 0;
+    };
+
+    // the timing needs GL, without it the automatic mode never uses the pre-pass
+    explicit
+    DepthPrepassController(bool timed);
+
+    DepthPrepassController(const DepthPrepassController &) = delete;
+    DepthPrepassController &operator=(const DepthPrepassController &) = delete;
+
+    void set_mode(Mode mode);
+    Mode get_mode() const;
+    // whether the next frame uses the pre-pass, call it once per frame when the frame is queued
+    bool decide();
+
+    // around the opaque pass of a frame, used is what decide() returned for it, they do nothing without timing
+    void begin_timing(bool used);
+    void end_timing();
+    // picks up the finished timings, never waits
+    void poll();
+
+    const Stats &get_stats() const;
+
+    static const char *get_mode_name(Mode mode);
+
+private:
+    Mode mode = MODE_AUTO;
+    std::unique_ptr<GpuTimer> timer;
+    // what the automatic mode prefers and how long ago it last tried the other way
+    bool preferred = false;
+    unsigned frames_since_probe = 0;
+    Stats stats;
+
+    void add_sample(bool prepass, double milliseconds);
+};
+
+
+#endif //LEARNOPENGL_DEPTHPREPASSCONTROLLER_H
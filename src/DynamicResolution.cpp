@@ -0,0 +1,179 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "RenderDevice.h"
+
+// the scale moves in steps of 1 / DYNAMIC_RESOLUTION_STEPS so the frame graph sees a few sizes only and its render
+// targets get reused, it never goes below DYNAMIC_RESOLUTION_MIN_STEPS of them
+#define DYNAMIC_RESOLUTION_STEPS 20
+#define DYNAMIC_RESOLUTION_MIN_STEPS 10
+// the controller aims this far below the target to leave room for spikes
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85
+// measurements after a change of scale that are ignored, they may still be of frames at the old scale
+#define DYNAMIC_RESOLUTION_SETTLE_FRAMES 8
+// weight of a new measurement in the smoothed times
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.2
+#define DYNAMIC_RESOLUTION_SHARPNESS 0.5F
+// texture units nobody else uses, the bindings of the scene survive the upscale
+#define DYNAMIC_RESOLUTION_COLOR_UNIT 5
+#define DYNAMIC_RESOLUTION_DEPTH_UNIT 6
+
+DynamicResolution::DynamicResolution(double target_ms_i) :
+        upscale_shader("resource/shader/fullscreen_vertex_shader.glsl",
+                       "resource/shader/upscale_fragment_shader.glsl"),
+        output_size_location(upscale_shader.get_uniform_location("output_size")),
+        target_ms(target_ms_i),
+        scale_steps(DYNAMIC_RESOLUTION_STEPS) {
+    glGenVertexArrays(1, &this->empty_vao);
+    glGenFramebuffers(1, &this->framebuffer);
+    RenderDevice::get_current().add_objects(0, 1, 1);
+    this->upscale_shader.use();
+    this->upscale_shader.set_uniform("source", DYNAMIC_RESOLUTION_COLOR_UNIT);
+    this->upscale_shader.set_uniform("depth_source", DYNAMIC_RESOLUTION_DEPTH_UNIT);
+    this->upscale_shader.set_uniform("sharpness", DYNAMIC_RESOLUTION_SHARPNESS);
+    glUseProgram(0);
+}
+
+DynamicResolution::~DynamicResolution() {
+    glDeleteFramebuffers(1, &this->framebuffer);
+    glDeleteVertexArrays(1, &this->empty_vao);
+    RenderDevice::get_current().add_objects(0, -1, -1);
+}
+
+void DynamicResolution::set_enabled(bool enabled_i) {
+    if (enabled_i == this->enabled) {
+        return;
+    }
+    this->enabled = enabled_i;
+    if (!this->enabled) {
+        this->set_scale_steps(DYNAMIC_RESOLUTION_STEPS);
+    }
+}
+
+void DynamicResolution::set_target_ms(double target_ms_i) {
+    this->target_ms = target_ms_i;
+}
+
+double DynamicResolution::get_target_ms() const {
+    return this->target_ms;
+}
+
+void DynamicResolution::get_render_size(int width, int height, int &render_width, int &render_height) const {
+    render_width = std::max(1, width * this->scale_steps / DYNAMIC_RESOLUTION_STEPS);
+    render_height = std::max(1, height * this->scale_steps / DYNAMIC_RESOLUTION_STEPS);
+}
+
+bool DynamicResolution::is_scaled() const {
+    return this->scale_steps != DYNAMIC_RESOLUTION_STEPS;
+}
+
+void DynamicResolution::begin_frame() {
+    this->timer.begin(0);
+}
+
+void DynamicResolution::end_frame() {
+    this->timer.end();
+    this->stats.dropped_timings = this->timer.get_dropped();
+}
+
+void DynamicResolution::poll() {
+    this->timer.poll([this](unsigned, double milliseconds) {
+        this->add_sample(milliseconds);
+    });
+}
+
+void DynamicResolution::set_scale_steps(int steps) {
+    if (steps == this->scale_steps) {
+        return;
+    }
+    this->scale_steps = steps;
+    this->stats.scale = static_cast<float>(steps) / DYNAMIC_RESOLUTION_STEPS;
+    ++this->stats.scale_changes;
+    this->settled_frames = 0;
+    this->control_ms = -1;
+}
+
+void DynamicResolution::add_sample(double milliseconds) {
+    this->stats.last_gpu_ms = milliseconds;
+    this->stats.gpu_ms = this->stats.gpu_ms < 0 ? milliseconds :
+                         this->stats.gpu_ms + (milliseconds - this->stats.gpu_ms) * DYNAMIC_RESOLUTION_SMOOTHING;
+    ++this->stats.frames;
+    this->stats.missed_frames += milliseconds > this->target_ms;
+    if (!this->enabled || ++this->settled_frames <= DYNAMIC_RESOLUTION_SETTLE_FRAMES) {
+        return;
+    }
+    this->control_ms = this->control_ms < 0 ? milliseconds :
+                       this->control_ms + (milliseconds - this->control_ms) * DYNAMIC_RESOLUTION_SMOOTHING;
+    // the time of a frame grows with its pixels, i.e. with the square of the scale
+    double ideal_steps = this->scale_steps * std::sqrt(this->target_ms * DYNAMIC_RESOLUTION_HEADROOM /
+                                                       std::max(this->control_ms, 1e-3));
+    int steps = this->scale_steps;
+    if (ideal_steps < steps) {
+        steps = static_cast<int>(std::floor(ideal_steps));
+    } else if (ideal_steps >= steps + 1) {
+        ++steps;
+    }
+    this->set_scale_steps(std::min(std::max(steps, DYNAMIC_RESOLUTION_MIN_STEPS), DYNAMIC_RESOLUTION_STEPS));
+}
+
+void DynamicResolution::bind_target(const FrameGraph &graph, FrameGraph::Resource color,
+                                    FrameGraph::Resource depth) {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &this->output_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, graph.get_texture(color), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, graph.get_texture(depth), 0);
+}
+
+void DynamicResolution::add_upscale_pass(FrameGraph &graph, FrameGraph::Resource scene_color,
+                                         FrameGraph::Resource scene_depth, FrameGraph::Resource &color,
+                                         FrameGraph::Resource &depth) {
+    graph.add_pass("upscale", [&](FrameGraph::Builder &builder) {
+        builder.read(scene_color);
+        builder.read(scene_depth);
+        color = builder.write(color);
+        depth = builder.write(depth);
+    }, [this, &graph, scene_color, scene_depth, color] {
+        int program, vao, active_texture, depth_func, polygon_mode[2];
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+        glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+        glGetIntegerv(GL_POLYGON_MODE, polygon_mode);
+
+        const FrameGraph::TextureDescription &output = graph.get_description(color);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<unsigned>(this->output_framebuffer));
+        glViewport(0, 0, output.width, output.height);
+        glActiveTexture(GL_TEXTURE0 + DYNAMIC_RESOLUTION_COLOR_UNIT);
+        glBindTexture(GL_TEXTURE_2D, graph.get_texture(scene_color));
+        glActiveTexture(GL_TEXTURE0 + DYNAMIC_RESOLUTION_DEPTH_UNIT);
+        glBindTexture(GL_TEXTURE_2D, graph.get_texture(scene_depth));
+        // every pixel is written, depth included
+        glDepthFunc(GL_ALWAYS);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        this->upscale_shader.use();
+        glUniform2f(this->output_size_location, static_cast<float>(output.width), static_cast<float>(output.height));
+        glBindVertexArray(this->empty_vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderDevice &device = RenderDevice::get_current();
+        device.add_binds(0, 1, 2);
+        device.add_uniform_calls(1);
+        device.add_draw(GL_TRIANGLES, 3);
+
+        glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygon_mode[0]));
+        glDepthFunc(static_cast<GLenum>(depth_func));
+        glBindVertexArray(vao);
+        glUseProgram(program);
+        device.add_binds(1, 1, 0);
+        glActiveTexture(active_texture);
+    });
+}
+
+const DynamicResolution::Stats &DynamicResolution::get_stats() const {
+    return this->stats;
+}
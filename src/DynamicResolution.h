@@ -0,0 +1,87 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_DYNAMICRESOLUTION_H
+#define LEARNOPENGL_DYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+
+#include "FrameGraph.h"
+#include "GpuTimer.h"
+#include "Shader.h"
+
+// holds a GPU frame time by rendering the scene at a fraction of the output resolution: the GPU time of every frame
+// is measured with timestamp queries, the scale drops right away when the frames get too slow and creeps back up one
+// step at a time when there is room, a scaled scene goes to transient textures of the frame graph and a sharpening
+// upscale pass composites it to the output, at full scale the scene is drawn to the output directly
+class DynamicResolution {
+
+public:
+    struct Stats {
+        float scale = 1;
+        // smoothed GPU milliseconds of a whole frame and the newest ones, negative until measured
+        double gpu_ms = -1;
+        double last_gpu_ms = -1;
+        // measured frames and the ones that took longer than the target
+        unsigned long long frames = 0;
+        unsigned long long missed_frames = 0;
+        unsigned long long scale_changes = 0;
+        unsigned long long dropped_timings = 0;
+    };
+
+    // target_ms is the GPU time of a frame to hold
+    explicit
+    DynamicResolution(double target_ms);
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution &) = delete;
+    DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+    // a disabled one stays at full scale but still measures
+    void set_enabled(bool enabled);
+    void set_target_ms(double target_ms);
+    double get_target_ms() const;
+    // the size the scene is rendered at for an output of width x height
+    void get_render_size(int width, int height, int &render_width, int &render_height) const;
+    bool is_scaled() const;
+
+    // around all the GPU work of a frame
+    void begin_frame();
+    void end_frame();
+    // picks up the finished measurements and adjusts the scale, never waits
+    void poll();
+
+    // call in the first pass that writes the scaled scene, it attaches the textures and binds them as the framebuffer,
+    // the framebuffer bound before is where the upscale pass draws to
+    void bind_target(const FrameGraph &graph, FrameGraph::Resource color, FrameGraph::Resource depth);
+    // adds the pass that upscales the scene into the output and copies its depth there, so later passes can draw on
+    // top, the pass restores the program, VAO, active texture, depth function and polygon mode, leaves the output
+    // framebuffer bound and the viewport at its size
+    void add_upscale_pass(FrameGraph &graph, FrameGraph::Resource scene_color, FrameGraph::Resource scene_depth,
+                          FrameGraph::Resource &color, FrameGraph::Resource &depth);
+
+    const Stats &get_stats() const;
+
+private:
+    Shader upscale_shader;
+    int output_size_location;
+    unsigned empty_vao = 0;
+    unsigned framebuffer = 0;
+    int output_framebuffer = 0;
+    GpuTimer timer;
+    bool enabled = true;
+    double target_ms;
+    // the scale in steps of 1 / DYNAMIC_RESOLUTION_STEPS
+    int scale_steps;
+    // frames measured since the scale changed and their smoothed time, earlier ones were at another scale
+    unsigned settled_frames = 0;
+    double control_ms = -1;
+    Stats stats;
+
+    void set_scale_steps(int steps);
+    void add_sample(double milliseconds);
+};
+
+
+#endif //LEARNOPENGL_DYNAMICRESOLUTION_H
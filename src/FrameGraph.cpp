@@ -0,0 +1,309 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "MemoryTracker.h"
+
+// the constants are bound to references, e.g. by std::min, so they need a definition
+const unsigned FrameGraph::RENDER_TARGET_RETIRE_FRAMES;
+const unsigned FrameGraph::NONE;
+
+bool FrameGraph::TextureDescription::operator==(const TextureDescription &other) const {
+    return this->width == other.width && this->height == other.height && this->format == other.format &&
+           this->levels == other.levels;
+}
+
+FrameGraph::Builder::Builder(FrameGraph &graph, unsigned pass) : graph(graph), pass(pass) {
+}
+
+FrameGraph::Resource FrameGraph::Builder::create(const string &name, const TextureDescription &description) {
+    // fails early for formats the device cannot render into
+    RenderDevice::get_render_target_size(description.width, description.height, description.format,
+                                         description.levels);
+    auto resource = static_cast<Resource>(this->graph.versions.size());
+    this->graph.textures.push_back({name, description, false, resource, 0, NONE, NONE});
+    this->graph.versions.push_back({static_cast<unsigned>(this->graph.textures.size() - 1), this->pass, NONE, {}, 0});
+    this->graph.passes[this->pass].writes.push_back(resource);
+    return resource;
+}
+
+void FrameGraph::Builder::read(Resource resource) {
+    this->graph.check_resource(resource);
+    Version &version = this->graph.versions[resource];
+    if (version.writer == this->pass) {
+        throw std::runtime_error("Pass " + this->graph.passes[this->pass].name + " reads what it writes!");
+    }
+    version.readers.push_back(this->pass);
+    this->graph.passes[this->pass].reads.push_back(resource);
+}
+
+FrameGraph::Resource FrameGraph::Builder::write(Resource resource) {
+    this->graph.check_resource(resource);
+    unsigned texture = this->graph.versions[resource].texture;
+    if (this->graph.textures[texture].newest != resource) {
+        throw std::runtime_error("Texture " + this->graph.textures[texture].name + " was already written over!");
+    }
+    this->read(resource);
+    auto written = static_cast<Resource>(this->graph.versions.size());
+    this->graph.versions.push_back({texture, this->pass, resource, {}, 0});
+    this->graph.textures[texture].newest = written;
+    Pass &pass = this->graph.passes[this->pass];
+    pass.writes.push_back(written);
+    if (this->graph.textures[texture].imported) {
+        pass.side_effects = true;
+    }
+    return written;
+}
+
+void FrameGraph::Builder::set_side_effects() {
+    this->graph.passes[this->pass].side_effects = true;
+}
+
+FrameGraph::FrameGraph(RenderDevice &device) : device(device) {
+}
+
+FrameGraph::~FrameGraph() {
+    for (const auto &render_target : this->render_targets) {
+        this->device.destroy_texture(render_target.texture);
+    }
+}
+
+void FrameGraph::reset() {
+    this->textures.clear();
+    this->versions.clear();
+    this->passes.clear();
+}
+
+FrameGraph::Resource FrameGraph::import_texture(const string &name, const TextureDescription &description,
+                                                unsigned texture) {
+    auto resource = static_cast<Resource>(this->versions.size());
+    this->textures.push_back({name, description, true, resource, texture, NONE, NONE});
+    this->versions.push_back({static_cast<unsigned>(this->textures.size() - 1), NONE, NONE, {}, 0});
+    return resource;
+}
+
+void FrameGraph::add_pass(const string &name, const Setup &setup, const Execute &execute) {
+    this->passes.push_back({name, execute, {}, {}, false, 0});
+    Builder builder(*this, static_cast<unsigned>(this->passes.size() - 1));
+    setup(builder);
+}
+
+void FrameGraph::check_resource(Resource resource) const {
+    if (resource >= this->versions.size()) {
+        throw std::runtime_error("Unknown frame graph resource " + std::to_string(resource) + "!");
+    }
+}
+
+void FrameGraph::cull() {
+    // a pass is needed as long as anyone reads one of its versions, a version as long as a needed pass reads it
+    std::vector<Resource> unread;
+    for (auto &pass : this->passes) {
+        pass.references = static_cast<unsigned>(pass.writes.size());
+    }
+    for (size_t i = 0; i != this->versions.size(); ++i) {
+        Version &version = this->versions[i];
+        version.references = static_cast<unsigned>(version.readers.size());
+        if (!version.references) {
+            unread.push_back(static_cast<Resource>(i));
+        }
+    }
+    auto release_reads = [&](const Pass &pass) {
+        for (Resource read : pass.reads) {
+            if (--this->versions[read].references == 0) {
+                unread.push_back(read);
+            }
+        }
+    };
+    for (const auto &pass : this->passes) {
+        if (!pass.references && !pass.side_effects) {
+            release_reads(pass);
+        }
+    }
+    while (!unread.empty()) {
+        unsigned writer = this->versions[unread.back()].writer;
+        unread.pop_back();
+        if (writer == NONE) {
+            continue;
+        }
+        Pass &pass = this->passes[writer];
+        if (--pass.references == 0 && !pass.side_effects) {
+            release_reads(pass);
+        }
+    }
+}
+
+std::vector<unsigned> FrameGraph::sort() const {
+    // a pass comes after the writers of what it reads and, since it writes over them, after the readers of the
+    // versions it writes over, among the passes that are ready the one added first goes first
+    auto is_culled = [this](unsigned pass) {
+        return !this->passes[pass].references && !this->passes[pass].side_effects;
+    };
+    std::vector<std::vector<unsigned>> successors(this->passes.size());
+    std::vector<unsigned> predecessor_counts(this->passes.size(), 0);
+    auto add_edge = [&](unsigned before, unsigned after) {
+        if (before != NONE && before != after && !is_culled(before)) {
+            successors[before].push_back(after);
+            ++predecessor_counts[after];
+        }
+    };
+    unsigned remaining = 0;
+    for (unsigned pass = 0; pass != this->passes.size(); ++pass) {
+        if (is_culled(pass)) {
+            continue;
+        }
+        ++remaining;
+        for (Resource read : this->passes[pass].reads) {
+            add_edge(this->versions[read].writer, pass);
+        }
+        for (Resource written : this->passes[pass].writes) {
+            unsigned previous = this->versions[written].previous;
+            if (previous != NONE) {
+                for (unsigned reader : this->versions[previous].readers) {
+                    add_edge(reader, pass);
+                }
+            }
+        }
+    }
+    std::vector<unsigned> order;
+    std::vector<bool> done(this->passes.size(), false);
+    while (order.size() != remaining) {
+        unsigned next = NONE;
+        for (unsigned pass = 0; pass != this->passes.size(); ++pass) {
+            if (!done[pass] && !is_culled(pass) && !predecessor_counts[pass]) {
+                next = pass;
+                break;
+            }
+        }
+        if (next == NONE) {
+            throw std::runtime_error("The passes of the frame graph depend on each other in a cycle!");
+        }
+        done[next] = true;
+        order.push_back(next);
+        for (unsigned successor : successors[next]) {
+            --predecessor_counts[successor];
+        }
+    }
+    return order;
+}
+
+void FrameGraph::assign_render_targets(const std::vector<unsigned> &order) {
+    std::vector<unsigned> positions(this->passes.size(), NONE);
+    for (unsigned i = 0; i != order.size(); ++i) {
+        positions[order[i]] = i;
+    }
+    // the lifetime of a texture spans every pass that runs and touches one of its versions
+    auto use = [&](Texture &texture, unsigned pass) {
+        if (pass == NONE || positions[pass] == NONE) {
+            return;
+        }
+        texture.first_use = std::min(texture.first_use == NONE ? positions[pass] : texture.first_use, positions[pass]);
+        texture.last_use = texture.last_use == NONE ? positions[pass] : std::max(texture.last_use, positions[pass]);
+    };
+    for (const auto &version : this->versions) {
+        Texture &texture = this->textures[version.texture];
+        use(texture, version.writer);
+        for (unsigned reader : version.readers) {
+            use(texture, reader);
+        }
+    }
+    std::vector<unsigned> transients;
+    for (unsigned i = 0; i != this->textures.size(); ++i) {
+        if (!this->textures[i].imported && this->textures[i].first_use != NONE) {
+            transients.push_back(i);
+        }
+    }
+    std::stable_sort(transients.begin(), transients.end(), [this](unsigned a, unsigned b) {
+        return this->textures[a].first_use < this->textures[b].first_use;
+    });
+
+    // first fit: any render target of the same description whose last user runs before the first one of the texture
+    ++this->frame;
+    for (unsigned i : transients) {
+        Texture &texture = this->textures[i];
+        RenderTarget *target = nullptr;
+        for (auto &render_target : this->render_targets) {
+            if (render_target.description == texture.description &&
+                (render_target.last_frame != this->frame || render_target.busy_until < texture.first_use)) {
+                target = &render_target;
+                break;
+            }
+        }
+        if (!target) {
+            const TextureDescription &description = texture.description;
+            // named after the texture it was created for, it is shared with the others of the same description
+            MemoryTracker::Scope memory_scope("frame graph " + texture.name);
+            unsigned handle = this->device.create_render_target(description.width, description.height,
+                                                                description.format, description.levels);
+            this->render_targets.push_back({description, handle, RenderDevice::get_render_target_size(
+                    description.width, description.height, description.format, description.levels), 0, 0});
+            target = &this->render_targets.back();
+        }
+        if (target->last_frame != this->frame) {
+            ++this->stats.render_targets;
+            this->stats.aliased_bytes += target->size;
+        }
+        target->last_frame = this->frame;
+        target->busy_until = texture.last_use;
+        texture.texture = target->texture;
+        ++this->stats.transient_textures;
+        this->stats.unaliased_bytes += target->size;
+    }
+
+    // whatever the last frames did not need, e.g. after a resize, goes away
+    for (size_t i = 0; i != this->render_targets.size();) {
+        if (this->frame - this->render_targets[i].last_frame >= RENDER_TARGET_RETIRE_FRAMES) {
+            this->device.destroy_texture(this->render_targets[i].texture);
+            this->render_targets.erase(this->render_targets.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            ++i;
+        }
+    }
+}
+
+void FrameGraph::execute() {
+    this->stats = Stats();
+    this->stats.passes = static_cast<unsigned>(this->passes.size());
+    this->cull();
+    std::vector<unsigned> order = this->sort();
+    this->stats.culled_passes = static_cast<unsigned>(this->passes.size() - order.size());
+    this->assign_render_targets(order);
+    this->executed_passes.clear();
+    for (unsigned pass : order) {
+        this->executed_passes.push_back(this->passes[pass].name);
+        if (this->begin_pass) {
+            this->begin_pass(this->passes[pass].name);
+        }
+        this->passes[pass].execute();
+        if (this->end_pass) {
+            this->end_pass(this->passes[pass].name);
+        }
+    }
+}
+
+void FrameGraph::set_pass_hooks(const PassHook &begin, const PassHook &end) {
+    this->begin_pass = begin;
+    this->end_pass = end;
+}
+
+unsigned FrameGraph::get_texture(Resource resource) const {
+    this->check_resource(resource);
+    return this->textures[this->versions[resource].texture].texture;
+}
+
+const FrameGraph::TextureDescription &FrameGraph::get_description(Resource resource) const {
+    this->check_resource(resource);
+    return this->textures[this->versions[resource].texture].description;
+}
+
+const std::vector<string> &FrameGraph::get_executed_passes() const {
+    return this->executed_passes;
+}
+
+const FrameGraph::Stats &FrameGraph::get_stats() const {
+    return this->stats;
+}
@@ -0,0 +1,161 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_FRAMEGRAPH_H
+#define LEARNOPENGL_FRAMEGRAPH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+using std::string;
+
+// the passes of a frame and the textures they create, read and write: every frame the passes are declared again, the
+// graph culls the ones nothing needs, orders the rest by their dependencies and backs the transient textures with
+// render targets from a pool that survives the frames, transient textures whose lifetimes do not overlap share one
+class FrameGraph {
+
+public:
+    struct TextureDescription {
+        int width;
+        int height;
+        // see RenderDevice::get_render_target_size()
+        GLenum format;
+        int levels;
+
+        bool operator==(const TextureDescription &other) const;
+    };
+
+    struct Stats {
+        unsigned passes = 0;
+        unsigned culled_passes = 0;
+        unsigned transient_textures = 0;
+        unsigned render_targets = 0;
+        // what the transient textures of the frame take with a render target each and with the aliasing
+        size_t unaliased_bytes = 0;
+        size_t aliased_bytes = 0;
+    };
+
+    // a version of a texture, writing a texture makes a new version
+    typedef unsigned Resource;
+
+    // what a pass declares in its setup
+    class Builder {
+
+    public:
+        Resource create(const string &name, const TextureDescription &description);
+        void read(Resource resource);
+        // keeps the contents of the texture, so it also reads the version it writes over
+        Resource write(Resource resource);
+        // runs the pass even if nothing reads what it writes, e.g. because it reads back to the CPU
+        void set_side_effects();
+
+    private:
+        friend class FrameGraph;
+
+        FrameGraph &graph;
+        unsigned pass;
+
+        Builder(FrameGraph &graph, unsigned pass);
+    };
+
+    typedef std::function<void(Builder &)> Setup;
+    typedef std::function<void()> Execute;
+    typedef std::function<void(const string &)> PassHook;
+
+    explicit
+    FrameGraph(RenderDevice &device);
+    ~FrameGraph();
+
+    FrameGraph(const FrameGraph &) = delete;
+    FrameGraph &operator=(const FrameGraph &) = delete;
+
+    // forgets the passes and textures of the last frame, the render targets stay in the pool
+    void reset();
+    // a texture that lives outside of the graph, e.g. texture 0 for the default framebuffer, passes that write one
+    // are never culled
+    Resource import_texture(const string &name, const TextureDescription &description, unsigned texture);
+    // setup runs right away, execute when the graph is executed
+    void add_pass(const string &name, const Setup &setup, const Execute &execute);
+    // culls, orders, assigns the render targets and runs the passes
+    void execute();
+    // begin is called with the name of every pass right before it runs and end right after, e.g. to time them, empty
+    // functions remove the hooks
+    void set_pass_hooks(const PassHook &begin, const PassHook &end);
+
+    // the texture of a resource, transient ones only have one while the passes run
+    unsigned get_texture(Resource resource) const;
+    const TextureDescription &get_description(Resource resource) const;
+    // the names of the passes that ran in the last execute(), in their order
+    const std::vector<string> &get_executed_passes() const;
+    const Stats &get_stats() const;
+
+private:
+    // render targets that no frame has used for this many frames are destroyed
+    static const unsigned RENDER_TARGET_RETIRE_FRAMES = 60;
+    static const unsigned NONE = ~0U;
+
+    struct Texture {
+        string name;
+        TextureDescription description;
+        bool imported;
+        // only the newest version can be written
+        Resource newest;
+        // the render target while the passes run
+        unsigned texture;
+        // the span of the ordered passes that use it
+        unsigned first_use;
+        unsigned last_use;
+    };
+
+    struct Version {
+        unsigned texture;
+        // the pass that created or wrote it, NONE for imported textures
+        unsigned writer;
+        // the version it was written over, NONE for the first one
+        unsigned previous;
+        std::vector<unsigned> readers;
+        unsigned references;
+    };
+
+    struct Pass {
+        string name;
+        Execute execute;
+        std::vector<Resource> reads;
+        std::vector<Resource> writes;
+        bool side_effects;
+        unsigned references;
+    };
+
+    struct RenderTarget {
+        TextureDescription description;
+        unsigned texture;
+        size_t size;
+        unsigned long long last_frame;
+        // the last ordered pass that uses it this frame
+        unsigned busy_until;
+    };
+
+    RenderDevice &device;
+    std::vector<Texture> textures;
+    std::vector<Version> versions;
+    std::vector<Pass> passes;
+    std::vector<RenderTarget> render_targets;
+    std::vector<string> executed_passes;
+    PassHook begin_pass;
+    PassHook end_pass;
+    unsigned long long frame = 0;
+    Stats stats;
+
+    void check_resource(Resource resource) const;
+    void cull();
+    std::vector<unsigned> sort() const;
+    void assign_render_targets(const std::vector<unsigned> &order);
+};
+
+
+#endif //LEARNOPENGL_FRAMEGRAPH_H
@@ -0,0 +1,174 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "FramePipeline.h"
+
+#define DEFAULT_FRAME_RATE 60.0
+#define DEFAULT_MAX_QUEUED_FRAMES 2
+// the last bit of a wait is spun, the sleeps of the OS overshoot by about this much
+#define PACER_SPIN_SECONDS 0.002
+// a swap that takes longer than this waited for a blank
+#define PACER_BLOCKED_SWAP_SECONDS 0.001
+// how early the low latency mode starts a frame: its smoothed work times a factor plus a margin
+#define PACER_WORK_FACTOR 1.25
+#define PACER_MARGIN_SECONDS 0.0015
+// weight of a new frame in the smoothed work
+#define PACER_SMOOTHING 0.1
+
+FramePacer::FramePacer(RenderDevice &device_i) :
+        device(device_i),
+        period(1.0 / DEFAULT_FRAME_RATE),
+        max_queued_frames(DEFAULT_MAX_QUEUED_FRAMES) {}
+
+FramePacer::~FramePacer() {
+    for (const auto &frame : this->presented) {
+        this->device.destroy_fence(frame.fence);
+    }
+}
+
+void FramePacer::set_mode(Mode new_mode) {
+    if (new_mode == this->mode) {
+        return;
+    }
+    this->mode = new_mode;
+    this->next_start = -1;
+    this->last_present = -1;
+    this->blank_anchor = -1;
+    this->stats = Stats();
+}
+
+FramePacer::Mode FramePacer::get_mode() const {
+    return this->mode;
+}
+
+void FramePacer::set_frame_rate(double frame_rate) {
+    this->period = 1.0 / (frame_rate > 0 ? frame_rate : DEFAULT_FRAME_RATE);
+}
+
+void FramePacer::set_max_queued_frames(unsigned frames) {
+    this->max_queued_frames = std::max(frames, 1U);
+}
+
+int FramePacer::get_swap_interval(bool tear_control) const {
+    switch (this->mode) {
+        case PACING_VSYNC:
+        case PACING_LOW_LATENCY:
+            return 1;
+        case PACING_ADAPTIVE_VSYNC:
+            return tear_control ? -1 : 1;
+        default:
+            return 0;
+    }
+}
+
+void FramePacer::wait_for_frame_start() {
+    double wait_start = FramePipeline::get_time();
+    this->retire_presented(this->mode == PACING_LOW_LATENCY ? 0 : this->max_queued_frames - 1);
+    double now = FramePipeline::get_time();
+    this->stats.queue_wait_ms += (now - wait_start) * 1000.0;
+
+    if (this->mode == PACING_CAP) {
+        // a frame that starts more than a period late starts the schedule over instead of rushing to catch up
+        if (this->next_start < 0 || now - this->next_start > this->period) {
+            this->next_start = now;
+        }
+        this->sleep_until(this->next_start);
+        this->next_start += this->period;
+    } else if (this->mode == PACING_LOW_LATENCY && this->blank_anchor >= 0) {
+        // the first blank the frame can still make with its work and a margin, it starts that long before it
+        double lead = this->work * PACER_WORK_FACTOR + PACER_MARGIN_SECONDS;
+        double blanks = std::ceil((now + lead - this->blank_anchor) / this->period);
+        this->sleep_until(this->blank_anchor + blanks * this->period - lead);
+    }
+    this->frame_start = FramePipeline::get_time();
+}
+
+void FramePacer::begin_present() {
+    this->present_start = FramePipeline::get_time();
+}
+
+void FramePacer::end_present(double sample_time) {
+    double now = FramePipeline::get_time();
+    if (this->frame_start >= 0) {
+        double frame_work = this->present_start - this->frame_start;
+        this->work = this->work == 0 ? frame_work : this->work + (frame_work - this->work) * PACER_SMOOTHING;
+    }
+    // a swap that blocked returned right at a blank, until one does the first present stands in for one
+    if (now - this->present_start > PACER_BLOCKED_SWAP_SECONDS || this->blank_anchor < 0) {
+        this->blank_anchor = now;
+    }
+    ++this->stats.frames;
+    if (this->last_present >= 0) {
+        double interval_ms = (now - this->last_present) * 1000.0;
+        ++this->stats.intervals;
+        this->stats.interval_ms += interval_ms;
+        this->stats.interval_squared_ms += interval_ms * interval_ms;
+    }
+    this->last_present = now;
+    this->presented.push_back({this->device.insert_fence(), sample_time});
+}
+
+void FramePacer::retire_presented(size_t max) {
+    while (!this->presented.empty() && this->device.is_fence_signaled(this->presented.front().fence)) {
+        this->finish_presented(FramePipeline::get_time());
+    }
+    while (this->presented.size() > max) {
+        this->device.wait_fence(this->presented.front().fence);
+        this->finish_presented(FramePipeline::get_time());
+    }
+}
+
+void FramePacer::finish_presented(double now) {
+    const Presented &frame = this->presented.front();
+    double latency_ms = (now - frame.sample_time) * 1000.0;
+    ++this->stats.latency_frames;
+    this->stats.latency_ms += latency_ms;
+    this->stats.max_latency_ms = std::max(this->stats.max_latency_ms, latency_ms);
+    this->device.destroy_fence(frame.fence);
+    this->presented.pop_front();
+}
+
+void FramePacer::sleep_until(double time) {
+    double now = FramePipeline::get_time();
+    double sleep_start = now;
+    if (time - now > PACER_SPIN_SECONDS) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(time - now - PACER_SPIN_SECONDS));
+        now = FramePipeline::get_time();
+    }
+    double spin_start = now;
+    // the fences are checked while spinning anyway, so the latency of the finished frames is measured closer
+    while (now < time) {
+        this->retire_presented(this->presented.size());
+        std::this_thread::yield();
+        now = FramePipeline::get_time();
+    }
+    this->stats.sleep_ms += (spin_start - sleep_start) * 1000.0;
+    this->stats.spin_ms += (now - spin_start) * 1000.0;
+}
+
+const FramePacer::Stats &FramePacer::get_stats() const {
+    return this->stats;
+}
+
+const char *FramePacer::get_mode_name(Mode mode) {
+    switch (mode) {
+        case PACING_VSYNC:
+            return "vsync";
+        case PACING_ADAPTIVE_VSYNC:
+            return "adaptive vsync";
+        case PACING_CAP:
+            return "capped";
+        case PACING_LOW_LATENCY:
+            return "low latency";
+        default:
+            return "off";
+    }
+}
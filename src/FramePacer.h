@@ -0,0 +1,106 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_FRAMEPACER_H
+#define LEARNOPENGL_FRAMEPACER_H
+
+#include <deque>
+
+#include "RenderDevice.h"
+
+// decides when the next frame starts and how it is presented: the swap interval of a mode is up to the caller to
+// apply, a cap sleeps (and spins the last bit) until the next frame is due, the low latency mode predicts the next
+// vertical blank and starts sampling the input just early enough to submit before it, every mode bounds the frames
+// queued ahead of the GPU with fences before the input of the next one is sampled, which also measures the latency
+// from sampling the input to the GPU finishing the frame
+class FramePacer {
+
+public:
+    enum Mode {
+        // whatever the swap interval 0 gives, as fast as possible
+        PACING_OFF,
+        PACING_VSYNC,
+        // vsync that tears instead of waiting for the next blank when a frame is late, plain vsync without support
+        PACING_ADAPTIVE_VSYNC,
+        PACING_CAP,
+        // vsync with one frame queued at most and the start of the frame delayed until just before the deadline
+        PACING_LOW_LATENCY,
+        PACING_MODE_COUNT
+    };
+
+    // sums since the mode was set
+    struct Stats {
+        unsigned long long frames = 0;
+        // between the ends of consecutive presents, squared too for the jitter
+        unsigned long long intervals = 0;
+        double interval_ms = 0;
+        double interval_squared_ms = 0;
+        // from sampling the input to the fence after the present signaling
+        unsigned long long latency_frames = 0;
+        double latency_ms = 0;
+        double max_latency_ms = 0;
+        // waiting for the start of a frame and for the GPU to catch up
+        double sleep_ms = 0;
+        double spin_ms = 0;
+        double queue_wait_ms = 0;
+    };
+
+    // the fences live on device, which must be current on the calling thread whenever the pacer is used
+    explicit
+    FramePacer(RenderDevice &device);
+    ~FramePacer();
+
+    FramePacer(const FramePacer &) = delete;
+    FramePacer &operator=(const FramePacer &) = delete;
+
+    void set_mode(Mode mode);
+    Mode get_mode() const;
+    // frames per second of the cap and of the display, the low latency mode predicts the blanks with it
+    void set_frame_rate(double frame_rate);
+    // frames presented but not finished by the GPU before a new one may start, the low latency mode allows one
+    void set_max_queued_frames(unsigned frames);
+    // the swap interval of the mode, tear_control is whether negative intervals are supported
+    int get_swap_interval(bool tear_control) const;
+
+    // call before the input of a frame is sampled
+    void wait_for_frame_start();
+    // call around the swap of a frame whose input was sampled at sample_time (FramePipeline::get_time())
+    void begin_present();
+    void end_present(double sample_time);
+
+    const Stats &get_stats() const;
+
+    static const char *get_mode_name(Mode mode);
+
+private:
+    struct Presented {
+        void *fence;
+        double sample_time;
+    };
+
+    RenderDevice &device;
+    Mode mode = PACING_OFF;
+    double period;
+    unsigned max_queued_frames;
+    std::deque<Presented> presented;
+    // when the capped frame is due next
+    double next_start = -1;
+    // when the current frame started and its present began
+    double frame_start = -1;
+    double present_start = -1;
+    double last_present = -1;
+    // a time a blank happened, found by a swap that blocked, the others are a period apart
+    double blank_anchor = -1;
+    // smoothed seconds from the start of a frame to its present
+    double work = 0;
+    Stats stats;
+
+    // takes the fences that signaled, waits for the oldest ones while more than max are queued
+    void retire_presented(size_t max);
+    void finish_presented(double now);
+    void sleep_until(double time);
+};
+
+
+#endif //LEARNOPENGL_FRAMEPACER_H
@@ -0,0 +1,182 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "FramePipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include "CpuProfiler.h"
+#include "MemoryTracker.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double milliseconds_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+FramePipeline::FramePipeline(unsigned max_depth, size_t frame_data_size, unsigned max_views) :
+        device(RenderDevice::get_current()),
+        max_depth(std::max(max_depth, 1U)),
+        depth(std::max(max_depth, 1U)),
+        slot_jobs(std::max(max_depth, 1U), 0),
+        frame_data_size(frame_data_size),
+        max_views(std::max(max_views, 1U)),
+        stats(std::max(max_depth, 1U) + 1) {
+    size_t alignment = this->device.get_uniform_buffer_alignment();
+    // every view is bound on its own, so each one starts at an aligned offset
+    this->view_stride = (frame_data_size + alignment - 1) / alignment * alignment;
+    this->slot_stride = this->view_stride * this->max_views;
+    this->staging.resize(this->slot_stride);
+    MemoryTracker::Scope memory_scope("frame pipeline");
+    this->uniform_buffer = this->device.create_buffer(GL_UNIFORM_BUFFER, this->slot_stride * this->max_depth,
+                                                      nullptr, GL_DYNAMIC_DRAW);
+    this->thread = std::thread(&FramePipeline::worker_loop, this);
+}
+
+FramePipeline::~FramePipeline() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->job_ready.notify_all();
+    this->thread.join();
+    for (void *fence : this->fences) {
+        this->device.destroy_fence(fence);
+    }
+    this->device.destroy_buffer(this->uniform_buffer);
+}
+
+void FramePipeline::set_depth(unsigned new_depth) {
+    if (new_depth < 1 || new_depth > this->max_depth) {
+        throw std::runtime_error("Pipeline depth out of range!");
+    }
+    this->depth = new_depth;
+}
+
+unsigned FramePipeline::get_depth() const {
+    return this->depth;
+}
+
+unsigned FramePipeline::get_max_depth() const {
+    return this->max_depth;
+}
+
+void FramePipeline::prepare(unsigned slot, const std::function<void()> &job, bool on_pipeline_thread) {
+    if (!on_pipeline_thread) {
+        // the earlier preparations may still use whatever this one uses
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_done.wait(lock, [this] { return this->finished_jobs == this->queued_jobs; });
+            this->slot_jobs[slot] = this->queued_jobs;
+        }
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobs.push_back(job);
+        this->slot_jobs[slot] = ++this->queued_jobs;
+    }
+    this->job_ready.notify_one();
+}
+
+void FramePipeline::wait_prepared(unsigned slot) {
+    auto start = Clock::now();
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        unsigned long long job = this->slot_jobs[slot];
+        this->job_done.wait(lock, [this, job] { return this->finished_jobs >= job; });
+    }
+    this->pending_prepare_wait_ms += milliseconds_since(start);
+}
+
+void FramePipeline::wait_for_slot() {
+    auto start = Clock::now();
+    while (this->fences.size() >= this->depth) {
+        void *fence = this->fences.front();
+        this->fences.pop_front();
+        this->device.wait_fence(fence);
+        this->device.destroy_fence(fence);
+    }
+    this->pending_fence_wait_ms += milliseconds_since(start);
+}
+
+void FramePipeline::begin_submit(const void *frame_data, unsigned views, unsigned binding) {
+    if (views < 1 || views > this->max_views) {
+        throw std::runtime_error("View count out of range!");
+    }
+    this->wait_for_slot();
+
+    // at most depth <= max depth frames are in flight, so the GPU is done with the slot we are about to overwrite
+    this->slot_offset = this->slot_stride * this->next_ring_slot;
+    this->next_ring_slot = (this->next_ring_slot + 1) % this->max_depth;
+    this->view_count = views;
+    for (unsigned view = 0; view != views; ++view) {
+        const unsigned char *source = static_cast<const unsigned char *>(frame_data) + this->frame_data_size * view;
+        std::memcpy(&this->staging[this->view_stride * view], source, this->frame_data_size);
+    }
+    this->device.update_buffer(this->uniform_buffer, this->slot_offset,
+                               this->view_stride * (views - 1) + this->frame_data_size, this->staging.data(), true);
+    this->bind_view(0, binding);
+}
+
+void FramePipeline::bind_view(unsigned view, unsigned binding) {
+    if (view >= this->view_count) {
+        throw std::runtime_error("The frame has no view " + std::to_string(view) + "!");
+    }
+    this->device.bind_uniform_buffer(binding, this->uniform_buffer, this->slot_offset + this->view_stride * view,
+                                     this->frame_data_size);
+}
+
+void FramePipeline::end_submit(double sample_time) {
+    this->fences.push_back(this->device.insert_fence());
+
+    double now = get_time();
+    Stats &depth_stats = this->stats[this->depth];
+    ++depth_stats.frames;
+    if (this->last_submit_time >= 0) {
+        depth_stats.frame_ms += (now - this->last_submit_time) * 1000.0;
+    }
+    depth_stats.latency_ms += (now - sample_time) * 1000.0;
+    depth_stats.prepare_wait_ms += this->pending_prepare_wait_ms;
+    depth_stats.fence_wait_ms += this->pending_fence_wait_ms;
+    this->last_submit_time = now;
+    this->pending_prepare_wait_ms = 0;
+    this->pending_fence_wait_ms = 0;
+}
+
+double FramePipeline::get_time() {
+    return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
+
+const FramePipeline::Stats &FramePipeline::get_stats(unsigned stats_depth) const {
+    return this->stats.at(stats_depth);
+}
+
+void FramePipeline::worker_loop() {
+    CpuProfiler::set_thread_name("frame preparation");
+    MemoryTracker::Scope memory_scope("frame preparation");
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_ready.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+            if (this->jobs.empty()) {
+                return;
+            }
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ++this->finished_jobs;
+        }
+        this->job_done.notify_all();
+    }
+}
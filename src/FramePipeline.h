@@ -0,0 +1,112 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_FRAMEPIPELINE_H
+#define LEARNOPENGL_FRAMEPIPELINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+// overlaps the stages of consecutive frames: with a depth of n, up to n - 1 frames are prepared (culled and recorded)
+// on the pipeline thread while the GL thread submits an older one, and up to n frames are in flight on the GPU, the
+// per-frame uniform buffer is a ring whose slots are only rewritten once the fence of their last frame has signaled,
+// every slot holds an array of the uniform data of the views of the frame
+class FramePipeline {
+
+public:
+    // sums over every frame submitted at one depth
+    struct Stats {
+        unsigned long long frames = 0;
+        // time between the ends of consecutive submissions
+        double frame_ms = 0;
+        // from sampling the input of a frame to the end of its submission
+        double latency_ms = 0;
+        // the GL thread waiting for a preparation to finish
+        double prepare_wait_ms = 0;
+        // the GL thread waiting for the GPU to give a ring slot back
+        double fence_wait_ms = 0;
+    };
+
+    // frame_data_size is the size of the uniform data of a view, a frame has up to max_views of them, the ring lives
+    // on the current render device
+    FramePipeline(unsigned max_depth, size_t frame_data_size, unsigned max_views = 1);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    // takes effect for the following frames, frames already in flight finish normally
+    void set_depth(unsigned depth);
+    unsigned get_depth() const;
+    unsigned get_max_depth() const;
+
+    // runs the preparation of the frame in slot (in [0, max depth)) on the pipeline thread after every preparation
+    // queued before it, or right away on the calling thread if on_pipeline_thread is false
+    void prepare(unsigned slot, const std::function<void()> &job, bool on_pipeline_thread);
+    // blocks until the preparation of slot is done
+    void wait_prepared(unsigned slot);
+
+    // blocks until fewer than depth frames are in flight on the GPU, call it before whatever should happen as late as
+    // possible before the submission, begin_submit() does it otherwise
+    void wait_for_slot();
+    // waits for a slot, then writes the view_count tightly packed blocks of frame_data into the next ring slot and
+    // binds the first one to the uniform buffer binding point
+    void begin_submit(const void *frame_data, unsigned view_count, unsigned binding);
+    // binds the block of another view of the frame being submitted
+    void bind_view(unsigned view, unsigned binding);
+    // fences the frame, call it after the swap, sample_time is the get_time() at which its input was sampled
+    void end_submit(double sample_time);
+    // seconds on a steady clock
+    static double get_time();
+
+    const Stats &get_stats(unsigned depth) const;
+
+private:
+    RenderDevice &device;
+    unsigned max_depth;
+    unsigned depth;
+
+    // the pipeline thread
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    std::deque<std::function<void()>> jobs;
+    unsigned long long queued_jobs = 0;
+    unsigned long long finished_jobs = 0;
+    // the job number every slot waits for
+    std::vector<unsigned long long> slot_jobs;
+    bool stopping = false;
+
+    // the GPU side
+    unsigned uniform_buffer = 0;
+    size_t frame_data_size;
+    unsigned max_views;
+    size_t view_stride = 0;
+    size_t slot_stride = 0;
+    unsigned next_ring_slot = 0;
+    // the slot of the frame being submitted
+    size_t slot_offset = 0;
+    unsigned view_count = 0;
+    // the views spread out to their aligned offsets
+    std::vector<unsigned char> staging;
+    std::deque<void *> fences;
+
+    std::vector<Stats> stats;
+    double last_submit_time = -1;
+    double pending_prepare_wait_ms = 0;
+    double pending_fence_wait_ms = 0;
+
+    void worker_loop();
+};
+
+
+#endif //LEARNOPENGL_FRAMEPIPELINE_H
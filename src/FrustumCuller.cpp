@@ -0,0 +1,395 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CULL_SIMD_WIDTH 4
+#else
+#define CULL_SIMD_WIDTH 1
+#endif
+
+// maximum number of objects per leaf, a multiple of the SIMD width
+#define CULL_LEAF_SIZE 8
+// below this many objects a parallel cull is slower than a serial one
+#define CULL_PARALLEL_THRESHOLD 16384
+
+Frustum::Frustum(const mat4 &m) {
+    // Gribb & Hartmann, glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    for (int i = 0; i != 3; ++i) {
+        for (int j = 0; j != 4; ++j) {
+            this->planes[i * 2][j] = m[j][3] + m[j][i];
+            this->planes[i * 2 + 1][j] = m[j][3] - m[j][i];
+        }
+    }
+    for (auto &plane : this->planes) {
+        plane /= glm::length(vec3(plane));
+    }
+}
+
+bool Frustum::intersects(const vec3 &center, const vec3 &extent) const {
+    for (const auto &plane : this->planes) {
+        vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius = glm::dot(glm::abs(normal), extent);
+        if (distance + radius < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Frustum::classify(const vec3 &center, const vec3 &extent) const {
+    int side = 1;
+    for (const auto &plane : this->planes) {
+        vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius = glm::dot(glm::abs(normal), extent);
+        if (distance + radius < 0) {
+            return -1;
+        }
+        if (distance - radius < 0) {
+            side = 0;
+        }
+    }
+    return side;
+}
+
+unsigned FrustumCuller::add_object(const vec3 &min, const vec3 &max) {
+    this->object_centers.push_back((min + max) * 0.5F);
+    this->object_extents.push_back((max - min) * 0.5F);
+    this->dirty = true;
+    return static_cast<unsigned>(this->object_centers.size() - 1);
+}
+
+void FrustumCuller::set_bounds(unsigned object_id, const vec3 &min, const vec3 &max) {
+    vec3 center = (min + max) * 0.5F;
+    vec3 extent = (max - min) * 0.5F;
+    this->object_centers[object_id] = center;
+    this->object_extents[object_id] = extent;
+    if (this->dirty) {
+        return;
+    }
+    unsigned slot = this->object_slot[object_id];
+    this->center_x[slot] = center.x;
+    this->center_y[slot] = center.y;
+    this->center_z[slot] = center.z;
+    this->extent_x[slot] = extent.x;
+    this->extent_y[slot] = extent.y;
+    this->extent_z[slot] = extent.z;
+}
+
+void FrustumCuller::get_bounds(unsigned object_id, vec3 &center, vec3 &extent) const {
+    center = this->object_centers[object_id];
+    extent = this->object_extents[object_id];
+}
+
+size_t FrustumCuller::get_object_count() const {
+    return this->object_centers.size();
+}
+
+void FrustumCuller::build() {
+    auto count = static_cast<unsigned>(this->object_centers.size());
+    this->slot_object.resize(count);
+    for (unsigned i = 0; i != count; ++i) {
+        this->slot_object[i] = i;
+    }
+    this->nodes.clear();
+    this->nodes.reserve(2 * (count / CULL_LEAF_SIZE + 1));
+    if (count != 0) {
+        this->build_node(0, count);
+    }
+
+    // the padding lets the SIMD loop read past the end of the last leaf, those lanes are masked off anyway
+    size_t padded = count + CULL_LEAF_SIZE;
+    for (auto *array : {&this->center_x, &this->center_y, &this->center_z,
+                        &this->extent_x, &this->extent_y, &this->extent_z}) {
+        array->assign(padded, 0.0F);
+    }
+    this->object_slot.resize(count);
+    for (unsigned slot = 0; slot != count; ++slot) {
+        unsigned object = this->slot_object[slot];
+        this->object_slot[object] = slot;
+        this->center_x[slot] = this->object_centers[object].x;
+        this->center_y[slot] = this->object_centers[object].y;
+        this->center_z[slot] = this->object_centers[object].z;
+        this->extent_x[slot] = this->object_extents[object].x;
+        this->extent_y[slot] = this->object_extents[object].y;
+        this->extent_z[slot] = this->object_extents[object].z;
+    }
+    this->dirty = false;
+}
+
+unsigned FrustumCuller::build_node(unsigned first, unsigned count) {
+    vec3 box_min(INFINITY), box_max(-INFINITY);
+    vec3 centroid_min(INFINITY), centroid_max(-INFINITY);
+    for (unsigned i = first; i != first + count; ++i) {
+        const vec3 &center = this->object_centers[this->slot_object[i]];
+        const vec3 &extent = this->object_extents[this->slot_object[i]];
+        box_min = glm::min(box_min, center - extent);
+        box_max = glm::max(box_max, center + extent);
+        centroid_min = glm::min(centroid_min, center);
+        centroid_max = glm::max(centroid_max, center);
+    }
+    auto index = static_cast<unsigned>(this->nodes.size());
+    Node node = {(box_min + box_max) * 0.5F, (box_max - box_min) * 0.5F, first, count, 0};
+    this->nodes.push_back(node);
+    if (count <= CULL_LEAF_SIZE) {
+        return index;
+    }
+
+    // median split along the longest axis of the centroids
+    vec3 size = centroid_max - centroid_min;
+    int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+    // keep the split on a leaf boundary so leaves stay full
+    unsigned left_count = (count / 2 + CULL_LEAF_SIZE - 1) / CULL_LEAF_SIZE * CULL_LEAF_SIZE;
+    auto begin = this->slot_object.begin() + first;
+    const std::vector<vec3> &centers = this->object_centers;
+    std::nth_element(begin, begin + left_count, begin + count, [&](unsigned a, unsigned b) {
+        return centers[a][axis] < centers[b][axis];
+    });
+    this->build_node(first, left_count);
+    unsigned right = this->build_node(first + left_count, count - left_count);
+    this->nodes[index].right_child = right;
+    return index;
+}
+
+void FrustumCuller::refit() {
+    if (this->dirty) {
+        this->build();
+    } else if (!this->nodes.empty()) {
+        this->refit_node(0);
+    }
+}
+
+void FrustumCuller::refit_node(unsigned node_index) {
+    Node &node = this->nodes[node_index];
+    vec3 box_min, box_max;
+    if (node.right_child == 0) {
+        box_min = vec3(INFINITY);
+        box_max = vec3(-INFINITY);
+        for (unsigned i = node.first; i != node.first + node.count; ++i) {
+            vec3 center(this->center_x[i], this->center_y[i], this->center_z[i]);
+            vec3 extent(this->extent_x[i], this->extent_y[i], this->extent_z[i]);
+            box_min = glm::min(box_min, center - extent);
+            box_max = glm::max(box_max, center + extent);
+        }
+    } else {
+        this->refit_node(node_index + 1);
+        this->refit_node(node.right_child);
+        const Node &left = this->nodes[node_index + 1];
+        const Node &right = this->nodes[node.right_child];
+        box_min = glm::min(left.center - left.extent, right.center - right.extent);
+        box_max = glm::max(left.center + left.extent, right.center + right.extent);
+    }
+    node.center = (box_min + box_max) * 0.5F;
+    node.extent = (box_max - box_min) * 0.5F;
+}
+
+void FrustumCuller::cull(const Frustum &frustum, std::vector<unsigned> &visible) const {
+    if (this->dirty) {
+        throw std::runtime_error("FrustumCuller::build() must be called after adding objects!");
+    }
+    visible.clear();
+    if (!this->nodes.empty()) {
+        this->cull_subtree(frustum, 0, visible);
+    }
+}
+
+void FrustumCuller::cull(const Frustum &frustum, ThreadPool &pool, std::vector<unsigned> &visible) const {
+    if (this->dirty) {
+        throw std::runtime_error("FrustumCuller::build() must be called after adding objects!");
+    }
+    if (pool.get_worker_count() == 1 || this->object_centers.size() < CULL_PARALLEL_THRESHOLD) {
+        this->cull(frustum, visible);
+        return;
+    }
+    // expand the top of the tree breadth first until there are a few subtrees per worker
+    std::vector<unsigned> roots(1, 0);
+    size_t wanted = pool.get_worker_count() * 4;
+    for (size_t i = 0; i != roots.size() && roots.size() < wanted;) {
+        const Node &node = this->nodes[roots[i]];
+        if (node.right_child == 0) {
+            ++i;
+            continue;
+        }
+        unsigned left = roots[i] + 1;
+        roots[i] = left;
+        roots.push_back(node.right_child);
+    }
+
+    std::vector<std::vector<unsigned>> results(roots.size());
+    pool.parallel_for(static_cast<unsigned>(roots.size()), [&](unsigned task, unsigned) {
+        this->cull_subtree(frustum, roots[task], results[task]);
+    });
+    visible.clear();
+    for (const auto &result : results) {
+        visible.insert(visible.end(), result.begin(), result.end());
+    }
+}
+
+void FrustumCuller::cull(const Frustum *frusta, unsigned frustum_count, std::vector<unsigned> &visible,
+                         std::vector<uint32_t> &masks) const {
+    if (this->dirty) {
+        throw std::runtime_error("FrustumCuller::build() must be called after adding objects!");
+    }
+    if (frustum_count > 32) {
+        throw std::runtime_error("At most 32 frusta can be culled against at once!");
+    }
+    visible.clear();
+    masks.clear();
+    if (this->nodes.empty() || frustum_count == 0) {
+        return;
+    }
+    // the frusta a node still has to be tested against and the ones it is known to be inside of
+    struct Entry {
+        unsigned node;
+        uint32_t partial;
+        uint32_t inside;
+    };
+    Entry stack[64];
+    int top = 0;
+    stack[top++] = {0, frustum_count == 32 ? ~0U : (1U << frustum_count) - 1, 0};
+    while (top != 0) {
+        Entry entry = stack[--top];
+        const Node &node = this->nodes[entry.node];
+        uint32_t partial = 0;
+        uint32_t inside = entry.inside;
+        for (unsigned frustum = 0; frustum != frustum_count; ++frustum) {
+            if (!(entry.partial & (1U << frustum))) {
+                continue;
+            }
+            int side = frusta[frustum].classify(node.center, node.extent);
+            if (side > 0) {
+                inside |= 1U << frustum;
+            } else if (side == 0) {
+                partial |= 1U << frustum;
+            }
+        }
+        if (partial == 0) {
+            if (inside != 0) {
+                visible.insert(visible.end(), this->slot_object.begin() + node.first,
+                               this->slot_object.begin() + node.first + node.count);
+                masks.resize(visible.size(), inside);
+            }
+        } else if (node.right_child == 0) {
+            for (unsigned base = node.first; base < node.first + node.count; base += CULL_SIMD_WIDTH) {
+                unsigned lanes = std::min<unsigned>(CULL_SIMD_WIDTH, node.first + node.count - base);
+                uint32_t lane_masks[CULL_SIMD_WIDTH];
+                std::fill(lane_masks, lane_masks + CULL_SIMD_WIDTH, inside);
+                for (unsigned frustum = 0; frustum != frustum_count; ++frustum) {
+                    if (!(partial & (1U << frustum))) {
+                        continue;
+                    }
+                    unsigned outside = this->get_outside_lanes(frusta[frustum], base);
+                    for (unsigned lane = 0; lane != lanes; ++lane) {
+                        if (!(outside & (1U << lane))) {
+                            lane_masks[lane] |= 1U << frustum;
+                        }
+                    }
+                }
+                for (unsigned lane = 0; lane != lanes; ++lane) {
+                    if (lane_masks[lane] != 0) {
+                        visible.push_back(this->slot_object[base + lane]);
+                        masks.push_back(lane_masks[lane]);
+                    }
+                }
+            }
+        } else {
+            stack[top++] = {node.right_child, partial, inside};
+            stack[top++] = {entry.node + 1, partial, inside};
+        }
+    }
+}
+
+void FrustumCuller::cull_subtree(const Frustum &frustum, unsigned root, std::vector<unsigned> &visible) const {
+    unsigned stack[64];
+    int top = 0;
+    stack[top++] = root;
+    while (top != 0) {
+        const Node &node = this->nodes[stack[--top]];
+        int side = frustum.classify(node.center, node.extent);
+        if (side < 0) {
+            continue;
+        }
+        if (side > 0) {
+            // the whole subtree is visible, no need to look at the individual boxes
+            visible.insert(visible.end(), this->slot_object.begin() + node.first,
+                           this->slot_object.begin() + node.first + node.count);
+        } else if (node.right_child == 0) {
+            this->cull_leaf(frustum, node, visible);
+        } else {
+            stack[top++] = node.right_child;
+            stack[top++] = static_cast<unsigned>(&node - this->nodes.data()) + 1;
+        }
+    }
+}
+
+void FrustumCuller::cull_leaf(const Frustum &frustum, const Node &node, std::vector<unsigned> &visible) const {
+    for (unsigned base = node.first; base < node.first + node.count; base += CULL_SIMD_WIDTH) {
+        unsigned lanes = std::min<unsigned>(CULL_SIMD_WIDTH, node.first + node.count - base);
+        unsigned visible_mask = ~this->get_outside_lanes(frustum, base) & ((1U << lanes) - 1);
+        for (unsigned lane = 0; visible_mask != 0; ++lane, visible_mask >>= 1) {
+            if (visible_mask & 1) {
+                visible.push_back(this->slot_object[base + lane]);
+            }
+        }
+    }
+}
+
+unsigned FrustumCuller::get_outside_lanes(const Frustum &frustum, unsigned base) const {
+#if CULL_SIMD_WIDTH == 8
+    __m256 cx = _mm256_loadu_ps(&this->center_x[base]);
+    __m256 cy = _mm256_loadu_ps(&this->center_y[base]);
+    __m256 cz = _mm256_loadu_ps(&this->center_z[base]);
+    __m256 ex = _mm256_loadu_ps(&this->extent_x[base]);
+    __m256 ey = _mm256_loadu_ps(&this->extent_y[base]);
+    __m256 ez = _mm256_loadu_ps(&this->extent_z[base]);
+    __m256 outside = _mm256_setzero_ps();
+    for (const auto &plane : frustum.planes) {
+        __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)),
+                              _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+                _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+        __m256 radius = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::fabs(plane.x))),
+                              _mm256_mul_ps(ey, _mm256_set1_ps(std::fabs(plane.y)))),
+                _mm256_mul_ps(ez, _mm256_set1_ps(std::fabs(plane.z))));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius),
+                                                      _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+    return static_cast<unsigned>(_mm256_movemask_ps(outside));
+#elif CULL_SIMD_WIDTH == 4
+    __m128 cx = _mm_loadu_ps(&this->center_x[base]);
+    __m128 cy = _mm_loadu_ps(&this->center_y[base]);
+    __m128 cz = _mm_loadu_ps(&this->center_z[base]);
+    __m128 ex = _mm_loadu_ps(&this->extent_x[base]);
+    __m128 ey = _mm_loadu_ps(&this->extent_y[base]);
+    __m128 ez = _mm_loadu_ps(&this->extent_z[base]);
+    __m128 outside = _mm_setzero_ps();
+    for (const auto &plane : frustum.planes) {
+        __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(plane.x))),
+                           _mm_mul_ps(ey, _mm_set1_ps(std::fabs(plane.y)))),
+                _mm_mul_ps(ez, _mm_set1_ps(std::fabs(plane.z))));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+    }
+    return static_cast<unsigned>(_mm_movemask_ps(outside));
+#else
+    vec3 center(this->center_x[base], this->center_y[base], this->center_z[base]);
+    vec3 extent(this->extent_x[base], this->extent_y[base], this->extent_z[base]);
+    return frustum.intersects(center, extent) ? 0 : 1;
+#endif
+}
@@ -0,0 +1,91 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_FRUSTUMCULLER_H
+#define LEARNOPENGL_FRUSTUMCULLER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+
+using glm::vec3;
+using glm::vec4;
+using glm::mat4;
+
+// the six clip planes of a view projection matrix, normals point inwards
+struct Frustum {
+    // left, right, bottom, top, near, far
+    vec4 planes[6];
+
+    explicit
+    Frustum(const mat4 &view_projection);
+    bool intersects(const vec3 &center, const vec3 &extent) const;
+    // -1 if the box is outside, 1 if it is inside and 0 if it straddles a plane
+    int classify(const vec3 &center, const vec3 &extent) const;
+};
+
+// visibility culling of axis aligned bounding boxes against a frustum using a bounding volume hierarchy,
+// the leaves store their boxes as SoA (center and half extent) and are tested 4 (SSE) or 8 (AVX) at a time
+class FrustumCuller {
+
+public:
+    // returns the id of the object which is what cull() writes into the visible list
+    unsigned add_object(const vec3 &min, const vec3 &max);
+    // cheap update for moving objects, call refit() (or build()) before the next cull
+    void set_bounds(unsigned object_id, const vec3 &min, const vec3 &max);
+    void get_bounds(unsigned object_id, vec3 &center, vec3 &extent) const;
+    size_t get_object_count() const;
+
+    // (re)builds the hierarchy from scratch, needed after adding objects
+    void build();
+    // recomputes the node bounds bottom up without changing the tree topology
+    void refit();
+
+    // replaces the content of visible with the ids of all objects intersecting the frustum
+    void cull(const Frustum &frustum, std::vector<unsigned> &visible) const;
+    // same as cull() but the top of the tree is split into subtrees that are traversed by the pool's workers
+    void cull(const Frustum &frustum, ThreadPool &pool, std::vector<unsigned> &visible) const;
+    // culls against the union of up to 32 frusta in one traversal, visible gets every object that intersects any of
+    // them and masks the frusta it intersects, bit i for frustum i, a node inside or outside of a frustum settles it
+    // for the whole subtree, so frusta that overlap mostly cost one test per node
+    void cull(const Frustum *frusta, unsigned frustum_count, std::vector<unsigned> &visible,
+              std::vector<uint32_t> &masks) const;
+
+private:
+    struct Node {
+        vec3 center;
+        vec3 extent;
+        // range of the subtree in the SoA arrays
+        unsigned first;
+        unsigned count;
+        // the left child always directly follows its parent, 0 for leaves
+        unsigned right_child;
+    };
+
+    // objects in insertion order, the source of truth for build()
+    std::vector<vec3> object_centers;
+    std::vector<vec3> object_extents;
+
+    // SoA copies in tree order, padded to a multiple of the SIMD width
+    TaggedVector<float, MEMORY_CPU_CULLING> center_x, center_y, center_z;
+    TaggedVector<float, MEMORY_CPU_CULLING> extent_x, extent_y, extent_z;
+    TaggedVector<unsigned, MEMORY_CPU_CULLING> slot_object;
+    TaggedVector<unsigned, MEMORY_CPU_CULLING> object_slot;
+
+    TaggedVector<Node, MEMORY_CPU_CULLING> nodes;
+    bool dirty = false;
+
+    unsigned build_node(unsigned first, unsigned count);
+    void refit_node(unsigned node_index);
+    void cull_subtree(const Frustum &frustum, unsigned root, std::vector<unsigned> &visible) const;
+    void cull_leaf(const Frustum &frustum, const Node &node, std::vector<unsigned> &visible) const;
+    // the lanes of the SIMD group starting at slot base that are outside of the frustum
+    unsigned get_outside_lanes(const Frustum &frustum, unsigned base) const;
+};
+
+
+#endif //LEARNOPENGL_FRUSTUMCULLER_H
@@ -0,0 +1,360 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "GlRenderDevice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+GlRenderDevice::GlRenderDevice() {
+    int alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) {
+        this->uniform_buffer_alignment = static_cast<size_t>(alignment);
+    }
+}
+
+DeviceBackend GlRenderDevice::get_backend() const {
+    return BACKEND_GL;
+}
+
+unsigned GlRenderDevice::create_shader(GLenum stage, const string &source, const string &name) {
+    unsigned shader = glCreateShader(stage);
+    const char *source_pointer = source.c_str();
+    glShaderSource(shader, 1, &source_pointer, nullptr);
+    glCompileShader(shader);
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetShaderInfoLog(shader, 512, nullptr, info_log);
+        glDeleteShader(shader);
+        throw std::runtime_error(info_log);
+    }
+    ++this->counters.shaders;
+    return shader;
+}
+
+unsigned GlRenderDevice::create_program(unsigned vertex_shader, unsigned fragment_shader) {
+    unsigned program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    // check if linking is successful
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char info_log[512];
+        glGetProgramInfoLog(program, 512, nullptr, info_log);
+        glDeleteProgram(program);
+        throw std::runtime_error(info_log);
+    }
+    ++this->counters.programs;
+    return program;
+}
+
+void GlRenderDevice::destroy_shader(unsigned shader) {
+    glDeleteShader(shader);
+    --this->counters.shaders;
+}
+
+void GlRenderDevice::destroy_program(unsigned program) {
+    glDeleteProgram(program);
+    --this->counters.programs;
+}
+
+int GlRenderDevice::get_uniform_location(unsigned program, const string &name) {
+    return glGetUniformLocation(program, name.c_str());
+}
+
+void GlRenderDevice::bind_uniform_block(unsigned program, const string &name, unsigned binding) {
+    unsigned index = glGetUniformBlockIndex(program, name.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, index, binding);
+    }
+}
+
+void GlRenderDevice::use_program(unsigned program) {
+    glUseProgram(program);
+    ++this->counters.program_binds;
+}
+
+void GlRenderDevice::set_uniform(const UniformValue &value) {
+    switch (value.type) {
+        case UNIFORM_INT:
+            glUniform1i(value.location, value.data.i);
+            break;
+        case UNIFORM_UINT:
+            glUniform1ui(value.location, value.data.u);
+            break;
+        case UNIFORM_FLOAT:
+            glUniform1f(value.location, value.data.f[0]);
+            break;
+        case UNIFORM_VEC3:
+            glUniform3fv(value.location, 1, value.data.f);
+            break;
+        case UNIFORM_VEC4:
+            glUniform4fv(value.location, 1, value.data.f);
+            break;
+        case UNIFORM_MAT3:
+            glUniformMatrix3fv(value.location, 1, GL_FALSE, value.data.f);
+            break;
+        case UNIFORM_MAT4:
+            glUniformMatrix4fv(value.location, 1, GL_FALSE, value.data.f);
+            break;
+        default:
+            break;
+    }
+    ++this->counters.uniform_calls;
+}
+
+unsigned GlRenderDevice::create_buffer(GLenum target, size_t size, const void *data, GLenum usage) {
+    unsigned buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, static_cast<GLsizeiptr>(size), data, usage);
+    glBindBuffer(target, 0);
+    this->buffers[buffer] = {target, size, MemoryTracker::charge(MEMORY_GPU_BUFFERS, size)};
+    ++this->counters.buffers;
+    this->counters.buffer_bytes += size;
+    if (data) {
+        this->counters.bytes_uploaded += size;
+    }
+    return buffer;
+}
+
+void GlRenderDevice::update_buffer(unsigned buffer, size_t offset, size_t size, const void *data,
+                                   bool unsynchronized) {
+    GLenum target = this->buffers.at(buffer).target;
+    glBindBuffer(target, buffer);
+    void *destination = nullptr;
+    if (unsynchronized) {
+        destination = glMapBufferRange(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size),
+                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+    if (destination) {
+        std::memcpy(destination, data, size);
+        glUnmapBuffer(target);
+    } else {
+        glBufferSubData(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+    }
+    glBindBuffer(target, 0);
+    ++this->counters.buffer_updates;
+    this->counters.bytes_uploaded += size;
+}
+
+void GlRenderDevice::bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, static_cast<GLintptr>(offset),
+                      static_cast<GLsizeiptr>(size));
+}
+
+void GlRenderDevice::destroy_buffer(unsigned buffer) {
+    auto entry = this->buffers.find(buffer);
+    if (entry != this->buffers.end()) {
+        --this->counters.buffers;
+        this->counters.buffer_bytes -= entry->second.size;
+        MemoryTracker::release(entry->second.memory, entry->second.size);
+        this->buffers.erase(entry);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+size_t GlRenderDevice::get_uniform_buffer_alignment() const {
+    return this->uniform_buffer_alignment;
+}
+
+unsigned GlRenderDevice::create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                             unsigned attribute_count) {
+    unsigned vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    for (unsigned i = 0; i != attribute_count; ++i) {
+        const VertexAttribute &attribute = attributes[i];
+        glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE,
+                              static_cast<GLsizei>(attribute.stride),
+                              reinterpret_cast<void *>(static_cast<uintptr_t>(attribute.offset)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    ++this->counters.vertex_arrays;
+    return vertex_array;
+}
+
+void GlRenderDevice::destroy_vertex_array(unsigned vertex_array) {
+    glDeleteVertexArrays(1, &vertex_array);
+    --this->counters.vertex_arrays;
+}
+
+void GlRenderDevice::bind_vertex_array(unsigned vertex_array) {
+    glBindVertexArray(vertex_array);
+    ++this->counters.vertex_array_binds;
+}
+
+unsigned GlRenderDevice::create_texture_2d(int width, int height, GLenum format, const void *pixels) {
+    unsigned texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // default parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height,
+                 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    // the mip chain adds a third
+    size_t size = static_cast<size_t>(width) * height * (format == GL_RGB ? 3 : 4) * 4 / 3;
+    this->textures[texture] = {size, MemoryTracker::charge(MEMORY_GPU_TEXTURES, size)};
+    ++this->counters.textures;
+    this->counters.texture_bytes += size;
+    this->counters.bytes_uploaded += size * 3 / 4;
+    return texture;
+}
+
+void GlRenderDevice::set_texture_parameter(unsigned texture, GLenum parameter, int value) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, parameter, value);
+}
+
+void GlRenderDevice::bind_texture(unsigned unit, unsigned texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    ++this->counters.texture_binds;
+}
+
+void GlRenderDevice::destroy_texture(unsigned texture) {
+    auto entry = this->textures.find(texture);
+    if (entry != this->textures.end()) {
+        --this->counters.textures;
+        this->counters.texture_bytes -= entry->second.size;
+        MemoryTracker::release(entry->second.memory, entry->second.size);
+        this->textures.erase(entry);
+    }
+    glDeleteTextures(1, &texture);
+}
+
+unsigned GlRenderDevice::create_render_target(int width, int height, GLenum format, int levels) {
+    size_t size = get_render_target_size(width, height, format, levels);
+    GLenum pixel_format = GL_RGBA, pixel_type = GL_UNSIGNED_BYTE;
+    if (format == GL_R32F) {
+        pixel_format = GL_RED;
+        pixel_type = GL_FLOAT;
+    } else if (format == GL_RGBA16F) {
+        pixel_type = GL_FLOAT;
+    } else if (format == GL_DEPTH_COMPONENT24) {
+        pixel_format = GL_DEPTH_COMPONENT;
+        pixel_type = GL_UNSIGNED_INT;
+    } else if (format == GL_DEPTH_COMPONENT32F) {
+        pixel_format = GL_DEPTH_COMPONENT;
+        pixel_type = GL_FLOAT;
+    } else if (format == GL_DEPTH24_STENCIL8) {
+        pixel_format = GL_DEPTH_STENCIL;
+        pixel_type = GL_UNSIGNED_INT_24_8;
+    }
+    unsigned texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    for (int level = 0; level != levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(format), width, height, 0, pixel_format, pixel_type,
+                     nullptr);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    this->textures[texture] = {size, MemoryTracker::charge(MEMORY_GPU_RENDER_TARGETS, size)};
+    ++this->counters.textures;
+    this->counters.texture_bytes += size;
+    return texture;
+}
+
+void GlRenderDevice::set_viewport(int x, int y, int width, int height) {
+    glViewport(x, y, width, height);
+}
+
+void GlRenderDevice::set_scissor(bool enabled, int x, int y, int width, int height) {
+    if (enabled) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, width, height);
+    } else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void GlRenderDevice::clear(float red, float green, float blue, float alpha) {
+    glClearColor(red, green, blue, alpha);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    ++this->counters.clears;
+}
+
+void GlRenderDevice::set_depth_test(bool enabled) {
+    if (enabled) {
+        glEnable(GL_DEPTH_TEST);
+    } else {
+        glDisable(GL_DEPTH_TEST);
+    }
+}
+
+void GlRenderDevice::set_depth_write(bool enabled) {
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GlRenderDevice::set_depth_func(GLenum func) {
+    glDepthFunc(func);
+}
+
+void GlRenderDevice::set_color_write(bool enabled) {
+    GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+    glColorMask(mask, mask, mask, mask);
+}
+
+void GlRenderDevice::set_blend(bool enabled) {
+    if (enabled) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glDisable(GL_BLEND);
+    }
+}
+
+void GlRenderDevice::set_polygon_mode(GLenum mode) {
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GlRenderDevice::draw(GLenum mode, int first, int count, unsigned condition_query) {
+    if (condition_query) {
+        glBeginConditionalRender(condition_query, GL_QUERY_NO_WAIT);
+        glDrawArrays(mode, first, count);
+        glEndConditionalRender();
+    } else {
+        glDrawArrays(mode, first, count);
+    }
+    this->count_draw(mode, count);
+}
+
+void *GlRenderDevice::insert_fence() {
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void GlRenderDevice::wait_fence(void *fence) {
+    auto sync = static_cast<GLsync>(fence);
+    // flushing makes sure the fence is actually on its way to the GPU before we wait for it
+    while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    ++this->counters.fence_waits;
+}
+
+bool GlRenderDevice::is_fence_signaled(void *fence) {
+    GLenum result = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void GlRenderDevice::destroy_fence(void *fence) {
+    glDeleteSync(static_cast<GLsync>(fence));
+}
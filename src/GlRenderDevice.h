@@ -0,0 +1,82 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_GLRENDERDEVICE_H
+#define LEARNOPENGL_GLRENDERDEVICE_H
+
+#include <map>
+
+#include "MemoryTracker.h"
+#include "RenderDevice.h"
+
+// the OpenGL 3.3 core backend, handles are the GL object names, the context must be current on the calling thread
+class GlRenderDevice : public RenderDevice {
+
+public:
+    GlRenderDevice();
+
+    DeviceBackend get_backend() const override;
+
+    unsigned create_shader(GLenum stage, const string &source, const string &name) override;
+    unsigned create_program(unsigned vertex_shader, unsigned fragment_shader) override;
+    void destroy_shader(unsigned shader) override;
+    void destroy_program(unsigned program) override;
+    int get_uniform_location(unsigned program, const string &name) override;
+    void bind_uniform_block(unsigned program, const string &name, unsigned binding) override;
+    void use_program(unsigned program) override;
+    void set_uniform(const UniformValue &value) override;
+
+    unsigned create_buffer(GLenum target, size_t size, const void *data, GLenum usage) override;
+    void update_buffer(unsigned buffer, size_t offset, size_t size, const void *data, bool unsynchronized) override;
+    void bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) override;
+    void destroy_buffer(unsigned buffer) override;
+    size_t get_uniform_buffer_alignment() const override;
+
+    unsigned create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                 unsigned attribute_count) override;
+    void destroy_vertex_array(unsigned vertex_array) override;
+    void bind_vertex_array(unsigned vertex_array) override;
+
+    unsigned create_texture_2d(int width, int height, GLenum format, const void *pixels) override;
+    void set_texture_parameter(unsigned texture, GLenum parameter, int value) override;
+    void bind_texture(unsigned unit, unsigned texture) override;
+    void destroy_texture(unsigned texture) override;
+    unsigned create_render_target(int width, int height, GLenum format, int levels) override;
+
+    void set_viewport(int x, int y, int width, int height) override;
+    void set_scissor(bool enabled, int x, int y, int width, int height) override;
+    void clear(float red, float green, float blue, float alpha) override;
+    void set_depth_test(bool enabled) override;
+    void set_depth_write(bool enabled) override;
+    void set_depth_func(GLenum func) override;
+    void set_color_write(bool enabled) override;
+    void set_blend(bool enabled) override;
+    void set_polygon_mode(GLenum mode) override;
+    void draw(GLenum mode, int first, int count, unsigned condition_query) override;
+
+    void *insert_fence() override;
+    void wait_fence(void *fence) override;
+    bool is_fence_signaled(void *fence) override;
+    void destroy_fence(void *fence) override;
+
+private:
+    struct BufferInfo {
+        GLenum target;
+        size_t size;
+        MemoryTracker::Consumer *memory;
+    };
+
+    // textures and render targets
+    struct TextureInfo {
+        size_t size;
+        MemoryTracker::Consumer *memory;
+    };
+
+    std::map<unsigned, BufferInfo> buffers;
+    std::map<unsigned, TextureInfo> textures;
+    size_t uniform_buffer_alignment = 256;
+};
+
+
+#endif //LEARNOPENGL_GLRENDERDEVICE_H
@@ -0,0 +1,137 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "GpuOcclusionCuller.h"
+
+#include "RenderDevice.h"
+
+// the proxy boxes are inflated a little so they do not z-fight with the faces of the object they bound
+#define BOX_INFLATION 1.01F
+
+GpuOcclusionCuller::GpuOcclusionCuller(unsigned box_vao, int box_vertex_count) :
+        pool(GL_ANY_SAMPLES_PASSED),
+        box_shader("resource/shader/bounding_box_vertex_shader.glsl",
+                   "resource/shader/bounding_box_fragment_shader.glsl"),
+        box_vao(box_vao),
+        box_vertex_count(box_vertex_count) {
+}
+
+GpuOcclusionCuller::~GpuOcclusionCuller() {
+    // queries still in flight go back to the pool so its destructor deletes them
+    for (auto &state : this->objects) {
+        if (state.pending_query) {
+            this->pool.release(state.pending_query);
+        }
+    }
+}
+
+bool GpuOcclusionCuller::draw(unsigned object, const std::function<void()> &draw_object) {
+    unsigned condition_query;
+    if (!this->prepare_draw(object, condition_query)) {
+        return false;
+    }
+    if (condition_query) {
+        // if the query is done by the time the GPU gets here it drops the draw, otherwise it just draws
+        glBeginConditionalRender(condition_query, GL_QUERY_NO_WAIT);
+        draw_object();
+        glEndConditionalRender();
+    } else {
+        draw_object();
+    }
+    return true;
+}
+
+bool GpuOcclusionCuller::prepare_draw(unsigned object, unsigned &condition_query) {
+    ObjectState &state = this->get_state(object);
+    this->resolve(state);
+    condition_query = state.pending_query;
+    if (state.pending_query) {
+        ++this->stats.draws_conditional;
+    } else if (state.visible) {
+        ++this->stats.draws_unconditional;
+    } else {
+        ++this->stats.draws_skipped;
+        return false;
+    }
+    return true;
+}
+
+void GpuOcclusionCuller::begin_queries(const mat4 &view_projection, const vec3 &camera_position_v) {
+    this->camera_position = camera_position_v;
+    this->box_shader.use();
+    this->box_shader.set_uniform("view_projection_matrix", view_projection);
+    glBindVertexArray(this->box_vao);
+    RenderDevice::get_current().add_binds(0, 1, 0);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+}
+
+void GpuOcclusionCuller::query(unsigned object, const vec3 &center, const vec3 &extent) {
+    ObjectState &state = this->get_state(object);
+    this->resolve(state);
+    if (state.pending_query) {
+        // one query in flight per object is enough
+        return;
+    }
+
+    vec3 box_extent = extent * BOX_INFLATION;
+    vec3 distance = glm::abs(this->camera_position - center);
+    if (distance.x <= box_extent.x && distance.y <= box_extent.y && distance.z <= box_extent.z) {
+        // the box would be clipped away by the near plane, so it cannot tell us anything
+        state.visible = true;
+        return;
+    }
+
+    state.pending_query = this->pool.acquire();
+    this->box_shader.set_uniform("box_center", center);
+    this->box_shader.set_uniform("box_extent", box_extent);
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, state.pending_query);
+    glDrawArrays(GL_TRIANGLES, 0, this->box_vertex_count);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    RenderDevice::get_current().add_draw(GL_TRIANGLES, this->box_vertex_count);
+    ++this->stats.queries_issued;
+}
+
+void GpuOcclusionCuller::end_queries() {
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+}
+
+void GpuOcclusionCuller::reset_stats() {
+    this->stats = Stats();
+}
+
+const GpuOcclusionCuller::Stats &GpuOcclusionCuller::get_stats() const {
+    return this->stats;
+}
+
+size_t GpuOcclusionCuller::get_pool_size() const {
+    return this->pool.get_allocated_count();
+}
+
+GpuOcclusionCuller::ObjectState &GpuOcclusionCuller::get_state(unsigned object) {
+    if (object >= this->objects.size()) {
+        this->objects.resize(object + 1);
+    }
+    return this->objects[object];
+}
+
+void GpuOcclusionCuller::resolve(ObjectState &state) {
+    if (!state.pending_query) {
+        return;
+    }
+    int available = 0;
+    glGetQueryObjectiv(state.pending_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        ++this->stats.results_pending;
+        return;
+    }
+    unsigned any_samples = 0;
+    glGetQueryObjectuiv(state.pending_query, GL_QUERY_RESULT, &any_samples);
+    RenderDevice::get_current().add_query_reads(1);
+    state.visible = any_samples != 0;
+    this->pool.release(state.pending_query);
+    state.pending_query = 0;
+    ++this->stats.results_read;
+}
@@ -0,0 +1,81 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_GPUOCCLUSIONCULLER_H
+#define LEARNOPENGL_GPUOCCLUSIONCULLER_H
+
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "QueryPool.h"
+#include "Shader.h"
+
+using glm::vec3;
+using glm::mat4;
+
+// hardware occlusion culling with GL_ANY_SAMPLES_PASSED queries on bounding boxes rendered after the opaque pass,
+// the results are never waited for: once a result has arrived it decides whether the object is skipped, while it is
+// still in flight the object is drawn with conditional rendering and GL_QUERY_NO_WAIT
+class GpuOcclusionCuller {
+
+public:
+    struct Stats {
+        unsigned queries_issued = 0;
+        unsigned results_read = 0;
+        // still in flight when we wanted to look at them
+        unsigned results_pending = 0;
+        unsigned draws_skipped = 0;
+        unsigned draws_conditional = 0;
+        unsigned draws_unconditional = 0;
+    };
+
+    // box_vao must contain a unit cube centered at the origin as a triangle list
+    GpuOcclusionCuller(unsigned box_vao, int box_vertex_count);
+    ~GpuOcclusionCuller();
+
+    GpuOcclusionCuller(const GpuOcclusionCuller &) = delete;
+    GpuOcclusionCuller &operator=(const GpuOcclusionCuller &) = delete;
+
+    // calls draw_object unless the object is known to be hidden, returns whether it was called
+    bool draw(unsigned object, const std::function<void()> &draw_object);
+    // the same decision for draws that are recorded now and issued later, returns false if the object is skipped and
+    // otherwise the query to draw it conditionally with in condition_query, 0 if it is drawn plainly
+    bool prepare_draw(unsigned object, unsigned &condition_query);
+
+    // after the opaque pass, changes the program, the VAO and the color and depth masks
+    void begin_queries(const mat4 &view_projection, const vec3 &camera_position);
+    // renders the bounding box of the object into a query unless the previous one is still in flight
+    void query(unsigned object, const vec3 &center, const vec3 &extent);
+    // restores the color and depth masks
+    void end_queries();
+    // clears the stats, call it once per frame before the first draw()
+    void reset_stats();
+
+    const Stats &get_stats() const;
+    size_t get_pool_size() const;
+
+private:
+    struct ObjectState {
+        // the last query that has not been read yet
+        unsigned pending_query = 0;
+        bool visible = true;
+    };
+
+    QueryPool pool;
+    Shader box_shader;
+    unsigned box_vao;
+    int box_vertex_count;
+    vec3 camera_position;
+    std::vector<ObjectState> objects;
+    Stats stats;
+
+    ObjectState &get_state(unsigned object);
+    // reads the pending query of the object if the GPU is done with it, never waits
+    void resolve(ObjectState &state);
+};
+
+
+#endif //LEARNOPENGL_GPUOCCLUSIONCULLER_H
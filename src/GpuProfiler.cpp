@@ -0,0 +1,239 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "RenderDevice.h"
+
+// measurements of a zone the rolling statistics are over
+#define GPU_PROFILER_WINDOW 120
+// measurements in flight at most, a few frames of all the zones
+#define GPU_PROFILER_MAX_TIMINGS 256
+// the layout of the overlay in pixels
+#define GPU_PROFILER_MARGIN 10.0F
+#define GPU_PROFILER_ROW_HEIGHT 8.0F
+#define GPU_PROFILER_ROW_GAP 3.0F
+#define GPU_PROFILER_INDENT 6.0F
+#define GPU_PROFILER_BAR_OFFSET 40.0F
+#define GPU_PROFILER_BAR_WIDTH 240.0F
+#define GPU_PROFILER_MARK_WIDTH 2.0F
+// floats of a vertex: position and color
+#define GPU_PROFILER_VERTEX_SIZE 5
+
+// the colors of the zones, in the order of the zones
+static const glm::vec3 ZONE_COLORS[] = {
+        {0.9F, 0.3F, 0.3F}, {0.3F, 0.8F, 0.3F}, {0.3F, 0.5F, 0.9F}, {0.9F, 0.8F, 0.2F},
+        {0.8F, 0.4F, 0.9F}, {0.2F, 0.8F, 0.8F}, {0.9F, 0.6F, 0.2F}, {0.7F, 0.7F, 0.7F}
+};
+
+GpuProfiler::Scope::Scope(GpuProfiler &profiler_i, const string &name) : profiler(profiler_i) {
+    this->profiler.begin(name);
+}
+
+GpuProfiler::Scope::~Scope() {
+    this->profiler.end();
+}
+
+GpuProfiler::GpuProfiler() :
+        timer(GPU_PROFILER_MAX_TIMINGS),
+        overlay_shader("resource/shader/profiler_vertex_shader.glsl",
+                       "resource/shader/profiler_fragment_shader.glsl"),
+        viewport_size_location(overlay_shader.get_uniform_location("viewport_size")) {
+    glGenVertexArrays(1, &this->overlay_vao);
+    glGenBuffers(1, &this->overlay_vbo);
+    RenderDevice::get_current().add_objects(1, 1, 0);
+    glBindVertexArray(this->overlay_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, this->overlay_vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, GPU_PROFILER_VERTEX_SIZE * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, GPU_PROFILER_VERTEX_SIZE * sizeof(float),
+                          reinterpret_cast<void *>(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GpuProfiler::~GpuProfiler() {
+    MemoryTracker::release(this->overlay_memory, this->overlay_bytes);
+    glDeleteBuffers(1, &this->overlay_vbo);
+    glDeleteVertexArrays(1, &this->overlay_vao);
+    RenderDevice &device = RenderDevice::get_current();
+    device.add_objects(-1, -1, 0);
+    device.add_buffer_bytes(-static_cast<long long>(this->overlay_bytes));
+}
+
+void GpuProfiler::begin(const string &name) {
+    unsigned zone = this->find_zone(name, this->open.empty() ? NO_PARENT : this->open.back());
+    this->open.push_back(zone);
+    this->timer.begin(zone);
+}
+
+void GpuProfiler::end() {
+    if (this->open.empty()) {
+        return;
+    }
+    this->open.pop_back();
+    this->timer.end();
+}
+
+void GpuProfiler::poll() {
+    this->timer.poll([this](unsigned zone_index, double milliseconds) {
+        Zone &zone = this->zones[zone_index];
+        if (zone.samples.size() < GPU_PROFILER_WINDOW) {
+            zone.samples.push_back(milliseconds);
+        } else {
+            zone.samples[zone.next_sample] = milliseconds;
+        }
+        zone.next_sample = (zone.next_sample + 1) % GPU_PROFILER_WINDOW;
+        ++zone.count;
+    });
+}
+
+unsigned GpuProfiler::find_zone(const string &name, unsigned parent) {
+    for (size_t i = 0; i != this->zones.size(); ++i) {
+        if (this->zones[i].parent == parent && this->zones[i].name == name) {
+            return static_cast<unsigned>(i);
+        }
+    }
+    unsigned depth = parent == NO_PARENT ? 0 : this->zones[parent].depth + 1;
+    this->zones.push_back({name, parent, depth, {}, 0, 0});
+    return static_cast<unsigned>(this->zones.size() - 1);
+}
+
+std::vector<unsigned> GpuProfiler::get_tree_order() const {
+    std::vector<unsigned> order;
+    std::vector<unsigned> stack;
+    // depth first, the children of a zone in the order they were first begun
+    for (size_t i = this->zones.size(); i-- != 0;) {
+        if (this->zones[i].parent == NO_PARENT) {
+            stack.push_back(static_cast<unsigned>(i));
+        }
+    }
+    while (!stack.empty()) {
+        unsigned zone = stack.back();
+        stack.pop_back();
+        order.push_back(zone);
+        for (size_t i = this->zones.size(); i-- != zone + 1;) {
+            if (this->zones[i].parent == zone) {
+                stack.push_back(static_cast<unsigned>(i));
+            }
+        }
+    }
+    return order;
+}
+
+std::vector<GpuProfiler::ZoneStats> GpuProfiler::get_stats() const {
+    std::vector<unsigned> order = this->get_tree_order();
+    std::vector<ZoneStats> stats(order.size());
+    std::vector<double> sorted;
+    for (size_t i = 0; i != order.size(); ++i) {
+        const Zone &zone = this->zones[order[i]];
+        ZoneStats &zone_stats = stats[i];
+        zone_stats.name = zone.name;
+        zone_stats.depth = zone.depth;
+        zone_stats.samples = zone.count;
+        if (zone.samples.empty()) {
+            continue;
+        }
+        sorted = zone.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double sample : sorted) {
+            sum += sample;
+        }
+        // the sample that 99% of them are at or below
+        size_t p99 = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(sorted.size()))) - 1;
+        zone_stats.min_ms = sorted.front();
+        zone_stats.average_ms = sum / static_cast<double>(sorted.size());
+        zone_stats.p99_ms = sorted[p99];
+        zone_stats.last_ms = zone.samples[(zone.next_sample + zone.samples.size() - 1) % zone.samples.size()];
+    }
+    return stats;
+}
+
+unsigned long long GpuProfiler::get_dropped() const {
+    return this->timer.get_dropped();
+}
+
+void GpuProfiler::add_rectangle(float x, float y, float width, float height, const glm::vec3 &color) {
+    const float corners[6][2] = {{x, y}, {x + width, y}, {x + width, y + height},
+                                 {x, y}, {x + width, y + height}, {x, y + height}};
+    for (const auto &corner : corners) {
+        this->overlay_vertices.insert(this->overlay_vertices.end(),
+                                      {corner[0], corner[1], color.r, color.g, color.b});
+    }
+}
+
+void GpuProfiler::draw_overlay(int width, int height, double budget_ms) {
+    std::vector<ZoneStats> stats = this->get_stats();
+    this->overlay_vertices.clear();
+    float scale = GPU_PROFILER_BAR_WIDTH / static_cast<float>(budget_ms);
+    for (size_t i = 0; i != stats.size(); ++i) {
+        const ZoneStats &zone = stats[i];
+        glm::vec3 color = ZONE_COLORS[i % (sizeof(ZONE_COLORS) / sizeof(ZONE_COLORS[0]))];
+        float y = GPU_PROFILER_MARGIN + static_cast<float>(i) * (GPU_PROFILER_ROW_HEIGHT + GPU_PROFILER_ROW_GAP);
+        float bar_x = GPU_PROFILER_MARGIN + GPU_PROFILER_BAR_OFFSET;
+        // a swatch indented by the nesting, then the budget with the zone on it
+        this->add_rectangle(GPU_PROFILER_MARGIN + static_cast<float>(zone.depth) * GPU_PROFILER_INDENT, y,
+                            GPU_PROFILER_ROW_HEIGHT, GPU_PROFILER_ROW_HEIGHT, color);
+        this->add_rectangle(bar_x, y, GPU_PROFILER_BAR_WIDTH, GPU_PROFILER_ROW_HEIGHT, glm::vec3(0.15F));
+        if (zone.min_ms < 0) {
+            continue;
+        }
+        float min_x = std::min(static_cast<float>(zone.min_ms) * scale, GPU_PROFILER_BAR_WIDTH);
+        float p99_x = std::min(static_cast<float>(zone.p99_ms) * scale, GPU_PROFILER_BAR_WIDTH);
+        float average_x = std::min(static_cast<float>(zone.average_ms) * scale,
+                                   GPU_PROFILER_BAR_WIDTH - GPU_PROFILER_MARK_WIDTH);
+        this->add_rectangle(bar_x, y, min_x, GPU_PROFILER_ROW_HEIGHT, color * 0.35F);
+        this->add_rectangle(bar_x + min_x, y, std::max(p99_x - min_x, 1.0F), GPU_PROFILER_ROW_HEIGHT, color * 0.7F);
+        this->add_rectangle(bar_x + average_x, y, GPU_PROFILER_MARK_WIDTH, GPU_PROFILER_ROW_HEIGHT, glm::vec3(1.0F));
+    }
+    if (this->overlay_vertices.empty()) {
+        return;
+    }
+
+    int program, vao, array_buffer, polygon_mode[2];
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+    glGetIntegerv(GL_POLYGON_MODE, polygon_mode);
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+
+    glDisable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    this->overlay_shader.use();
+    glUniform2f(this->viewport_size_location, static_cast<float>(width), static_cast<float>(height));
+    glBindVertexArray(this->overlay_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, this->overlay_vbo);
+    // orphaned every frame, the driver hands out a fresh buffer while the last one is still drawn from
+    size_t overlay_bytes = this->overlay_vertices.size() * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(overlay_bytes), this->overlay_vertices.data(),
+                 GL_STREAM_DRAW);
+    RenderDevice &device = RenderDevice::get_current();
+    if (overlay_bytes != this->overlay_bytes) {
+        MemoryTracker::release(this->overlay_memory, this->overlay_bytes);
+        MemoryTracker::Scope memory_scope("gpu profiler");
+        this->overlay_memory = MemoryTracker::charge(MEMORY_GPU_BUFFERS, overlay_bytes);
+        device.add_buffer_bytes(static_cast<long long>(overlay_bytes) - static_cast<long long>(this->overlay_bytes));
+        this->overlay_bytes = overlay_bytes;
+    }
+    int overlay_vertex_count = static_cast<int>(this->overlay_vertices.size() / GPU_PROFILER_VERTEX_SIZE);
+    glDrawArrays(GL_TRIANGLES, 0, overlay_vertex_count);
+    device.add_binds(0, 1, 0);
+    device.add_uniform_calls(1);
+    device.add_buffer_update(overlay_bytes);
+    device.add_draw(GL_TRIANGLES, overlay_vertex_count);
+
+    glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygon_mode[0]));
+    if (depth_test) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<unsigned>(array_buffer));
+    glBindVertexArray(vao);
+    glUseProgram(program);
+    device.add_binds(1, 1, 0);
+}
@@ -0,0 +1,102 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_GPUPROFILER_H
+#define LEARNOPENGL_GPUPROFILER_H
+
+#include <vector>
+#include <glad/glad.h>
+
+#include "GpuTimer.h"
+#include "MemoryTracker.h"
+#include "Shader.h"
+
+// GPU time of named zones, e.g. the passes of the frame graph and scopes inside them: zones are told apart by their
+// name and the zone they are nested in, their timestamp queries are read back through a ring that spans several
+// frames so reading never waits for the GPU, the last measurements of every zone give a rolling min, average and 99th
+// percentile, which an overlay draws as bars in the top left corner of the screen
+class GpuProfiler {
+
+public:
+    struct ZoneStats {
+        string name;
+        // how many zones it is nested in
+        unsigned depth = 0;
+        // over the last GPU_PROFILER_WINDOW measurements, negative until there is one
+        double min_ms = -1;
+        double average_ms = -1;
+        double p99_ms = -1;
+        double last_ms = -1;
+        unsigned long long samples = 0;
+    };
+
+    // ends the zone it began when it goes out of scope
+    class Scope {
+
+    public:
+        Scope(GpuProfiler &profiler, const string &name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        GpuProfiler &profiler;
+    };
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+    // starts a zone inside the innermost one that was begun and not ended
+    void begin(const string &name);
+    void end();
+    // picks up the finished measurements, never waits
+    void poll();
+
+    // the zones depth first, i.e. every zone right after the one it is nested in or its siblings begun before it
+    std::vector<ZoneStats> get_stats() const;
+    // measurements dropped because the whole ring was still in flight
+    unsigned long long get_dropped() const;
+
+    // draws a bar per zone into the current framebuffer of width x height, the bars span from the minimum to the 99th
+    // percentile with a mark at the average, budget_ms is the full width, restores what it changes
+    void draw_overlay(int width, int height, double budget_ms);
+
+private:
+    struct Zone {
+        string name;
+        // index of the zone it is nested in, NO_PARENT at the top
+        unsigned parent;
+        unsigned depth;
+        // a ring of the last measurements
+        std::vector<double> samples;
+        size_t next_sample;
+        unsigned long long count;
+    };
+
+    static const unsigned NO_PARENT = ~0U;
+
+    GpuTimer timer;
+    std::vector<Zone> zones;
+    // the zones begun and not ended, innermost last
+    std::vector<unsigned> open;
+    Shader overlay_shader;
+    int viewport_size_location;
+    unsigned overlay_vao = 0;
+    unsigned overlay_vbo = 0;
+    // what the buffer holds since the last upload
+    size_t overlay_bytes = 0;
+    MemoryTracker::Consumer *overlay_memory = nullptr;
+    std::vector<float> overlay_vertices;
+
+    unsigned find_zone(const string &name, unsigned parent);
+    std::vector<unsigned> get_tree_order() const;
+    void add_rectangle(float x, float y, float width, float height, const glm::vec3 &color);
+};
+
+
+#endif //LEARNOPENGL_GPUPROFILER_H
@@ -0,0 +1,75 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "GpuTimer.h"
+
+#include "RenderDevice.h"
+
+// measurements in flight at most by default, more are not started until the oldest ones have arrived
+#define GPU_TIMER_MAX_TIMINGS 8
+
+GpuTimer::GpuTimer() : GpuTimer(GPU_TIMER_MAX_TIMINGS) {}
+
+GpuTimer::GpuTimer(size_t max_timings_i) : queries(GL_TIMESTAMP), max_timings(max_timings_i) {}
+
+GpuTimer::~GpuTimer() {
+    // queries still in flight go back to the pool so its destructor deletes them
+    for (const Timing &timing : this->timings) {
+        this->queries.release(timing.start);
+        this->queries.release(timing.end);
+    }
+    for (const Timing &timing : this->open) {
+        if (timing.start) {
+            this->queries.release(timing.start);
+            this->queries.release(timing.end);
+        }
+    }
+}
+
+void GpuTimer::begin(unsigned tag) {
+    if (this->timings.size() + this->open.size() >= this->max_timings) {
+        ++this->dropped;
+        this->open.push_back({0, 0, tag});
+        return;
+    }
+    this->open.push_back({this->queries.acquire(), this->queries.acquire(), tag});
+    glQueryCounter(this->open.back().start, GL_TIMESTAMP);
+}
+
+void GpuTimer::end() {
+    if (this->open.empty()) {
+        return;
+    }
+    Timing timing = this->open.back();
+    this->open.pop_back();
+    if (!timing.start) {
+        return;
+    }
+    glQueryCounter(timing.end, GL_TIMESTAMP);
+    this->timings.push_back(timing);
+}
+
+void GpuTimer::poll(const std::function<void(unsigned, double)> &done) {
+    // the timings finish in the order they ended, so the first one still in flight ends the loop
+    while (!this->timings.empty()) {
+        Timing timing = this->timings.front();
+        GLint available = 0;
+        glGetQueryObjectiv(timing.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(timing.start, GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(timing.end, GL_QUERY_RESULT, &end);
+        RenderDevice::get_current().add_query_reads(2);
+        this->queries.release(timing.start);
+        this->queries.release(timing.end);
+        this->timings.pop_front();
+        done(timing.tag, static_cast<double>(end - start) / 1e6);
+    }
+}
+
+unsigned long long GpuTimer::get_dropped() const {
+    return this->dropped;
+}
@@ -0,0 +1,56 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_GPUTIMER_H
+#define LEARNOPENGL_GPUTIMER_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "QueryPool.h"
+
+// measures how long the GPU takes for a span of commands with a pair of GL_TIMESTAMP queries, the results are picked
+// up frames later without waiting, so the measurements of different timers overlap freely and the ones of a timer
+// nest, each one carries a tag of the caller
+class GpuTimer {
+
+public:
+    GpuTimer();
+    // max_timings is how many measurements may be in flight, i.e. begun and not polled yet
+    explicit
+    GpuTimer(size_t max_timings);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // starts a measurement, when too many are still in flight it is dropped and its end() does nothing
+    void begin(unsigned tag);
+    // ends the innermost measurement that was begun
+    void end();
+    // calls done with the tag and the milliseconds of every finished measurement, oldest first, never waits
+    void poll(const std::function<void(unsigned, double)> &done);
+
+    // measurements dropped because too many were in flight
+    unsigned long long get_dropped() const;
+
+private:
+    struct Timing {
+        unsigned start;
+        unsigned end;
+        unsigned tag;
+    };
+
+    QueryPool queries;
+    size_t max_timings;
+    std::deque<Timing> timings;
+    // the measurements begun and not ended, innermost last, dropped ones have no start query
+    std::vector<Timing> open;
+    unsigned long long dropped = 0;
+};
+
+
+#endif //LEARNOPENGL_GPUTIMER_H
@@ -0,0 +1,158 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "HeadlessContext.h"
+
+#include <stdexcept>
+#include <glad/glad.h>
+
+#include "RenderDevice.h"
+
+#ifdef LEARNOPENGL_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+bool HeadlessContext::is_supported() {
+#ifdef LEARNOPENGL_EGL
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef LEARNOPENGL_EGL
+
+HeadlessContext::HeadlessContext(int width_i, int height_i) : width(width_i), height(height_i) {
+    // the surfaceless platform needs neither a window system nor a GPU, older EGLs only have the default display
+    EGLDisplay egl_display = EGL_NO_DISPLAY;
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display) {
+        egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (egl_display == EGL_NO_DISPLAY) {
+        egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor)) {
+        throw std::runtime_error("Failed to initialize EGL!");
+    }
+    this->display = egl_display;
+
+    const EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint config_count = 0;
+    eglChooseConfig(egl_display, config_attributes, &config, 1, &config_count);
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(egl_display);
+        throw std::runtime_error("EGL has no desktop OpenGL!");
+    }
+    const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+    };
+    // without a surface the config does not matter, EGL_KHR_no_config_context allows none at all
+    EGLContext egl_context = eglCreateContext(egl_display, config_count ? config : EGL_NO_CONFIG_KHR,
+                                              EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+        if (egl_context != EGL_NO_CONTEXT) {
+            eglDestroyContext(egl_display, egl_context);
+        }
+        eglTerminate(egl_display);
+        throw std::runtime_error("Failed to create a headless OpenGL 3.3 core context!");
+    }
+    this->context = egl_context;
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+        this->release();
+        throw std::runtime_error("Failed to initialize GLAD!");
+    }
+
+    // there is no default framebuffer, this one takes its place
+    glGenFramebuffers(1, &this->framebuffer);
+    glGenRenderbuffers(2, this->renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        this->release();
+        throw std::runtime_error("Failed to create the headless framebuffer!");
+    }
+    glViewport(0, 0, width, height);
+    MemoryTracker::Scope memory_scope("headless framebuffer");
+    this->memory_size = RenderDevice::get_render_target_size(width, height, GL_RGBA8, 1) +
+                        RenderDevice::get_render_target_size(width, height, GL_DEPTH_COMPONENT24, 1);
+    this->memory = MemoryTracker::charge(MEMORY_GPU_RENDER_TARGETS, this->memory_size);
+}
+
+HeadlessContext::~HeadlessContext() {
+    this->release();
+}
+
+void HeadlessContext::release() {
+    if (!this->display) {
+        return;
+    }
+    if (this->memory) {
+        MemoryTracker::release(this->memory, this->memory_size);
+        this->memory = nullptr;
+    }
+    if (this->context) {
+        glDeleteFramebuffers(1, &this->framebuffer);
+        glDeleteRenderbuffers(2, this->renderbuffers);
+        eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(this->display, this->context);
+    }
+    eglTerminate(this->display);
+    this->display = nullptr;
+    this->context = nullptr;
+}
+
+string HeadlessContext::get_renderer() const {
+    return string(reinterpret_cast<const char *>(glGetString(GL_RENDERER))) + ", " +
+           reinterpret_cast<const char *>(glGetString(GL_VERSION));
+}
+
+std::vector<unsigned char> HeadlessContext::read_pixels() const {
+    std::vector<unsigned char> pixels(static_cast<size_t>(this->width) * this->height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->framebuffer);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+#else
+
+HeadlessContext::HeadlessContext(int width_i, int height_i) : width(width_i), height(height_i) {
+    throw std::runtime_error("Built without EGL, there are no headless OpenGL contexts!");
+}
+
+HeadlessContext::~HeadlessContext() = default;
+
+void HeadlessContext::release() {}
+
+string HeadlessContext::get_renderer() const {
+    return "";
+}
+
+std::vector<unsigned char> HeadlessContext::read_pixels() const {
+    return {};
+}
+
+#endif
+
+int HeadlessContext::get_width() const {
+    return this->width;
+}
+
+int HeadlessContext::get_height() const {
+    return this->height;
+}
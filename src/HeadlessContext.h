@@ -0,0 +1,53 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_HEADLESSCONTEXT_H
+#define LEARNOPENGL_HEADLESSCONTEXT_H
+
+#include <string>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+using std::string;
+
+// an OpenGL 3.3 core context without a window or a display server: EGL on the surfaceless platform of Mesa (e.g.
+// llvmpipe) or the default display, made current on the calling thread with glad loaded, and a framebuffer object of
+// the requested size bound where the default framebuffer would be, only available when built with EGL
+class HeadlessContext {
+
+public:
+    // throws if there is no EGL or no context
+    HeadlessContext(int width, int height);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+    static bool is_supported();
+
+    int get_width() const;
+    int get_height() const;
+    // GL_RENDERER and GL_VERSION
+    string get_renderer() const;
+    // RGBA8 with the bottom row first, waits for the GPU
+    std::vector<unsigned char> read_pixels() const;
+
+private:
+    int width;
+    int height;
+    void *display = nullptr;
+    void *context = nullptr;
+    unsigned framebuffer = 0;
+    unsigned renderbuffers[2] = {0, 0};
+    // the renderbuffers are charged to MEMORY_GPU_RENDER_TARGETS
+    MemoryTracker::Consumer *memory = nullptr;
+    size_t memory_size = 0;
+
+    // destroys whatever was created
+    void release();
+};
+
+
+#endif //LEARNOPENGL_HEADLESSCONTEXT_H
@@ -0,0 +1,435 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "HiZPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HIZ_SSE 1
+#endif
+
+#include "RenderDevice.h"
+
+// the GPU reduces until both sides are at most this big, that level is what gets read back
+#define HIZ_READBACK_SIZE 128
+#define HIZ_READBACK_RING 3
+// a texture unit nobody else uses, so the bindings of the scene survive the reduction
+#define HIZ_TEXTURE_UNIT 7
+// beyond this camera movement since the depth was captured we do not trust it at all
+#define HIZ_MAX_CAMERA_MOTION 0.5F
+// corners closer than this (in clip space w) make the box visible
+#define HIZ_NEAR_W 1e-4F
+
+HiZPyramid::HiZPyramid() :
+        reduce_shader("resource/shader/fullscreen_vertex_shader.glsl",
+                      "resource/shader/hiz_reduce_fragment_shader.glsl"),
+        readbacks(HIZ_READBACK_RING) {
+    glGenVertexArrays(1, &this->empty_vao);
+    glGenFramebuffers(1, &this->framebuffer);
+    RenderDevice::get_current().add_objects(0, 1, 1);
+    this->reduce_shader.use();
+    this->reduce_shader.set_uniform("source", HIZ_TEXTURE_UNIT);
+    glUseProgram(0);
+}
+
+HiZPyramid::~HiZPyramid() {
+    this->release();
+    glDeleteFramebuffers(1, &this->framebuffer);
+    glDeleteVertexArrays(1, &this->empty_vao);
+    RenderDevice::get_current().add_objects(0, -1, -1);
+}
+
+void HiZPyramid::allocate(int width_i, int height_i) {
+    this->release();
+    this->width = width_i;
+    this->height = height_i;
+
+    // level 0 of the pyramid is already half the resolution of the depth buffer
+    this->level_sizes.clear();
+    glm::ivec2 size(width_i, height_i);
+    do {
+        size = glm::max(size / 2, glm::ivec2(1));
+        this->level_sizes.push_back(size);
+    } while (size.x > HIZ_READBACK_SIZE || size.y > HIZ_READBACK_SIZE);
+
+    MemoryTracker::Scope memory_scope("hi-z pyramid");
+    RenderDevice &device = RenderDevice::get_current();
+    const glm::ivec2 &readback_size = this->level_sizes.back();
+    this->readback_bytes = readback_size.x * readback_size.y * sizeof(float);
+    for (auto &readback : this->readbacks) {
+        glGenBuffers(1, &readback.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(this->readback_bytes), nullptr, GL_STREAM_READ);
+        readback.memory = MemoryTracker::charge(MEMORY_GPU_BUFFERS, this->readback_bytes);
+        device.add_objects(1, 0, 0);
+        device.add_buffer_bytes(static_cast<long long>(this->readback_bytes));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // the CPU levels keep going down to a single texel
+    this->cpu_level_sizes.assign(1, readback_size);
+    while (size.x > 1 || size.y > 1) {
+        size = glm::max(size / 2, glm::ivec2(1));
+        this->cpu_level_sizes.push_back(size);
+    }
+    this->cpu_levels.resize(this->cpu_level_sizes.size());
+    for (size_t level = 0; level != this->cpu_levels.size(); ++level) {
+        this->cpu_levels[level].resize(this->cpu_level_sizes[level].x * this->cpu_level_sizes[level].y);
+    }
+    this->has_cpu_depth = false;
+}
+
+void HiZPyramid::release() {
+    for (auto &readback : this->readbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+        if (readback.pbo) {
+            MemoryTracker::release(readback.memory, this->readback_bytes);
+            readback.memory = nullptr;
+            glDeleteBuffers(1, &readback.pbo);
+            RenderDevice &device = RenderDevice::get_current();
+            device.add_objects(-1, 0, 0);
+            device.add_buffer_bytes(-static_cast<long long>(this->readback_bytes));
+            readback.pbo = 0;
+        }
+    }
+}
+
+void HiZPyramid::add_passes(FrameGraph &graph, FrameGraph::Resource depth, const mat4 &view_projection,
+                            const vec3 &camera_position) {
+    const FrameGraph::TextureDescription &depth_description = graph.get_description(depth);
+    if (depth_description.width <= 0 || depth_description.height <= 0) {
+        return;
+    }
+    if (depth_description.width != this->width || depth_description.height != this->height) {
+        this->allocate(depth_description.width, depth_description.height);
+    }
+    ++this->frame;
+
+    // copy the depth of the opaque pass
+    graph.add_pass("hi-z depth copy", [&](FrameGraph::Builder &builder) {
+        builder.read(depth);
+        this->depth_copy = builder.create("hi-z depth", {this->width, this->height, GL_DEPTH_COMPONENT24, 1});
+    }, [this, &graph] {
+        int active_texture;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+        glActiveTexture(GL_TEXTURE0 + HIZ_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, graph.get_texture(this->depth_copy));
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, this->width, this->height);
+        glActiveTexture(active_texture);
+    });
+
+    // every level takes the max of the 2x2 (3x3 at odd edges) texels of the previous one
+    graph.add_pass("hi-z reduce", [&](FrameGraph::Builder &builder) {
+        builder.read(this->depth_copy);
+        this->pyramid = builder.create("hi-z pyramid", {this->level_sizes[0].x, this->level_sizes[0].y, GL_R32F,
+                                                  static_cast<int>(this->level_sizes.size())});
+    }, [this, &graph] {
+        int viewport[4], program, vao, read_framebuffer, draw_framebuffer, active_texture;
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_framebuffer);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+        GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+
+        unsigned pyramid_texture = graph.get_texture(this->pyramid);
+        glActiveTexture(GL_TEXTURE0 + HIZ_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, graph.get_texture(this->depth_copy));
+        glDisable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+        glBindVertexArray(this->empty_vao);
+        this->reduce_shader.use();
+        RenderDevice &device = RenderDevice::get_current();
+        device.add_binds(0, 1, 1);
+        for (size_t level = 0; level != this->level_sizes.size(); ++level) {
+            if (level != 0) {
+                // only the source level is visible to the shader, which keeps us clear of a feedback loop
+                glBindTexture(GL_TEXTURE_2D, pyramid_texture);
+                device.add_binds(0, 0, 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<int>(level) - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(level) - 1);
+            }
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramid_texture,
+                                   static_cast<int>(level));
+            glViewport(0, 0, this->level_sizes[level].x, this->level_sizes[level].y);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            device.add_draw(GL_TRIANGLES, 3);
+        }
+        // the render target goes back to the pool as it came
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(this->level_sizes.size()) - 1);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glBindVertexArray(vao);
+        glUseProgram(program);
+        device.add_binds(1, 1, 0);
+        glActiveTexture(active_texture);
+        if (depth_test) {
+            glEnable(GL_DEPTH_TEST);
+        }
+    });
+
+    // start reading back the last level, unless every PBO of the ring is still in flight
+    bool dropped = this->readbacks[this->next_readback].fence != nullptr;
+    if (dropped) {
+        ++this->stats.dropped_readbacks;
+    }
+    graph.add_pass("hi-z readback", [&](FrameGraph::Builder &builder) {
+        builder.read(this->pyramid);
+        if (!dropped) {
+            builder.set_side_effects();
+        }
+    }, [this, &graph, view_projection, camera_position] {
+        Readback &readback = this->readbacks[this->next_readback];
+        const glm::ivec2 &size = this->level_sizes.back();
+        int read_framebuffer;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->framebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               graph.get_texture(this->pyramid), static_cast<int>(this->level_sizes.size()) - 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        glReadPixels(0, 0, size.x, size.y, GL_RED, GL_FLOAT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.view_projection = view_projection;
+        readback.camera_position = camera_position;
+        readback.frame = this->frame;
+        this->next_readback = (this->next_readback + 1) % HIZ_READBACK_RING;
+    });
+}
+
+void HiZPyramid::poll() {
+    // the newest readback that is done wins, older finished ones are simply recycled
+    Readback *newest = nullptr;
+    for (auto &readback : this->readbacks) {
+        if (!readback.fence) {
+            continue;
+        }
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        if (!newest || readback.frame > newest->frame) {
+            newest = &readback;
+        }
+    }
+    if (!newest || (this->has_cpu_depth && newest->frame <= this->cpu_frame)) {
+        return;
+    }
+    CpuLevel &level0 = this->cpu_levels[0];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->pbo);
+    auto *data = static_cast<const float *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                             level0.size() * sizeof(float), GL_MAP_READ_BIT));
+    if (data) {
+        std::memcpy(level0.data(), data, level0.size() * sizeof(float));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        this->cpu_view_projection = newest->view_projection;
+        this->cpu_camera_position = newest->camera_position;
+        this->cpu_frame = newest->frame;
+        this->has_cpu_depth = true;
+        this->reduce_cpu_levels();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void HiZPyramid::reduce_cpu_levels() {
+    for (size_t level = 1; level != this->cpu_levels.size(); ++level) {
+        const CpuLevel &source = this->cpu_levels[level - 1];
+        const glm::ivec2 &source_size = this->cpu_level_sizes[level - 1];
+        const glm::ivec2 &size = this->cpu_level_sizes[level];
+        CpuLevel &destination = this->cpu_levels[level];
+        // same folding of odd edges as the shader
+        for (int y = 0; y != size.y; ++y) {
+            int y1 = y == size.y - 1 ? source_size.y - 1 : std::min(y * 2 + 1, source_size.y - 1);
+            for (int x = 0; x != size.x; ++x) {
+                int x1 = x == size.x - 1 ? source_size.x - 1 : std::min(x * 2 + 1, source_size.x - 1);
+                float depth = 0.0F;
+                for (int sy = y * 2; sy <= y1; ++sy) {
+                    for (int sx = x * 2; sx <= x1; ++sx) {
+                        depth = std::max(depth, source[sy * source_size.x + sx]);
+                    }
+                }
+                destination[y * size.x + x] = depth;
+            }
+        }
+    }
+}
+
+bool HiZPyramid::is_rect_visible(float min_x, float min_y, float max_x, float max_y, float depth) const {
+    const glm::ivec2 &size0 = this->cpu_level_sizes[0];
+    min_x = std::max(min_x, 0.0F) * static_cast<float>(size0.x);
+    max_x = std::min(max_x, 1.0F) * static_cast<float>(size0.x);
+    min_y = std::max(min_y, 0.0F) * static_cast<float>(size0.y);
+    max_y = std::min(max_y, 1.0F) * static_cast<float>(size0.y);
+    if (min_x >= max_x || min_y >= max_y) {
+        return true;
+    }
+    // the level where the rectangle spans at most about two texels per side
+    float span = std::max(max_x - min_x, max_y - min_y);
+    auto level = static_cast<size_t>(std::max(0.0F, std::ceil(std::log2(span * 0.5F))));
+    level = std::min(level, this->cpu_levels.size() - 1);
+
+    const glm::ivec2 &size = this->cpu_level_sizes[level];
+    auto scale = static_cast<float>(1U << level);
+    int x0 = std::min(static_cast<int>(min_x / scale), size.x - 1);
+    int x1 = std::min(static_cast<int>(max_x / scale), size.x - 1);
+    int y0 = std::min(static_cast<int>(min_y / scale), size.y - 1);
+    int y1 = std::min(static_cast<int>(max_y / scale), size.y - 1);
+    const CpuLevel &texels = this->cpu_levels[level];
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (depth <= texels[y * size.x + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void HiZPyramid::cull(const FrustumCuller &culler, std::vector<unsigned> &visible,
+                      const mat4 &view_projection, const vec3 &camera_position) {
+    unsigned dropped = this->stats.dropped_readbacks;
+    this->stats = Stats();
+    this->stats.dropped_readbacks = dropped;
+    this->poll();
+    if (!this->has_cpu_depth) {
+        return;
+    }
+    // cull() runs before this frame's passes, so the depth of the previous frame is one frame old
+    this->stats.depth_age = static_cast<int>(this->frame - this->cpu_frame) + 1;
+    if (glm::length(camera_position - this->cpu_camera_position) > HIZ_MAX_CAMERA_MOTION) {
+        return;
+    }
+
+    // the rectangles grow by a texel of the read back level plus twice the screen motion of the box corners, which
+    // also covers the parallax of occluders up to half as far away as the box
+    float texel = 1.0F / static_cast<float>(std::min(this->cpu_level_sizes[0].x, this->cpu_level_sizes[0].y));
+    const mat4 &old_matrix = this->cpu_view_projection;
+    const mat4 &new_matrix = view_projection;
+    size_t kept = 0;
+    for (size_t base = 0; base < visible.size(); base += 4) {
+        size_t lanes = std::min<size_t>(4, visible.size() - base);
+        float center[3][4], extent[3][4];
+        for (size_t lane = 0; lane != 4; ++lane) {
+            vec3 c, e;
+            culler.get_bounds(visible[base + std::min(lane, lanes - 1)], c, e);
+            for (int axis = 0; axis != 3; ++axis) {
+                center[axis][lane] = c[axis];
+                extent[axis][lane] = e[axis];
+            }
+        }
+
+        // project the 8 corners of 4 boxes at once with both the old and the new matrix
+        float min_x[4], min_y[4], max_x[4], max_y[4], min_z[4], min_w[4], motion[4];
+#if defined(HIZ_SSE)
+        __m128 v_min_x = _mm_set1_ps(INFINITY), v_min_y = v_min_x, v_min_z = v_min_x, v_min_w = v_min_x;
+        __m128 v_max_x = _mm_set1_ps(-INFINITY), v_max_y = v_max_x;
+        __m128 v_motion = _mm_setzero_ps();
+        __m128 c[3], e[3];
+        for (int axis = 0; axis != 3; ++axis) {
+            c[axis] = _mm_loadu_ps(center[axis]);
+            e[axis] = _mm_loadu_ps(extent[axis]);
+        }
+        for (int corner = 0; corner != 8; ++corner) {
+            __m128 p[3];
+            for (int axis = 0; axis != 3; ++axis) {
+                p[axis] = corner & (1 << axis) ? _mm_add_ps(c[axis], e[axis]) : _mm_sub_ps(c[axis], e[axis]);
+            }
+            __m128 clip[2][4];
+            const mat4 *matrices[2] = {&old_matrix, &new_matrix};
+            for (int m = 0; m != 2; ++m) {
+                const mat4 &matrix = *matrices[m];
+                for (int row = 0; row != 4; ++row) {
+                    clip[m][row] = _mm_add_ps(
+                            _mm_add_ps(_mm_mul_ps(p[0], _mm_set1_ps(matrix[0][row])),
+                                       _mm_mul_ps(p[1], _mm_set1_ps(matrix[1][row]))),
+                            _mm_add_ps(_mm_mul_ps(p[2], _mm_set1_ps(matrix[2][row])),
+                                       _mm_set1_ps(matrix[3][row])));
+                }
+            }
+            v_min_w = _mm_min_ps(v_min_w, _mm_min_ps(clip[0][3], clip[1][3]));
+            // guard the division, lanes behind the near plane are marked visible below anyway
+            __m128 old_w = _mm_max_ps(clip[0][3], _mm_set1_ps(HIZ_NEAR_W));
+            __m128 new_w = _mm_max_ps(clip[1][3], _mm_set1_ps(HIZ_NEAR_W));
+            __m128 old_x = _mm_div_ps(clip[0][0], old_w), old_y = _mm_div_ps(clip[0][1], old_w);
+            __m128 new_x = _mm_div_ps(clip[1][0], new_w), new_y = _mm_div_ps(clip[1][1], new_w);
+            v_min_x = _mm_min_ps(v_min_x, old_x);
+            v_max_x = _mm_max_ps(v_max_x, old_x);
+            v_min_y = _mm_min_ps(v_min_y, old_y);
+            v_max_y = _mm_max_ps(v_max_y, old_y);
+            v_min_z = _mm_min_ps(v_min_z, _mm_div_ps(clip[0][2], old_w));
+            __m128 dx = _mm_sub_ps(new_x, old_x), dy = _mm_sub_ps(new_y, old_y);
+            __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            v_motion = _mm_max_ps(v_motion, _mm_max_ps(_mm_and_ps(dx, abs_mask), _mm_and_ps(dy, abs_mask)));
+        }
+        _mm_storeu_ps(min_x, v_min_x);
+        _mm_storeu_ps(max_x, v_max_x);
+        _mm_storeu_ps(min_y, v_min_y);
+        _mm_storeu_ps(max_y, v_max_y);
+        _mm_storeu_ps(min_z, v_min_z);
+        _mm_storeu_ps(min_w, v_min_w);
+        _mm_storeu_ps(motion, v_motion);
+#else
+        for (size_t lane = 0; lane != 4; ++lane) {
+            min_x[lane] = min_y[lane] = min_z[lane] = min_w[lane] = INFINITY;
+            max_x[lane] = max_y[lane] = -INFINITY;
+            motion[lane] = 0.0F;
+            for (int corner = 0; corner != 8; ++corner) {
+                glm::vec4 p(1.0F);
+                for (int axis = 0; axis != 3; ++axis) {
+                    p[axis] = center[axis][lane] + (corner & (1 << axis) ? extent[axis][lane] : -extent[axis][lane]);
+                }
+                glm::vec4 old_clip = old_matrix * p, new_clip = new_matrix * p;
+                min_w[lane] = std::min(min_w[lane], std::min(old_clip.w, new_clip.w));
+                float old_w = std::max(old_clip.w, HIZ_NEAR_W), new_w = std::max(new_clip.w, HIZ_NEAR_W);
+                glm::vec2 old_xy = glm::vec2(old_clip) / old_w, new_xy = glm::vec2(new_clip) / new_w;
+                min_x[lane] = std::min(min_x[lane], old_xy.x);
+                max_x[lane] = std::max(max_x[lane], old_xy.x);
+                min_y[lane] = std::min(min_y[lane], old_xy.y);
+                max_y[lane] = std::max(max_y[lane], old_xy.y);
+                min_z[lane] = std::min(min_z[lane], old_clip.z / old_w);
+                glm::vec2 delta = glm::abs(new_xy - old_xy);
+                motion[lane] = std::max(motion[lane], std::max(delta.x, delta.y));
+            }
+        }
+#endif
+
+        for (size_t lane = 0; lane != lanes; ++lane) {
+            bool is_visible = true;
+            if (min_w[lane] > HIZ_NEAR_W) {
+                // NDC to [0, 1], the motion is kept in NDC units which doubles it in [0, 1]
+                float margin = motion[lane] + texel;
+                is_visible = this->is_rect_visible(min_x[lane] * 0.5F + 0.5F - margin,
+                                                   min_y[lane] * 0.5F + 0.5F - margin,
+                                                   max_x[lane] * 0.5F + 0.5F + margin,
+                                                   max_y[lane] * 0.5F + 0.5F + margin,
+                                                   min_z[lane] * 0.5F + 0.5F);
+            }
+            ++this->stats.tested;
+            if (is_visible) {
+                visible[kept++] = visible[base + lane];
+            } else {
+                ++this->stats.culled;
+            }
+        }
+    }
+    visible.resize(kept);
+}
+
+const HiZPyramid::Stats &HiZPyramid::get_stats() const {
+    return this->stats;
+}
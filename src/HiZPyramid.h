@@ -0,0 +1,100 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_HIZPYRAMID_H
+#define LEARNOPENGL_HIZPYRAMID_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "FrameGraph.h"
+#include "FrustumCuller.h"
+#include "MemoryTracker.h"
+#include "Shader.h"
+
+using glm::vec3;
+using glm::mat4;
+
+// hierarchical-z occlusion culling with a frame of latency: after the opaque pass the depth buffer is reduced into a
+// max depth mip pyramid on the GPU, a coarse level is read back through a ring of PBOs guarded by fences and the next
+// frame tests bounding boxes against it on the CPU, so neither occluder selection nor pipeline stalls are needed, the
+// copy of the depth and the pyramid are transient textures of the frame graph
+class HiZPyramid {
+
+public:
+    struct Stats {
+        unsigned tested = 0;
+        unsigned culled = 0;
+        // how many frames old the depth used for testing is, -1 if there was none
+        int depth_age = -1;
+        // readbacks that were dropped because the whole ring was still in flight
+        unsigned dropped_readbacks = 0;
+    };
+
+    HiZPyramid();
+    ~HiZPyramid();
+
+    HiZPyramid(const HiZPyramid &) = delete;
+    HiZPyramid &operator=(const HiZPyramid &) = delete;
+
+    // adds the passes that copy depth, a version of the depth buffer of the bound read framebuffer, reduce it and
+    // start the readback, when the whole ring is still in flight nothing reads the pyramid and the graph culls them
+    // all, the passes restore the viewport, program, VAO, framebuffer and depth test state
+    void add_passes(FrameGraph &graph, FrameGraph::Resource depth, const mat4 &view_projection,
+                    const vec3 &camera_position);
+    // picks up the newest finished readback, never waits
+    void poll();
+    // removes the ids that are hidden behind the depth of an earlier frame from the output of FrustumCuller::cull()
+    void cull(const FrustumCuller &culler, std::vector<unsigned> &visible,
+              const mat4 &view_projection, const vec3 &camera_position);
+
+    const Stats &get_stats() const;
+
+private:
+    struct Readback {
+        unsigned pbo = 0;
+        MemoryTracker::Consumer *memory = nullptr;
+        GLsync fence = nullptr;
+        mat4 view_projection;
+        vec3 camera_position;
+        unsigned long long frame = 0;
+    };
+
+    Shader reduce_shader;
+    unsigned empty_vao = 0;
+    unsigned framebuffer = 0;
+    int width = 0;
+    int height = 0;
+    // GPU levels, the last one is read back
+    std::vector<glm::ivec2> level_sizes;
+    std::vector<Readback> readbacks;
+    size_t readback_bytes = 0;
+    unsigned next_readback = 0;
+    unsigned long long frame = 0;
+    // the textures of the passes of this frame
+    FrameGraph::Resource depth_copy = 0;
+    FrameGraph::Resource pyramid = 0;
+
+    typedef TaggedVector<float, MEMORY_CPU_CULLING> CpuLevel;
+
+    // the newest depth on the CPU, level 0 is the read back level and the others are further max reductions
+    std::vector<CpuLevel> cpu_levels;
+    std::vector<glm::ivec2> cpu_level_sizes;
+    mat4 cpu_view_projection;
+    vec3 cpu_camera_position;
+    unsigned long long cpu_frame = 0;
+    bool has_cpu_depth = false;
+
+    Stats stats;
+
+    void allocate(int width, int height);
+    void release();
+    void reduce_cpu_levels();
+    // returns whether any texel in the rectangle (in [0, 1] screen coordinates) is at least as far as depth
+    bool is_rect_visible(float min_x, float min_y, float max_x, float max_y, float depth) const;
+};
+
+
+#endif //LEARNOPENGL_HIZPYRAMID_H
@@ -0,0 +1,16 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_JSON_H
+#define LEARNOPENGL_JSON_H
+
+#include <string>
+
+using std::string;
+
+// the text as a quoted JSON string, quotes, backslashes and control characters escaped
+string json_string(const string &text);
+
+
+#endif //LEARNOPENGL_JSON_H
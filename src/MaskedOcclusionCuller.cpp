@@ -0,0 +1,308 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "MaskedOcclusionCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define TILE_WIDTH 32
+#define TILE_HEIGHT 8
+// vertices closer than this (in clip space w) are not rasterized, skipping an occluder is always safe
+#define OCCLUSION_NEAR_W 1e-4F
+// widens every edge a bit so pixels centered exactly on an edge shared by two triangles are never missed by both
+#define EDGE_BIAS (1.0F / 64.0F)
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+MaskedOcclusionCuller::MaskedOcclusionCuller(unsigned width, unsigned height) :
+        width((width + TILE_WIDTH - 1) / TILE_WIDTH * TILE_WIDTH),
+        height((height + TILE_HEIGHT - 1) / TILE_HEIGHT * TILE_HEIGHT),
+        tiles_x(this->width / TILE_WIDTH),
+        tiles_y(this->height / TILE_HEIGHT),
+        view_projection(1.0F),
+        tiles(tiles_x * tiles_y),
+        bins(tiles_y) {
+}
+
+void MaskedOcclusionCuller::begin_frame(const mat4 &view_projection_m) {
+    this->view_projection = view_projection_m;
+    for (auto &tile : this->tiles) {
+        std::fill(tile.mask, tile.mask + TILE_HEIGHT, 0U);
+        tile.z_max0 = 1.0F;
+        tile.z_max1 = 0.0F;
+    }
+    this->triangles.clear();
+    for (auto &bin : this->bins) {
+        bin.clear();
+    }
+    this->stats = Stats();
+}
+
+void MaskedOcclusionCuller::add_occluder(const float *vertices, unsigned vertex_count, unsigned stride,
+                                         const mat4 &model_matrix) {
+    mat4 matrix = this->view_projection * model_matrix;
+    for (unsigned i = 0; i + 2 < vertex_count; i += 3) {
+        glm::vec4 clip[3];
+        for (unsigned j = 0; j != 3; ++j) {
+            const float *position = vertices + (i + j) * stride;
+            clip[j] = matrix * glm::vec4(position[0], position[1], position[2], 1.0F);
+        }
+        this->setup_triangle(clip[0], clip[1], clip[2]);
+    }
+}
+
+void MaskedOcclusionCuller::setup_triangle(const glm::vec4 &v0, const glm::vec4 &v1, const glm::vec4 &v2) {
+    if (v0.w < OCCLUSION_NEAR_W || v1.w < OCCLUSION_NEAR_W || v2.w < OCCLUSION_NEAR_W) {
+        return;
+    }
+    // screen space with pixel centers at .5, depth mapped to [0, 1]
+    float x[3], y[3], z[3];
+    const glm::vec4 *v[3] = {&v0, &v1, &v2};
+    for (int i = 0; i != 3; ++i) {
+        x[i] = (v[i]->x / v[i]->w * 0.5F + 0.5F) * static_cast<float>(this->width);
+        y[i] = (v[i]->y / v[i]->w * 0.5F + 0.5F) * static_cast<float>(this->height);
+        z[i] = v[i]->z / v[i]->w * 0.5F + 0.5F;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (std::fabs(area) < 1e-8F) {
+        return;
+    }
+
+    Triangle triangle;
+    triangle.min_x = std::max(std::min(std::min(x[0], x[1]), x[2]), 0.0F);
+    triangle.max_x = std::min(std::max(std::max(x[0], x[1]), x[2]), static_cast<float>(this->width));
+    triangle.min_y = std::max(std::min(std::min(y[0], y[1]), y[2]), 0.0F);
+    triangle.max_y = std::min(std::max(std::max(y[0], y[1]), y[2]), static_cast<float>(this->height));
+    triangle.z_min = std::min(std::min(z[0], z[1]), z[2]);
+    triangle.z_max = std::max(std::max(z[0], z[1]), z[2]);
+    if (triangle.min_x >= triangle.max_x || triangle.min_y >= triangle.max_y ||
+        triangle.z_max < 0.0F || triangle.z_min > 1.0F) {
+        return;
+    }
+    // the occluders are not guaranteed to be wound consistently, so flip the edges instead of back face culling
+    float sign = area > 0 ? 1.0F : -1.0F;
+    for (int i = 0; i != 3; ++i) {
+        int j = (i + 1) % 3;
+        triangle.edge_a[i] = -(y[j] - y[i]) * sign;
+        triangle.edge_b[i] = (x[j] - x[i]) * sign;
+        triangle.edge_c[i] = -(triangle.edge_a[i] * x[i] + triangle.edge_b[i] * y[i]);
+    }
+    triangle.z_a = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    triangle.z_b = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    triangle.z_c = z[0] - triangle.z_a * x[0] - triangle.z_b * y[0];
+
+    auto index = static_cast<unsigned>(this->triangles.size());
+    this->triangles.push_back(triangle);
+    auto first_row = static_cast<unsigned>(triangle.min_y) / TILE_HEIGHT;
+    auto last_row = std::min(static_cast<unsigned>(triangle.max_y) / TILE_HEIGHT, this->tiles_y - 1);
+    for (unsigned row = first_row; row <= last_row; ++row) {
+        this->bins[row].push_back(index);
+    }
+}
+
+void MaskedOcclusionCuller::rasterize(ThreadPool *pool) {
+    auto start = Clock::now();
+    if (pool) {
+        pool->parallel_for(this->tiles_y, [this](unsigned row, unsigned) {
+            this->rasterize_tile_row(row);
+        });
+    } else {
+        for (unsigned row = 0; row != this->tiles_y; ++row) {
+            this->rasterize_tile_row(row);
+        }
+    }
+    this->stats.occluder_triangles = static_cast<unsigned>(this->triangles.size());
+    this->stats.rasterize_ms = elapsed_ms(start);
+}
+
+void MaskedOcclusionCuller::rasterize_tile_row(unsigned tile_y) {
+    // a tile row is only ever touched by one task, so no synchronization is needed
+    for (unsigned index : this->bins[tile_y]) {
+        const Triangle &triangle = this->triangles[index];
+        auto first = static_cast<unsigned>(triangle.min_x) / TILE_WIDTH;
+        auto last = std::min(static_cast<unsigned>(triangle.max_x) / TILE_WIDTH, this->tiles_x - 1);
+        for (unsigned tile_x = first; tile_x <= last; ++tile_x) {
+            this->rasterize_tile(triangle, tile_x, tile_y);
+        }
+    }
+}
+
+void MaskedOcclusionCuller::rasterize_tile(const Triangle &triangle, unsigned tile_x, unsigned tile_y) {
+    Tile &tile = this->tiles[tile_y * this->tiles_x + tile_x];
+    auto left = static_cast<float>(tile_x * TILE_WIDTH);
+    auto bottom = static_cast<float>(tile_y * TILE_HEIGHT);
+
+    // conservative farthest depth of the triangle inside this tile, from the plane at the clamped corners
+    float x0 = std::max(left, triangle.min_x), x1 = std::min(left + TILE_WIDTH, triangle.max_x);
+    float y0 = std::max(bottom, triangle.min_y), y1 = std::min(bottom + TILE_HEIGHT, triangle.max_y);
+    float z_corner = triangle.z_c + std::max(triangle.z_a * x0, triangle.z_a * x1) +
+                     std::max(triangle.z_b * y0, triangle.z_b * y1);
+    float z_max = std::min(std::max(z_corner, triangle.z_min), triangle.z_max);
+    if (z_max >= tile.z_max0) {
+        // behind everything that is already in the tile
+        return;
+    }
+
+    uint32_t coverage[TILE_HEIGHT];
+#if defined(__AVX2__)
+    const __m256 row_centers = _mm256_add_ps(_mm256_set1_ps(bottom + 0.5F),
+                                             _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i all_ones = _mm256_set1_epi32(-1);
+    __m256i mask = all_ones;
+    for (int e = 0; e != 3; ++e) {
+        float a = triangle.edge_a[e], b = triangle.edge_b[e], c = triangle.edge_c[e];
+        __m256 row_value = _mm256_add_ps(_mm256_mul_ps(row_centers, _mm256_set1_ps(b)), _mm256_set1_ps(c));
+        __m256i edge_mask;
+        if (a == 0.0F) {
+            edge_mask = _mm256_castps_si256(_mm256_cmp_ps(row_value, _mm256_setzero_ps(), _CMP_GE_OQ));
+        } else {
+            // x of the edge on every row, relative to the first pixel center of the tile
+            __m256 crossing = _mm256_sub_ps(_mm256_div_ps(row_value, _mm256_set1_ps(-a)),
+                                            _mm256_set1_ps(left + 0.5F));
+            if (a > 0) {
+                // inside to the right, the first covered column
+                __m256 first = _mm256_ceil_ps(_mm256_sub_ps(crossing, _mm256_set1_ps(EDGE_BIAS)));
+                first = _mm256_min_ps(_mm256_max_ps(first, _mm256_setzero_ps()), _mm256_set1_ps(32.0F));
+                edge_mask = _mm256_sllv_epi32(all_ones, _mm256_cvtps_epi32(first));
+            } else {
+                // inside to the left, the number of covered columns
+                __m256 count = _mm256_floor_ps(_mm256_add_ps(crossing, _mm256_set1_ps(1.0F + EDGE_BIAS)));
+                count = _mm256_min_ps(_mm256_max_ps(count, _mm256_setzero_ps()), _mm256_set1_ps(32.0F));
+                edge_mask = _mm256_srlv_epi32(all_ones, _mm256_sub_epi32(_mm256_set1_epi32(32),
+                                                                         _mm256_cvtps_epi32(count)));
+            }
+        }
+        mask = _mm256_and_si256(mask, edge_mask);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(coverage), mask);
+#else
+    for (int row = 0; row != TILE_HEIGHT; ++row) {
+        float center_y = bottom + static_cast<float>(row) + 0.5F;
+        uint32_t mask = ~0U;
+        for (int e = 0; e != 3; ++e) {
+            float a = triangle.edge_a[e];
+            float row_value = triangle.edge_b[e] * center_y + triangle.edge_c[e];
+            if (a == 0.0F) {
+                mask &= row_value >= 0 ? ~0U : 0U;
+                continue;
+            }
+            float crossing = row_value / -a - (left + 0.5F);
+            if (a > 0) {
+                float first = std::min(std::max(std::ceil(crossing - EDGE_BIAS), 0.0F), 32.0F);
+                mask &= first >= 32.0F ? 0U : ~0U << static_cast<unsigned>(first);
+            } else {
+                float count = std::min(std::max(std::floor(crossing + 1.0F + EDGE_BIAS), 0.0F), 32.0F);
+                mask &= count <= 0.0F ? 0U : ~0U >> (32U - static_cast<unsigned>(count));
+            }
+        }
+        coverage[row] = mask;
+    }
+#endif
+
+    // merge the triangle into the working layer, once it covers the whole tile it becomes the reference layer
+    bool any = false;
+    bool full = true;
+    for (int row = 0; row != TILE_HEIGHT; ++row) {
+        any = any || coverage[row] != 0;
+        tile.mask[row] |= coverage[row];
+        full = full && tile.mask[row] == ~0U;
+    }
+    if (!any) {
+        return;
+    }
+    tile.z_max1 = std::max(tile.z_max1, z_max);
+    if (full) {
+        tile.z_max0 = tile.z_max1;
+        tile.z_max1 = 0.0F;
+        std::fill(tile.mask, tile.mask + TILE_HEIGHT, 0U);
+    }
+}
+
+bool MaskedOcclusionCuller::is_visible(const vec3 &center, const vec3 &extent) const {
+    float min_x = INFINITY, max_x = -INFINITY, min_y = INFINITY, max_y = -INFINITY, min_z = INFINITY;
+    for (int i = 0; i != 8; ++i) {
+        vec3 corner = center + extent * vec3(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1);
+        glm::vec4 clip = this->view_projection * glm::vec4(corner, 1.0F);
+        if (clip.w < OCCLUSION_NEAR_W) {
+            // crosses the near plane, we cannot say anything about it
+            return true;
+        }
+        float x = (clip.x / clip.w * 0.5F + 0.5F) * static_cast<float>(this->width);
+        float y = (clip.y / clip.w * 0.5F + 0.5F) * static_cast<float>(this->height);
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+        min_z = std::min(min_z, clip.z / clip.w * 0.5F + 0.5F);
+    }
+    // every pixel the rectangle touches
+    int x0 = std::max(static_cast<int>(std::floor(min_x)), 0);
+    int x1 = std::min(static_cast<int>(std::floor(max_x)), static_cast<int>(this->width) - 1);
+    int y0 = std::max(static_cast<int>(std::floor(min_y)), 0);
+    int y1 = std::min(static_cast<int>(std::floor(max_y)), static_cast<int>(this->height) - 1);
+    if (x0 > x1 || y0 > y1) {
+        return true;
+    }
+
+    for (int tile_y = y0 / TILE_HEIGHT; tile_y <= y1 / TILE_HEIGHT; ++tile_y) {
+        for (int tile_x = x0 / TILE_WIDTH; tile_x <= x1 / TILE_WIDTH; ++tile_x) {
+            const Tile &tile = this->tiles[tile_y * this->tiles_x + tile_x];
+            if (min_z > tile.z_max0) {
+                continue;
+            }
+            // columns and rows of the rectangle inside this tile
+            int first_column = std::max(x0 - tile_x * TILE_WIDTH, 0);
+            int last_column = std::min(x1 - tile_x * TILE_WIDTH, TILE_WIDTH - 1);
+            uint32_t columns = (~0U << first_column) & (~0U >> (31 - last_column));
+            int first_row = std::max(y0 - tile_y * TILE_HEIGHT, 0);
+            int last_row = std::min(y1 - tile_y * TILE_HEIGHT, TILE_HEIGHT - 1);
+            bool covered = true;
+            for (int row = first_row; row <= last_row; ++row) {
+                covered = covered && (columns & ~tile.mask[row]) == 0;
+            }
+            if (!covered || min_z <= tile.z_max1) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MaskedOcclusionCuller::cull(const FrustumCuller &culler, std::vector<unsigned> &visible) {
+    auto start = Clock::now();
+    vec3 center, extent;
+    size_t kept = 0;
+    for (unsigned object : visible) {
+        culler.get_bounds(object, center, extent);
+        if (this->is_visible(center, extent)) {
+            visible[kept++] = object;
+        }
+    }
+    this->stats.tested += static_cast<unsigned>(visible.size());
+    this->stats.culled += static_cast<unsigned>(visible.size() - kept);
+    visible.resize(kept);
+    this->stats.test_ms += elapsed_ms(start);
+}
+
+const MaskedOcclusionCuller::Stats &MaskedOcclusionCuller::get_stats() const {
+    return this->stats;
+}
+
+unsigned MaskedOcclusionCuller::get_width() const {
+    return this->width;
+}
+
+unsigned MaskedOcclusionCuller::get_height() const {
+    return this->height;
+}
@@ -0,0 +1,88 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_MASKEDOCCLUSIONCULLER_H
+#define LEARNOPENGL_MASKEDOCCLUSIONCULLER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "FrustumCuller.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+
+using glm::vec3;
+using glm::mat4;
+
+// low resolution software occlusion culling in the spirit of Masked Software Occlusion Culling (Hasselgren et al.),
+// occluders are rasterized into 32x8 pixel tiles that only keep a coverage mask and two max depths each,
+// occludees are tested with their screen space bounding rectangle and nearest depth
+class MaskedOcclusionCuller {
+
+public:
+    struct Stats {
+        unsigned occluder_triangles = 0;
+        unsigned tested = 0;
+        unsigned culled = 0;
+        double rasterize_ms = 0;
+        double test_ms = 0;
+    };
+
+    // the width is rounded up to a multiple of 32 and the height to a multiple of 8
+    explicit
+    MaskedOcclusionCuller(unsigned width = 256, unsigned height = 256);
+
+    // clears the buffer and the stats
+    void begin_frame(const mat4 &view_projection);
+    // queues a non-indexed triangle list, stride is in floats and the position must come first
+    void add_occluder(const float *vertices, unsigned vertex_count, unsigned stride, const mat4 &model_matrix);
+    // rasterizes the queued occluders, one tile row per task
+    void rasterize(ThreadPool *pool = nullptr);
+
+    bool is_visible(const vec3 &center, const vec3 &extent) const;
+    // removes the occluded ids from the output of FrustumCuller::cull()
+    void cull(const FrustumCuller &culler, std::vector<unsigned> &visible);
+
+    const Stats &get_stats() const;
+    unsigned get_width() const;
+    unsigned get_height() const;
+
+private:
+    struct Tile {
+        // one 32 bit coverage row per pixel row of the working layer
+        uint32_t mask[8];
+        // every pixel of the tile is at most this far away
+        float z_max0;
+        // every pixel in the mask is at most this far away
+        float z_max1;
+    };
+
+    struct Triangle {
+        // edge functions a * x + b * y + c >= 0 inside
+        float edge_a[3], edge_b[3], edge_c[3];
+        // depth plane z = z_a * x + z_b * y + z_c
+        float z_a, z_b, z_c;
+        float z_min, z_max;
+        float min_x, max_x, min_y, max_y;
+    };
+
+    unsigned width;
+    unsigned height;
+    unsigned tiles_x;
+    unsigned tiles_y;
+    mat4 view_projection;
+    TaggedVector<Tile, MEMORY_CPU_CULLING> tiles;
+    TaggedVector<Triangle, MEMORY_CPU_CULLING> triangles;
+    // triangle indices overlapping each tile row
+    std::vector<std::vector<unsigned>> bins;
+    Stats stats;
+
+    void setup_triangle(const glm::vec4 &v0, const glm::vec4 &v1, const glm::vec4 &v2);
+    void rasterize_tile_row(unsigned tile_y);
+    void rasterize_tile(const Triangle &triangle, unsigned tile_x, unsigned tile_y);
+};
+
+
+#endif //LEARNOPENGL_MASKEDOCCLUSIONCULLER_H
@@ -0,0 +1,272 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+// what allocate() puts in front of the memory it returns
+struct AllocationHeader {
+    MemoryTracker::Consumer *consumer;
+    size_t size;
+};
+
+static_assert(sizeof(AllocationHeader) <= MemoryTracker::ALIGNMENT, "the header must fit in the alignment");
+
+// a scope alive on this thread and the consumers of the tags it named so far, so they are only looked up once
+struct ScopeEntry {
+    string name;
+    MemoryTracker::Consumer *consumers[MEMORY_TAG_COUNT];
+};
+
+// the scopes alive on this thread, innermost last, the first one is the unnamed one outside of all of them
+static thread_local std::vector<ScopeEntry> scopes(1, ScopeEntry());
+
+const size_t MemoryTracker::ALIGNMENT;
+std::mutex MemoryTracker::mutex;
+MemoryTracker::TagStats MemoryTracker::stats[MEMORY_TAG_COUNT];
+bool MemoryTracker::over_budget[MEMORY_TAG_COUNT] = {};
+MemoryTracker::BudgetCallback MemoryTracker::budget_callback;
+std::map<std::pair<int, string>, MemoryTracker::Consumer> MemoryTracker::consumers;
+
+static double to_mib(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// the writes happen under the lock, so relaxed is enough for them and for the readers without it
+static size_t load(const std::atomic<size_t> &value) {
+    return value.load(std::memory_order_relaxed);
+}
+
+static void store(std::atomic<size_t> &value, size_t new_value) {
+    value.store(new_value, std::memory_order_relaxed);
+}
+
+MemoryTracker::Scope::Scope(const string &name) {
+    scopes.push_back(ScopeEntry());
+    scopes.back().name = name;
+}
+
+MemoryTracker::Scope::~Scope() {
+    scopes.pop_back();
+}
+
+void *MemoryTracker::allocate(MemoryTag tag, size_t size) {
+    void *memory = std::malloc(ALIGNMENT + size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    auto header = static_cast<AllocationHeader *>(memory);
+    header->size = size;
+    header->consumer = charge(tag, size);
+    return static_cast<unsigned char *>(memory) + ALIGNMENT;
+}
+
+void MemoryTracker::deallocate(void *pointer) {
+    if (!pointer) {
+        return;
+    }
+    void *memory = static_cast<unsigned char *>(pointer) - ALIGNMENT;
+    auto header = static_cast<AllocationHeader *>(memory);
+    release(header->consumer, header->size);
+    std::free(memory);
+}
+
+MemoryTracker::Consumer *MemoryTracker::charge(MemoryTag tag, size_t size) {
+    Consumer *consumer;
+    bool crossed;
+    Stats tag_stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        consumer = &get_consumer(tag);
+        crossed = grow(*consumer, size);
+        tag_stats = get_stats_lock_free(tag);
+    }
+    if (crossed) {
+        call_budget_callback(tag, tag_stats.bytes, tag_stats.budget);
+    }
+    return consumer;
+}
+
+void MemoryTracker::release(Consumer *consumer, size_t size) {
+    if (!consumer) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    shrink(*consumer, size);
+}
+
+void MemoryTracker::set_budget(MemoryTag tag, size_t bytes) {
+    bool crossed;
+    size_t used;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        store(stats[tag].budget, bytes);
+        used = load(stats[tag].bytes);
+        crossed = bytes && used > bytes && !over_budget[tag];
+        over_budget[tag] = bytes && used > bytes;
+    }
+    if (crossed) {
+        call_budget_callback(tag, used, bytes);
+    }
+}
+
+void MemoryTracker::set_budget_callback(const BudgetCallback &callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget_callback = callback;
+}
+
+MemoryTracker::Stats MemoryTracker::get_stats(MemoryTag tag) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return get_stats_lock_free(tag);
+}
+
+MemoryTracker::Stats MemoryTracker::get_stats_lock_free(MemoryTag tag) {
+    const TagStats &tag_stats = stats[tag];
+    Stats copy;
+    copy.bytes = load(tag_stats.bytes);
+    copy.peak_bytes = load(tag_stats.peak_bytes);
+    copy.allocations = load(tag_stats.allocations);
+    copy.budget = load(tag_stats.budget);
+    return copy;
+}
+
+std::vector<MemoryTracker::Consumer> MemoryTracker::get_top_consumers(size_t count) {
+    std::vector<Consumer> top;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &entry : consumers) {
+            if (entry.second.bytes) {
+                top.push_back(entry.second);
+            }
+        }
+    }
+    std::sort(top.begin(), top.end(), [](const Consumer &a, const Consumer &b) {
+        return a.bytes != b.bytes ? a.bytes > b.bytes : a.peak_bytes > b.peak_bytes;
+    });
+    if (top.size() > count) {
+        top.resize(count);
+    }
+    return top;
+}
+
+void MemoryTracker::dump(std::ostream &out, size_t count) {
+    Stats tag_stats[MEMORY_TAG_COUNT];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+            tag_stats[tag] = get_stats_lock_free(static_cast<MemoryTag>(tag));
+        }
+    }
+    std::vector<Consumer> top = get_top_consumers(count);
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    out << std::left << std::setw(20) << "tag" << std::right << std::setw(12) << "MiB" << std::setw(12) << "peak MiB"
+        << std::setw(12) << "budget MiB" << std::setw(10) << "count" << "\n";
+    for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+        const Stats &tag_stat = tag_stats[tag];
+        out << std::left << std::setw(20) << get_tag_name(static_cast<MemoryTag>(tag)) << std::right
+            << std::setw(12) << to_mib(tag_stat.bytes) << std::setw(12) << to_mib(tag_stat.peak_bytes);
+        if (tag_stat.budget) {
+            out << std::setw(12) << to_mib(tag_stat.budget);
+        } else {
+            out << std::setw(12) << "-";
+        }
+        out << std::setw(10) << tag_stat.allocations
+            << (tag_stat.budget && tag_stat.bytes > tag_stat.budget ? "  over budget" : "") << "\n";
+    }
+    out << "top " << top.size() << " consumers:\n";
+    for (const auto &consumer : top) {
+        out << std::left << std::setw(20) << get_tag_name(consumer.tag) << std::right << std::setw(12)
+            << to_mib(consumer.bytes) << std::setw(12) << to_mib(consumer.peak_bytes) << std::setw(22)
+            << consumer.allocations << "  " << (consumer.name.empty() ? "-" : consumer.name) << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+    out << std::flush;
+}
+
+const char *MemoryTracker::get_tag_name(MemoryTag tag) {
+    switch (tag) {
+        case MEMORY_CPU_IMAGES:
+            return "cpu/images";
+        case MEMORY_CPU_CULLING:
+            return "cpu/culling";
+        case MEMORY_CPU_COMMANDS:
+            return "cpu/commands";
+        case MEMORY_CPU_RASTERIZER:
+            return "cpu/rasterizer";
+        case MEMORY_GPU_TEXTURES:
+            return "gpu/textures";
+        case MEMORY_GPU_BUFFERS:
+            return "gpu/buffers";
+        case MEMORY_GPU_RENDER_TARGETS:
+            return "gpu/render_targets";
+        default:
+            return "unknown";
+    }
+}
+
+MemoryTracker::Consumer &MemoryTracker::get_consumer(MemoryTag tag) {
+    ScopeEntry &scope = scopes.back();
+    if (!scope.consumers[tag]) {
+        auto key = std::make_pair(static_cast<int>(tag), scope.name);
+        auto entry = consumers.find(key);
+        if (entry == consumers.end()) {
+            entry = consumers.insert(std::make_pair(key, Consumer())).first;
+            entry->second.tag = tag;
+            entry->second.name = scope.name;
+        }
+        scope.consumers[tag] = &entry->second;
+    }
+    return *scope.consumers[tag];
+}
+
+bool MemoryTracker::grow(Consumer &consumer, size_t bytes) {
+    consumer.bytes += bytes;
+    consumer.peak_bytes = std::max(consumer.peak_bytes, consumer.bytes);
+    ++consumer.allocations;
+    TagStats &tag_stats = stats[consumer.tag];
+    size_t tag_bytes = load(tag_stats.bytes) + bytes;
+    store(tag_stats.bytes, tag_bytes);
+    store(tag_stats.peak_bytes, std::max(load(tag_stats.peak_bytes), tag_bytes));
+    store(tag_stats.allocations, load(tag_stats.allocations) + 1);
+    size_t budget = load(tag_stats.budget);
+    if (budget && tag_bytes > budget && !over_budget[consumer.tag]) {
+        over_budget[consumer.tag] = true;
+        return true;
+    }
+    return false;
+}
+
+void MemoryTracker::shrink(Consumer &consumer, size_t bytes) {
+    consumer.bytes -= bytes;
+    --consumer.allocations;
+    TagStats &tag_stats = stats[consumer.tag];
+    size_t tag_bytes = load(tag_stats.bytes) - bytes;
+    store(tag_stats.bytes, tag_bytes);
+    store(tag_stats.allocations, load(tag_stats.allocations) - 1);
+    if (tag_bytes <= load(tag_stats.budget)) {
+        over_budget[consumer.tag] = false;
+    }
+}
+
+void MemoryTracker::call_budget_callback(MemoryTag tag, size_t bytes, size_t budget) {
+    BudgetCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        callback = budget_callback;
+    }
+    if (callback) {
+        callback(tag, bytes, budget);
+    } else {
+        std::cerr << "Memory budget exceeded: " << get_tag_name(tag) << " holds " << to_mib(bytes) << " MiB of "
+                  << to_mib(budget) << " MiB!" << std::endl;
+    }
+}
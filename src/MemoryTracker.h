@@ -0,0 +1,174 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_MEMORYTRACKER_H
+#define LEARNOPENGL_MEMORYTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+
+// what the memory is for, the CPU tags count what went through MemoryTracker::allocate() and the GPU ones estimate
+// what the render devices created
+enum MemoryTag {
+    // decoded images on their way to a texture
+    MEMORY_CPU_IMAGES = 0,
+    // the frustum, masked occlusion and hi-z culling
+    MEMORY_CPU_CULLING = 1,
+    // the arenas of the command lists
+    MEMORY_CPU_COMMANDS = 2,
+    // the framebuffer of the software device
+    MEMORY_CPU_RASTERIZER = 3,
+    MEMORY_GPU_TEXTURES = 4,
+    MEMORY_GPU_BUFFERS = 5,
+    MEMORY_GPU_RENDER_TARGETS = 6,
+    MEMORY_TAG_COUNT = 7
+};
+
+// counts the bytes every tag and every consumer holds, a consumer is a tag and the name of the innermost Scope on the
+// thread that allocated, a tag can have a budget, the callback hears about it once when the tag grows past it and
+// again only after it went back below, everything may be called from any thread
+class MemoryTracker {
+
+public:
+    struct Stats {
+        size_t bytes = 0;
+        size_t peak_bytes = 0;
+        // allocations or objects alive
+        size_t allocations = 0;
+        // 0 for none
+        size_t budget = 0;
+    };
+
+    struct Consumer {
+        MemoryTag tag;
+        // empty for what was allocated outside of any scope
+        string name;
+        size_t bytes = 0;
+        size_t peak_bytes = 0;
+        size_t allocations = 0;
+    };
+
+    // called with the bytes of the tag that went past its budget, outside of the lock of the tracker
+    typedef std::function<void(MemoryTag tag, size_t bytes, size_t budget)> BudgetCallback;
+
+    // names what this thread allocates or creates while it is alive, scopes nest and the innermost one wins
+    class Scope {
+
+    public:
+        explicit
+        Scope(const string &name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    // what allocate() returns is aligned to this
+    static const size_t ALIGNMENT = 16;
+
+    MemoryTracker() = delete;
+
+    // throws std::bad_alloc like new
+    static void *allocate(MemoryTag tag, size_t size);
+    // does nothing for nullptr
+    static void deallocate(void *pointer);
+
+    // memory that is not allocated here, a GPU object or an image of a library, returns the consumer it went to,
+    // which the owner keeps with the object to hand it back to release() with the same size
+    static Consumer *charge(MemoryTag tag, size_t size);
+    // does nothing for nullptr
+    static void release(Consumer *consumer, size_t size);
+
+    // 0 removes the budget
+    static void set_budget(MemoryTag tag, size_t bytes);
+    // the default one warns on std::cerr
+    static void set_budget_callback(const BudgetCallback &callback);
+
+    static Stats get_stats(MemoryTag tag);
+    // without the lock, for threads that must not wait on the allocating ones, every number is current but they may
+    // be from slightly different moments
+    static Stats get_stats_lock_free(MemoryTag tag);
+    // the consumers holding the most bytes, those holding nothing are left out
+    static std::vector<Consumer> get_top_consumers(size_t count);
+    // the tags with their budgets and the top count consumers as tables
+    static void dump(std::ostream &out, size_t count = 10);
+    static const char *get_tag_name(MemoryTag tag);
+
+private:
+    // the Stats of a tag, only changed under the lock, atomic for get_stats_lock_free()
+    struct TagStats {
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> peak_bytes{0};
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> budget{0};
+    };
+
+    static std::mutex mutex;
+    static TagStats stats[MEMORY_TAG_COUNT];
+    // whether the tag is past its budget, the callback was told
+    static bool over_budget[MEMORY_TAG_COUNT];
+    static BudgetCallback budget_callback;
+    // never erased, allocations, objects and the scopes of the threads point at their consumer
+    static std::map<std::pair<int, string>, Consumer> consumers;
+
+    // the consumer of the tag named by the scope of this thread, call locked
+    static Consumer &get_consumer(MemoryTag tag);
+    // adds bytes to a consumer and its tag, true if that took the tag past its budget, call locked
+    static bool grow(Consumer &consumer, size_t bytes);
+    static void shrink(Consumer &consumer, size_t bytes);
+    static void call_budget_callback(MemoryTag tag, size_t bytes, size_t budget);
+};
+
+// an allocator for the standard containers that puts what they hold on a tag
+template<typename T, MemoryTag tag>
+class TaggedAllocator {
+
+public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind {
+        typedef TaggedAllocator<U, tag> other;
+    };
+
+    static_assert(alignof(T) <= MemoryTracker::ALIGNMENT, "over-aligned types are not supported");
+
+    TaggedAllocator() = default;
+
+    template<typename U>
+    TaggedAllocator(const TaggedAllocator<U, tag> &) {}
+
+    T *allocate(size_t count) {
+        return static_cast<T *>(MemoryTracker::allocate(tag, count * sizeof(T)));
+    }
+
+    void deallocate(T *pointer, size_t) {
+        MemoryTracker::deallocate(pointer);
+    }
+};
+
+template<typename T, typename U, MemoryTag tag>
+bool operator==(const TaggedAllocator<T, tag> &, const TaggedAllocator<U, tag> &) {
+    return true;
+}
+
+template<typename T, typename U, MemoryTag tag>
+bool operator!=(const TaggedAllocator<T, tag> &, const TaggedAllocator<U, tag> &) {
+    return false;
+}
+
+template<typename T, MemoryTag tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, tag>>;
+
+
+#endif //LEARNOPENGL_MEMORYTRACKER_H
@@ -0,0 +1,137 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+#include "Json.h"
+
+// the most a warmup run multiplies the iterations by, so a first run that was too quick to measure does not overshoot
+#define MICRO_BENCHMARK_MAX_GROWTH 10.0
+
+#if !(defined(__GNUC__) || defined(__clang__))
+const void *volatile MicroBenchmark::sink = nullptr;
+#endif
+
+// seconds body takes for iterations operations
+static double time_body(const MicroBenchmark::Body &body, unsigned long long iterations) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void MicroBenchmark::add(const string &name, const Body &body) {
+    this->benchmarks.push_back({name, body});
+}
+
+std::vector<MicroBenchmark::Result> MicroBenchmark::run(const Options &options) const {
+    std::vector<Result> results;
+    for (const auto &benchmark : this->benchmarks) {
+        if (benchmark.name.find(options.filter) != string::npos) {
+            results.push_back(run_one(benchmark, options));
+        }
+    }
+    return results;
+}
+
+std::vector<string> MicroBenchmark::get_names() const {
+    std::vector<string> names;
+    for (const auto &benchmark : this->benchmarks) {
+        names.push_back(benchmark.name);
+    }
+    return names;
+}
+
+MicroBenchmark::Result MicroBenchmark::run_one(const Benchmark &benchmark, const Options &options) {
+    Result result;
+    result.name = benchmark.name;
+    // the warmup grows the iterations until a run lasts a repetition and keeps running that many until it is over
+    unsigned long long iterations = 1;
+    double warmup = 0;
+    while (true) {
+        double seconds = time_body(benchmark.body, iterations);
+        warmup += seconds;
+        if (seconds < options.repetition_seconds) {
+            double growth = seconds > 0 ? options.repetition_seconds / seconds * 1.2 : MICRO_BENCHMARK_MAX_GROWTH;
+            growth = std::min(std::max(growth, 2.0), MICRO_BENCHMARK_MAX_GROWTH);
+            iterations = static_cast<unsigned long long>(std::ceil(static_cast<double>(iterations) * growth));
+        } else if (warmup >= options.warmup_seconds) {
+            break;
+        }
+    }
+    result.iterations = iterations;
+
+    for (unsigned i = 0; i != std::max(options.repetitions, 1U); ++i) {
+        result.samples.push_back(time_body(benchmark.body, iterations) * 1e9 / static_cast<double>(iterations));
+    }
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t count = sorted.size();
+    result.median_ns = count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    result.min_ns = sorted.front();
+    result.max_ns = sorted.back();
+    double sum = 0;
+    for (double sample : sorted) {
+        sum += sample;
+    }
+    result.mean_ns = sum / static_cast<double>(count);
+    double squares = 0;
+    for (double sample : sorted) {
+        squares += (sample - result.mean_ns) * (sample - result.mean_ns);
+    }
+    result.stddev_ns = count > 1 ? std::sqrt(squares / static_cast<double>(count - 1)) : 0;
+    result.cv = result.mean_ns > 0 ? result.stddev_ns / result.mean_ns : 0;
+    return result;
+}
+
+void MicroBenchmark::write_table(std::ostream &out, const std::vector<Result> &results, double max_cv) {
+    size_t name_width = 9;
+    for (const auto &result : results) {
+        name_width = std::max(name_width, result.name.size());
+    }
+    std::ios::fmtflags flags = out.flags();
+    out << std::left << std::setw(static_cast<int>(name_width)) << "benchmark" << std::right << std::setw(14)
+        << "ns/op" << std::setw(14) << "min" << std::setw(9) << "cv" << std::setw(14) << "iterations" << "\n";
+    out << std::fixed;
+    for (const auto &result : results) {
+        out << std::left << std::setw(static_cast<int>(name_width)) << result.name << std::right
+            << std::setprecision(2) << std::setw(14) << result.median_ns << std::setw(14) << result.min_ns
+            << std::setprecision(1) << std::setw(8) << result.cv * 100.0 << "%" << std::setw(14) << result.iterations
+            << (result.cv > max_cv ? "  unstable" : "") << "\n";
+    }
+    out.flags(flags);
+    out << std::flush;
+}
+
+void MicroBenchmark::write_json(std::ostream &out, const std::vector<Result> &results,
+                                const std::vector<std::pair<string, string>> &context) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    // nanoseconds with picoseconds, never in scientific notation
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"context\": {";
+    for (size_t i = 0; i != context.size(); ++i) {
+        out << (i ? ", " : "") << json_string(context[i].first) << ": " << json_string(context[i].second);
+    }
+    out << "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i != results.size(); ++i) {
+        const Result &result = results[i];
+        out << (i ? "," : "") << "\n    {\"name\": " << json_string(result.name) << ", \"iterations\": "
+            << result.iterations << ", \"repetitions\": " << result.samples.size() << ", \"ns_per_op\": "
+            << result.median_ns << ", \"mean_ns\": " << result.mean_ns << ", \"min_ns\": " << result.min_ns
+            << ", \"max_ns\": " << result.max_ns << ", \"stddev_ns\": " << result.stddev_ns << ", \"cv\": "
+            << std::setprecision(5) << result.cv << std::setprecision(3) << ", \"samples_ns\": [";
+        for (size_t j = 0; j != result.samples.size(); ++j) {
+            out << (j ? ", " : "") << result.samples[j];
+        }
+        out << "]}";
+    }
+    out << (results.empty() ? "" : "\n  ") << "]\n}" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
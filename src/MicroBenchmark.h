@@ -0,0 +1,84 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_MICROBENCHMARK_H
+#define LEARNOPENGL_MICROBENCHMARK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::string;
+
+// times small pieces of code in nanoseconds per operation: a benchmark first runs for a warmup, which also finds how
+// many operations a repetition needs to last long enough for the clock, then runs that many for every repetition,
+// the median of the repetitions is the result and their coefficient of variation tells how much to trust it
+class MicroBenchmark {
+
+public:
+    // runs the operation iterations times, called with growing counts during the warmup
+    typedef std::function<void(unsigned long long iterations)> Body;
+
+    struct Options {
+        double warmup_seconds = 0.1;
+        // the least time one repetition takes
+        double repetition_seconds = 0.02;
+        unsigned repetitions = 15;
+        // only the benchmarks whose name contains it run
+        string filter;
+    };
+
+    struct Result {
+        string name;
+        unsigned long long iterations = 0;
+        // nanoseconds per operation of every repetition
+        std::vector<double> samples;
+        double median_ns = 0;
+        double mean_ns = 0;
+        double min_ns = 0;
+        double max_ns = 0;
+        double stddev_ns = 0;
+        // the standard deviation over the mean
+        double cv = 0;
+    };
+
+    void add(const string &name, const Body &body);
+    // every benchmark that passes the filter in the order they were added
+    std::vector<Result> run(const Options &options) const;
+    std::vector<string> get_names() const;
+
+    // a row per result, flagging those whose coefficient of variation is above max_cv
+    static void write_table(std::ostream &out, const std::vector<Result> &results, double max_cv);
+    // {"context": {...}, "benchmarks": [...]}, context holds strings that describe the run
+    static void write_json(std::ostream &out, const std::vector<Result> &results,
+                           const std::vector<std::pair<string, string>> &context);
+
+    // keeps the compiler from optimizing away the computation of value
+    template<typename T>
+    static void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        sink = &value;
+#endif
+    }
+
+private:
+    struct Benchmark {
+        string name;
+        Body body;
+    };
+
+    std::vector<Benchmark> benchmarks;
+
+#if !(defined(__GNUC__) || defined(__clang__))
+    static const void *volatile sink;
+#endif
+
+    static Result run_one(const Benchmark &benchmark, const Options &options);
+};
+
+
+#endif //LEARNOPENGL_MICROBENCHMARK_H
@@ -0,0 +1,15 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "MouseAccumulator.h"
+
+void MouseAccumulator::add(float delta_x, float delta_y) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->total += glm::dvec2(delta_x, delta_y);
+}
+
+glm::dvec2 MouseAccumulator::get_total() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->total;
+}
@@ -0,0 +1,32 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_MOUSEACCUMULATOR_H
+#define LEARNOPENGL_MOUSEACCUMULATOR_H
+
+#include <mutex>
+#include <glm/glm.hpp>
+
+// sums up the mouse movement of the event thread, any thread can read the total: the simulation turns the camera by
+// what moved since its last step, once per step instead of once per event, and the renderer can latch what moved
+// after a frame was sampled right before it draws the frame
+class MouseAccumulator {
+
+public:
+    MouseAccumulator() = default;
+
+    MouseAccumulator(const MouseAccumulator &) = delete;
+    MouseAccumulator &operator=(const MouseAccumulator &) = delete;
+
+    void add(float delta_x, float delta_y);
+    // all the movement so far, in doubles so it stays exact for a long time
+    glm::dvec2 get_total() const;
+
+private:
+    mutable std::mutex mutex;
+    glm::dvec2 total = glm::dvec2(0.0);
+};
+
+
+#endif //LEARNOPENGL_MOUSEACCUMULATOR_H
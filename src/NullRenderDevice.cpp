@@ -0,0 +1,377 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "NullRenderDevice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+static std::runtime_error invalid(const string &what) {
+    return std::runtime_error("Null render device: " + what + "!");
+}
+
+DeviceBackend NullRenderDevice::get_backend() const {
+    return BACKEND_NULL;
+}
+
+unsigned NullRenderDevice::create_shader(GLenum stage, const string &source, const string &name) {
+    if (stage != GL_VERTEX_SHADER && stage != GL_FRAGMENT_SHADER) {
+        throw invalid("unknown shader stage");
+    }
+    if (source.compare(0, 9, "#version ") != 0) {
+        throw invalid(name + " does not start with #version");
+    }
+    ShaderInfo info;
+    info.stage = stage;
+    parse_declarations(source, info.uniforms, info.blocks);
+    unsigned handle = this->next_handle++;
+    this->shaders[handle] = info;
+    ++this->counters.shaders;
+    return handle;
+}
+
+unsigned NullRenderDevice::create_program(unsigned vertex_shader, unsigned fragment_shader) {
+    auto vertex = this->shaders.find(vertex_shader);
+    auto fragment = this->shaders.find(fragment_shader);
+    if (vertex == this->shaders.end() || fragment == this->shaders.end()) {
+        throw invalid("linking a shader that does not exist");
+    }
+    if (vertex->second.stage != GL_VERTEX_SHADER || fragment->second.stage != GL_FRAGMENT_SHADER) {
+        throw invalid("linking shaders of the wrong stages");
+    }
+    ProgramInfo info;
+    for (const ShaderInfo *shader : {&vertex->second, &fragment->second}) {
+        for (const auto &uniform : shader->uniforms) {
+            auto existing = info.uniforms.find(uniform.first);
+            if (existing != info.uniforms.end()) {
+                if (existing->second.type != uniform.second) {
+                    throw invalid("uniform " + uniform.first + " is declared with different types");
+                }
+                continue;
+            }
+            auto location = static_cast<int>(info.uniforms.size());
+            info.uniforms[uniform.first] = {location, uniform.second};
+            info.location_types[location] = uniform.second;
+        }
+        for (const auto &block : shader->blocks) {
+            info.blocks[block] = -1;
+        }
+    }
+    unsigned handle = this->next_handle++;
+    this->programs[handle] = info;
+    ++this->counters.programs;
+    return handle;
+}
+
+void NullRenderDevice::destroy_shader(unsigned shader) {
+    if (!this->shaders.erase(shader)) {
+        throw invalid("destroying a shader that does not exist");
+    }
+    --this->counters.shaders;
+}
+
+void NullRenderDevice::destroy_program(unsigned program) {
+    if (!this->programs.erase(program)) {
+        throw invalid("destroying a program that does not exist");
+    }
+    if (this->current_program == program) {
+        this->current_program = 0;
+    }
+    --this->counters.programs;
+}
+
+int NullRenderDevice::get_uniform_location(unsigned program, const string &name) {
+    auto info = this->programs.find(program);
+    if (info == this->programs.end()) {
+        throw invalid("querying a program that does not exist");
+    }
+    auto uniform = info->second.uniforms.find(name);
+    return uniform == info->second.uniforms.end() ? -1 : uniform->second.location;
+}
+
+void NullRenderDevice::bind_uniform_block(unsigned program, const string &name, unsigned binding) {
+    auto info = this->programs.find(program);
+    if (info == this->programs.end()) {
+        throw invalid("binding a block of a program that does not exist");
+    }
+    if (binding >= MAX_UNIFORM_BINDINGS) {
+        throw invalid("uniform buffer binding out of range");
+    }
+    auto block = info->second.blocks.find(name);
+    if (block != info->second.blocks.end()) {
+        block->second = static_cast<int>(binding);
+    }
+}
+
+void NullRenderDevice::use_program(unsigned program) {
+    if (program && !this->programs.count(program)) {
+        throw invalid("using a program that does not exist");
+    }
+    this->current_program = program;
+    ++this->counters.program_binds;
+}
+
+void NullRenderDevice::set_uniform(const UniformValue &value) {
+    if (!this->current_program) {
+        throw invalid("setting a uniform without a program");
+    }
+    ++this->counters.uniform_calls;
+    // like GL, -1 is silently ignored
+    if (value.location == -1) {
+        return;
+    }
+    const ProgramInfo &info = this->programs.at(this->current_program);
+    auto type = info.location_types.find(value.location);
+    if (type == info.location_types.end()) {
+        throw invalid("setting a uniform at a location the program does not have");
+    }
+    if (type->second != value.type) {
+        throw invalid("setting a uniform with the wrong type");
+    }
+}
+
+unsigned NullRenderDevice::create_buffer(GLenum target, size_t size, const void *data, GLenum usage) {
+    if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER && target != GL_UNIFORM_BUFFER) {
+        throw invalid("unsupported buffer target");
+    }
+    if (usage != GL_STATIC_DRAW && usage != GL_DYNAMIC_DRAW && usage != GL_STREAM_DRAW) {
+        throw invalid("unsupported buffer usage");
+    }
+    unsigned handle = this->next_handle++;
+    this->buffers[handle] = {target, size, MemoryTracker::charge(MEMORY_GPU_BUFFERS, size)};
+    ++this->counters.buffers;
+    this->counters.buffer_bytes += size;
+    if (data) {
+        this->counters.bytes_uploaded += size;
+    }
+    return handle;
+}
+
+void NullRenderDevice::update_buffer(unsigned buffer, size_t offset, size_t size, const void *data,
+                                     bool unsynchronized) {
+    auto info = this->buffers.find(buffer);
+    if (info == this->buffers.end()) {
+        throw invalid("updating a buffer that does not exist");
+    }
+    if (offset + size > info->second.size || !data) {
+        throw invalid("buffer update out of range");
+    }
+    ++this->counters.buffer_updates;
+    this->counters.bytes_uploaded += size;
+}
+
+void NullRenderDevice::bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) {
+    auto info = this->buffers.find(buffer);
+    if (info == this->buffers.end() || info->second.target != GL_UNIFORM_BUFFER) {
+        throw invalid("binding something that is not a uniform buffer");
+    }
+    if (binding >= MAX_UNIFORM_BINDINGS || offset + size > info->second.size ||
+        offset % this->get_uniform_buffer_alignment() != 0) {
+        throw invalid("uniform buffer range out of bounds or misaligned");
+    }
+    UniformBinding &bound = this->uniform_bindings[binding];
+    bound.buffer = buffer;
+    bound.offset = offset;
+    bound.size = size;
+}
+
+void NullRenderDevice::destroy_buffer(unsigned buffer) {
+    auto info = this->buffers.find(buffer);
+    if (info == this->buffers.end()) {
+        throw invalid("destroying a buffer that does not exist");
+    }
+    --this->counters.buffers;
+    this->counters.buffer_bytes -= info->second.size;
+    MemoryTracker::release(info->second.memory, info->second.size);
+    this->buffers.erase(info);
+    for (auto &binding : this->uniform_bindings) {
+        if (binding.buffer == buffer) {
+            binding = UniformBinding();
+        }
+    }
+}
+
+size_t NullRenderDevice::get_uniform_buffer_alignment() const {
+    // the largest alignment common drivers ask for
+    return 256;
+}
+
+unsigned NullRenderDevice::create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                               unsigned attribute_count) {
+    auto buffer = this->buffers.find(vertex_buffer);
+    if (buffer == this->buffers.end() || buffer->second.target != GL_ARRAY_BUFFER) {
+        throw invalid("vertex array without a vertex buffer");
+    }
+    VertexArrayInfo info = {static_cast<size_t>(-1)};
+    for (unsigned i = 0; i != attribute_count; ++i) {
+        const VertexAttribute &attribute = attributes[i];
+        size_t attribute_size = sizeof(float) * static_cast<size_t>(attribute.components);
+        if (attribute.components < 1 || attribute.components > 4 || attribute.stride == 0 ||
+            attribute.offset + attribute_size > buffer->second.size) {
+            throw invalid("vertex attribute out of range");
+        }
+        size_t count = (buffer->second.size - attribute.offset - attribute_size) / attribute.stride + 1;
+        info.vertex_count = std::min(info.vertex_count, count);
+    }
+    if (attribute_count == 0) {
+        info.vertex_count = 0;
+    }
+    unsigned handle = this->next_handle++;
+    this->vertex_arrays[handle] = info;
+    ++this->counters.vertex_arrays;
+    return handle;
+}
+
+void NullRenderDevice::destroy_vertex_array(unsigned vertex_array) {
+    if (!this->vertex_arrays.erase(vertex_array)) {
+        throw invalid("destroying a vertex array that does not exist");
+    }
+    if (this->current_vertex_array == vertex_array) {
+        this->current_vertex_array = 0;
+    }
+    --this->counters.vertex_arrays;
+}
+
+void NullRenderDevice::bind_vertex_array(unsigned vertex_array) {
+    if (vertex_array && !this->vertex_arrays.count(vertex_array)) {
+        throw invalid("binding a vertex array that does not exist");
+    }
+    this->current_vertex_array = vertex_array;
+    ++this->counters.vertex_array_binds;
+}
+
+unsigned NullRenderDevice::create_texture_2d(int width, int height, GLenum format, const void *pixels) {
+    if (width <= 0 || height <= 0 || (format != GL_RGB && format != GL_RGBA) || !pixels) {
+        throw invalid("invalid texture");
+    }
+    // the mip chain adds a third
+    size_t size = static_cast<size_t>(width) * height * (format == GL_RGB ? 3 : 4) * 4 / 3;
+    unsigned handle = this->next_handle++;
+    this->textures[handle] = {size, MemoryTracker::charge(MEMORY_GPU_TEXTURES, size)};
+    ++this->counters.textures;
+    this->counters.texture_bytes += size;
+    this->counters.bytes_uploaded += size * 3 / 4;
+    return handle;
+}
+
+void NullRenderDevice::set_texture_parameter(unsigned texture, GLenum parameter, int value) {
+    if (!this->textures.count(texture)) {
+        throw invalid("setting a parameter of a texture that does not exist");
+    }
+}
+
+void NullRenderDevice::bind_texture(unsigned unit, unsigned texture) {
+    if (unit >= MAX_TEXTURE_UNITS || (texture && !this->textures.count(texture))) {
+        throw invalid("binding a texture that does not exist or to a unit out of range");
+    }
+    ++this->counters.texture_binds;
+}
+
+void NullRenderDevice::destroy_texture(unsigned texture) {
+    auto info = this->textures.find(texture);
+    if (info == this->textures.end()) {
+        throw invalid("destroying a texture that does not exist");
+    }
+    --this->counters.textures;
+    this->counters.texture_bytes -= info->second.size;
+    MemoryTracker::release(info->second.memory, info->second.size);
+    this->textures.erase(info);
+}
+
+unsigned NullRenderDevice::create_render_target(int width, int height, GLenum format, int levels) {
+    size_t size = get_render_target_size(width, height, format, levels);
+    unsigned handle = this->next_handle++;
+    this->textures[handle] = {size, MemoryTracker::charge(MEMORY_GPU_RENDER_TARGETS, size)};
+    ++this->counters.textures;
+    this->counters.texture_bytes += size;
+    return handle;
+}
+
+void NullRenderDevice::set_viewport(int x, int y, int width, int height) {
+    if (width < 0 || height < 0) {
+        throw invalid("negative viewport size");
+    }
+}
+
+void NullRenderDevice::set_scissor(bool enabled, int x, int y, int width, int height) {
+    if (enabled && (width < 0 || height < 0)) {
+        throw invalid("negative scissor size");
+    }
+}
+
+void NullRenderDevice::clear(float red, float green, float blue, float alpha) {
+    ++this->counters.clears;
+}
+
+void NullRenderDevice::set_depth_test(bool enabled) {
+}
+
+void NullRenderDevice::set_depth_write(bool enabled) {
+}
+
+void NullRenderDevice::set_depth_func(GLenum func) {
+    if (func != GL_LESS && func != GL_LEQUAL && func != GL_EQUAL) {
+        throw invalid("unsupported depth function");
+    }
+}
+
+void NullRenderDevice::set_color_write(bool enabled) {
+}
+
+void NullRenderDevice::set_blend(bool enabled) {
+}
+
+void NullRenderDevice::set_polygon_mode(GLenum mode) {
+    if (mode != GL_FILL && mode != GL_LINE && mode != GL_POINT) {
+        throw invalid("unknown polygon mode");
+    }
+}
+
+void NullRenderDevice::draw(GLenum mode, int first, int count, unsigned condition_query) {
+    if (mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN && mode != GL_LINES &&
+        mode != GL_LINE_STRIP && mode != GL_LINE_LOOP && mode != GL_POINTS) {
+        throw invalid("unknown primitive mode");
+    }
+    if (!this->current_program || !this->current_vertex_array) {
+        throw invalid("drawing without a program or a vertex array");
+    }
+    if (first < 0 || count < 0 ||
+        static_cast<size_t>(first) + count > this->vertex_arrays.at(this->current_vertex_array).vertex_count) {
+        throw invalid("drawing past the end of the vertex buffer");
+    }
+    for (const auto &block : this->programs.at(this->current_program).blocks) {
+        if (block.second < 0 || !this->uniform_bindings[block.second].buffer) {
+            throw invalid("uniform block " + block.first + " has no buffer bound");
+        }
+    }
+    this->count_draw(mode, count);
+}
+
+void *NullRenderDevice::insert_fence() {
+    unsigned long long fence = this->next_fence++;
+    this->fences.insert(fence);
+    return reinterpret_cast<void *>(static_cast<uintptr_t>(fence));
+}
+
+void NullRenderDevice::wait_fence(void *fence) {
+    if (!this->fences.count(reinterpret_cast<uintptr_t>(fence))) {
+        throw invalid("waiting for a fence that does not exist");
+    }
+    // there is no GPU, so every fence has already signaled
+    ++this->counters.fence_waits;
+}
+
+bool NullRenderDevice::is_fence_signaled(void *fence) {
+    if (!this->fences.count(reinterpret_cast<uintptr_t>(fence))) {
+        throw invalid("querying a fence that does not exist");
+    }
+    return true;
+}
+
+void NullRenderDevice::destroy_fence(void *fence) {
+    if (!this->fences.erase(reinterpret_cast<uintptr_t>(fence))) {
+        throw invalid("destroying a fence that does not exist");
+    }
+}
@@ -0,0 +1,124 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_NULLRENDERDEVICE_H
+#define LEARNOPENGL_NULLRENDERDEVICE_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "MemoryTracker.h"
+#include "RenderDevice.h"
+
+// a backend without a context or a GPU: every call is validated and counted, objects only exist as bookkeeping and
+// nothing is drawn, so the CPU side of a frame can be measured anywhere, misuse throws a std::runtime_error
+class NullRenderDevice : public RenderDevice {
+
+public:
+    DeviceBackend get_backend() const override;
+
+    unsigned create_shader(GLenum stage, const string &source, const string &name) override;
+    unsigned create_program(unsigned vertex_shader, unsigned fragment_shader) override;
+    void destroy_shader(unsigned shader) override;
+    void destroy_program(unsigned program) override;
+    int get_uniform_location(unsigned program, const string &name) override;
+    void bind_uniform_block(unsigned program, const string &name, unsigned binding) override;
+    void use_program(unsigned program) override;
+    void set_uniform(const UniformValue &value) override;
+
+    unsigned create_buffer(GLenum target, size_t size, const void *data, GLenum usage) override;
+    void update_buffer(unsigned buffer, size_t offset, size_t size, const void *data, bool unsynchronized) override;
+    void bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) override;
+    void destroy_buffer(unsigned buffer) override;
+    size_t get_uniform_buffer_alignment() const override;
+
+    unsigned create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                 unsigned attribute_count) override;
+    void destroy_vertex_array(unsigned vertex_array) override;
+    void bind_vertex_array(unsigned vertex_array) override;
+
+    unsigned create_texture_2d(int width, int height, GLenum format, const void *pixels) override;
+    void set_texture_parameter(unsigned texture, GLenum parameter, int value) override;
+    void bind_texture(unsigned unit, unsigned texture) override;
+    void destroy_texture(unsigned texture) override;
+    unsigned create_render_target(int width, int height, GLenum format, int levels) override;
+
+    void set_viewport(int x, int y, int width, int height) override;
+    void set_scissor(bool enabled, int x, int y, int width, int height) override;
+    void clear(float red, float green, float blue, float alpha) override;
+    void set_depth_test(bool enabled) override;
+    void set_depth_write(bool enabled) override;
+    void set_depth_func(GLenum func) override;
+    void set_color_write(bool enabled) override;
+    void set_blend(bool enabled) override;
+    void set_polygon_mode(GLenum mode) override;
+    void draw(GLenum mode, int first, int count, unsigned condition_query) override;
+
+    void *insert_fence() override;
+    void wait_fence(void *fence) override;
+    bool is_fence_signaled(void *fence) override;
+    void destroy_fence(void *fence) override;
+
+private:
+    static const unsigned MAX_TEXTURE_UNITS = 16;
+    static const unsigned MAX_UNIFORM_BINDINGS = 36;
+
+    struct Uniform {
+        int location;
+        UniformType type;
+    };
+
+    struct ShaderInfo {
+        GLenum stage;
+        std::map<string, UniformType> uniforms;
+        std::set<string> blocks;
+    };
+
+    struct ProgramInfo {
+        std::map<string, Uniform> uniforms;
+        std::map<int, UniformType> location_types;
+        // block name to binding point, -1 until bind_uniform_block()
+        std::map<string, int> blocks;
+    };
+
+    struct BufferInfo {
+        GLenum target;
+        size_t size;
+        MemoryTracker::Consumer *memory;
+    };
+
+    struct VertexArrayInfo {
+        // how many vertices every attribute can read without running off the end of the buffer
+        size_t vertex_count;
+    };
+
+    // textures and render targets
+    struct TextureInfo {
+        size_t size;
+        MemoryTracker::Consumer *memory;
+    };
+
+    struct UniformBinding {
+        unsigned buffer = 0;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    unsigned next_handle = 1;
+    std::map<unsigned, ShaderInfo> shaders;
+    std::map<unsigned, ProgramInfo> programs;
+    std::map<unsigned, BufferInfo> buffers;
+    std::map<unsigned, VertexArrayInfo> vertex_arrays;
+    std::map<unsigned, TextureInfo> textures;
+    std::set<unsigned long long> fences;
+    unsigned long long next_fence = 1;
+
+    unsigned current_program = 0;
+    unsigned current_vertex_array = 0;
+    std::vector<UniformBinding> uniform_bindings = std::vector<UniformBinding>(MAX_UNIFORM_BINDINGS);
+};
+
+
+#endif //LEARNOPENGL_NULLRENDERDEVICE_H
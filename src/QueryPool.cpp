@@ -0,0 +1,38 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "QueryPool.h"
+
+QueryPool::QueryPool(GLenum target) : target(target) {
+}
+
+QueryPool::~QueryPool() {
+    if (!this->free_queries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(this->free_queries.size()), this->free_queries.data());
+    }
+}
+
+unsigned QueryPool::acquire() {
+    if (this->free_queries.empty()) {
+        unsigned query;
+        glGenQueries(1, &query);
+        ++this->allocated_count;
+        return query;
+    }
+    unsigned query = this->free_queries.back();
+    this->free_queries.pop_back();
+    return query;
+}
+
+void QueryPool::release(unsigned query) {
+    this->free_queries.push_back(query);
+}
+
+GLenum QueryPool::get_target() const {
+    return this->target;
+}
+
+size_t QueryPool::get_allocated_count() const {
+    return this->allocated_count;
+}
@@ -0,0 +1,35 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_QUERYPOOL_H
+#define LEARNOPENGL_QUERYPOOL_H
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+// recycles query objects so we do not create and delete them every frame
+class QueryPool {
+
+public:
+    explicit
+    QueryPool(GLenum target);
+    ~QueryPool();
+
+    QueryPool(const QueryPool &) = delete;
+    QueryPool &operator=(const QueryPool &) = delete;
+
+    unsigned acquire();
+    void release(unsigned query);
+    GLenum get_target() const;
+    size_t get_allocated_count() const;
+
+private:
+    GLenum target;
+    std::vector<unsigned> free_queries;
+    size_t allocated_count = 0;
+};
+
+
+#endif //LEARNOPENGL_QUERYPOOL_H
@@ -0,0 +1,99 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "RedrawScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+unsigned RedrawScheduler::add_animation(const string &name, double rate) {
+    if (rate < 0) {
+        throw std::runtime_error("Animation " + name + " has a negative update rate!");
+    }
+    this->animations.push_back({name, rate, true, 0, 0, 0, 0});
+    return static_cast<unsigned>(this->animations.size() - 1);
+}
+
+void RedrawScheduler::set_animation_running(unsigned animation, bool running, double now) {
+    Animation &entry = this->animations.at(animation);
+    if (entry.running == running) {
+        return;
+    }
+    entry.running = running;
+    if (running) {
+        entry.paused_seconds += now - entry.paused_at;
+        entry.next_update = now;
+    } else {
+        entry.paused_at = now;
+    }
+}
+
+bool RedrawScheduler::is_animation_running(unsigned animation) const {
+    return this->animations.at(animation).running;
+}
+
+double RedrawScheduler::get_animation_time(unsigned animation) const {
+    return this->animations.at(animation).time;
+}
+
+void RedrawScheduler::request_redraw() {
+    if (!this->requested.exchange(true, std::memory_order_acq_rel) && this->wake) {
+        this->wake();
+    }
+}
+
+void RedrawScheduler::set_wake_callback(const std::function<void()> &wake) {
+    this->wake = wake;
+}
+
+bool RedrawScheduler::is_due(double now) const {
+    if (this->requested.load(std::memory_order_acquire)) {
+        return true;
+    }
+    for (const auto &animation : this->animations) {
+        if (animation.running && (animation.rate == 0 || now >= animation.next_update)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double RedrawScheduler::get_timeout(double now, double max_timeout) const {
+    double timeout = max_timeout;
+    for (const auto &animation : this->animations) {
+        if (animation.running) {
+            timeout = std::min(timeout, animation.rate == 0 ? 0 : animation.next_update - now);
+        }
+    }
+    return std::max(timeout, 0.0);
+}
+
+void RedrawScheduler::begin_frame(double now) {
+    this->requested.store(false, std::memory_order_release);
+    ++this->stats.redraws;
+    for (auto &animation : this->animations) {
+        if (!animation.running) {
+            continue;
+        }
+        double time = now - animation.paused_seconds;
+        if (animation.rate == 0) {
+            animation.time = time;
+            animation.next_update = now;
+            continue;
+        }
+        double updates = std::floor(time * animation.rate);
+        animation.time = updates / animation.rate;
+        animation.next_update = (updates + 1) / animation.rate + animation.paused_seconds;
+    }
+}
+
+void RedrawScheduler::add_idle_time(double seconds) {
+    ++this->stats.waits;
+    this->stats.idle_seconds += seconds;
+}
+
+const RedrawScheduler::Stats &RedrawScheduler::get_stats() const {
+    return this->stats;
+}
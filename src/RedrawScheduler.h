@@ -0,0 +1,76 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_REDRAWSCHEDULER_H
+#define LEARNOPENGL_REDRAWSCHEDULER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+using std::string;
+
+// decides whether a frame is worth drawing at all: input and streaming request a redraw, animations update at no more
+// than the rate they declare, when nothing is due the last frame stays on screen and the caller can sleep for
+// get_timeout() seconds, the time of an animation is quantized to its rate so frames in between would look the same
+class RedrawScheduler {
+
+public:
+    struct Stats {
+        unsigned long long redraws = 0;
+        unsigned long long waits = 0;
+        double idle_seconds = 0;
+    };
+
+    RedrawScheduler() = default;
+
+    RedrawScheduler(const RedrawScheduler &) = delete;
+    RedrawScheduler &operator=(const RedrawScheduler &) = delete;
+
+    // rate is in updates per second, 0 updates it every frame, returns the id of the animation
+    unsigned add_animation(const string &name, double rate);
+    // a paused animation keeps its time and resumes from there
+    void set_animation_running(unsigned animation, bool running, double now);
+    bool is_animation_running(unsigned animation) const;
+    // the time the animation shows in the frame begun last
+    double get_animation_time(unsigned animation) const;
+
+    // can be called from any thread, e.g. when streamed data arrives, the first request after a frame calls the wake
+    // callback so a thread sleeping in the event loop notices
+    void request_redraw();
+    void set_wake_callback(const std::function<void()> &wake);
+
+    // whether a redraw was requested or a running animation reached its next update
+    bool is_due(double now) const;
+    // seconds until the next animation update, at most max_timeout
+    double get_timeout(double now, double max_timeout) const;
+    // call when the frame drawn at now is sampled, it takes the requests and advances the animations
+    void begin_frame(double now);
+    // how long the caller slept because nothing was due
+    void add_idle_time(double seconds);
+
+    const Stats &get_stats() const;
+
+private:
+    struct Animation {
+        string name;
+        double rate;
+        bool running;
+        // time spent paused, the animation runs on now minus that
+        double paused_seconds;
+        double paused_at;
+        double time;
+        // when the time moves on next, in the time of the caller
+        double next_update;
+    };
+
+    std::vector<Animation> animations;
+    std::atomic<bool> requested{true};
+    std::function<void()> wake;
+    Stats stats;
+};
+
+
+#endif //LEARNOPENGL_REDRAWSCHEDULER_H
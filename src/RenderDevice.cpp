@@ -0,0 +1,218 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "RenderDevice.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <glm/gtc/type_ptr.hpp>
+
+// every thread that renders has its own, like its GL context
+static thread_local RenderDevice *current_device = nullptr;
+
+UniformValue::UniformValue(int location, int value) : location(location), type(UNIFORM_INT) {
+    this->data.i = value;
+}
+
+UniformValue::UniformValue(int location, unsigned value) : location(location), type(UNIFORM_UINT) {
+    this->data.u = value;
+}
+
+UniformValue::UniformValue(int location, float value) : location(location), type(UNIFORM_FLOAT) {
+    this->data.f[0] = value;
+}
+
+UniformValue::UniformValue(int location, const vec3 &value) : location(location), type(UNIFORM_VEC3) {
+    std::memcpy(this->data.f, glm::value_ptr(value), sizeof(value));
+}
+
+UniformValue::UniformValue(int location, const vec4 &value) : location(location), type(UNIFORM_VEC4) {
+    std::memcpy(this->data.f, glm::value_ptr(value), sizeof(value));
+}
+
+UniformValue::UniformValue(int location, const mat3 &value) : location(location), type(UNIFORM_MAT3) {
+    std::memcpy(this->data.f, glm::value_ptr(value), sizeof(value));
+}
+
+UniformValue::UniformValue(int location, const mat4 &value) : location(location), type(UNIFORM_MAT4) {
+    std::memcpy(this->data.f, glm::value_ptr(value), sizeof(value));
+}
+
+RenderDevice *RenderDevice::set_current(RenderDevice *device) {
+    RenderDevice *previous = current_device;
+    current_device = device;
+    return previous;
+}
+
+RenderDevice &RenderDevice::get_current() {
+    if (!current_device) {
+        throw std::runtime_error("No render device is current!");
+    }
+    return *current_device;
+}
+
+const RenderDevice::Counters &RenderDevice::get_counters() const {
+    return this->counters;
+}
+
+void RenderDevice::reset_frame_counters() {
+    Counters objects = this->counters;
+    this->counters = Counters();
+    this->counters.shaders = objects.shaders;
+    this->counters.programs = objects.programs;
+    this->counters.buffers = objects.buffers;
+    this->counters.vertex_arrays = objects.vertex_arrays;
+    this->counters.framebuffers = objects.framebuffers;
+    this->counters.textures = objects.textures;
+    this->counters.buffer_bytes = objects.buffer_bytes;
+    this->counters.texture_bytes = objects.texture_bytes;
+}
+
+void RenderDevice::add_draw(GLenum mode, int count) {
+    this->count_draw(mode, count);
+}
+
+void RenderDevice::add_binds(unsigned programs, unsigned vertex_arrays, unsigned textures) {
+    this->counters.program_binds += programs;
+    this->counters.vertex_array_binds += vertex_arrays;
+    this->counters.texture_binds += textures;
+}
+
+void RenderDevice::add_uniform_calls(unsigned calls) {
+    this->counters.uniform_calls += calls;
+}
+
+void RenderDevice::add_buffer_update(size_t size) {
+    ++this->counters.buffer_updates;
+    this->counters.bytes_uploaded += size;
+}
+
+void RenderDevice::add_objects(int buffers, int vertex_arrays, int framebuffers) {
+    this->counters.buffers += static_cast<unsigned>(buffers);
+    this->counters.vertex_arrays += static_cast<unsigned>(vertex_arrays);
+    this->counters.framebuffers += static_cast<unsigned>(framebuffers);
+}
+
+void RenderDevice::add_buffer_bytes(long long bytes) {
+    this->counters.buffer_bytes += static_cast<size_t>(bytes);
+}
+
+void RenderDevice::add_query_reads(unsigned reads) {
+    this->counters.query_reads += reads;
+}
+
+void RenderDevice::count_draw(GLenum mode, int count) {
+    ++this->counters.draws;
+    this->counters.vertices += static_cast<unsigned long long>(count);
+    switch (mode) {
+        case GL_TRIANGLES:
+            this->counters.triangles += static_cast<unsigned long long>(count / 3);
+            break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            this->counters.triangles += static_cast<unsigned long long>(std::max(count - 2, 0));
+            break;
+        default:
+            break;
+    }
+}
+
+size_t RenderDevice::get_render_target_size(int width, int height, GLenum format, int levels) {
+    size_t texel_size;
+    switch (format) {
+        case GL_RGBA8:
+        case GL_R32F:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8:
+            texel_size = 4;
+            break;
+        case GL_RGBA16F:
+            texel_size = 8;
+            break;
+        default:
+            throw std::runtime_error("Unsupported render target format " + std::to_string(format) + "!");
+    }
+    if (width <= 0 || height <= 0 || levels <= 0) {
+        throw std::runtime_error("Invalid render target size!");
+    }
+    size_t size = 0;
+    for (int level = 0; level != levels; ++level) {
+        size += static_cast<size_t>(width) * height * texel_size;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return size;
+}
+
+static bool parse_uniform_type(const string &name, UniformType &type) {
+    if (name == "int" || name == "bool" || name == "sampler2D") {
+        type = UNIFORM_INT;
+    } else if (name == "uint") {
+        type = UNIFORM_UINT;
+    } else if (name == "float") {
+        type = UNIFORM_FLOAT;
+    } else if (name == "vec3") {
+        type = UNIFORM_VEC3;
+    } else if (name == "vec4") {
+        type = UNIFORM_VEC4;
+    } else if (name == "mat3") {
+        type = UNIFORM_MAT3;
+    } else if (name == "mat4") {
+        type = UNIFORM_MAT4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void RenderDevice::parse_declarations(const string &source, std::map<string, UniformType> &uniforms,
+                                      std::set<string> &blocks) {
+    // split into identifiers and single punctuation characters, comments and the preprocessor are skipped
+    std::vector<string> tokens;
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (source.compare(i, 2, "//") == 0 || c == '#') {
+            i = source.find('\n', i);
+            if (i == string::npos) {
+                break;
+            }
+        } else if (source.compare(i, 2, "/*") == 0) {
+            i = source.find("*/", i);
+            if (i == string::npos) {
+                break;
+            }
+            i += 2;
+        } else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = i;
+            while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                ++i;
+            }
+            tokens.push_back(source.substr(start, i - start));
+        } else {
+            if (!std::isspace(static_cast<unsigned char>(c))) {
+                tokens.push_back(string(1, c));
+            }
+            ++i;
+        }
+    }
+    for (size_t t = 0; t + 2 < tokens.size(); ++t) {
+        if (tokens[t] != "uniform") {
+            continue;
+        }
+        if (tokens[t + 2] == "{") {
+            blocks.insert(tokens[t + 1]);
+            continue;
+        }
+        UniformType type;
+        if (!parse_uniform_type(tokens[t + 1], type)) {
+            throw std::runtime_error("Unsupported uniform type " + tokens[t + 1] + "!");
+        }
+        uniforms[tokens[t + 2]] = type;
+    }
+}
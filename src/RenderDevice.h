@@ -0,0 +1,191 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_RENDERDEVICE_H
+#define LEARNOPENGL_RENDERDEVICE_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+using std::string;
+
+using glm::vec3;
+using glm::vec4;
+using glm::mat3;
+using glm::mat4;
+
+enum DeviceBackend {
+    BACKEND_GL, BACKEND_NULL, BACKEND_SOFTWARE
+};
+
+enum UniformType {
+    UNIFORM_INT, UNIFORM_UINT, UNIFORM_FLOAT, UNIFORM_VEC3, UNIFORM_VEC4, UNIFORM_MAT3, UNIFORM_MAT4
+};
+
+// a uniform with an already resolved location, so it can be recorded without touching the device
+struct UniformValue {
+    int location = -1;
+    UniformType type = UNIFORM_INT;
+    union {
+        int i;
+        unsigned u;
+        float f[16];
+    } data;
+
+    UniformValue() = default;
+    UniformValue(int location, int value);
+    UniformValue(int location, unsigned value);
+    UniformValue(int location, float value);
+    UniformValue(int location, const vec3 &value);
+    UniformValue(int location, const vec4 &value);
+    UniformValue(int location, const mat3 &value);
+    UniformValue(int location, const mat4 &value);
+};
+
+// one float attribute of a vertex array, read from the vertex buffer of the array
+struct VertexAttribute {
+    unsigned location;
+    int components;
+    unsigned stride;
+    unsigned offset;
+};
+
+// the thin layer between the renderer and the graphics API, objects are plain handles and enums are the GL ones so
+// the GL backend can pass everything through, handle 0 is never a valid object
+class RenderDevice {
+
+public:
+    // what went through the device, the draw counters add up until reset_frame_counters() while the object counters
+    // always describe what is alive
+    struct Counters {
+        unsigned long long draws = 0;
+        unsigned long long vertices = 0;
+        unsigned long long triangles = 0;
+        // the render queue only binds what changed, so these are the switches
+        unsigned long long program_binds = 0;
+        unsigned long long vertex_array_binds = 0;
+        unsigned long long texture_binds = 0;
+        unsigned long long uniform_calls = 0;
+        unsigned long long buffer_updates = 0;
+        unsigned long long bytes_uploaded = 0;
+        unsigned long long clears = 0;
+        unsigned long long fence_waits = 0;
+        // occlusion and timer query results read back, they are only read once available so none of them waited
+        unsigned long long query_reads = 0;
+
+        unsigned shaders = 0;
+        unsigned programs = 0;
+        unsigned buffers = 0;
+        unsigned vertex_arrays = 0;
+        // only the GL code that renders to textures itself has them
+        unsigned framebuffers = 0;
+        unsigned textures = 0;
+        size_t buffer_bytes = 0;
+        size_t texture_bytes = 0;
+    };
+
+    virtual ~RenderDevice() = default;
+
+    // the device Shader, Texture2D and the renderer create their objects on, of the calling thread, returns the previous
+    // one
+    static RenderDevice *set_current(RenderDevice *device);
+    static RenderDevice &get_current();
+
+    virtual DeviceBackend get_backend() const = 0;
+
+    // throws with the compile or link log if that fails, name is the file the source came from, backends that cannot
+    // compile GLSL look up their port of the shader by it
+    virtual unsigned create_shader(GLenum stage, const string &source, const string &name) = 0;
+    virtual unsigned create_program(unsigned vertex_shader, unsigned fragment_shader) = 0;
+    virtual void destroy_shader(unsigned shader) = 0;
+    virtual void destroy_program(unsigned program) = 0;
+    // -1 if the program has no active uniform with that name
+    virtual int get_uniform_location(unsigned program, const string &name) = 0;
+    // does nothing if the program has no such block
+    virtual void bind_uniform_block(unsigned program, const string &name, unsigned binding) = 0;
+    virtual void use_program(unsigned program) = 0;
+    // sets a uniform of the program in use
+    virtual void set_uniform(const UniformValue &value) = 0;
+
+    virtual unsigned create_buffer(GLenum target, size_t size, const void *data, GLenum usage) = 0;
+    // unsynchronized promises that the GPU is done with the range, e.g. because a fence said so
+    virtual void update_buffer(unsigned buffer, size_t offset, size_t size, const void *data,
+                               bool unsynchronized = false) = 0;
+    virtual void bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) = 0;
+    virtual void destroy_buffer(unsigned buffer) = 0;
+    virtual size_t get_uniform_buffer_alignment() const = 0;
+
+    virtual unsigned create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                         unsigned attribute_count) = 0;
+    virtual void destroy_vertex_array(unsigned vertex_array) = 0;
+    virtual void bind_vertex_array(unsigned vertex_array) = 0;
+
+    // 8 bits per channel, format is GL_RGB or GL_RGBA, the mip chain is generated
+    virtual unsigned create_texture_2d(int width, int height, GLenum format, const void *pixels) = 0;
+    virtual void set_texture_parameter(unsigned texture, GLenum parameter, int value) = 0;
+    virtual void bind_texture(unsigned unit, unsigned texture) = 0;
+    virtual void destroy_texture(unsigned texture) = 0;
+    // a texture for the GPU to render into, format is one of the sized formats get_render_target_size() knows, levels
+    // is the length of its mip chain, it is filtered with GL_NEAREST and destroyed with destroy_texture()
+    virtual unsigned create_render_target(int width, int height, GLenum format, int levels) = 0;
+    // the bytes of such a render target, throws for any other format
+    static size_t get_render_target_size(int width, int height, GLenum format, int levels);
+
+    virtual void set_viewport(int x, int y, int width, int height) = 0;
+    // while enabled, draws and clears only touch the pixels inside the rectangle
+    virtual void set_scissor(bool enabled, int x, int y, int width, int height) = 0;
+    // clears color and depth
+    virtual void clear(float red, float green, float blue, float alpha) = 0;
+    virtual void set_depth_test(bool enabled) = 0;
+    virtual void set_depth_write(bool enabled) = 0;
+    // GL_LESS, GL_LEQUAL or GL_EQUAL
+    virtual void set_depth_func(GLenum func) = 0;
+    // a depth only draw leaves the color buffer alone
+    virtual void set_color_write(bool enabled) = 0;
+    // alpha blending with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    virtual void set_blend(bool enabled) = 0;
+    // GL_FILL or GL_LINE
+    virtual void set_polygon_mode(GLenum mode) = 0;
+    // draws with the program, vertex array and textures bound, inside conditional rendering (GL_QUERY_NO_WAIT) on
+    // condition_query if it is not 0 and the backend has queries
+    virtual void draw(GLenum mode, int first, int count, unsigned condition_query = 0) = 0;
+
+    // fences that signal when the GPU has finished everything issued before them
+    virtual void *insert_fence() = 0;
+    virtual void wait_fence(void *fence) = 0;
+    // never waits
+    virtual bool is_fence_signaled(void *fence) = 0;
+    virtual void destroy_fence(void *fence) = 0;
+
+    const Counters &get_counters() const;
+    void reset_frame_counters();
+    // for the GL code that draws, binds and uploads itself, so its passes are counted like everything else
+    void add_draw(GLenum mode, int count);
+    void add_binds(unsigned programs, unsigned vertex_arrays, unsigned textures);
+    void add_uniform_calls(unsigned calls);
+    void add_buffer_update(size_t size);
+    // for the GL code that creates its objects itself, negative for the ones it deletes
+    void add_objects(int buffers, int vertex_arrays, int framebuffers);
+    void add_buffer_bytes(long long bytes);
+    // for the GL code that reads its queries itself
+    void add_query_reads(unsigned reads);
+
+protected:
+    Counters counters;
+
+    // counts a draw of count vertices assembled as mode
+    void count_draw(GLenum mode, int count);
+
+    // finds the uniforms (samplers count as ints) and uniform blocks declared in GLSL source, throws on uniform types
+    // the devices do not support
+    static void parse_declarations(const string &source, std::map<string, UniformType> &uniforms,
+                                  std::set<string> &blocks);
+};
+
+
+#endif //LEARNOPENGL_RENDERDEVICE_H
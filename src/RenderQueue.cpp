@@ -0,0 +1,232 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+#define KEY_PASS_BITS 4
+#define KEY_PROGRAM_BITS 8
+#define KEY_MATERIAL_BITS 12
+#define KEY_VAO_BITS 12
+#define KEY_DEPTH_BITS 24
+
+unsigned RenderQueue::Stats::get_state_changes() const {
+    return this->program_changes + this->vao_changes + this->texture_changes;
+}
+
+void RenderQueue::begin_frame(float far_plane) {
+    this->far = far_plane;
+    this->stats = Stats();
+    this->items.clear();
+    this->direct_list.reset();
+    this->batch_items.clear();
+    this->batch_order.clear();
+    this->batch_list.reset();
+    for (auto &entry : this->program_uniforms) {
+        entry.second.applied = false;
+    }
+}
+
+void RenderQueue::set_program_uniforms(const Shader &shader, const std::vector<UniformValue> &values) {
+    ProgramUniforms &entry = this->program_uniforms[&shader];
+    entry.uniforms = values;
+    entry.applied = false;
+}
+
+void RenderQueue::submit(const DrawItem &item, const UniformValue *values, unsigned uniform_count) {
+    this->direct_list.record(item, values, uniform_count);
+    this->items.push_back(this->direct_list.get_last());
+}
+
+void RenderQueue::submit(const DrawItem &item, const std::vector<UniformValue> &values) {
+    this->submit(item, values.data(), static_cast<unsigned>(values.size()));
+}
+
+void RenderQueue::submit(const CommandList &list) {
+    for (const DrawPacket *packet = list.get_first(); packet; packet = packet->next) {
+        this->items.push_back(packet);
+    }
+}
+
+uint64_t RenderQueue::make_key(unsigned pass, bool translucent, unsigned program, unsigned material, unsigned vao,
+                               float normalized_depth) {
+    const uint64_t depth_max = (1ULL << KEY_DEPTH_BITS) - 1;
+    auto depth = static_cast<uint64_t>(std::min(std::max(normalized_depth, 0.0F), 1.0F) * depth_max);
+    uint64_t state = static_cast<uint64_t>(program & ((1U << KEY_PROGRAM_BITS) - 1));
+    state = (state << KEY_MATERIAL_BITS) | (material & ((1U << KEY_MATERIAL_BITS) - 1));
+    state = (state << KEY_VAO_BITS) | (vao & ((1U << KEY_VAO_BITS) - 1));
+    const int state_bits = KEY_PROGRAM_BITS + KEY_MATERIAL_BITS + KEY_VAO_BITS;
+    // 3 bits are left over at the bottom
+    uint64_t key = static_cast<uint64_t>(pass & ((1U << KEY_PASS_BITS) - 1)) << 60;
+    if (translucent) {
+        // back to front first, the state only breaks ties
+        key |= 1ULL << 59;
+        key |= (depth_max - depth) << (59 - KEY_DEPTH_BITS);
+        key |= state << (59 - KEY_DEPTH_BITS - state_bits);
+    } else {
+        key |= state << (59 - state_bits);
+        key |= depth << (59 - state_bits - KEY_DEPTH_BITS);
+    }
+    return key;
+}
+
+uint64_t RenderQueue::compute_key(const DrawItem &item) {
+    auto program = this->program_ids.insert(std::make_pair(item.shader, this->program_ids.size())).first->second;
+    auto material = this->material_ids.insert(std::make_pair(std::make_pair(item.textures[0], item.textures[1]),
+                                                             this->material_ids.size())).first->second;
+    auto vao = this->vao_ids.insert(std::make_pair(item.vao, this->vao_ids.size())).first->second;
+    return make_key(item.pass, item.translucent, static_cast<unsigned>(program), static_cast<unsigned>(material),
+                    static_cast<unsigned>(vao), item.depth / this->far);
+}
+
+void RenderQueue::radix_sort() {
+    size_t count = this->keys.size();
+    this->sorted_keys.resize(count);
+    this->sorted_order.resize(count);
+    // least significant byte first, every pass is stable
+    for (int shift = 0; shift != 64; shift += 8) {
+        size_t histogram[256] = {0};
+        for (uint64_t key : this->keys) {
+            ++histogram[(key >> shift) & 0xFF];
+        }
+        // all keys share this byte, nothing would move
+        if (histogram[(this->keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t &bucket : histogram) {
+            size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i != count; ++i) {
+            size_t destination = histogram[(this->keys[i] >> shift) & 0xFF]++;
+            this->sorted_keys[destination] = this->keys[i];
+            this->sorted_order[destination] = this->order[i];
+        }
+        this->keys.swap(this->sorted_keys);
+        this->order.swap(this->sorted_order);
+    }
+}
+
+void RenderQueue::execute() {
+    this->sort_items();
+    this->draw(this->items, this->order, ~0U);
+    this->items.clear();
+    this->direct_list.reset();
+}
+
+void RenderQueue::sort() {
+    this->sort_items();
+    this->batch_items.swap(this->items);
+    this->batch_order.swap(this->order);
+    std::swap(this->batch_list, this->direct_list);
+    this->items.clear();
+    this->direct_list.reset();
+}
+
+void RenderQueue::execute_view(unsigned view) {
+    this->draw(this->batch_items, this->batch_order, 1U << view);
+}
+
+void RenderQueue::sort_items() {
+    this->stats.items += static_cast<unsigned>(this->items.size());
+    this->keys.resize(this->items.size());
+    this->order.resize(this->items.size());
+    if (this->items.empty()) {
+        return;
+    }
+    for (size_t i = 0; i != this->items.size(); ++i) {
+        const DrawItem &item = this->items[i]->item;
+        this->keys[i] = this->compute_key(item);
+        this->order[i] = static_cast<uint32_t>(i);
+        this->stats.naive_state_changes += 2 + (item.textures[0] != 0) + (item.textures[1] != 0);
+    }
+    this->radix_sort();
+}
+
+void RenderQueue::draw(const std::vector<const DrawPacket *> &draw_items, const std::vector<uint32_t> &draw_order,
+                       uint32_t view_bits) {
+    RenderDevice &device = RenderDevice::get_current();
+    const Shader *shader = nullptr;
+    unsigned vao = 0;
+    unsigned textures[2] = {0, 0};
+    bool blending = false;
+    bool depth_write = true;
+    bool depth_equal = false;
+    bool color_write = true;
+    for (uint32_t index : draw_order) {
+        const DrawPacket &packet = *draw_items[index];
+        const DrawItem &item = packet.item;
+        if (!(item.view_mask & view_bits)) {
+            continue;
+        }
+        if (item.translucent != blending) {
+            blending = item.translucent;
+            device.set_blend(blending);
+        }
+        // translucent items and the ones whose depth is already there leave the depth buffer alone
+        if ((!item.translucent && !item.depth_prepassed) != depth_write) {
+            depth_write = !depth_write;
+            device.set_depth_write(depth_write);
+        }
+        if (item.depth_prepassed != depth_equal) {
+            depth_equal = item.depth_prepassed;
+            device.set_depth_func(depth_equal ? GL_EQUAL : GL_LESS);
+        }
+        if ((item.pass != PASS_DEPTH) != color_write) {
+            color_write = item.pass != PASS_DEPTH;
+            device.set_color_write(color_write);
+        }
+        if (item.shader != shader) {
+            shader = item.shader;
+            shader->use();
+            ++this->stats.program_changes;
+            auto entry = this->program_uniforms.find(shader);
+            // uniforms stick to the program, so once per frame is enough no matter how often we switch back
+            if (entry != this->program_uniforms.end() && !entry->second.applied) {
+                for (const auto &uniform : entry->second.uniforms) {
+                    device.set_uniform(uniform);
+                }
+                this->stats.uniform_calls += static_cast<unsigned>(entry->second.uniforms.size());
+                entry->second.applied = true;
+            }
+        }
+        if (item.vao != vao) {
+            vao = item.vao;
+            device.bind_vertex_array(vao);
+            ++this->stats.vao_changes;
+        }
+        for (unsigned unit = 0; unit != 2; ++unit) {
+            if (item.textures[unit] != 0 && item.textures[unit] != textures[unit]) {
+                textures[unit] = item.textures[unit];
+                device.bind_texture(unit, textures[unit]);
+                ++this->stats.texture_changes;
+            }
+        }
+        for (unsigned i = 0; i != packet.uniform_count; ++i) {
+            device.set_uniform(packet.uniforms[i]);
+        }
+        this->stats.uniform_calls += packet.uniform_count;
+        ++this->stats.draws;
+        device.draw(item.mode, item.first, item.count, item.condition_query);
+    }
+    if (blending) {
+        device.set_blend(false);
+    }
+    if (!depth_write) {
+        device.set_depth_write(true);
+    }
+    if (depth_equal) {
+        device.set_depth_func(GL_LESS);
+    }
+    if (!color_write) {
+        device.set_color_write(true);
+    }
+}
+
+const RenderQueue::Stats &RenderQueue::get_stats() const {
+    return this->stats;
+}
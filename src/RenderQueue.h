@@ -0,0 +1,92 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_RENDERQUEUE_H
+#define LEARNOPENGL_RENDERQUEUE_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <glad/glad.h>
+
+#include "CommandList.h"
+#include "Shader.h"
+
+// collects the draws of a frame, sorts them by a packed 64 bit key and executes them with as few state changes as
+// possible, the key is (pass, translucency, program, material, VAO, depth) for opaque items and
+// (pass, translucency, inverted depth, program, material, VAO) for translucent ones, the draws of several views are
+// sorted once into a batch that every view walks, skipping the items not in its view mask
+class RenderQueue {
+
+public:
+    struct Stats {
+        unsigned items = 0;
+        // the items times the views that drew them
+        unsigned draws = 0;
+        unsigned program_changes = 0;
+        unsigned vao_changes = 0;
+        unsigned texture_changes = 0;
+        unsigned uniform_calls = 0;
+        // what rebinding everything for every item (as the hand written draw code did) would have cost
+        unsigned naive_state_changes = 0;
+
+        unsigned get_state_changes() const;
+    };
+
+    // far is the largest depth that still sorts correctly
+    void begin_frame(float far = 300.0F);
+    // uniforms that are the same for every item drawn with the program, set once per frame before its first item
+    void set_program_uniforms(const Shader &shader, const std::vector<UniformValue> &uniforms);
+    void submit(const DrawItem &item, const UniformValue *uniforms = nullptr, unsigned uniform_count = 0);
+    void submit(const DrawItem &item, const std::vector<UniformValue> &uniforms);
+    // merges the draws recorded into a list, the list must stay untouched until execute()
+    void submit(const CommandList &list);
+    // sorts and draws everything submitted since begin_frame() or the last execute() on the current render device, it
+    // may be called several times a frame when something has to happen in between, the stats add up until the next
+    // begin_frame()
+    void execute();
+    // sorts everything submitted since begin_frame() or the last execute() into the batch of the views, which lives
+    // until the next sort() or begin_frame(), the lists must stay untouched until then
+    void sort();
+    // draws the items of the batch whose view mask has the bit of view, the caller binds what the view needs first
+    void execute_view(unsigned view);
+
+    static uint64_t make_key(unsigned pass, bool translucent, unsigned program, unsigned material, unsigned vao,
+                             float normalized_depth);
+    const Stats &get_stats() const;
+
+private:
+    struct ProgramUniforms {
+        std::vector<UniformValue> uniforms;
+        bool applied = false;
+    };
+
+    float far = 300.0F;
+    // what was submitted directly instead of through a list
+    CommandList direct_list;
+    std::vector<const DrawPacket *> items;
+    std::vector<uint64_t> keys, sorted_keys;
+    std::vector<uint32_t> order, sorted_order;
+    // what sort() took out of the above
+    CommandList batch_list;
+    std::vector<const DrawPacket *> batch_items;
+    std::vector<uint32_t> batch_order;
+    std::map<const Shader *, ProgramUniforms> program_uniforms;
+    // small ids so the programs, materials and VAOs fit into their key bits
+    std::map<const Shader *, unsigned> program_ids;
+    std::map<std::pair<unsigned, unsigned>, unsigned> material_ids;
+    std::map<unsigned, unsigned> vao_ids;
+    Stats stats;
+
+    uint64_t compute_key(const DrawItem &item);
+    // sorts items into order
+    void sort_items();
+    void radix_sort();
+    // draws the items in order whose view mask intersects view_bits
+    void draw(const std::vector<const DrawPacket *> &draw_items, const std::vector<uint32_t> &draw_order,
+              uint32_t view_bits);
+};
+
+
+#endif //LEARNOPENGL_RENDERQUEUE_H
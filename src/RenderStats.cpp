@@ -0,0 +1,64 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "RenderStats.h"
+
+const int RenderStats::FRAME_TIME_BUCKET_COUNT;
+const double RenderStats::FRAME_TIME_BUCKETS[FRAME_TIME_BUCKET_COUNT] = {
+        1.0, 2.0, 4.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.3, 50.0, 66.7, 100.0, 250.0
+};
+std::mutex RenderStats::mutex;
+RenderStats::Frame RenderStats::frames[2];
+unsigned RenderStats::front = 0;
+std::chrono::steady_clock::time_point RenderStats::last_end;
+std::atomic<bool> RenderStats::publishing{false};
+TripleBuffer<RenderStats::Frame> RenderStats::published_frames;
+
+void RenderStats::end_frame(const RenderDevice::Counters &counters) {
+    auto now = std::chrono::steady_clock::now();
+    // the back frame is the render thread's alone, the readers only copy the front one under the lock
+    const Frame &previous = frames[front];
+    Frame &back = frames[1 - front];
+    back = previous;
+    back.index = previous.index + 1;
+    back.counters = counters;
+    back.frame_ms = 0;
+    if (previous.index) {
+        back.frame_ms = std::chrono::duration<double, std::milli>(now - last_end).count();
+        for (int bucket = 0; bucket != FRAME_TIME_BUCKET_COUNT; ++bucket) {
+            if (back.frame_ms <= FRAME_TIME_BUCKETS[bucket]) {
+                ++back.frame_ms_buckets[bucket];
+            }
+        }
+        ++back.frame_ms_count;
+        back.frame_ms_sum += back.frame_ms;
+    }
+    last_end = now;
+    for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+        back.memory[tag] = MemoryTracker::get_stats_lock_free(static_cast<MemoryTag>(tag));
+    }
+    if (publishing.load(std::memory_order_relaxed)) {
+        published_frames.get_write_buffer() = back;
+        published_frames.publish();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    front = 1 - front;
+}
+
+RenderStats::Frame RenderStats::get_last_frame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return frames[front];
+}
+
+void RenderStats::set_publishing(bool enabled) {
+    publishing.store(enabled, std::memory_order_relaxed);
+}
+
+bool RenderStats::acquire_published_frame() {
+    return published_frames.acquire();
+}
+
+const RenderStats::Frame &RenderStats::get_published_frame() {
+    return published_frames.get_read_buffer();
+}
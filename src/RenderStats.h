@@ -0,0 +1,67 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_RENDERSTATS_H
+#define LEARNOPENGL_RENDERSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "MemoryTracker.h"
+#include "RenderDevice.h"
+#include "TripleBuffer.h"
+
+// what the last finished frame cost, for any thread: the renderer hands over the counters of every frame it finished,
+// they are written into the back one of two frames and swapped to the front, which the readers copy, so neither side
+// ever sees a frame half written nor waits for more than a copy
+class RenderStats {
+
+public:
+    static const int FRAME_TIME_BUCKET_COUNT = 13;
+    // the upper bounds of the buckets of the frame time histogram in milliseconds, frames slower than the last one
+    // only count in the total
+    static const double FRAME_TIME_BUCKETS[FRAME_TIME_BUCKET_COUNT];
+
+    struct Frame {
+        // 0 before the first frame
+        unsigned long long index = 0;
+        // the draw counters of the frame and the objects alive at its end
+        RenderDevice::Counters counters;
+        // from the end of the previous frame to the end of this one, 0 for the first
+        double frame_ms = 0;
+        // of all frames so far but the first, each bucket counts the frames at most as slow as its bound
+        unsigned long long frame_ms_buckets[FRAME_TIME_BUCKET_COUNT] = {};
+        unsigned long long frame_ms_count = 0;
+        double frame_ms_sum = 0;
+        // what every memory tag held at the end of the frame, read without the lock of the tracker
+        MemoryTracker::Stats memory[MEMORY_TAG_COUNT];
+    };
+
+    RenderStats() = delete;
+
+    // call on the render thread once a frame has been submitted, with what went through the device for it
+    static void end_frame(const RenderDevice::Counters &counters);
+    static Frame get_last_frame();
+
+    // while enabled every frame is also published to a single consumer thread without any lock, the render thread
+    // pays a copy per frame for it, only one consumer may exist at a time
+    static void set_publishing(bool enabled);
+    // consumer side, returns whether a newer frame than the current published one was taken
+    static bool acquire_published_frame();
+    static const Frame &get_published_frame();
+
+private:
+    static std::mutex mutex;
+    static Frame frames[2];
+    // the frame readers copy, only the render thread swaps it
+    static unsigned front;
+    // when the render thread ended the last frame
+    static std::chrono::steady_clock::time_point last_end;
+    static std::atomic<bool> publishing;
+    static TripleBuffer<Frame> published_frames;
+};
+
+
+#endif //LEARNOPENGL_RENDERSTATS_H
@@ -0,0 +1,1086 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "Scene.h"
+
+#include <glad/glad.h>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <deque>
+#include <initializer_list>
+#include <fstream>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Texture2D.h"
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "MaskedOcclusionCuller.h"
+#include "GpuOcclusionCuller.h"
+#include "HiZPyramid.h"
+#include "DynamicResolution.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameGraph.h"
+#include "CommandList.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "FramePipeline.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+
+// the uniform buffer binding point of FrameData
+#define FRAME_DATA_BINDING 0
+// how many views a frame can be drawn from, the FrameData of all of them share a slot of the uniform buffer ring
+#define MAX_VIEWS 4
+// the overview looks straight down from this high above the camera and shows this far around it
+#define OVERVIEW_HEIGHT 50.0F
+#define OVERVIEW_EXTENT 20.0F
+// the side of the overview as a fraction of the shorter side of the window
+#define OVERVIEW_FRACTION 0.3F
+// how far below the diagonal the grid of the extra cubes is
+#define CUBE_GRID_HEIGHT (-3.0F)
+// the perspective of the main view
+#define FIELD_OF_VIEW 45.0F
+#define NEAR_PLANE 0.1F
+#define FAR_PLANE 300.0F
+// the most the late latch turns the main view away from the sampled one, in degrees of yaw and of pitch each, the
+// main view is frustum culled with a guard band this wide so nothing it turns into is missing
+#define LATE_LATCH_MAX_DEGREES 2.0F
+
+// the FrameData uniform block of the shaders, std140 layout
+struct FrameData {
+    glm::mat4 view_matrix;
+    glm::mat4 projection_matrix;
+    glm::vec4 view_position;
+};
+
+// a camera a frame is drawn from, the first view of a frame is the main one
+struct View {
+    glm::mat4 view_matrix;
+    glm::mat4 projection_matrix;
+    glm::vec3 position;
+    // x, y, width and height in the framebuffer
+    glm::ivec4 viewport;
+};
+
+// a frame between its snapshot and its submission
+struct PreparedFrame {
+    FrameSnapshot snapshot;
+    std::vector<View> views;
+    // of the main view
+    glm::mat4 view_projection_matrix;
+    glm::vec3 translation;
+    // what any view sees and which views see it, bit i for view i
+    std::vector<unsigned> visible_objects;
+    std::vector<uint32_t> view_masks;
+    // the objects of the main view that the GL thread tests with occlusion queries
+    std::vector<unsigned> main_objects;
+    // the ones of them that survived the filtering on the GL thread
+    std::vector<unsigned> draw_objects;
+    // scratch space with an entry per object
+    std::vector<bool> object_marks;
+    // one per worker of the pool
+    std::vector<CommandList> command_lists;
+    // whether the draws are recorded yet, a frame that needs the GL thread to filter its objects is recorded there
+    bool recorded = false;
+    bool needs_gl = false;
+    // whether the opaque objects lay down their depth first
+    bool depth_prepass = false;
+    double record_ms = 0;
+    MaskedOcclusionCuller::Stats occlusion_stats;
+};
+
+// the objects whose mask has the bit of view
+static void get_view_objects(const std::vector<unsigned> &objects, const std::vector<uint32_t> &masks, unsigned view,
+                             std::vector<unsigned> &view_objects) {
+    view_objects.clear();
+    for (size_t i = 0; i != objects.size(); ++i) {
+        if (masks[i] & (1U << view)) {
+            view_objects.push_back(objects[i]);
+        }
+    }
+}
+
+// takes the main view out of the masks of the objects that further culling for it dropped, kept are the ones it kept,
+// the objects no view sees anymore are removed, marks has an entry per object and is left all false
+static void refine_main_view(const std::vector<unsigned> &kept, std::vector<unsigned> &objects,
+                             std::vector<uint32_t> &masks, std::vector<bool> &marks) {
+    for (unsigned object : kept) {
+        marks[object] = true;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i != objects.size(); ++i) {
+        uint32_t mask = marks[objects[i]] ? masks[i] : masks[i] & ~1U;
+        if (mask != 0) {
+            objects[count] = objects[i];
+            masks[count++] = mask;
+        }
+    }
+    objects.resize(count);
+    masks.resize(count);
+    for (unsigned object : kept) {
+        marks[object] = false;
+    }
+}
+
+// a perspective projection whose frustum has every side plane turned outwards by margin degrees, it holds whatever a
+// turn of the camera by up to that angle brings into the frustum of the same perspective without it
+static glm::mat4 get_guard_band_projection(float field_of_view, float aspect, float near, float far, float margin) {
+    float half_y = glm::radians(field_of_view) * 0.5F;
+    float half_x = std::atan(aspect * std::tan(half_y));
+    float margin_radians = glm::radians(margin);
+    return glm::perspective(2.0F * (half_y + margin_radians),
+                            std::tan(half_x + margin_radians) / std::tan(half_y + margin_radians), near, far);
+}
+
+// copies the vertices into a new vertex buffer and creates a vertex array that reads the attributes from it, the
+// buffer goes to vertex_buffer if given
+static unsigned int init_vao(RenderDevice &device, const float *vertices, size_t size,
+                             std::initializer_list<VertexAttribute> attributes, unsigned *vertex_buffer = nullptr) {
+    // OpenGL has many buffer types, and VBO has GL_ARRAY_BUFFER as its type
+    unsigned vbo_id = device.create_buffer(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    if (vertex_buffer) {
+        *vertex_buffer = vbo_id;
+    }
+    // the attributes tell the program how to read the buffer:
+    // location, size of vertex attributes, stride, offset
+    return device.create_vertex_array(vbo_id, attributes.begin(), static_cast<unsigned>(attributes.size()));
+}
+
+unsigned int init_cube_vao(RenderDevice &device, unsigned *vertex_buffer) {
+    // vertex data and VBO
+    float vertices[] = {
+            // 3 positions,                2 tex coords
+            // front
+            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            -0.5, 0.5, 0.5, 0.0, 1.0, // left top
+            0.5, 0.5, 0.5, 1.0, 1.0, // right top
+            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            0.5, 0.5, 0.5, 1.0, 1.0, // right top
+            0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
+            // back
+            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
+            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            0.5, -0.5, -0.5, 1.0, 0.0, // right bottom
+            // left
+            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
+            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
+            -0.5, 0.5, 0.5, 1.0, 1.0, // right top
+            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
+            -0.5, 0.5, 0.5, 1.0, 1.0, // right top
+            -0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
+            // right
+            0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            0.5, 0.5, 0.5, 0.0, 1.0, // left top
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            0.5, -0.5, -0.5, 1.0, 0.0, // right bottom
+            // top
+            -0.5, 0.5, 0.5, 0.0, 0.0, // left bottom
+            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            -0.5, 0.5, 0.5, 0.0, 0.0, // left bottom
+            0.5, 0.5, -0.5, 1.0, 1.0, // right top
+            0.5, 0.5, 0.5, 1.0, 0.0, // right bottom
+            // bottom
+            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            -0.5, -0.5, -0.5, 0.0, 1.0, // left top
+            0.5, -0.5, -0.5, 1.0, 1.0, // right top
+            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
+            0.5, -0.5, -0.5, 1.0, 1.0, // right top
+            0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
+    };
+    // right now, we have the data and a program to process the data, we still need a way to
+    // pass the data into the program
+    return init_vao(device, vertices, sizeof(vertices), {
+            {0, 3, 5 * sizeof(float), 0},
+            {1, 2, 5 * sizeof(float), 3 * sizeof(float)}
+    }, vertex_buffer);
+}
+
+static unsigned int init_coordinates_vao(RenderDevice &device, unsigned *vertex_buffer) {
+    float line_vertices[] = {
+        // x-axis
+        -1.0, 0.0, 0.0,
+        1.0, 0.0, 0.0,
+        // y-axis
+        0.0, -1.0, 0.0,
+        0.0, 1.0, 0.0,
+        // z-axis
+        0.0, 0.0, -1.0,
+        0.0, 0.0, 1.0,
+    };
+    return init_vao(device, line_vertices, sizeof(line_vertices), {{0, 3, 3 * sizeof(float), 0}}, vertex_buffer);
+}
+
+static unsigned int init_crosshair_vao(RenderDevice &device, unsigned *vertex_buffer) {
+    float vertices[] = {
+            -0.02, 0.0, 0.0,
+            0.02, 0.0, 0.0,
+            0.0, -0.02, 0.0,
+            0.0, 0.02, 0.0
+    };
+    return init_vao(device, vertices, sizeof(vertices), {{0, 3, 3 * sizeof(float), 0}}, vertex_buffer);
+}
+
+// positions of a unit cube as a triangle list, shared by the light source and the occlusion culler
+static const float cube_positions[] = {
+        -0.5, -0.5, 0.5,
+        -0.5, 0.5, 0.5,
+        0.5, 0.5, 0.5,
+        -0.5, -0.5, 0.5,
+        0.5, 0.5, 0.5,
+        0.5, -0.5, 0.5,
+        -0.5, -0.5, -0.5,
+        -0.5, 0.5, -0.5,
+        0.5, 0.5, -0.5,
+        -0.5, -0.5, -0.5,
+        0.5, 0.5, -0.5,
+        0.5, -0.5, -0.5,
+        -0.5, -0.5, -0.5,
+        -0.5, 0.5, -0.5,
+        -0.5, 0.5, 0.5,
+        -0.5, -0.5, -0.5,
+        -0.5, 0.5, 0.5,
+        -0.5, -0.5, 0.5,
+        0.5, -0.5, 0.5,
+        0.5, 0.5, 0.5,
+        0.5, 0.5, -0.5,
+        0.5, -0.5, 0.5,
+        0.5, 0.5, -0.5,
+        0.5, -0.5, -0.5,
+        -0.5, 0.5, 0.5,
+        -0.5, 0.5, -0.5,
+        0.5, 0.5, -0.5,
+        -0.5, 0.5, 0.5,
+        0.5, 0.5, -0.5,
+        0.5, 0.5, 0.5,
+        -0.5, -0.5, 0.5,
+        -0.5, -0.5, -0.5,
+        0.5, -0.5, -0.5,
+        -0.5, -0.5, 0.5,
+        0.5, -0.5, -0.5,
+        0.5, -0.5, 0.5,
+};
+
+unsigned int init_light_source_vao(RenderDevice &device, unsigned *vertex_buffer) {
+    return init_vao(device, cube_positions, sizeof(cube_positions), {{0, 3, 3 * sizeof(float), 0}}, vertex_buffer);
+}
+
+unsigned int init_lighting_cube_vao(RenderDevice &device, unsigned *vertex_buffer) {
+    float vertices[] = {
+            // front
+            -0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
+            -0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
+            0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
+            -0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
+            0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
+            0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
+            // back
+            -0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
+            -0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
+            0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
+            -0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
+            0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
+            0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
+            // left
+            -0.5, -0.5, -0.5, -1.0, 0.0, 0.0,
+            -0.5, 0.5, -0.5, -1.0, 0.0, 0.0,
+            -0.5, 0.5, 0.5, -1.0, 0.0, 0.0,
+            -0.5, -0.5, -0.5, -1.0, 0.0, 0.0,
+            -0.5, 0.5, 0.5, -1.0, 0.0, 0.0,
+            -0.5, -0.5, 0.5, -1.0, 0.0, 0.0,
+            // right
+            0.5, -0.5, 0.5, 1.0, 0.0, 0.0,
+            0.5, 0.5, 0.5, 1.0, 0.0, 0.0,
+            0.5, 0.5, -0.5, 1.0, 0.0, 0.0,
+            0.5, -0.5, 0.5, 1.0, 0.0, 0.0,
+            0.5, 0.5, -0.5, 1.0, 0.0, 0.0,
+            0.5, -0.5, -0.5, 1.0, 0.0, 0.0,
+            // top
+            -0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
+            -0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
+            0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
+            -0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
+            0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
+            0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
+            // bottom
+            -0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
+            -0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
+            0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
+            -0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
+            0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
+            0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
+    };
+    return init_vao(device, vertices, sizeof(vertices), {
+            {0, 3, 6 * sizeof(float), 0},
+            {1, 3, 6 * sizeof(float), 3 * sizeof(float)}
+    }, vertex_buffer);
+}
+
+// the cubes of a scene relative to base: the first DEFAULT_CUBE_COUNT go up the diagonal, the others fill a square grid
+// below it, two units apart
+static std::vector<glm::mat4> get_cube_model_matrices(const glm::mat4 &base, unsigned count) {
+    std::vector<glm::mat4> model_matrices;
+    auto side = static_cast<unsigned>(std::ceil(std::sqrt(static_cast<double>(
+            count > DEFAULT_CUBE_COUNT ? count - DEFAULT_CUBE_COUNT : 0))));
+    for (unsigned i = 0; i != count; ++i) {
+        vec3 position(static_cast<float>(i));
+        if (i >= DEFAULT_CUBE_COUNT) {
+            unsigned cell = i - DEFAULT_CUBE_COUNT;
+            position = vec3(static_cast<float>(cell % side) * 2.0F - static_cast<float>(side),
+                            CUBE_GRID_HEIGHT, -static_cast<float>(cell / side) * 2.0F);
+        }
+        model_matrices.push_back(glm::translate(base, position));
+    }
+    return model_matrices;
+}
+
+// adds the draw counters of frame to total
+static void add_draw_counters(RenderDevice::Counters &total, const RenderDevice::Counters &frame) {
+    RenderDevice::Counters objects = frame;
+    objects.draws = total.draws + frame.draws;
+    objects.vertices = total.vertices + frame.vertices;
+    objects.triangles = total.triangles + frame.triangles;
+    objects.program_binds = total.program_binds + frame.program_binds;
+    objects.vertex_array_binds = total.vertex_array_binds + frame.vertex_array_binds;
+    objects.texture_binds = total.texture_binds + frame.texture_binds;
+    objects.uniform_calls = total.uniform_calls + frame.uniform_calls;
+    objects.buffer_updates = total.buffer_updates + frame.buffer_updates;
+    objects.bytes_uploaded = total.bytes_uploaded + frame.bytes_uploaded;
+    objects.clears = total.clears + frame.clears;
+    objects.fence_waits = total.fence_waits + frame.fence_waits;
+    objects.query_reads = total.query_reads + frame.query_reads;
+    total = objects;
+}
+
+void render_scene(RenderDevice &device, const std::function<const FrameSnapshot *(bool)> &next_frame,
+                  const std::function<void(double)> &present, const std::function<bool(glm::dvec2 &)> &latch_mouse,
+                  const SceneDescription &description, SceneResults *results) {
+    // matrices
+    glm::mat4 projection_matrix(glm::perspective(glm::radians(FIELD_OF_VIEW),
+                                                 static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT,
+                                                 NEAR_PLANE, FAR_PLANE));
+    // the main view is culled with this one while late latching, a turn by the limit in yaw and in pitch moves a
+    // direction by up to twice the limit
+    glm::mat4 guard_band_projection_matrix = get_guard_band_projection(
+            FIELD_OF_VIEW, static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT, NEAR_PLANE, FAR_PLANE,
+            2.0F * LATE_LATCH_MAX_DEGREES);
+    bool wireframe_enabled = false;
+    unsigned reports_printed = 0;
+    RateCounter render_counter;
+    unsigned long long submitted_frames = 0;
+    // the frames whose draw counters go into the results, and whether the last one submitted is one of them, the
+    // counters of a frame are complete when the next one is submitted
+    unsigned long long measured_frames = 0;
+    bool last_frame_measured = false;
+    // frames whose view was latched, the ones of them the mouse turned, by how much and how late after sampling
+    unsigned long long latched_frames = 0, turned_frames = 0;
+    double latched_turn_degrees = 0, latch_delay_ms = 0;
+    // what the scene allocates is its own unless a scope further in says otherwise
+    MemoryTracker::Scope memory_scope("scene");
+    // the vertex buffers of the meshes, destroyed with their vertex arrays at the end
+    unsigned crosshair_vbo, coordinate_vbo, cube_vbo, light_source_vbo, lighting_cube_vbo;
+
+    // crosshair
+    Shader crosshair_shader("resource/shader/crosshair_vertex_shader.glsl",
+                            "resource/shader/crosshair_fragment_shader.glsl");
+    unsigned crosshair_vao = init_crosshair_vao(device, &crosshair_vbo);
+
+    // coordinate line
+    Shader coordinate_shader("resource/shader/line_vertex_shader.glsl",
+                             "resource/shader/line_fragment_shader.glsl");
+    glm::mat4 line_model_matrix = glm::scale(glm::mat4(1.0F), glm::vec3(10000.0F));
+    coordinate_shader.use();
+    coordinate_shader.set_uniform("model_matrix", line_model_matrix);
+    coordinate_shader.bind_uniform_block("FrameData", FRAME_DATA_BINDING);
+    unsigned coordinate_vao = init_coordinates_vao(device, &coordinate_vbo);
+
+    // cube initialization
+    Texture2D cube_texture1("resource/texture/grass_block_side.png");
+    Texture2D cube_texture2("resource/texture/oak_planks.png");
+    cube_texture1.bind(GL_TEXTURE0);
+    cube_texture2.bind(GL_TEXTURE1);
+    Shader cube_shader("resource/shader/cube_vertex_shader.glsl",
+                       "resource/shader/cube_fragment_shader.glsl");
+    cube_shader.use();
+    cube_shader.set_uniform("texture0", 0);
+    cube_shader.set_uniform("texture1", 1);
+    glm::mat4 cube_model_matrix = glm::translate(glm::mat4(1.0F), glm::vec3(0.5F));
+    cube_shader.set_uniform("model_matrix", cube_model_matrix);
+    cube_shader.bind_uniform_block("FrameData", FRAME_DATA_BINDING);
+    unsigned cube_vao = init_cube_vao(device, &cube_vbo);
+
+    // light source
+    Shader light_source_shader("resource/shader/cube_vertex_shader.glsl",
+                              "resource/shader/light_source_fragment_shader.glsl");
+    light_source_shader.use();
+    glm::vec3 light_source_position = glm::vec3(2.0F, 3.0F, -10.0F);
+    glm::mat4 light_source_model_matrix = glm::translate(glm::mat4(1.0F), light_source_position);
+    light_source_shader.set_uniform("model_matrix", light_source_model_matrix);
+    light_source_shader.bind_uniform_block("FrameData", FRAME_DATA_BINDING);
+    unsigned light_source_vao = init_light_source_vao(device, &light_source_vbo);
+
+    // lighting object
+    Shader lighting_cube_shader("resource/shader/lighting_cube_vertex_shader.glsl",
+                              "resource/shader/lighting_cube_fragment_shader.glsl");
+    lighting_cube_shader.use();
+    glm::mat4 lighting_cube_model_matrix = glm::translate(cube_model_matrix, glm::vec3(0, 0, 0));
+    lighting_cube_shader.set_uniform("model_matrix", lighting_cube_model_matrix); //glm::mat4(1.0F)
+    lighting_cube_shader.bind_uniform_block("FrameData", FRAME_DATA_BINDING);
+    lighting_cube_shader.set_uniform("light_color", 1.0F, 1.0F, 1.0F);
+    lighting_cube_shader.set_uniform("object_color", 1.0F, 0.5F, 0.31F);
+    lighting_cube_shader.set_uniform("light_position", light_source_position);
+    unsigned lighting_cube_vao = init_lighting_cube_vao(device, &lighting_cube_vbo);
+
+    // depth pre-pass, every object is a cube, so the position only VAO of the light source draws all of them
+    Shader depth_shader("resource/shader/depth_vertex_shader.glsl",
+                        "resource/shader/depth_fragment_shader.glsl");
+    depth_shader.bind_uniform_block("FrameData", FRAME_DATA_BINDING);
+    // without GL there is no GPU time to decide by, so the automatic mode leaves the pre-pass off
+    DepthPrepassController depth_prepass(device.get_backend() == BACKEND_GL);
+
+    // frustum culling, every object is a unit cube
+    FrustumCuller culler;
+    unsigned light_source_object = culler.add_object(light_source_position - vec3(0.5F),
+                                                     light_source_position + vec3(0.5F));
+    auto first_lighting_cube_object = static_cast<unsigned>(culler.get_object_count());
+    std::vector<glm::mat4> lighting_cube_model_matrices = get_cube_model_matrices(lighting_cube_model_matrix,
+                                                                                  description.cube_count);
+    for (const auto &model_matrix : lighting_cube_model_matrices) {
+        vec3 center = vec3(model_matrix[3]);
+        culler.add_object(center - vec3(0.5F), center + vec3(0.5F));
+    }
+    culler.build();
+    // occlusion culling of whatever survived the frustum, the lighting cubes are the occluders
+    ThreadPool pool;
+    MaskedOcclusionCuller occlusion_culler;
+    // hardware occlusion queries, the depth pyramid, the dynamic resolution and the profiler talk to GL directly, so
+    // other backends go without them, they are destroyed before the context goes away
+    std::unique_ptr<GpuOcclusionCuller> gpu_occlusion_culler;
+    std::unique_ptr<HiZPyramid> hiz_pyramid;
+    std::unique_ptr<DynamicResolution> dynamic_resolution;
+    std::unique_ptr<GpuProfiler> gpu_profiler;
+    if (device.get_backend() == BACKEND_GL) {
+        gpu_occlusion_culler.reset(new GpuOcclusionCuller(light_source_vao, 36));
+        hiz_pyramid.reset(new HiZPyramid());
+        dynamic_resolution.reset(new DynamicResolution(GPU_TARGET_MS));
+        gpu_profiler.reset(new GpuProfiler());
+    }
+
+    // the passes of every frame, the transient textures of hi-z and the scaled scene come from its pool, every pass is
+    // a zone of the profiler
+    FrameGraph frame_graph(device);
+    if (gpu_profiler) {
+        frame_graph.set_pass_hooks([&](const string &name) { gpu_profiler->begin(name); },
+                                   [&](const string &) { gpu_profiler->end(); });
+    }
+
+    // every draw goes through the render queue, the uniform locations are looked up once here
+    RenderQueue render_queue;
+    int light_source_model_location = light_source_shader.get_uniform_location("model_matrix");
+    int lighting_cube_light_location = lighting_cube_shader.get_uniform_location("light_position");
+    int lighting_cube_model_location = lighting_cube_shader.get_uniform_location("model_matrix");
+    int lighting_cube_normal_location = lighting_cube_shader.get_uniform_location("normal_matrix");
+    int depth_model_location = depth_shader.get_uniform_location("model_matrix");
+    // the occlusion query to draw each object conditionally with, 0 for none
+    std::vector<unsigned> condition_queries(culler.get_object_count());
+
+    // frames are prepared ahead of their submission, every slot of the pipeline has its own prepared frame
+    std::vector<PreparedFrame> prepared(MAX_PIPELINE_DEPTH);
+    std::unique_ptr<FramePipeline> pipeline(new FramePipeline(MAX_PIPELINE_DEPTH, sizeof(FrameData), MAX_VIEWS));
+    for (auto &prepared_frame : prepared) {
+        prepared_frame.command_lists.resize(pool.get_worker_count());
+        prepared_frame.object_marks.assign(culler.get_object_count(), false);
+    }
+    unsigned next_slot = 0;
+    // the slots being prepared or waiting for submission, oldest first
+    std::deque<unsigned> in_flight;
+    const FrameSnapshot *pending_frame = nullptr;
+    bool finished = false;
+
+    // records the objects in chunks on the pool, every worker into its own list
+    // an object some other view sees too is drawn without its query, which only knows about the main view
+    auto record_objects = [&](PreparedFrame &prepared_frame, const std::vector<unsigned> &objects,
+                              const std::vector<uint32_t> &masks, bool use_queries) {
+        CPU_PROFILE_ZONE("record objects");
+        auto record_start = std::chrono::steady_clock::now();
+        for (auto &list : prepared_frame.command_lists) {
+            list.reset();
+        }
+        const unsigned chunk_size = 256;
+        auto chunk_count = static_cast<unsigned>((objects.size() + chunk_size - 1) / chunk_size);
+        pool.parallel_for(chunk_count, [&](unsigned chunk, unsigned worker) {
+            CommandList &list = prepared_frame.command_lists[worker];
+            size_t end = std::min(objects.size(), static_cast<size_t>(chunk + 1) * chunk_size);
+            for (size_t j = static_cast<size_t>(chunk) * chunk_size; j != end; ++j) {
+                unsigned object = objects[j];
+                DrawItem item;
+                vec3 center, extent;
+                culler.get_bounds(object, center, extent);
+                item.depth = glm::distance(prepared_frame.snapshot.camera_position, center);
+                item.condition_query = use_queries && masks[j] == 1 ? condition_queries[object] : 0;
+                item.view_mask = masks[j];
+                item.count = 36;
+                glm::mat4 temp_matrix;
+                if (object == light_source_object) {
+                    temp_matrix = glm::translate(light_source_model_matrix, prepared_frame.translation);
+                } else {
+                    temp_matrix = lighting_cube_model_matrices[object - first_lighting_cube_object];
+                }
+                if (prepared_frame.depth_prepass) {
+                    DrawItem depth_item = item;
+                    depth_item.pass = PASS_DEPTH;
+                    depth_item.shader = &depth_shader;
+                    depth_item.vao = light_source_vao;
+                    *list.record(depth_item, 1) = UniformValue(depth_model_location, temp_matrix);
+                    item.depth_prepassed = true;
+                }
+                if (object == light_source_object) {
+                    item.shader = &light_source_shader;
+                    item.vao = light_source_vao;
+                    *list.record(item, 1) = UniformValue(light_source_model_location, temp_matrix);
+                    continue;
+                }
+                glm::mat3 normal_matrix = get_normal_matrix(temp_matrix);
+                item.shader = &lighting_cube_shader;
+                item.vao = lighting_cube_vao;
+                UniformValue *uniforms = list.record(item, 2);
+                uniforms[0] = UniformValue(lighting_cube_model_location, temp_matrix);
+                uniforms[1] = UniformValue(lighting_cube_normal_location, normal_matrix);
+            }
+        });
+        prepared_frame.recorded = true;
+        prepared_frame.record_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - record_start).count();
+    };
+
+    // everything that does not need GL: culling against the frustum and the software depth buffer and, unless the
+    // GL thread still has to filter the objects, recording the draws
+    auto prepare_frame = [&](PreparedFrame &prepared_frame, bool record) {
+        CPU_PROFILE_ZONE("prepare frame");
+        const FrameSnapshot &snapshot = prepared_frame.snapshot;
+        prepared_frame.translation = glm::vec3(static_cast<float>(sin(snapshot.light_time)) * 30, 0.0, 0.0);
+        prepared_frame.recorded = false;
+        glm::vec3 light_source_center = light_source_position + prepared_frame.translation;
+        culler.set_bounds(light_source_object, light_source_center - vec3(0.5F),
+                          light_source_center + vec3(0.5F));
+        culler.refit();
+        prepared_frame.view_projection_matrix = projection_matrix * snapshot.view_matrix;
+        std::vector<View> &views = prepared_frame.views;
+        views.clear();
+        views.push_back({snapshot.view_matrix, projection_matrix, snapshot.camera_position,
+                         glm::ivec4(0, 0, snapshot.framebuffer_width, snapshot.framebuffer_height)});
+        if (snapshot.overview_enabled) {
+            glm::vec3 eye = snapshot.camera_position + glm::vec3(0.0F, OVERVIEW_HEIGHT, 0.0F);
+            int size = static_cast<int>(static_cast<float>(std::min(snapshot.framebuffer_width,
+                                                                    snapshot.framebuffer_height)) * OVERVIEW_FRACTION);
+            views.push_back({glm::lookAt(eye, snapshot.camera_position, glm::vec3(0.0F, 0.0F, -1.0F)),
+                             glm::ortho(-OVERVIEW_EXTENT, OVERVIEW_EXTENT, -OVERVIEW_EXTENT, OVERVIEW_EXTENT, 0.1F,
+                                        OVERVIEW_HEIGHT * 2.0F), eye,
+                             glm::ivec4(snapshot.framebuffer_width - size, snapshot.framebuffer_height - size,
+                                        size, size)});
+        }
+        // one traversal for all views, then the main view alone goes through the occlusion culling, which keeps what
+        // lies in the guard band off its screen
+        std::vector<Frustum> frusta;
+        for (const View &view : views) {
+            frusta.emplace_back(view.projection_matrix * view.view_matrix);
+        }
+        if (snapshot.late_latch) {
+            frusta[0] = Frustum(guard_band_projection_matrix * views[0].view_matrix);
+        }
+        std::vector<unsigned> &visible_objects = prepared_frame.visible_objects;
+        culler.cull(frusta.data(), static_cast<unsigned>(frusta.size()), visible_objects, prepared_frame.view_masks);
+        std::vector<unsigned> &main_objects = prepared_frame.main_objects;
+        get_view_objects(visible_objects, prepared_frame.view_masks, 0, main_objects);
+        occlusion_culler.begin_frame(prepared_frame.view_projection_matrix);
+        for (unsigned object : main_objects) {
+            if (object >= first_lighting_cube_object) {
+                occlusion_culler.add_occluder(cube_positions, 36, 3,
+                                              lighting_cube_model_matrices[object - first_lighting_cube_object]);
+            }
+        }
+        occlusion_culler.rasterize(&pool);
+        occlusion_culler.cull(culler, main_objects);
+        prepared_frame.occlusion_stats = occlusion_culler.get_stats();
+        refine_main_view(main_objects, visible_objects, prepared_frame.view_masks, prepared_frame.object_marks);
+        if (record) {
+            record_objects(prepared_frame, visible_objects, prepared_frame.view_masks, false);
+        }
+    };
+
+    device.set_depth_test(true);
+    // what went through the device for the last frame
+    RenderDevice::Counters frame_counters;
+    // the render loop
+    while (true) {
+        // keep up to depth frames between their snapshot and their submission
+        while (!finished && in_flight.size() < pipeline->get_depth()) {
+            if (!pending_frame) {
+                {
+                    CPU_PROFILE_ZONE("next frame");
+                    pending_frame = next_frame(in_flight.empty());
+                }
+                if (!pending_frame) {
+                    finished = true;
+                    break;
+                }
+                // the last frame stays on screen, the ones in flight still get submitted
+                if (pending_frame->idle) {
+                    pending_frame = nullptr;
+                    break;
+                }
+                pipeline->set_depth(pending_frame->pipeline_depth);
+            }
+            // the depth pyramid and the queries are GL thread state that the culling of a frame has to see, so such
+            // a frame is neither prepared ahead nor overlapped with the preparation of the next one
+            bool use_hiz = pending_frame->hiz_enabled && hiz_pyramid;
+            bool use_queries = pending_frame->gpu_occlusion_enabled && gpu_occlusion_culler;
+            bool needs_gl = use_hiz || use_queries;
+            if (!in_flight.empty() && (needs_gl || prepared[in_flight.back()].needs_gl)) {
+                break;
+            }
+            unsigned slot = next_slot;
+            next_slot = (next_slot + 1) % pipeline->get_max_depth();
+            PreparedFrame &prepared_frame = prepared[slot];
+            prepared_frame.snapshot = *pending_frame;
+            prepared_frame.snapshot.hiz_enabled = use_hiz;
+            prepared_frame.snapshot.gpu_occlusion_enabled = use_queries;
+            prepared_frame.needs_gl = needs_gl;
+            depth_prepass.set_mode(pending_frame->depth_prepass_mode);
+            prepared_frame.depth_prepass = depth_prepass.decide();
+            pending_frame = nullptr;
+            pipeline->prepare(slot, [&, needs_gl, slot] { prepare_frame(prepared[slot], !needs_gl); },
+                              pipeline->get_depth() > 1 && !needs_gl);
+            in_flight.push_back(slot);
+        }
+        if (in_flight.empty()) {
+            break;
+        }
+        // the submission of a frame, from waiting for its preparation to its present
+        CPU_PROFILE_ZONE("submit frame");
+        unsigned slot = in_flight.front();
+        in_flight.pop_front();
+        {
+            CPU_PROFILE_ZONE("wait prepared");
+            pipeline->wait_prepared(slot);
+        }
+        PreparedFrame &prepared_frame = prepared[slot];
+        const FrameSnapshot &snapshot = prepared_frame.snapshot;
+
+        // what went through the device since the last frame was submitted, before the first one only the setup
+        frame_counters = device.get_counters();
+        device.reset_frame_counters();
+        if (submitted_frames) {
+            RenderStats::end_frame(frame_counters);
+        }
+        if (results && last_frame_measured) {
+            add_draw_counters(results->counters, frame_counters);
+        }
+        last_frame_measured = snapshot.measured;
+        const std::vector<View> &views = prepared_frame.views;
+
+        // the scene is rendered at render_width x render_height, which is less than the window when the GPU is slow
+        int viewport_width = snapshot.framebuffer_width, viewport_height = snapshot.framebuffer_height;
+        int render_width = viewport_width, render_height = viewport_height;
+        bool scaled = false;
+        if (dynamic_resolution) {
+            dynamic_resolution->poll();
+            dynamic_resolution->set_enabled(snapshot.dynamic_resolution_enabled);
+            dynamic_resolution->set_target_ms(snapshot.gpu_target_ms);
+            dynamic_resolution->get_render_size(viewport_width, viewport_height, render_width, render_height);
+            scaled = dynamic_resolution->is_scaled();
+        }
+        if (snapshot.wireframe != wireframe_enabled) {
+            wireframe_enabled = snapshot.wireframe;
+            device.set_polygon_mode(wireframe_enabled ? GL_LINE : GL_FILL);
+        }
+        render_counter.tick(FramePipeline::get_time());
+        ++submitted_frames;
+        measured_frames += snapshot.measured ? 1 : 0;
+        depth_prepass.poll();
+        if (gpu_profiler) {
+            gpu_profiler->poll();
+        }
+        glm::mat4 view_projection_matrix = prepared_frame.view_projection_matrix;
+        std::vector<unsigned> &main_objects = prepared_frame.main_objects;
+
+        // the filtering of the main view that needs the GL thread, after which the draws can be recorded
+        if (gpu_occlusion_culler) {
+            gpu_occlusion_culler->reset_stats();
+        }
+        if (!prepared_frame.recorded) {
+            if (snapshot.hiz_enabled) {
+                hiz_pyramid->cull(culler, main_objects, view_projection_matrix, snapshot.camera_position);
+            }
+            std::vector<unsigned> &draw_objects = prepared_frame.draw_objects;
+            draw_objects.clear();
+            for (unsigned object : main_objects) {
+                condition_queries[object] = 0;
+                if (!snapshot.gpu_occlusion_enabled ||
+                    gpu_occlusion_culler->prepare_draw(object, condition_queries[object])) {
+                    draw_objects.push_back(object);
+                }
+            }
+            refine_main_view(draw_objects, prepared_frame.visible_objects, prepared_frame.view_masks,
+                             prepared_frame.object_marks);
+            record_objects(prepared_frame, prepared_frame.visible_objects, prepared_frame.view_masks, true);
+        }
+
+        // the per frame uniform data, the main view turned by the mouse movement since the snapshot, as late as the
+        // passes allow, which need its matrix for the depth pyramid and the queries, the culling keeps the sampled one
+        // and its guard band covers the turn, which is limited to it
+        {
+            CPU_PROFILE_ZONE("wait for slot");
+            pipeline->wait_for_slot();
+        }
+        FrameData frame_data[MAX_VIEWS];
+        for (size_t view = 0; view != views.size(); ++view) {
+            frame_data[view].view_matrix = views[view].view_matrix;
+            frame_data[view].projection_matrix = views[view].projection_matrix;
+            frame_data[view].view_position = glm::vec4(views[view].position, 1.0F);
+        }
+        glm::dvec2 mouse_total;
+        if (snapshot.late_latch && latch_mouse && latch_mouse(mouse_total)) {
+            ++latched_frames;
+            latch_delay_ms += (FramePipeline::get_time() - snapshot.sample_time) * 1000.0;
+            if (mouse_total != snapshot.mouse_total) {
+                float yaw = snapshot.camera_yaw, pitch = snapshot.camera_pitch;
+                Camera::turn(yaw, pitch, static_cast<float>(mouse_total.x - snapshot.mouse_total.x),
+                             static_cast<float>(mouse_total.y - snapshot.mouse_total.y));
+                yaw = glm::clamp(yaw, snapshot.camera_yaw - LATE_LATCH_MAX_DEGREES,
+                                 snapshot.camera_yaw + LATE_LATCH_MAX_DEGREES);
+                pitch = glm::clamp(pitch, snapshot.camera_pitch - LATE_LATCH_MAX_DEGREES,
+                                   snapshot.camera_pitch + LATE_LATCH_MAX_DEGREES);
+                ++turned_frames;
+                latched_turn_degrees += std::abs(yaw - snapshot.camera_yaw) + std::abs(pitch - snapshot.camera_pitch);
+                frame_data[0].view_matrix = Camera::get_view_matrix(snapshot.camera_position, yaw, pitch,
+                                                                    snapshot.camera_world_up);
+                view_projection_matrix = views[0].projection_matrix * frame_data[0].view_matrix;
+            }
+        }
+        pipeline->begin_submit(frame_data, static_cast<unsigned>(views.size()), FRAME_DATA_BINDING);
+
+        // the passes of the frame, they draw into the default framebuffer or, when scaled, into transient textures
+        // that are upscaled into it before the overlay
+        frame_graph.reset();
+        FrameGraph::Resource backbuffer_color = frame_graph.import_texture(
+                "backbuffer color", {viewport_width, viewport_height, GL_RGBA8, 1}, 0);
+        FrameGraph::Resource backbuffer_depth = frame_graph.import_texture(
+                "backbuffer depth", {viewport_width, viewport_height, GL_DEPTH_COMPONENT24, 1}, 0);
+        FrameGraph::Resource color = backbuffer_color;
+        FrameGraph::Resource depth = backbuffer_depth;
+        FrameGraph::Resource scene_color = 0, scene_depth = 0;
+
+        // light source and lighting cubes
+        frame_graph.add_pass("opaque", [&](FrameGraph::Builder &builder) {
+            if (scaled) {
+                color = scene_color = builder.create("scene color", {render_width, render_height, GL_RGBA8, 1});
+                depth = scene_depth = builder.create("scene depth",
+                                                     {render_width, render_height, GL_DEPTH_COMPONENT24, 1});
+            } else {
+                color = builder.write(color);
+                depth = builder.write(depth);
+            }
+        }, [&] {
+            if (scaled) {
+                dynamic_resolution->bind_target(frame_graph, scene_color, scene_depth);
+            }
+            device.set_viewport(0, 0, render_width, render_height);
+            // reset color and depth information
+            device.clear(0.2F, 0.3F, 0.3F, 1.0F);
+            render_queue.begin_frame();
+            render_queue.set_program_uniforms(lighting_cube_shader, {
+                    UniformValue(lighting_cube_light_location, light_source_position + prepared_frame.translation)
+            });
+            for (const auto &list : prepared_frame.command_lists) {
+                render_queue.submit(list);
+            }
+            // the other views draw the same sorted batch
+            render_queue.sort();
+            depth_prepass.begin_timing(prepared_frame.depth_prepass);
+            if (gpu_profiler) {
+                gpu_profiler->begin(prepared_frame.depth_prepass ? "main view with depth pre-pass" : "main view");
+            }
+            render_queue.execute_view(0);
+            if (gpu_profiler) {
+                gpu_profiler->end();
+            }
+            depth_prepass.end_timing();
+        });
+
+        // depth pyramid of the opaque objects for the next frames
+        if (snapshot.hiz_enabled) {
+            hiz_pyramid->add_passes(frame_graph, depth, view_projection_matrix, snapshot.camera_position);
+        }
+
+        // occlusion queries against the depth of the opaque objects, their results are used in later frames
+        if (snapshot.gpu_occlusion_enabled) {
+            frame_graph.add_pass("occlusion queries", [&](FrameGraph::Builder &builder) {
+                builder.read(depth);
+                builder.set_side_effects();
+            }, [&] {
+                gpu_occlusion_culler->begin_queries(view_projection_matrix, snapshot.camera_position);
+                for (unsigned object : main_objects) {
+                    vec3 center, extent;
+                    culler.get_bounds(object, center, extent);
+                    gpu_occlusion_culler->query(object, center, extent);
+                }
+                gpu_occlusion_culler->end_queries();
+            });
+        }
+
+        // the other views, inside their own rectangles on top of the main one, after everything that reads its depth
+        if (views.size() > 1) {
+            frame_graph.add_pass("views", [&](FrameGraph::Builder &builder) {
+                color = builder.write(color);
+                depth = builder.write(depth);
+            }, [&] {
+                for (unsigned view = 1; view != views.size(); ++view) {
+                    glm::ivec4 rect = views[view].viewport * glm::ivec4(render_width, render_height,
+                                                                        render_width, render_height) /
+                                      glm::ivec4(viewport_width, viewport_height, viewport_width, viewport_height);
+                    device.set_viewport(rect.x, rect.y, rect.z, rect.w);
+                    device.set_scissor(true, rect.x, rect.y, rect.z, rect.w);
+                    device.clear(0.1F, 0.15F, 0.15F, 1.0F);
+                    pipeline->bind_view(view, FRAME_DATA_BINDING);
+                    render_queue.execute_view(view);
+                }
+                device.set_scissor(false, 0, 0, 0, 0);
+                device.set_viewport(0, 0, render_width, render_height);
+                pipeline->bind_view(0, FRAME_DATA_BINDING);
+            });
+        }
+
+        // the scaled scene goes to the window, the overlay is drawn on top at its full resolution
+        if (scaled) {
+            dynamic_resolution->add_upscale_pass(frame_graph, color, depth, backbuffer_color, backbuffer_depth);
+            color = backbuffer_color;
+            depth = backbuffer_depth;
+        }
+
+        // render cube
+//        cube_shader.use();;
+//        glBindVertexArray(cube_vao);
+//        glDrawArrays(GL_TRIANGLES, 0, 36);
+
+        frame_graph.add_pass("overlay", [&](FrameGraph::Builder &builder) {
+            color = builder.write(color);
+            depth = builder.write(depth);
+        }, [&] {
+            // crosshair
+            DrawItem crosshair_item;
+            crosshair_item.pass = PASS_OVERLAY;
+            crosshair_item.shader = &crosshair_shader;
+            crosshair_item.vao = crosshair_vao;
+            crosshair_item.mode = GL_LINES;
+            crosshair_item.count = 4;
+            render_queue.submit(crosshair_item);
+            // render coordinate
+            DrawItem coordinate_item;
+            coordinate_item.shader = &coordinate_shader;
+            coordinate_item.vao = coordinate_vao;
+            coordinate_item.mode = GL_LINES;
+            coordinate_item.count = 6;
+            render_queue.submit(coordinate_item);
+            render_queue.execute();
+            if (gpu_profiler && snapshot.gpu_profiler_overlay) {
+                gpu_profiler->draw_overlay(viewport_width, viewport_height, snapshot.gpu_target_ms);
+            }
+        });
+        if (dynamic_resolution) {
+            dynamic_resolution->begin_frame();
+        }
+        if (gpu_profiler) {
+            gpu_profiler->begin("frame");
+        }
+        {
+            CPU_PROFILE_ZONE("execute frame graph");
+            frame_graph.execute();
+        }
+        if (gpu_profiler) {
+            gpu_profiler->end();
+        }
+        if (dynamic_resolution) {
+            dynamic_resolution->end_frame();
+        }
+
+        if (snapshot.report_requests != reports_printed) {
+            CPU_PROFILE_ZONE("report");
+            reports_printed = snapshot.report_requests;
+            std::cout << "throughput: simulation " << snapshot.simulation_rate << " steps/s, render "
+                      << render_counter.rate << " frames/s" << std::endl;
+            if (snapshot.paced) {
+                const FramePacer::Stats &pacing = snapshot.pacing_stats;
+                double intervals = static_cast<double>(std::max(pacing.intervals, 1ULL));
+                double interval_ms = pacing.interval_ms / intervals;
+                double frames = static_cast<double>(std::max(pacing.frames, 1ULL));
+                std::cout << "frame pacing: " << FramePacer::get_mode_name(snapshot.pacing_mode) << " at "
+                          << snapshot.frame_rate << " Hz, " << interval_ms << " ms between presents (jitter "
+                          << std::sqrt(std::max(pacing.interval_squared_ms / intervals - interval_ms * interval_ms,
+                                                0.0))
+                          << " ms), input to GPU done " << pacing.latency_ms / std::max(pacing.latency_frames, 1ULL)
+                          << " ms (max " << pacing.max_latency_ms << " ms), " << pacing.sleep_ms / frames
+                          << " ms sleeping, " << pacing.spin_ms / frames << " ms spinning and "
+                          << pacing.queue_wait_ms / frames << " ms waiting for queued frames per frame" << std::endl;
+            }
+            if (latched_frames) {
+                std::cout << "late latch: " << turned_frames << " of " << latched_frames
+                          << " frames turned by the mouse after sampling, by "
+                          << (turned_frames ? latched_turn_degrees / static_cast<double>(turned_frames) : 0.0)
+                          << " degrees on average, latched " << latch_delay_ms / static_cast<double>(latched_frames)
+                          << " ms after sampling" << std::endl;
+            }
+            if (snapshot.on_demand) {
+                const RedrawScheduler::Stats &redraw = snapshot.redraw_stats;
+                std::cout << "on demand: " << redraw.redraws << " frames sampled, " << redraw.waits
+                          << " waits for a change, " << redraw.idle_seconds << " s idle" << std::endl;
+            }
+            for (unsigned depth = 1; depth <= pipeline->get_max_depth(); ++depth) {
+                const FramePipeline::Stats &stats = pipeline->get_stats(depth);
+                if (stats.frames < 2) {
+                    continue;
+                }
+                double frames = static_cast<double>(stats.frames);
+                std::cout << "pipeline depth " << depth << (depth == pipeline->get_depth() ? " (current)" : "")
+                          << ": " << 1000.0 * (frames - 1) / stats.frame_ms << " frames/s, latency "
+                          << stats.latency_ms / frames << " ms, waited " << stats.prepare_wait_ms / frames
+                          << " ms on preparation and " << stats.fence_wait_ms / frames << " ms on fences per frame"
+                          << std::endl;
+            }
+            const RenderQueue::Stats &queue = render_queue.get_stats();
+            std::cout << "render queue: " << queue.items << " items, " << queue.draws << " draws in " << views.size()
+                      << " views, " << queue.get_state_changes()
+                      << " state changes (" << queue.naive_state_changes << " unsorted), "
+                      << queue.program_changes << " programs, " << queue.vao_changes << " VAOs, "
+                      << queue.texture_changes << " textures, " << queue.uniform_calls << " uniform calls, recorded in "
+                      << prepared_frame.record_ms << " ms on " << prepared_frame.command_lists.size() << " threads"
+                      << std::endl;
+            std::cout << "render device: " << frame_counters.draws << " draws, " << frame_counters.triangles
+                      << " triangles, " << frame_counters.vertices << " vertices, " << frame_counters.program_binds
+                      << " program, " << frame_counters.vertex_array_binds << " VAO and "
+                      << frame_counters.texture_binds << " texture binds, " << frame_counters.uniform_calls
+                      << " uniform calls, " << frame_counters.buffer_updates << " buffer updates, "
+                      << frame_counters.bytes_uploaded << " bytes uploaded, " << frame_counters.fence_waits
+                      << " fence waits, " << frame_counters.query_reads << " query reads last frame, "
+                      << frame_counters.programs << " programs, "
+                      << frame_counters.buffers << " buffers (" << frame_counters.buffer_bytes << " bytes), "
+                      << frame_counters.framebuffers << " framebuffers, "
+                      << frame_counters.textures << " textures (" << frame_counters.texture_bytes << " bytes)"
+                      << std::endl;
+            const FrameGraph::Stats &graph = frame_graph.get_stats();
+            std::cout << "frame graph: " << graph.passes << " passes (" << graph.culled_passes << " culled), ran";
+            for (const string &pass : frame_graph.get_executed_passes()) {
+                std::cout << " " << pass << ",";
+            }
+            std::cout << " " << graph.transient_textures << " transient textures in " << graph.render_targets
+                      << " render targets, " << graph.unaliased_bytes << " bytes without aliasing, "
+                      << graph.aliased_bytes << " bytes with" << std::endl;
+            const DepthPrepassController::Stats &prepass = depth_prepass.get_stats();
+            std::cout << "depth pre-pass: " << DepthPrepassController::get_mode_name(depth_prepass.get_mode())
+                      << ", used in " << prepass.prepass_frames << " of " << prepass.frames << " frames, GPU "
+                      << prepass.prepass_ms << " ms with and " << prepass.direct_ms << " ms without, "
+                      << prepass.switches << " switches" << std::endl;
+            if (dynamic_resolution) {
+                const DynamicResolution::Stats &resolution = dynamic_resolution->get_stats();
+                std::cout << "dynamic resolution: " << (snapshot.dynamic_resolution_enabled ? "on" : "off")
+                          << ", scale " << resolution.scale << " (" << render_width << "x" << render_height << " of "
+                          << viewport_width << "x" << viewport_height << "), GPU " << resolution.gpu_ms
+                          << " ms per frame (last " << resolution.last_gpu_ms << " ms) for a target of "
+                          << dynamic_resolution->get_target_ms() << " ms, " << resolution.missed_frames << "/"
+                          << resolution.frames << " frames missed ("
+                          << (resolution.frames ? 100.0 * resolution.missed_frames / resolution.frames : 0.0)
+                          << "%), " << resolution.scale_changes << " scale changes, " << resolution.dropped_timings
+                          << " timings dropped" << std::endl;
+            }
+            if (gpu_profiler) {
+                std::cout << "gpu profiler: " << gpu_profiler->get_dropped() << " timings dropped" << std::endl;
+                for (const auto &zone : gpu_profiler->get_stats()) {
+                    std::cout << "    " << string(2 * zone.depth, ' ') << zone.name << ": min " << zone.min_ms
+                              << " ms, average " << zone.average_ms << " ms, p99 " << zone.p99_ms << " ms, last "
+                              << zone.last_ms << " ms, " << zone.samples << " measured" << std::endl;
+                }
+            }
+            const MaskedOcclusionCuller::Stats &occlusion = prepared_frame.occlusion_stats;
+            std::cout << "occlusion culling: " << occlusion.culled << "/" << occlusion.tested << " culled ("
+                      << (occlusion.tested ? 100.0 * occlusion.culled / occlusion.tested : 0.0) << "%), "
+                      << occlusion.occluder_triangles << " occluder triangles, rasterize "
+                      << occlusion.rasterize_ms << " ms, test " << occlusion.test_ms << " ms" << std::endl;
+            if (snapshot.hiz_enabled) {
+                const HiZPyramid::Stats &hiz = hiz_pyramid->get_stats();
+                std::cout << "hi-z culling: " << hiz.culled << "/" << hiz.tested << " culled, depth "
+                          << hiz.depth_age << " frames old, " << hiz.dropped_readbacks << " readbacks dropped"
+                          << std::endl;
+            }
+            if (snapshot.gpu_occlusion_enabled) {
+                const GpuOcclusionCuller::Stats &queries = gpu_occlusion_culler->get_stats();
+                std::cout << "occlusion queries: " << queries.queries_issued << " issued, "
+                          << queries.results_read << " read, " << queries.results_pending << " in flight, "
+                          << gpu_occlusion_culler->get_pool_size() << " pooled, draws "
+                          << queries.draws_skipped << " skipped, " << queries.draws_conditional << " conditional, "
+                          << queries.draws_unconditional << " unconditional" << std::endl;
+            }
+        }
+
+        {
+            CPU_PROFILE_ZONE("present");
+            present(snapshot.sample_time);
+        }
+        pipeline->end_submit(snapshot.sample_time);
+    }
+
+    if (submitted_frames) {
+        RenderStats::end_frame(device.get_counters());
+    }
+    if (results) {
+        if (last_frame_measured) {
+            add_draw_counters(results->counters, device.get_counters());
+        }
+        results->frames = measured_frames;
+        if (gpu_profiler) {
+            results->gpu_zones = gpu_profiler->get_stats();
+        }
+    }
+
+    pipeline.reset();
+    gpu_occlusion_culler.reset();
+    hiz_pyramid.reset();
+    dynamic_resolution.reset();
+    gpu_profiler.reset();
+    for (unsigned vao : {crosshair_vao, coordinate_vao, cube_vao, light_source_vao, lighting_cube_vao}) {
+        device.destroy_vertex_array(vao);
+    }
+    for (unsigned vbo : {crosshair_vbo, coordinate_vbo, cube_vbo, light_source_vbo, lighting_cube_vbo}) {
+        device.destroy_buffer(vbo);
+    }
+}
+
+void write_ppm(const string &path, const unsigned char *pixels, int width, int height) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<char> row(static_cast<size_t>(width) * 3);
+    for (int y = height - 1; y >= 0; --y) {
+        const unsigned char *source = pixels + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x != width; ++x) {
+            for (int c = 0; c != 3; ++c) {
+                row[x * 3 + c] = static_cast<char>(source[x * 4 + c]);
+            }
+        }
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+}
@@ -0,0 +1,135 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_SCENE_H
+#define LEARNOPENGL_SCENE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "DepthPrepassController.h"
+#include "FramePacer.h"
+#include "GpuProfiler.h"
+#include "RedrawScheduler.h"
+#include "RenderDevice.h"
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 800
+// how many frames may be between the snapshot and the end of their submission
+#define MAX_PIPELINE_DEPTH 3
+#define DEFAULT_PIPELINE_DEPTH 2
+// the GPU time of a frame the dynamic resolution holds by default
+#define GPU_TARGET_MS (1000.0 / 60.0)
+// lighting cubes of the scene unless told otherwise
+#define DEFAULT_CUBE_COUNT 5
+
+using std::string;
+
+// everything the renderer needs to know about a simulation step, the renderer never reads the globals of the
+// application, so it can run on another thread
+struct FrameSnapshot {
+    unsigned long long step = 0;
+    float time = 0;
+    // the time of the light animation, it only moves on at the rate of the animation
+    float light_time = 0;
+    // FramePipeline::get_time() when the input was sampled, to measure the latency
+    double sample_time = 0;
+    glm::mat4 view_matrix;
+    glm::vec3 camera_position;
+    // what the view matrix was made of, so the renderer can turn it by the mouse movement after mouse_total
+    float camera_yaw = 0;
+    float camera_pitch = 0;
+    glm::vec3 camera_world_up;
+    glm::dvec2 mouse_total;
+    bool late_latch = false;
+    int framebuffer_width = WINDOW_WIDTH;
+    int framebuffer_height = WINDOW_HEIGHT;
+    bool gpu_occlusion_enabled = false;
+    bool hiz_enabled = false;
+    bool wireframe = false;
+    bool overview_enabled = false;
+    DepthPrepassController::Mode depth_prepass_mode = DepthPrepassController::MODE_AUTO;
+    bool dynamic_resolution_enabled = true;
+    double gpu_target_ms = GPU_TARGET_MS;
+    bool gpu_profiler_overlay = false;
+    unsigned pipeline_depth = DEFAULT_PIPELINE_DEPTH;
+    unsigned report_requests = 0;
+    // simulation steps per second
+    double simulation_rate = 0;
+    bool on_demand = false;
+    RedrawScheduler::Stats redraw_stats;
+    // nothing changed since the last snapshot, the frame does not need to be drawn
+    bool idle = false;
+    // whether what the frame draws goes into the SceneResults, e.g. not for warmup frames
+    bool measured = true;
+    // how the GL thread paces the frames, the statistics are filled in there and only for a window
+    FramePacer::Mode pacing_mode = FramePacer::PACING_VSYNC;
+    double frame_rate = 60;
+    bool paced = false;
+    FramePacer::Stats pacing_stats;
+};
+
+// counts events per second over windows of about a second
+struct RateCounter {
+    unsigned count = 0;
+    double window_start = -1;
+    double rate = 0;
+
+    void tick(double now) {
+        if (this->window_start < 0) {
+            this->window_start = now;
+        }
+        ++this->count;
+        if (now - this->window_start >= 1.0) {
+            this->rate = this->count / (now - this->window_start);
+            this->count = 0;
+            this->window_start = now;
+        }
+    }
+};
+
+// what the scene is made of besides the light source
+struct SceneDescription {
+    // the first DEFAULT_CUBE_COUNT are on a diagonal, the others on a grid below them
+    unsigned cube_count = DEFAULT_CUBE_COUNT;
+};
+
+// what render_scene() measured, filled in when it returns
+struct SceneResults {
+    // the measured frames submitted
+    unsigned long long frames = 0;
+    // the draw counters summed over the measured frames, the object counters of the end
+    RenderDevice::Counters counters;
+    // the zones of the GPU profiler, only on GL
+    std::vector<GpuProfiler::ZoneStats> gpu_zones;
+};
+
+// owns every object of the scene and draws the snapshots returned by next_frame on device until it returns nullptr,
+// present is called after every frame with the time its input was sampled, device must be the current render device
+// of the calling thread, next_frame may block until there is something to draw if its argument is set, otherwise
+// frames wait for their submission and it returns an idle snapshot instead, latch_mouse, if given, returns whether it
+// knows the newest MouseAccumulator total, the main view of a frame is turned by what moved after its snapshot
+void render_scene(RenderDevice &device, const std::function<const FrameSnapshot *(bool)> &next_frame,
+                  const std::function<void(double)> &present,
+                  const std::function<bool(glm::dvec2 &)> &latch_mouse = nullptr,
+                  const SceneDescription &description = SceneDescription(), SceneResults *results = nullptr);
+
+// the matrix that takes the normals of a model to the world, the inverse transpose of its upper 3x3
+inline glm::mat3 get_normal_matrix(const glm::mat4 &model_matrix) {
+    return glm::mat3(glm::transpose(glm::inverse(model_matrix)));
+}
+
+// the vertex arrays of the cube meshes of the scene, the vertices are copied into a new vertex buffer, which goes to
+// vertex_buffer if given: textured, positions only for the light source and with normals for the lighting cubes
+unsigned int init_cube_vao(RenderDevice &device, unsigned *vertex_buffer = nullptr);
+unsigned int init_light_source_vao(RenderDevice &device, unsigned *vertex_buffer = nullptr);
+unsigned int init_lighting_cube_vao(RenderDevice &device, unsigned *vertex_buffer = nullptr);
+
+// a binary PPM of an RGBA8 image whose first row is the bottom one
+void write_ppm(const string &path, const unsigned char *pixels, int width, int height);
+
+
+#endif //LEARNOPENGL_SCENE_H
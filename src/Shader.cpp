@@ -6,53 +6,39 @@
 
 #include <iostream>
 
-void Shader::init_shader(const unsigned shader_id, const string &path) const {
+#include "CpuProfiler.h"
+
+string Shader::read_source(const string &path) {
     ifstream file(path);
     ostringstream source_stream;
     string temp;
     while (std::getline(file, temp)) {
         source_stream << temp << std::endl;
     }
-    temp = source_stream.str();
-    auto source = temp.c_str();
-    glShaderSource(shader_id, 1, &source, nullptr);
-    glCompileShader(shader_id);
-    int success;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetShaderInfoLog(shader_id, 512, nullptr, info_log);
-        throw std::runtime_error(info_log);
-    }
+    return source_stream.str();
 }
 
 Shader::Shader(const string &vertex_shader_path, const string &fragment_shader_path) :
-        vertex_shader_id(glCreateShader(GL_VERTEX_SHADER)),
-        fragment_shader_id(glCreateShader(GL_FRAGMENT_SHADER)),
-        id(glCreateProgram()) {
-
-    this->init_shader(this->vertex_shader_id, vertex_shader_path);
-    this->init_shader(this->fragment_shader_id, fragment_shader_path);
-
-    glAttachShader(this->id, this->vertex_shader_id);
-    glAttachShader(this->id, this->fragment_shader_id);
-    glLinkProgram(this->id);
-    // check if linking is successful
-    int success;
-    glGetProgramiv(this->id, GL_LINK_STATUS, &success);
-    if (!success) {
-        char info_log[512];
-        glGetProgramInfoLog(this->id, 512, nullptr, info_log);
-        throw std::runtime_error(info_log);
-    }
-    // delete the shaders because we don't need them anymore
-//    glDeleteShader(this->vertex_shader_id);
-//    glDeleteShader(this->fragment_shader_id);
+        device(RenderDevice::get_current()) {
+    // created in the body, so the zone covers the compilation
+    CPU_PROFILE_ZONE("Shader::Shader");
+    this->vertex_shader_id = this->device.create_shader(GL_VERTEX_SHADER, read_source(vertex_shader_path),
+                                                        vertex_shader_path);
+    this->fragment_shader_id = this->device.create_shader(GL_FRAGMENT_SHADER, read_source(fragment_shader_path),
+                                                          fragment_shader_path);
+    this->id = this->device.create_program(this->vertex_shader_id, this->fragment_shader_id);
+}
+
+Shader::~Shader() {
+    // the shaders are kept while the program lives, get_vertex_shader_id() and get_fragment_shader_id() hand them out
+    this->device.destroy_program(this->id);
+    this->device.destroy_shader(this->vertex_shader_id);
+    this->device.destroy_shader(this->fragment_shader_id);
 }
 
 void Shader::use() const {
     // activate the program and every rendering call onwards will use the program
-    glUseProgram(this->id);
+    this->device.use_program(this->id);
 }
 
 unsigned int Shader::get_fragment_shader_id() const {
@@ -67,29 +53,37 @@ unsigned int Shader::get_program_id() const {
     return this->id;
 }
 
+int Shader::get_uniform_location(const string &name) const {
+    return this->device.get_uniform_location(this->id, name);
+}
+
+void Shader::bind_uniform_block(const string &name, unsigned binding) const {
+    this->device.bind_uniform_block(this->id, name, binding);
+}
+
 void Shader::set_uniform(const string &name, float value) const {
-    glUniform1f(glGetUniformLocation(this->id, name.c_str()), value);
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name), value));
 }
 
 void Shader::set_uniform(const string &name, int value) const {
-    glUniform1i(glGetUniformLocation(this->id, name.c_str()), value);
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name), value));
 }
 
 void Shader::set_uniform(const string &name, unsigned int value) const {
-    glUniform1ui(glGetUniformLocation(this->id, name.c_str()), value);
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name), value));
 }
 
 void Shader::set_uniform(const string &name, float v1, float v2, float v3) const {
-    glUniform3f(glGetUniformLocation(this->id, name.c_str()), v1, v2, v3);
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name), vec3(v1, v2, v3)));
 }
 
 void Shader::set_uniform(const string &name, float v1, float v2, float v3, float v4) const {
-    glUniform4f(glGetUniformLocation(this->id, name.c_str()), v1, v2, v3, v4);
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name), glm::vec4(v1, v2, v3, v4)));
 }
 
 void Shader::set_uniform(const string &name, const glm::mat4 &value, GLboolean transpose) const{
-    glUniformMatrix4fv(glGetUniformLocation(this->id, name.c_str()), 1, transpose,
-                       glm::value_ptr(value));
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name),
+                                          transpose ? glm::transpose(value) : value));
 }
 
 void Shader::set_uniform(const string &name, const vec3 &value) const {
@@ -97,8 +91,8 @@ void Shader::set_uniform(const string &name, const vec3 &value) const {
 }
 
 void Shader::set_uniform(const string &name, const mat3 &value, GLboolean transpose) const {
-    glUniformMatrix3fv(glGetUniformLocation(this->id, name.c_str()), 1, transpose,
-                       glm::value_ptr(value));
+    this->device.set_uniform(UniformValue(this->get_uniform_location(name),
+                                          transpose ? glm::transpose(value) : value));
 }
 
 
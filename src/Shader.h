@@ -12,6 +12,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "RenderDevice.h"
+
 using std::string;
 using std::ifstream;
 using std::ostringstream;
@@ -23,19 +25,30 @@ using glm::vec3;
 class Shader {
 
 private:
+    RenderDevice &device;
     unsigned vertex_shader_id;
     unsigned fragment_shader_id;
     unsigned id;
 
-    void init_shader(unsigned shader_id, const string &source) const;
+    static string read_source(const string &path);
 
 public:
+    // the objects are created on the current render device
     Shader(const string &vertex_shader_path, const string &fragment_shader_path);
+    ~Shader();
+
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
+
     void use() const;
 
     unsigned int get_vertex_shader_id() const;
     unsigned int get_program_id() const;
     unsigned int get_fragment_shader_id() const;
+    // -1 if the program has no active uniform with that name
+    int get_uniform_location(const string &name) const;
+    // connects the uniform block to a uniform buffer binding point, does nothing if the program has no such block
+    void bind_uniform_block(const string &name, unsigned binding) const;
 
     void set_uniform(const string &name, float value) const;
     void set_uniform(const string &name, int value) const;
@@ -0,0 +1,1273 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "SoftwareRenderDevice.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#else
+#define RASTER_SSE2 0
+#endif
+
+// the framebuffer is split into square tiles of this many pixels, one task each
+#define TILE_SIZE 64
+// window coordinates are snapped to 1/256 of a pixel like llvmpipe does
+#define SUBPIXEL_SCALE 256
+// primitives are only clipped where they leave this multiple of the clip volume in x and y, the viewport cuts off
+// the rest while rasterizing
+#define GUARD_BAND 2.0F
+#define MAX_FRAMEBUFFER_SIZE 4096
+
+// 4 lanes, one per pixel of a 2x2 quad
+#if RASTER_SSE2
+// the edge functions are integers of up to 42 bits, doubles hold them exactly where 32 bit lanes would overflow
+struct Edge4 {
+    __m128d low, high;
+};
+typedef __m128 Float4;
+
+static inline Edge4 edge4(double a, double b, double c, double d) {
+    return {_mm_setr_pd(a, b), _mm_setr_pd(c, d)};
+}
+
+static inline Edge4 edge4_add(Edge4 a, Edge4 b) {
+    return {_mm_add_pd(a.low, b.low), _mm_add_pd(a.high, b.high)};
+}
+
+static inline Edge4 edge4_splat(double a) {
+    return {_mm_set1_pd(a), _mm_set1_pd(a)};
+}
+
+// a bit for every lane that is >= 0
+static inline unsigned edge4_non_negative(Edge4 a) {
+    __m128d zero = _mm_setzero_pd();
+    return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpge_pd(a.low, zero)) |
+                                 _mm_movemask_pd(_mm_cmpge_pd(a.high, zero)) << 2);
+}
+
+static inline Float4 float4(float a, float b, float c, float d) {
+    return _mm_setr_ps(a, b, c, d);
+}
+
+static inline Float4 float4_splat(float a) {
+    return _mm_set1_ps(a);
+}
+
+static inline Float4 float4_add(Float4 a, Float4 b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline Float4 float4_mul(Float4 a, Float4 b) {
+    return _mm_mul_ps(a, b);
+}
+
+static inline Float4 float4_div(Float4 a, Float4 b) {
+    return _mm_div_ps(a, b);
+}
+
+static inline void float4_store(float *destination, Float4 a) {
+    _mm_storeu_ps(destination, a);
+}
+#else
+struct Edge4 {
+    double v[4];
+};
+
+struct Float4 {
+    float v[4];
+};
+
+static inline Edge4 edge4(double a, double b, double c, double d) {
+    return {{a, b, c, d}};
+}
+
+static inline Edge4 edge4_add(Edge4 a, Edge4 b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+
+static inline Edge4 edge4_splat(double a) {
+    return {{a, a, a, a}};
+}
+
+static inline unsigned edge4_non_negative(Edge4 a) {
+    return (a.v[0] >= 0) | (a.v[1] >= 0) << 1 | (a.v[2] >= 0) << 2 | (a.v[3] >= 0) << 3;
+}
+
+static inline Float4 float4(float a, float b, float c, float d) {
+    return {{a, b, c, d}};
+}
+
+static inline Float4 float4_splat(float a) {
+    return {{a, a, a, a}};
+}
+
+static inline Float4 float4_add(Float4 a, Float4 b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+
+static inline Float4 float4_mul(Float4 a, Float4 b) {
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+
+static inline Float4 float4_div(Float4 a, Float4 b) {
+    return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}};
+}
+
+static inline void float4_store(float *destination, Float4 a) {
+    std::memcpy(destination, a.v, sizeof(a.v));
+}
+#endif
+
+static std::runtime_error invalid(const string &what) {
+    return std::runtime_error("Software render device: " + what + "!");
+}
+
+static long long floor_divide(long long value, long long divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+// rounds half to even like the conversions of the GPUs and llvmpipe
+static unsigned char to_unorm8(float value) {
+    return static_cast<unsigned char>(std::lrint(std::min(std::max(value, 0.0F), 1.0F) * 255.0F));
+}
+
+// >= 0 inside, the planes of the clip volume widened by the guard band in x and y
+static float clip_distance(const vec4 &position, int plane) {
+    switch (plane) {
+        case 0:
+            return GUARD_BAND * position.w - position.x;
+        case 1:
+            return GUARD_BAND * position.w + position.x;
+        case 2:
+            return GUARD_BAND * position.w - position.y;
+        case 3:
+            return GUARD_BAND * position.w + position.y;
+        case 4:
+            return position.w - position.z;
+        default:
+            return position.w + position.z;
+    }
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(int width, int height, unsigned thread_count) :
+        width(width),
+        height(height),
+        tiles_x((width + TILE_SIZE - 1) / TILE_SIZE),
+        tiles_y((height + TILE_SIZE - 1) / TILE_SIZE),
+        pool(thread_count) {
+    if (width <= 0 || height <= 0 || width > MAX_FRAMEBUFFER_SIZE || height > MAX_FRAMEBUFFER_SIZE) {
+        throw invalid("framebuffer size out of range");
+    }
+    MemoryTracker::Scope memory_scope("software framebuffer");
+    this->color_buffer.assign(static_cast<size_t>(width) * height * 4, 0);
+    this->depth_buffer.assign(static_cast<size_t>(width) * height, 1.0F);
+    this->bins.resize(static_cast<size_t>(this->tiles_x) * this->tiles_y);
+    this->viewport[2] = width;
+    this->viewport[3] = height;
+}
+
+DeviceBackend SoftwareRenderDevice::get_backend() const {
+    return BACKEND_SOFTWARE;
+}
+
+unsigned SoftwareRenderDevice::create_shader(GLenum stage, const string &source, const string &name) {
+    const SoftwareShaderPort *port = SoftwareShaderPort::find(name);
+    if (!port || port->stage != stage) {
+        throw invalid("there is no port of " + name);
+    }
+    ShaderInfo info = {port, {}};
+    std::set<string> blocks;
+    parse_declarations(source, info.uniforms, blocks);
+    // the port has to read exactly what the GLSL declares, anything else means one of them changed without the other
+    std::set<string> port_uniforms(port->uniforms.begin(), port->uniforms.end());
+    port_uniforms.insert(port->samplers.begin(), port->samplers.end());
+    std::set<string> declared_uniforms;
+    for (const auto &uniform : info.uniforms) {
+        declared_uniforms.insert(uniform.first);
+    }
+    if (port_uniforms != declared_uniforms || std::set<string>(port->blocks.begin(), port->blocks.end()) != blocks ||
+        port->uniforms.size() > SOFTWARE_MAX_PORT_UNIFORMS || port->samplers.size() > SOFTWARE_MAX_PORT_SAMPLERS ||
+        port->blocks.size() > SOFTWARE_MAX_PORT_BLOCKS || port->get_varying_floats() > SOFTWARE_MAX_VARYINGS) {
+        throw invalid("the port of " + name + " does not match its GLSL");
+    }
+    unsigned handle = this->next_handle++;
+    this->shaders[handle] = info;
+    ++this->counters.shaders;
+    return handle;
+}
+
+unsigned SoftwareRenderDevice::create_program(unsigned vertex_shader, unsigned fragment_shader) {
+    auto vertex = this->shaders.find(vertex_shader);
+    auto fragment = this->shaders.find(fragment_shader);
+    if (vertex == this->shaders.end() || fragment == this->shaders.end() ||
+        vertex->second.port->stage != GL_VERTEX_SHADER || fragment->second.port->stage != GL_FRAGMENT_SHADER) {
+        throw invalid("linking shaders that do not exist or are of the wrong stages");
+    }
+    ProgramInfo info;
+    info.vertex = vertex->second.port;
+    info.fragment = fragment->second.port;
+    for (const ShaderInfo *shader : {&vertex->second, &fragment->second}) {
+        for (const auto &uniform : shader->uniforms) {
+            auto existing = info.uniforms.find(uniform.first);
+            if (existing != info.uniforms.end()) {
+                if (existing->second.type != uniform.second) {
+                    throw invalid("uniform " + uniform.first + " is declared with different types");
+                }
+                continue;
+            }
+            auto location = static_cast<int>(info.values.size());
+            info.uniforms[uniform.first] = {location, uniform.second};
+            UniformValue value;
+            value.location = location;
+            value.type = uniform.second;
+            std::memset(&value.data, 0, sizeof(value.data));
+            info.values.push_back(value);
+        }
+        for (const char *block : shader->port->blocks) {
+            info.block_bindings[block] = 0;
+        }
+    }
+    for (size_t i = 0; i != info.vertex->uniforms.size(); ++i) {
+        info.vertex_uniforms[i] = info.uniforms.at(info.vertex->uniforms[i]).location;
+    }
+    for (size_t i = 0; i != info.fragment->uniforms.size(); ++i) {
+        info.fragment_uniforms[i] = info.uniforms.at(info.fragment->uniforms[i]).location;
+    }
+    for (size_t i = 0; i != info.fragment->samplers.size(); ++i) {
+        info.fragment_samplers[i] = info.uniforms.at(info.fragment->samplers[i]).location;
+    }
+    // link the varyings by name like GL does
+    info.vertex_varyings = info.vertex->get_varying_floats();
+    info.fragment_varyings = 0;
+    for (const auto &input : info.fragment->varyings) {
+        unsigned offset = 0;
+        bool found = false;
+        for (const auto &output : info.vertex->varyings) {
+            if (string(output.name) == input.name && output.components == input.components) {
+                found = true;
+                break;
+            }
+            offset += output.components;
+        }
+        if (!found) {
+            throw invalid(string("the vertex shader does not write ") + input.name);
+        }
+        for (unsigned c = 0; c != input.components; ++c) {
+            info.varying_sources[info.fragment_varyings++] = offset + c;
+        }
+    }
+    unsigned handle = this->next_handle++;
+    this->programs[handle] = info;
+    ++this->counters.programs;
+    return handle;
+}
+
+void SoftwareRenderDevice::destroy_shader(unsigned shader) {
+    if (!this->shaders.erase(shader)) {
+        throw invalid("destroying a shader that does not exist");
+    }
+    --this->counters.shaders;
+}
+
+void SoftwareRenderDevice::destroy_program(unsigned program) {
+    if (!this->programs.erase(program)) {
+        throw invalid("destroying a program that does not exist");
+    }
+    if (this->current_program == program) {
+        this->current_program = 0;
+    }
+    --this->counters.programs;
+}
+
+SoftwareRenderDevice::ProgramInfo &SoftwareRenderDevice::get_program(unsigned program) {
+    auto info = this->programs.find(program);
+    if (info == this->programs.end()) {
+        throw invalid("using a program that does not exist");
+    }
+    return info->second;
+}
+
+int SoftwareRenderDevice::get_uniform_location(unsigned program, const string &name) {
+    const ProgramInfo &info = this->get_program(program);
+    auto uniform = info.uniforms.find(name);
+    return uniform == info.uniforms.end() ? -1 : uniform->second.location;
+}
+
+void SoftwareRenderDevice::bind_uniform_block(unsigned program, const string &name, unsigned binding) {
+    ProgramInfo &info = this->get_program(program);
+    if (binding >= MAX_UNIFORM_BINDINGS) {
+        throw invalid("uniform buffer binding out of range");
+    }
+    auto block = info.block_bindings.find(name);
+    if (block != info.block_bindings.end()) {
+        block->second = binding;
+    }
+}
+
+void SoftwareRenderDevice::use_program(unsigned program) {
+    if (program) {
+        this->get_program(program);
+    }
+    this->current_program = program;
+    ++this->counters.program_binds;
+}
+
+void SoftwareRenderDevice::set_uniform(const UniformValue &value) {
+    ++this->counters.uniform_calls;
+    // like GL, -1 is silently ignored
+    if (value.location == -1) {
+        return;
+    }
+    ProgramInfo &info = this->get_program(this->current_program);
+    if (value.location < 0 || static_cast<size_t>(value.location) >= info.values.size() ||
+        info.values[value.location].type != value.type) {
+        throw invalid("setting a uniform that does not exist or has another type");
+    }
+    info.values[value.location] = value;
+}
+
+unsigned SoftwareRenderDevice::create_buffer(GLenum target, size_t size, const void *data, GLenum usage) {
+    unsigned handle = this->next_handle++;
+    BufferInfo &info = this->buffers[handle];
+    info.target = target;
+    info.data.assign(size, 0);
+    if (data) {
+        std::memcpy(info.data.data(), data, size);
+        this->counters.bytes_uploaded += size;
+    }
+    ++this->counters.buffers;
+    this->counters.buffer_bytes += size;
+    info.memory = MemoryTracker::charge(MEMORY_GPU_BUFFERS, size);
+    return handle;
+}
+
+void SoftwareRenderDevice::update_buffer(unsigned buffer, size_t offset, size_t size, const void *data,
+                                         bool unsynchronized) {
+    auto info = this->buffers.find(buffer);
+    if (info == this->buffers.end() || offset + size > info->second.data.size()) {
+        throw invalid("updating a buffer that does not exist or out of its range");
+    }
+    // the draws already copied what they read, so there is nothing to synchronize with
+    std::memcpy(info->second.data.data() + offset, data, size);
+    ++this->counters.buffer_updates;
+    this->counters.bytes_uploaded += size;
+}
+
+void SoftwareRenderDevice::bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) {
+    auto info = this->buffers.find(buffer);
+    if (binding >= MAX_UNIFORM_BINDINGS || info == this->buffers.end() ||
+        offset + size > info->second.data.size()) {
+        throw invalid("uniform buffer binding out of range");
+    }
+    UniformBinding &bound = this->uniform_bindings[binding];
+    bound.buffer = buffer;
+    bound.offset = offset;
+    bound.size = size;
+}
+
+void SoftwareRenderDevice::destroy_buffer(unsigned buffer) {
+    auto info = this->buffers.find(buffer);
+    if (info == this->buffers.end()) {
+        throw invalid("destroying a buffer that does not exist");
+    }
+    --this->counters.buffers;
+    this->counters.buffer_bytes -= info->second.data.size();
+    MemoryTracker::release(info->second.memory, info->second.data.size());
+    this->buffers.erase(info);
+}
+
+size_t SoftwareRenderDevice::get_uniform_buffer_alignment() const {
+    // std140 never needs more than a vec4
+    return 16;
+}
+
+unsigned SoftwareRenderDevice::create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                                   unsigned attribute_count) {
+    if (!this->buffers.count(vertex_buffer)) {
+        throw invalid("vertex array without a vertex buffer");
+    }
+    VertexArrayInfo info = {vertex_buffer, std::vector<VertexAttribute>(attributes, attributes + attribute_count)};
+    for (const VertexAttribute &attribute : info.attributes) {
+        if (attribute.location >= SOFTWARE_MAX_ATTRIBUTES || attribute.components < 1 || attribute.components > 4) {
+            throw invalid("vertex attribute out of range");
+        }
+    }
+    unsigned handle = this->next_handle++;
+    this->vertex_arrays[handle] = info;
+    ++this->counters.vertex_arrays;
+    return handle;
+}
+
+void SoftwareRenderDevice::destroy_vertex_array(unsigned vertex_array) {
+    if (!this->vertex_arrays.erase(vertex_array)) {
+        throw invalid("destroying a vertex array that does not exist");
+    }
+    if (this->current_vertex_array == vertex_array) {
+        this->current_vertex_array = 0;
+    }
+    --this->counters.vertex_arrays;
+}
+
+void SoftwareRenderDevice::bind_vertex_array(unsigned vertex_array) {
+    if (vertex_array && !this->vertex_arrays.count(vertex_array)) {
+        throw invalid("binding a vertex array that does not exist");
+    }
+    this->current_vertex_array = vertex_array;
+    ++this->counters.vertex_array_binds;
+}
+
+unsigned SoftwareRenderDevice::create_texture_2d(int width, int height, GLenum format, const void *pixels) {
+    if (width <= 0 || height <= 0 || (format != GL_RGB && format != GL_RGBA) || !pixels) {
+        throw invalid("invalid texture");
+    }
+    unsigned handle = this->next_handle++;
+    SoftwareTexture &texture = this->textures[handle];
+    texture.set_image(width, height, format, static_cast<const unsigned char *>(pixels));
+    // the same defaults as the GL backend
+    texture.min_filter = GL_NEAREST_MIPMAP_NEAREST;
+    texture.mag_filter = GL_NEAREST;
+    ++this->counters.textures;
+    this->counters.texture_bytes += texture.get_size();
+    this->texture_memory[handle] = MemoryTracker::charge(MEMORY_GPU_TEXTURES, texture.get_size());
+    this->counters.bytes_uploaded += static_cast<size_t>(width) * height * (format == GL_RGB ? 3 : 4);
+    return handle;
+}
+
+void SoftwareRenderDevice::set_texture_parameter(unsigned texture, GLenum parameter, int value) {
+    auto info = this->textures.find(texture);
+    if (info == this->textures.end()) {
+        throw invalid("setting a parameter of a texture that does not exist");
+    }
+    auto mode = static_cast<GLenum>(value);
+    bool wrap = mode == GL_REPEAT || mode == GL_CLAMP_TO_EDGE || mode == GL_MIRRORED_REPEAT;
+    bool filter = mode == GL_NEAREST || mode == GL_LINEAR;
+    bool mip_filter = mode == GL_NEAREST_MIPMAP_NEAREST || mode == GL_LINEAR_MIPMAP_NEAREST ||
+                      mode == GL_NEAREST_MIPMAP_LINEAR || mode == GL_LINEAR_MIPMAP_LINEAR;
+    if (parameter == GL_TEXTURE_WRAP_S && wrap) {
+        info->second.wrap_s = mode;
+    } else if (parameter == GL_TEXTURE_WRAP_T && wrap) {
+        info->second.wrap_t = mode;
+    } else if (parameter == GL_TEXTURE_MIN_FILTER && (filter || mip_filter)) {
+        info->second.min_filter = mode;
+    } else if (parameter == GL_TEXTURE_MAG_FILTER && filter) {
+        info->second.mag_filter = mode;
+    } else {
+        throw invalid("unsupported texture parameter");
+    }
+}
+
+void SoftwareRenderDevice::bind_texture(unsigned unit, unsigned texture) {
+    if (unit >= MAX_TEXTURE_UNITS || (texture && !this->textures.count(texture))) {
+        throw invalid("binding a texture that does not exist or to a unit out of range");
+    }
+    this->texture_units[unit] = texture;
+    ++this->counters.texture_binds;
+}
+
+void SoftwareRenderDevice::destroy_texture(unsigned texture) {
+    auto info = this->textures.find(texture);
+    if (info == this->textures.end()) {
+        throw invalid("destroying a texture that does not exist");
+    }
+    // queued draws may still sample it
+    this->flush();
+    --this->counters.textures;
+    this->counters.texture_bytes -= info->second.get_size();
+    MemoryTracker::release(this->texture_memory[texture], info->second.get_size());
+    this->texture_memory.erase(texture);
+    this->textures.erase(info);
+    for (unsigned &unit : this->texture_units) {
+        if (unit == texture) {
+            unit = 0;
+        }
+    }
+}
+
+unsigned SoftwareRenderDevice::create_render_target(int width, int height, GLenum format, int levels) {
+    // there is only the one framebuffer to rasterize into
+    throw invalid("render targets are not supported");
+}
+
+void SoftwareRenderDevice::set_viewport(int x, int y, int viewport_width, int viewport_height) {
+    // the guard band only keeps the fixed point coordinates in range for viewports around the framebuffer
+    if (viewport_width < 0 || viewport_height < 0 || viewport_width > MAX_FRAMEBUFFER_SIZE ||
+        viewport_height > MAX_FRAMEBUFFER_SIZE || std::abs(x) > MAX_FRAMEBUFFER_SIZE ||
+        std::abs(y) > MAX_FRAMEBUFFER_SIZE) {
+        throw invalid("viewport out of range");
+    }
+    this->viewport[0] = x;
+    this->viewport[1] = y;
+    this->viewport[2] = viewport_width;
+    this->viewport[3] = viewport_height;
+}
+
+void SoftwareRenderDevice::set_scissor(bool enabled, int x, int y, int scissor_width, int scissor_height) {
+    if (enabled && (scissor_width < 0 || scissor_height < 0)) {
+        throw invalid("negative scissor size");
+    }
+    this->scissor_test = enabled;
+    this->scissor[0] = x;
+    this->scissor[1] = y;
+    this->scissor[2] = scissor_width;
+    this->scissor[3] = scissor_height;
+}
+
+void SoftwareRenderDevice::get_clip_rect(bool only_scissor, int &min_x, int &min_y, int &max_x, int &max_y) const {
+    min_x = 0;
+    min_y = 0;
+    max_x = this->width - 1;
+    max_y = this->height - 1;
+    auto clip = [&](const int *rect) {
+        min_x = std::max(min_x, rect[0]);
+        min_y = std::max(min_y, rect[1]);
+        max_x = std::min(max_x, rect[0] + rect[2] - 1);
+        max_y = std::min(max_y, rect[1] + rect[3] - 1);
+    };
+    if (!only_scissor) {
+        clip(this->viewport);
+    }
+    if (this->scissor_test) {
+        clip(this->scissor);
+    }
+}
+
+void SoftwareRenderDevice::clear(float red, float green, float blue, float alpha) {
+    auto *clear = static_cast<Clear *>(this->frame_arena.allocate(sizeof(Clear), alignof(Clear)));
+    clear->color[0] = to_unorm8(red);
+    clear->color[1] = to_unorm8(green);
+    clear->color[2] = to_unorm8(blue);
+    clear->color[3] = to_unorm8(alpha);
+    // like glClear, the depth mask and the scissor apply but the viewport does not
+    clear->depth = this->depth_write;
+    this->get_clip_rect(true, clear->min_x, clear->min_y, clear->max_x, clear->max_y);
+    if (clear->min_x <= clear->max_x && clear->min_y <= clear->max_y) {
+        this->bin(BIN_CLEAR, clear, clear->min_x, clear->min_y, clear->max_x, clear->max_y);
+    }
+    ++this->counters.clears;
+}
+
+void SoftwareRenderDevice::set_depth_test(bool enabled) {
+    this->depth_test = enabled;
+}
+
+void SoftwareRenderDevice::set_depth_write(bool enabled) {
+    this->depth_write = enabled;
+}
+
+void SoftwareRenderDevice::set_depth_func(GLenum func) {
+    if (func != GL_LESS && func != GL_LEQUAL && func != GL_EQUAL) {
+        throw invalid("unsupported depth function");
+    }
+    this->depth_func = func;
+}
+
+void SoftwareRenderDevice::set_color_write(bool enabled) {
+    this->color_write = enabled;
+}
+
+void SoftwareRenderDevice::set_blend(bool enabled) {
+    this->blend = enabled;
+}
+
+void SoftwareRenderDevice::set_polygon_mode(GLenum mode) {
+    if (mode != GL_FILL && mode != GL_LINE && mode != GL_POINT) {
+        throw invalid("unknown polygon mode");
+    }
+    this->polygon_mode = mode;
+}
+
+const unsigned char *SoftwareRenderDevice::get_block(const ProgramInfo &program, const SoftwareShaderPort &port,
+                                                     unsigned block) {
+    const UniformBinding &binding = this->uniform_bindings[program.block_bindings.at(port.blocks[block])];
+    auto buffer = this->buffers.find(binding.buffer);
+    if (buffer == this->buffers.end()) {
+        throw invalid(string("uniform block ") + port.blocks[block] + " has no buffer bound");
+    }
+    return buffer->second.data.data() + binding.offset;
+}
+
+SoftwareRenderDevice::DrawState *SoftwareRenderDevice::record_draw_state(ProgramInfo &program) {
+    CommandArena &arena = this->frame_arena;
+    auto *draw = static_cast<DrawState *>(arena.allocate(sizeof(DrawState), alignof(DrawState)));
+    const SoftwareShaderPort &port = *program.fragment;
+    draw->port = &port;
+    // the tiles run after the uniforms, buffers and units may have changed for later draws, so copy what they read
+    for (size_t i = 0; i != port.uniforms.size(); ++i) {
+        auto *data = static_cast<float *>(arena.allocate(sizeof(UniformValue::data), alignof(float)));
+        std::memcpy(data, &program.values[program.fragment_uniforms[i]].data, sizeof(UniformValue::data));
+        draw->state.uniforms[i] = data;
+    }
+    for (size_t i = 0; i != port.samplers.size(); ++i) {
+        auto unit = static_cast<unsigned>(program.values[program.fragment_samplers[i]].data.i);
+        unsigned texture = unit < MAX_TEXTURE_UNITS ? this->texture_units[unit] : 0;
+        draw->state.textures[i] = texture ? &this->textures.at(texture) : nullptr;
+    }
+    for (unsigned i = 0; i != port.blocks.size(); ++i) {
+        const UniformBinding &binding = this->uniform_bindings[program.block_bindings.at(port.blocks[i])];
+        const unsigned char *source = this->get_block(program, port, i);
+        auto *data = static_cast<unsigned char *>(arena.allocate(binding.size, alignof(float)));
+        std::memcpy(data, source, binding.size);
+        draw->state.blocks[i] = data;
+    }
+    auto *sources = static_cast<unsigned *>(arena.allocate(sizeof(program.varying_sources), alignof(unsigned)));
+    std::memcpy(sources, program.varying_sources, sizeof(program.varying_sources));
+    draw->varying_sources = sources;
+    draw->varying_count = program.fragment_varyings;
+    draw->depth_test = this->depth_test;
+    draw->depth_write = this->depth_write;
+    draw->depth_func = this->depth_func;
+    draw->color_write = this->color_write;
+    draw->blend = this->blend;
+    return draw;
+}
+
+void SoftwareRenderDevice::shade_vertices(ProgramInfo &program, int first, int count) {
+    const VertexArrayInfo &vertex_array = this->vertex_arrays.at(this->current_vertex_array);
+    const std::vector<unsigned char> &data = this->buffers.at(vertex_array.buffer).data;
+    const SoftwareShaderPort &port = *program.vertex;
+    SoftwareShaderState state;
+    for (size_t i = 0; i != port.uniforms.size(); ++i) {
+        state.uniforms[i] = program.values[program.vertex_uniforms[i]].data.f;
+    }
+    for (unsigned i = 0; i != port.blocks.size(); ++i) {
+        state.blocks[i] = this->get_block(program, port, i);
+    }
+    this->shaded_vertices.resize(static_cast<size_t>(count));
+    for (int i = 0; i != count; ++i) {
+        // unused attributes read as (0, 0, 0, 1) like in GL
+        vec4 attributes[SOFTWARE_MAX_ATTRIBUTES];
+        std::fill(attributes, attributes + SOFTWARE_MAX_ATTRIBUTES, vec4(0.0F, 0.0F, 0.0F, 1.0F));
+        for (const VertexAttribute &attribute : vertex_array.attributes) {
+            size_t offset = attribute.offset + static_cast<size_t>(first + i) * attribute.stride;
+            size_t size = sizeof(float) * static_cast<size_t>(attribute.components);
+            if (offset + size > data.size()) {
+                throw invalid("drawing past the end of the vertex buffer");
+            }
+            std::memcpy(&attributes[attribute.location][0], &data[offset], size);
+        }
+        ShadedVertex &vertex = this->shaded_vertices[i];
+        std::fill(vertex.varyings, vertex.varyings + SOFTWARE_MAX_VARYINGS, 0.0F);
+        port.vertex(state, attributes, vertex.position, vertex.varyings);
+    }
+}
+
+void SoftwareRenderDevice::draw(GLenum mode, int first, int count, unsigned condition_query) {
+    if (!this->current_program || !this->current_vertex_array) {
+        throw invalid("drawing without a program or a vertex array");
+    }
+    if (first < 0 || count < 0) {
+        throw invalid("negative draw range");
+    }
+    this->count_draw(mode, count);
+    ProgramInfo &program = this->get_program(this->current_program);
+    this->shade_vertices(program, first, count);
+    const DrawState *draw = this->record_draw_state(program);
+    const ShadedVertex *vertices = this->shaded_vertices.data();
+
+    auto triangle = [&](int i0, int i1, int i2) {
+        const ShadedVertex corners[3] = {vertices[i0], vertices[i1], vertices[i2]};
+        if (this->polygon_mode == GL_FILL) {
+            this->draw_triangle(draw, corners);
+        } else if (this->polygon_mode == GL_LINE) {
+            for (int i = 0; i != 3; ++i) {
+                this->draw_line(draw, corners[i], corners[(i + 1) % 3]);
+            }
+        } else {
+            for (const ShadedVertex &corner : corners) {
+                this->draw_point(draw, corner);
+            }
+        }
+    };
+    switch (mode) {
+        case GL_TRIANGLES:
+            for (int i = 0; i + 2 < count; i += 3) {
+                triangle(i, i + 1, i + 2);
+            }
+            break;
+        case GL_TRIANGLE_STRIP:
+            for (int i = 0; i + 2 < count; ++i) {
+                // every other triangle is flipped so they all keep the winding of the first
+                if (i % 2 == 0) {
+                    triangle(i, i + 1, i + 2);
+                } else {
+                    triangle(i + 1, i, i + 2);
+                }
+            }
+            break;
+        case GL_TRIANGLE_FAN:
+            for (int i = 1; i + 1 < count; ++i) {
+                triangle(0, i, i + 1);
+            }
+            break;
+        case GL_LINES:
+            for (int i = 0; i + 1 < count; i += 2) {
+                this->draw_line(draw, vertices[i], vertices[i + 1]);
+            }
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for (int i = 0; i + 1 < count; ++i) {
+                this->draw_line(draw, vertices[i], vertices[i + 1]);
+            }
+            if (mode == GL_LINE_LOOP && count > 2) {
+                this->draw_line(draw, vertices[count - 1], vertices[0]);
+            }
+            break;
+        case GL_POINTS:
+            for (int i = 0; i != count; ++i) {
+                this->draw_point(draw, vertices[i]);
+            }
+            break;
+        default:
+            throw invalid("unknown primitive mode");
+    }
+}
+
+SoftwareRenderDevice::WindowVertex SoftwareRenderDevice::to_window(const DrawState *draw,
+                                                                   const ShadedVertex &vertex) const {
+    WindowVertex window;
+    const vec4 &position = vertex.position;
+    window.inverse_w = 1.0F / position.w;
+    window.x = (position.x * window.inverse_w + 1.0F) * 0.5F * static_cast<float>(this->viewport[2]) +
+               static_cast<float>(this->viewport[0]);
+    window.y = (position.y * window.inverse_w + 1.0F) * 0.5F * static_cast<float>(this->viewport[3]) +
+               static_cast<float>(this->viewport[1]);
+    window.z = position.z * window.inverse_w * 0.5F + 0.5F;
+    // in the order the fragment shader reads them
+    for (unsigned i = 0; i != draw->varying_count; ++i) {
+        window.varyings[i] = vertex.varyings[draw->varying_sources[i]] * window.inverse_w;
+    }
+    return window;
+}
+
+void SoftwareRenderDevice::draw_triangle(const DrawState *draw, const ShadedVertex *vertices) {
+    unsigned outside_all = 0x3F, outside_any = 0;
+    for (int i = 0; i != 3; ++i) {
+        unsigned outside = 0;
+        for (int plane = 0; plane != 6; ++plane) {
+            outside |= (clip_distance(vertices[i].position, plane) < 0) << plane;
+        }
+        outside_all &= outside;
+        outside_any |= outside;
+    }
+    if (outside_all) {
+        return;
+    }
+    if (!outside_any) {
+        WindowVertex window[3] = {to_window(draw, vertices[0]), to_window(draw, vertices[1]),
+                                  to_window(draw, vertices[2])};
+        this->setup_triangle(draw, window);
+        return;
+    }
+    // Sutherland-Hodgman against the planes the triangle crosses, a triangle gains at most one vertex per plane
+    ShadedVertex polygons[2][9];
+    unsigned size = 3;
+    std::copy(vertices, vertices + 3, polygons[0]);
+    int current = 0;
+    for (int plane = 0; plane != 6 && size >= 3; ++plane) {
+        if (!(outside_any & 1U << plane)) {
+            continue;
+        }
+        const ShadedVertex *input = polygons[current];
+        ShadedVertex *output = polygons[1 - current];
+        unsigned output_size = 0;
+        for (unsigned i = 0; i != size; ++i) {
+            const ShadedVertex &a = input[i], &b = input[(i + 1) % size];
+            float distance_a = clip_distance(a.position, plane), distance_b = clip_distance(b.position, plane);
+            if (distance_a >= 0) {
+                output[output_size++] = a;
+            }
+            if ((distance_a >= 0) != (distance_b >= 0)) {
+                float t = distance_a / (distance_a - distance_b);
+                ShadedVertex &vertex = output[output_size++];
+                vertex.position = glm::mix(a.position, b.position, t);
+                for (int v = 0; v != SOFTWARE_MAX_VARYINGS; ++v) {
+                    vertex.varyings[v] = a.varyings[v] + (b.varyings[v] - a.varyings[v]) * t;
+                }
+            }
+        }
+        size = output_size;
+        current = 1 - current;
+    }
+    if (size < 3) {
+        return;
+    }
+    WindowVertex window[9];
+    for (unsigned i = 0; i != size; ++i) {
+        window[i] = to_window(draw, polygons[current][i]);
+    }
+    for (unsigned i = 1; i + 1 < size; ++i) {
+        WindowVertex fan[3] = {window[0], window[i], window[i + 1]};
+        this->setup_triangle(draw, fan);
+    }
+}
+
+void SoftwareRenderDevice::setup_triangle(const DrawState *draw, const WindowVertex *input) {
+    WindowVertex vertices[3] = {input[0], input[1], input[2]};
+    long long x[3], y[3];
+    for (int i = 0; i != 3; ++i) {
+        x[i] = std::llround(vertices[i].x * SUBPIXEL_SCALE);
+        y[i] = std::llround(vertices[i].y * SUBPIXEL_SCALE);
+    }
+    long long area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0) {
+        return;
+    }
+    // nothing is culled, so make every triangle counter-clockwise
+    if (area < 0) {
+        std::swap(vertices[1], vertices[2]);
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+    }
+    // the pixels whose centers lie inside the bounding box, within the viewport, the scissor and the framebuffer
+    const long long half = SUBPIXEL_SCALE / 2;
+    int clip_min_x, clip_min_y, clip_max_x, clip_max_y;
+    this->get_clip_rect(false, clip_min_x, clip_min_y, clip_max_x, clip_max_y);
+    int min_x = std::max(static_cast<int>(floor_divide(*std::min_element(x, x + 3) - half + SUBPIXEL_SCALE - 1,
+                                                       SUBPIXEL_SCALE)), clip_min_x);
+    int min_y = std::max(static_cast<int>(floor_divide(*std::min_element(y, y + 3) - half + SUBPIXEL_SCALE - 1,
+                                                       SUBPIXEL_SCALE)), clip_min_y);
+    int max_x = std::min(static_cast<int>(floor_divide(*std::max_element(x, x + 3) - half, SUBPIXEL_SCALE)),
+                         clip_max_x);
+    int max_y = std::min(static_cast<int>(floor_divide(*std::max_element(y, y + 3) - half, SUBPIXEL_SCALE)),
+                         clip_max_y);
+    if (min_x > max_x || min_y > max_y) {
+        return;
+    }
+
+    unsigned plane_count = 2 + draw->varying_count;
+    auto *triangle = static_cast<Triangle *>(this->frame_arena.allocate(sizeof(Triangle), alignof(Triangle)));
+    auto *planes = static_cast<Plane *>(this->frame_arena.allocate(sizeof(Plane) * plane_count, alignof(Plane)));
+    triangle->draw = draw;
+    triangle->min_x = min_x;
+    triangle->min_y = min_y;
+    triangle->max_x = max_x;
+    triangle->max_y = max_y;
+    for (int i = 0; i != 3; ++i) {
+        int j = (i + 1) % 3;
+        long long a = y[i] - y[j], b = x[j] - x[i];
+        // top-left fill rule with y up: left edges go down, top edges go left, pixels on other edges are outside
+        bool top_left = y[j] < y[i] || (y[j] == y[i] && x[j] < x[i]);
+        triangle->a[i] = static_cast<int>(a);
+        triangle->b[i] = static_cast<int>(b);
+        triangle->c[i] = -(a * x[i] + b * y[i]) - (top_left ? 0 : 1);
+    }
+
+    // the attributes are planes over the snapped positions, in pixels relative to the first vertex
+    double x0 = static_cast<double>(x[0]) / SUBPIXEL_SCALE, y0 = static_cast<double>(y[0]) / SUBPIXEL_SCALE;
+    double x1 = static_cast<double>(x[1]) / SUBPIXEL_SCALE - x0, y1 = static_cast<double>(y[1]) / SUBPIXEL_SCALE - y0;
+    double x2 = static_cast<double>(x[2]) / SUBPIXEL_SCALE - x0, y2 = static_cast<double>(y[2]) / SUBPIXEL_SCALE - y0;
+    double determinant = x1 * y2 - x2 * y1;
+    auto make_plane = [&](float v0, float v1, float v2) {
+        double d1 = static_cast<double>(v1) - v0, d2 = static_cast<double>(v2) - v0;
+        return Plane{v0, static_cast<float>((d1 * y2 - d2 * y1) / determinant),
+                     static_cast<float>((d2 * x1 - d1 * x2) / determinant)};
+    };
+    planes[0] = make_plane(vertices[0].z, vertices[1].z, vertices[2].z);
+    planes[1] = make_plane(vertices[0].inverse_w, vertices[1].inverse_w, vertices[2].inverse_w);
+    for (unsigned v = 0; v != draw->varying_count; ++v) {
+        planes[2 + v] = make_plane(vertices[0].varyings[v], vertices[1].varyings[v], vertices[2].varyings[v]);
+    }
+    triangle->origin_x = static_cast<float>(x0);
+    triangle->origin_y = static_cast<float>(y0);
+    triangle->planes = planes;
+    this->bin(BIN_TRIANGLE, triangle, min_x, min_y, max_x, max_y);
+    ++this->stats.triangles;
+}
+
+void SoftwareRenderDevice::draw_line(const DrawState *draw, const ShadedVertex &start, const ShadedVertex &end) {
+    // parametric clipping against the guard band
+    float t0 = 0, t1 = 1;
+    for (int plane = 0; plane != 6; ++plane) {
+        float distance_start = clip_distance(start.position, plane);
+        float distance_end = clip_distance(end.position, plane);
+        if (distance_start < 0 && distance_end < 0) {
+            return;
+        }
+        if (distance_start < 0) {
+            t0 = std::max(t0, distance_start / (distance_start - distance_end));
+        } else if (distance_end < 0) {
+            t1 = std::min(t1, distance_start / (distance_start - distance_end));
+        }
+    }
+    if (t0 >= t1) {
+        return;
+    }
+    ShadedVertex ends[2] = {start, end};
+    float ts[2] = {t0, t1};
+    auto *line = static_cast<Line *>(this->frame_arena.allocate(sizeof(Line), alignof(Line)));
+    line->draw = draw;
+    line->point = false;
+    for (int i = 0; i != 2; ++i) {
+        ends[i].position = glm::mix(start.position, end.position, ts[i]);
+        for (int v = 0; v != SOFTWARE_MAX_VARYINGS; ++v) {
+            ends[i].varyings[v] = start.varyings[v] + (end.varyings[v] - start.varyings[v]) * ts[i];
+        }
+        line->ends[i] = this->to_window(draw, ends[i]);
+    }
+    int clip_min_x, clip_min_y, clip_max_x, clip_max_y;
+    this->get_clip_rect(false, clip_min_x, clip_min_y, clip_max_x, clip_max_y);
+    line->min_x = std::max(static_cast<int>(std::ceil(std::min(line->ends[0].x, line->ends[1].x))) - 1, clip_min_x);
+    line->min_y = std::max(static_cast<int>(std::ceil(std::min(line->ends[0].y, line->ends[1].y))) - 1, clip_min_y);
+    line->max_x = std::min(static_cast<int>(std::floor(std::max(line->ends[0].x, line->ends[1].x))), clip_max_x);
+    line->max_y = std::min(static_cast<int>(std::floor(std::max(line->ends[0].y, line->ends[1].y))), clip_max_y);
+    if (line->min_x > line->max_x || line->min_y > line->max_y) {
+        return;
+    }
+    this->bin(BIN_LINE, line, line->min_x, line->min_y, line->max_x, line->max_y);
+    ++this->stats.lines;
+}
+
+void SoftwareRenderDevice::draw_point(const DrawState *draw, const ShadedVertex &vertex) {
+    for (int plane = 0; plane != 6; ++plane) {
+        if (clip_distance(vertex.position, plane) < 0) {
+            return;
+        }
+    }
+    auto *point = static_cast<Line *>(this->frame_arena.allocate(sizeof(Line), alignof(Line)));
+    point->draw = draw;
+    point->point = true;
+    point->ends[0] = point->ends[1] = this->to_window(draw, vertex);
+    point->min_x = point->max_x = static_cast<int>(std::floor(point->ends[0].x));
+    point->min_y = point->max_y = static_cast<int>(std::floor(point->ends[0].y));
+    int clip_min_x, clip_min_y, clip_max_x, clip_max_y;
+    this->get_clip_rect(false, clip_min_x, clip_min_y, clip_max_x, clip_max_y);
+    if (point->min_x < clip_min_x || point->min_y < clip_min_y || point->max_x > clip_max_x ||
+        point->max_y > clip_max_y) {
+        return;
+    }
+    this->bin(BIN_LINE, point, point->min_x, point->min_y, point->max_x, point->max_y);
+    ++this->stats.points;
+}
+
+void SoftwareRenderDevice::bin(BinType type, const void *primitive, int min_x, int min_y, int max_x, int max_y) {
+    for (int tile_y = min_y / TILE_SIZE; tile_y <= max_y / TILE_SIZE; ++tile_y) {
+        for (int tile_x = min_x / TILE_SIZE; tile_x <= max_x / TILE_SIZE; ++tile_x) {
+            this->bins[tile_y * this->tiles_x + tile_x].push_back({type, primitive});
+            ++this->stats.bin_entries;
+        }
+    }
+    this->has_work = true;
+}
+
+void *SoftwareRenderDevice::insert_fence() {
+    // with nothing waiting for a flush, everything before the fence is done already
+    if (!this->has_work) {
+        this->signaled_fence = this->next_fence;
+    }
+    return reinterpret_cast<void *>(this->next_fence++);
+}
+
+void SoftwareRenderDevice::wait_fence(void *fence) {
+    this->flush();
+    ++this->counters.fence_waits;
+}
+
+bool SoftwareRenderDevice::is_fence_signaled(void *fence) {
+    return reinterpret_cast<uintptr_t>(fence) <= this->signaled_fence;
+}
+
+void SoftwareRenderDevice::destroy_fence(void *fence) {
+}
+
+void SoftwareRenderDevice::flush() {
+    if (!this->has_work) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    this->pool.parallel_for(static_cast<unsigned>(this->bins.size()), [this](unsigned tile, unsigned worker) {
+        unsigned quads = this->rasterize_tile(tile);
+        this->quads_shaded.fetch_add(quads, std::memory_order_relaxed);
+    });
+    for (auto &bin : this->bins) {
+        bin.clear();
+    }
+    this->frame_arena.reset();
+    this->has_work = false;
+    this->signaled_fence = this->next_fence - 1;
+    ++this->stats.flushes;
+    this->stats.quads_shaded = this->quads_shaded.load(std::memory_order_relaxed);
+    this->stats.raster_ms += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+const unsigned char *SoftwareRenderDevice::get_color_buffer() {
+    this->flush();
+    return this->color_buffer.data();
+}
+
+int SoftwareRenderDevice::get_width() const {
+    return this->width;
+}
+
+int SoftwareRenderDevice::get_height() const {
+    return this->height;
+}
+
+unsigned SoftwareRenderDevice::get_thread_count() const {
+    return this->pool.get_worker_count();
+}
+
+unsigned long long SoftwareRenderDevice::get_steal_count() const {
+    return this->pool.get_steal_count();
+}
+
+const SoftwareRenderDevice::Stats &SoftwareRenderDevice::get_stats() const {
+    return this->stats;
+}
+
+unsigned SoftwareRenderDevice::rasterize_tile(unsigned tile) {
+    int x0 = static_cast<int>(tile % this->tiles_x) * TILE_SIZE;
+    int y0 = static_cast<int>(tile / this->tiles_x) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, this->width);
+    int y1 = std::min(y0 + TILE_SIZE, this->height);
+    unsigned quads = 0;
+    // in the order of the draws, so the tiles blend and test depth like the draws were executed one by one
+    for (const BinEntry &entry : this->bins[tile]) {
+        switch (entry.type) {
+            case BIN_CLEAR:
+                this->clear_tile(*static_cast<const Clear *>(entry.primitive), x0, y0, x1, y1);
+                break;
+            case BIN_TRIANGLE:
+                quads += this->rasterize_triangle(*static_cast<const Triangle *>(entry.primitive), x0, y0, x1, y1);
+                break;
+            case BIN_LINE:
+                quads += this->rasterize_line(*static_cast<const Line *>(entry.primitive), x0, y0, x1, y1);
+                break;
+        }
+    }
+    return quads;
+}
+
+void SoftwareRenderDevice::clear_tile(const Clear &clear, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, clear.min_x);
+    y0 = std::max(y0, clear.min_y);
+    x1 = std::min(x1, clear.max_x + 1);
+    y1 = std::min(y1, clear.max_y + 1);
+    for (int y = y0; y < y1; ++y) {
+        size_t row = static_cast<size_t>(y) * this->width;
+        for (int x = x0; x != x1; ++x) {
+            std::memcpy(&this->color_buffer[(row + x) * 4], clear.color, 4);
+        }
+        if (clear.depth) {
+            std::fill(&this->depth_buffer[row + x0], &this->depth_buffer[row + x1], 1.0F);
+        }
+    }
+}
+
+unsigned SoftwareRenderDevice::rasterize_triangle(const Triangle &triangle, int x0, int y0, int x1, int y1) {
+    int min_x = std::max(triangle.min_x, x0), max_x = std::min(triangle.max_x, x1 - 1);
+    int min_y = std::max(triangle.min_y, y0), max_y = std::min(triangle.max_y, y1 - 1);
+    if (min_x > max_x || min_y > max_y) {
+        return 0;
+    }
+    // quads start on even pixels, the tiles do as well
+    int start_x = min_x & ~1, start_y = min_y & ~1;
+    int end_x = max_x | 1, end_y = max_y | 1;
+
+    // edges that do not cross the region are either all inside, so they can be skipped, or all outside
+    Edge4 edge_rows[3];
+    Edge4 edge_steps_x[3], edge_steps_y[3];
+    int edge_count = 0;
+    for (int i = 0; i != 3; ++i) {
+        long long a = triangle.a[i], b = triangle.b[i];
+        auto value = [&](int x, int y) {
+            return a * (x * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) + b * (y * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) +
+                   triangle.c[i];
+        };
+        long long corners[4] = {value(start_x, start_y), value(end_x, start_y), value(start_x, end_y),
+                                value(end_x, end_y)};
+        long long lowest = *std::min_element(corners, corners + 4);
+        long long highest = *std::max_element(corners, corners + 4);
+        if (highest < 0) {
+            return 0;
+        }
+        if (lowest >= 0) {
+            continue;
+        }
+        auto origin = static_cast<double>(corners[0]);
+        auto step_x = static_cast<double>(a * SUBPIXEL_SCALE), step_y = static_cast<double>(b * SUBPIXEL_SCALE);
+        edge_rows[edge_count] = edge4(origin, origin + step_x, origin + step_y, origin + step_x + step_y);
+        edge_steps_x[edge_count] = edge4_splat(step_x * 2);
+        edge_steps_y[edge_count] = edge4_splat(step_y * 2);
+        ++edge_count;
+    }
+
+    const DrawState &draw = *triangle.draw;
+    unsigned plane_count = 2 + draw.varying_count;
+    const Plane *planes = triangle.planes;
+    float values[2 + SOFTWARE_MAX_VARYINGS][4];
+    float varyings[4][SOFTWARE_MAX_VARYINGS];
+    unsigned quads = 0;
+    for (int y = start_y; y <= max_y; y += 2) {
+        Edge4 edges[3] = {edge_rows[0], edge_rows[1], edge_rows[2]};
+        // the lanes of the rows that are inside the region
+        unsigned row_mask = (y >= min_y ? 0x3U : 0U) | (y + 1 <= max_y ? 0xCU : 0U);
+        Float4 offset_y = float4_splat(static_cast<float>(y) + 0.5F - triangle.origin_y);
+        offset_y = float4_add(offset_y, float4(0.0F, 0.0F, 1.0F, 1.0F));
+        for (int x = start_x; x <= max_x; x += 2) {
+            unsigned mask = row_mask & ((x >= min_x ? 0x5U : 0U) | (x + 1 <= max_x ? 0xAU : 0U));
+            for (int i = 0; i != edge_count; ++i) {
+                mask &= edge4_non_negative(edges[i]);
+                edges[i] = edge4_add(edges[i], edge_steps_x[i]);
+            }
+            if (!mask) {
+                continue;
+            }
+            Float4 offset_x = float4_add(float4_splat(static_cast<float>(x) + 0.5F - triangle.origin_x),
+                                         float4(0.0F, 1.0F, 0.0F, 1.0F));
+            // the depth and 1 / w first, then every varying times w for perspective correct values
+            Float4 inverse_w;
+            Float4 w;
+            for (unsigned p = 0; p != plane_count; ++p) {
+                Float4 value = float4_add(float4_splat(planes[p].base),
+                                          float4_add(float4_mul(float4_splat(planes[p].dx), offset_x),
+                                                     float4_mul(float4_splat(planes[p].dy), offset_y)));
+                if (p == 1) {
+                    inverse_w = value;
+                    w = float4_div(float4_splat(1.0F), inverse_w);
+                } else if (p > 1) {
+                    value = float4_mul(value, w);
+                }
+                float4_store(values[p], value);
+            }
+            for (unsigned v = 0; v != draw.varying_count; ++v) {
+                for (int lane = 0; lane != 4; ++lane) {
+                    varyings[lane][v] = values[2 + v][lane];
+                }
+            }
+            const int lane_x[4] = {x, x + 1, x, x + 1};
+            const int lane_y[4] = {y, y, y + 1, y + 1};
+            quads += this->shade_quad(draw, lane_x, lane_y, values[0], varyings, mask);
+        }
+        for (int i = 0; i != edge_count; ++i) {
+            edge_rows[i] = edge4_add(edge_rows[i], edge_steps_y[i]);
+        }
+    }
+    return quads;
+}
+
+unsigned SoftwareRenderDevice::rasterize_line(const Line &line, int x0, int y0, int x1, int y1) {
+    int min_x = std::max(line.min_x, x0), max_x = std::min(line.max_x, x1 - 1);
+    int min_y = std::max(line.min_y, y0), max_y = std::min(line.max_y, y1 - 1);
+    if (min_x > max_x || min_y > max_y) {
+        return 0;
+    }
+    const DrawState &draw = *line.draw;
+    const WindowVertex &start = line.ends[0], &end = line.ends[1];
+    int lane_x[4], lane_y[4];
+    float depth[4];
+    float varyings[4][SOFTWARE_MAX_VARYINGS];
+    unsigned lanes = 0, quads = 0;
+    auto add_pixel = [&](int x, int y, float t) {
+        if (x < min_x || x > max_x || y < min_y || y > max_y) {
+            return;
+        }
+        lane_x[lanes] = x;
+        lane_y[lanes] = y;
+        depth[lanes] = start.z + (end.z - start.z) * t;
+        float w = 1.0F / (start.inverse_w + (end.inverse_w - start.inverse_w) * t);
+        for (unsigned v = 0; v != draw.varying_count; ++v) {
+            varyings[lanes][v] = (start.varyings[v] + (end.varyings[v] - start.varyings[v]) * t) * w;
+        }
+        // lines have no quads, so 4 pixels along the line stand in for one
+        if (++lanes == 4) {
+            quads += this->shade_quad(draw, lane_x, lane_y, depth, varyings, 0xF);
+            lanes = 0;
+        }
+    };
+    if (line.point) {
+        add_pixel(line.min_x, line.min_y, 0);
+    } else {
+        // the pixels whose centers are crossed along the major axis, the last one is left to the next line of a strip
+        float dx = end.x - start.x, dy = end.y - start.y;
+        bool x_major = std::abs(dx) >= std::abs(dy);
+        float major_start = x_major ? start.x : start.y, major_delta = x_major ? dx : dy;
+        float minor_start = x_major ? start.y : start.x, minor_delta = x_major ? dy : dx;
+        if (major_delta == 0) {
+            return 0;
+        }
+        int first, last;
+        if (major_delta > 0) {
+            first = static_cast<int>(std::ceil(major_start - 0.5F));
+            last = static_cast<int>(std::ceil(major_start + major_delta - 0.5F)) - 1;
+        } else {
+            first = static_cast<int>(std::floor(major_start + major_delta - 0.5F)) + 1;
+            last = static_cast<int>(std::floor(major_start - 0.5F));
+        }
+        first = std::max(first, x_major ? min_x : min_y);
+        last = std::min(last, x_major ? max_x : max_y);
+        for (int i = first; i <= last; ++i) {
+            float t = (static_cast<float>(i) + 0.5F - major_start) / major_delta;
+            // the line covers half a pixel to either side, the center on the left or the bottom edge is inside
+            auto minor = static_cast<int>(std::ceil(minor_start + minor_delta * t)) - 1;
+            if (x_major) {
+                add_pixel(i, minor, t);
+            } else {
+                add_pixel(minor, i, t);
+            }
+        }
+    }
+    if (lanes) {
+        quads += this->shade_quad(draw, lane_x, lane_y, depth, varyings, (1U << lanes) - 1);
+    }
+    return quads;
+}
+
+bool SoftwareRenderDevice::shade_quad(const DrawState &draw, const int *x, const int *y, const float *depth,
+                                      const float (*varyings)[SOFTWARE_MAX_VARYINGS], unsigned mask) {
+    size_t index[4];
+    for (int lane = 0; lane != 4; ++lane) {
+        if (!(mask & 1U << lane)) {
+            continue;
+        }
+        index[lane] = static_cast<size_t>(y[lane]) * this->width + x[lane];
+        // the depth range clamps before the test, so what a pre-pass wrote compares equal
+        float fragment_depth = std::min(std::max(depth[lane], 0.0F), 1.0F);
+        float stored_depth = this->depth_buffer[index[lane]];
+        bool passed = draw.depth_func == GL_EQUAL ? fragment_depth == stored_depth :
+                      draw.depth_func == GL_LEQUAL ? fragment_depth <= stored_depth : fragment_depth < stored_depth;
+        if (draw.depth_test && !passed) {
+            mask &= ~(1U << lane);
+        }
+    }
+    if (!mask) {
+        return false;
+    }
+    // the fragment shader never discards or writes depth, so testing before shading gives the same result, and a depth
+    // only draw does not need it at all
+    vec4 colors[4];
+    if (draw.color_write) {
+        draw.port->fragment(draw.state, varyings, colors);
+    }
+    for (int lane = 0; lane != 4; ++lane) {
+        if (!(mask & 1U << lane)) {
+            continue;
+        }
+        // like GL, nothing is written to the depth buffer while the test is disabled
+        if (draw.depth_test && draw.depth_write) {
+            this->depth_buffer[index[lane]] = std::min(std::max(depth[lane], 0.0F), 1.0F);
+        }
+        if (!draw.color_write) {
+            continue;
+        }
+        unsigned char *destination = &this->color_buffer[index[lane] * 4];
+        vec4 color = colors[lane];
+        if (draw.blend) {
+            vec4 existing = vec4(destination[0], destination[1], destination[2], destination[3]) / 255.0F;
+            color = color * color.a + existing * (1.0F - color.a);
+        }
+        for (int c = 0; c != 4; ++c) {
+            destination[c] = to_unorm8(color[c]);
+        }
+    }
+    return draw.color_write;
+}
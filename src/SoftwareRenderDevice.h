@@ -0,0 +1,283 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_SOFTWARERENDERDEVICE_H
+#define LEARNOPENGL_SOFTWARERENDERDEVICE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "SoftwareShaders.h"
+#include "CommandList.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+
+// a rasterizer on the CPU that runs the C++ ports of the shaders: a draw shades its vertices, clips its primitives
+// and bins them into tiles of the framebuffer right away, the tiles are rasterized when the frame is flushed, one
+// task per tile on a work stealing pool, with SIMD edge functions and attribute interpolation over 2x2 quads, the
+// framebuffer follows GL: RGBA8 color, float depth, the first row is the bottom one
+class SoftwareRenderDevice : public RenderDevice {
+
+public:
+    struct Stats {
+        unsigned long long flushes = 0;
+        unsigned long long triangles = 0;
+        unsigned long long lines = 0;
+        unsigned long long points = 0;
+        // primitives times the tiles they were binned into
+        unsigned long long bin_entries = 0;
+        unsigned long long quads_shaded = 0;
+        double raster_ms = 0;
+    };
+
+    // the framebuffer is at most 4096 x 4096
+    SoftwareRenderDevice(int width, int height, unsigned thread_count = std::thread::hardware_concurrency());
+
+    DeviceBackend get_backend() const override;
+
+    unsigned create_shader(GLenum stage, const string &source, const string &name) override;
+    unsigned create_program(unsigned vertex_shader, unsigned fragment_shader) override;
+    void destroy_shader(unsigned shader) override;
+    void destroy_program(unsigned program) override;
+    int get_uniform_location(unsigned program, const string &name) override;
+    void bind_uniform_block(unsigned program, const string &name, unsigned binding) override;
+    void use_program(unsigned program) override;
+    void set_uniform(const UniformValue &value) override;
+
+    unsigned create_buffer(GLenum target, size_t size, const void *data, GLenum usage) override;
+    void update_buffer(unsigned buffer, size_t offset, size_t size, const void *data, bool unsynchronized) override;
+    void bind_uniform_buffer(unsigned binding, unsigned buffer, size_t offset, size_t size) override;
+    void destroy_buffer(unsigned buffer) override;
+    size_t get_uniform_buffer_alignment() const override;
+
+    unsigned create_vertex_array(unsigned vertex_buffer, const VertexAttribute *attributes,
+                                 unsigned attribute_count) override;
+    void destroy_vertex_array(unsigned vertex_array) override;
+    void bind_vertex_array(unsigned vertex_array) override;
+
+    unsigned create_texture_2d(int width, int height, GLenum format, const void *pixels) override;
+    void set_texture_parameter(unsigned texture, GLenum parameter, int value) override;
+    void bind_texture(unsigned unit, unsigned texture) override;
+    void destroy_texture(unsigned texture) override;
+    unsigned create_render_target(int width, int height, GLenum format, int levels) override;
+
+    void set_viewport(int x, int y, int width, int height) override;
+    void set_scissor(bool enabled, int x, int y, int width, int height) override;
+    void clear(float red, float green, float blue, float alpha) override;
+    void set_depth_test(bool enabled) override;
+    void set_depth_write(bool enabled) override;
+    void set_depth_func(GLenum func) override;
+    void set_color_write(bool enabled) override;
+    void set_blend(bool enabled) override;
+    void set_polygon_mode(GLenum mode) override;
+    // there are no queries, so condition_query is ignored and everything is drawn
+    void draw(GLenum mode, int first, int count, unsigned condition_query) override;
+
+    // waiting for a fence flushes, the frame is done once the tiles are
+    void *insert_fence() override;
+    void wait_fence(void *fence) override;
+    bool is_fence_signaled(void *fence) override;
+    void destroy_fence(void *fence) override;
+
+    // rasterizes everything drawn since the last flush, the textures it uses must still be alive
+    void flush();
+    // flushes and returns the color buffer
+    const unsigned char *get_color_buffer();
+    int get_width() const;
+    int get_height() const;
+    unsigned get_thread_count() const;
+    // tiles taken from another thread's range of the pool
+    unsigned long long get_steal_count() const;
+    const Stats &get_stats() const;
+
+private:
+    static const unsigned MAX_TEXTURE_UNITS = 16;
+    static const unsigned MAX_UNIFORM_BINDINGS = 36;
+
+    struct ShaderInfo {
+        const SoftwareShaderPort *port;
+        std::map<string, UniformType> uniforms;
+    };
+
+    struct Uniform {
+        int location;
+        UniformType type;
+    };
+
+    struct ProgramInfo {
+        const SoftwareShaderPort *vertex;
+        const SoftwareShaderPort *fragment;
+        std::map<string, Uniform> uniforms;
+        // by location, GL starts every uniform at 0
+        std::vector<UniformValue> values;
+        // the locations of the uniforms and samplers of each port in the order the port lists them
+        int vertex_uniforms[SOFTWARE_MAX_PORT_UNIFORMS];
+        int fragment_uniforms[SOFTWARE_MAX_PORT_UNIFORMS];
+        int fragment_samplers[SOFTWARE_MAX_PORT_SAMPLERS];
+        // the binding point of each block of each port, GL starts them at 0
+        std::map<string, unsigned> block_bindings;
+        // where each float the fragment shader reads sits in the output of the vertex shader
+        unsigned varying_sources[SOFTWARE_MAX_VARYINGS];
+        unsigned vertex_varyings;
+        unsigned fragment_varyings;
+    };
+
+    struct BufferInfo {
+        GLenum target;
+        std::vector<unsigned char> data;
+        MemoryTracker::Consumer *memory = nullptr;
+    };
+
+    struct VertexArrayInfo {
+        unsigned buffer;
+        std::vector<VertexAttribute> attributes;
+    };
+
+    struct UniformBinding {
+        unsigned buffer = 0;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    struct ShadedVertex {
+        vec4 position;
+        float varyings[SOFTWARE_MAX_VARYINGS];
+    };
+
+    // a vertex after the viewport transform
+    struct WindowVertex {
+        float x, y, z;
+        float inverse_w;
+        // already divided by w for perspective correct interpolation
+        float varyings[SOFTWARE_MAX_VARYINGS];
+    };
+
+    // everything the tiles need of a draw, copied at the time of the draw, it lives in the frame arena
+    struct DrawState {
+        const SoftwareShaderPort *port;
+        SoftwareShaderState state;
+        const unsigned *varying_sources;
+        unsigned varying_count;
+        bool depth_test;
+        bool depth_write;
+        GLenum depth_func;
+        bool color_write;
+        bool blend;
+    };
+
+    // base value at (x, y) of the first vertex and its change per pixel
+    struct Plane {
+        float base, dx, dy;
+    };
+
+    struct Triangle {
+        const DrawState *draw;
+        // the covered pixels are inside [min_x, max_x] x [min_y, max_y]
+        int min_x, min_y, max_x, max_y;
+        // edge functions a * x + b * y + c in fixed point with the fill rule folded into c, inside where >= 0
+        int a[3], b[3];
+        long long c[3];
+        float origin_x, origin_y;
+        // depth, 1 / w and then every varying divided by w, they follow the triangle in the arena
+        const Plane *planes;
+    };
+
+    // a line or a point of 1 pixel
+    struct Line {
+        const DrawState *draw;
+        bool point;
+        WindowVertex ends[2];
+        int min_x, min_y, max_x, max_y;
+    };
+
+    enum BinType {
+        BIN_CLEAR, BIN_TRIANGLE, BIN_LINE
+    };
+
+    struct Clear {
+        unsigned char color[4];
+        bool depth;
+        // the pixels it covers, inclusive
+        int min_x, min_y, max_x, max_y;
+    };
+
+    struct BinEntry {
+        BinType type;
+        const void *primitive;
+    };
+
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    TaggedVector<unsigned char, MEMORY_CPU_RASTERIZER> color_buffer;
+    TaggedVector<float, MEMORY_CPU_RASTERIZER> depth_buffer;
+    ThreadPool pool;
+    // what the draws since the last flush left for the tiles
+    CommandArena frame_arena;
+    std::vector<std::vector<BinEntry>> bins;
+    bool has_work = false;
+    Stats stats;
+    std::atomic<unsigned long long> quads_shaded{0};
+
+    unsigned next_handle = 1;
+    std::map<unsigned, ShaderInfo> shaders;
+    std::map<unsigned, ProgramInfo> programs;
+    std::map<unsigned, BufferInfo> buffers;
+    std::map<unsigned, VertexArrayInfo> vertex_arrays;
+    std::map<unsigned, SoftwareTexture> textures;
+    // what each texture was charged to, SoftwareTexture belongs to the shader ports
+    std::map<unsigned, MemoryTracker::Consumer *> texture_memory;
+    uintptr_t next_fence = 1;
+    // the newest fence whose work has been rasterized
+    uintptr_t signaled_fence = 0;
+
+    unsigned current_program = 0;
+    unsigned current_vertex_array = 0;
+    unsigned texture_units[MAX_TEXTURE_UNITS] = {0};
+    std::vector<UniformBinding> uniform_bindings = std::vector<UniformBinding>(MAX_UNIFORM_BINDINGS);
+    int viewport[4] = {0, 0, 0, 0};
+    bool scissor_test = false;
+    int scissor[4] = {0, 0, 0, 0};
+    bool depth_test = false;
+    bool depth_write = true;
+    GLenum depth_func = GL_LESS;
+    bool color_write = true;
+    bool blend = false;
+    GLenum polygon_mode = GL_FILL;
+
+    // reused by every draw
+    std::vector<ShadedVertex> shaded_vertices;
+
+    ProgramInfo &get_program(unsigned program);
+    const unsigned char *get_block(const ProgramInfo &program, const SoftwareShaderPort &port, unsigned block);
+    DrawState *record_draw_state(ProgramInfo &program);
+    void shade_vertices(ProgramInfo &program, int first, int count);
+    WindowVertex to_window(const DrawState *draw, const ShadedVertex &vertex) const;
+    // the pixels the scissor leaves of the framebuffer, and of the viewport too unless only_scissor, inclusive
+    void get_clip_rect(bool only_scissor, int &min_x, int &min_y, int &max_x, int &max_y) const;
+    void draw_triangle(const DrawState *draw, const ShadedVertex *vertices);
+    void draw_line(const DrawState *draw, const ShadedVertex &start, const ShadedVertex &end);
+    void draw_point(const DrawState *draw, const ShadedVertex &vertex);
+    void setup_triangle(const DrawState *draw, const WindowVertex *vertices);
+    void bin(BinType type, const void *primitive, int min_x, int min_y, int max_x, int max_y);
+
+    // the rasterizers return how many quads they shaded
+    unsigned rasterize_tile(unsigned tile);
+    void clear_tile(const Clear &clear, int x0, int y0, int x1, int y1);
+    unsigned rasterize_triangle(const Triangle &triangle, int x0, int y0, int x1, int y1);
+    unsigned rasterize_line(const Line &line, int x0, int y0, int x1, int y1);
+    // shades the lanes of a quad that are set in mask, the ones that pass the depth test are written, returns whether
+    // the fragment shader ran
+    bool shade_quad(const DrawState &draw, const int *x, const int *y, const float *depth,
+                    const float (*varyings)[SOFTWARE_MAX_VARYINGS], unsigned mask);
+};
+
+
+#endif //LEARNOPENGL_SOFTWARERENDERDEVICE_H
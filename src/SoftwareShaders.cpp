@@ -0,0 +1,334 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "SoftwareShaders.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+// the offsets of the members of the FrameData block, std140
+#define FRAME_DATA_VIEW_MATRIX 0
+#define FRAME_DATA_PROJECTION_MATRIX 64
+#define FRAME_DATA_VIEW_POSITION 128
+
+static int wrap_coordinate(int i, int size, GLenum mode) {
+    switch (mode) {
+        case GL_CLAMP_TO_EDGE:
+            return std::min(std::max(i, 0), size - 1);
+        case GL_MIRRORED_REPEAT: {
+            int period = i % (2 * size);
+            period = period < 0 ? period + 2 * size : period;
+            return period < size ? period : 2 * size - 1 - period;
+        }
+        default: {
+            int repeated = i % size;
+            return repeated < 0 ? repeated + size : repeated;
+        }
+    }
+}
+
+// floor() that stays far away from the limits of int, any texture is much smaller
+static int floor_to_int(float value) {
+    return static_cast<int>(std::floor(std::min(std::max(value, -16777216.0F), 16777216.0F)));
+}
+
+void SoftwareTexture::set_image(int width, int height, GLenum format, const unsigned char *pixels) {
+    this->levels.clear();
+    Level base = {width, height, std::vector<unsigned char>(static_cast<size_t>(width) * height * 4)};
+    int channels = format == GL_RGB ? 3 : 4;
+    for (size_t i = 0; i != static_cast<size_t>(width) * height; ++i) {
+        for (int c = 0; c != 4; ++c) {
+            base.texels[i * 4 + c] = c < channels ? pixels[i * channels + c] : 255;
+        }
+    }
+    this->levels.push_back(std::move(base));
+    while (this->levels.back().width > 1 || this->levels.back().height > 1) {
+        const Level &source = this->levels.back();
+        Level level = {std::max(source.width / 2, 1), std::max(source.height / 2, 1), {}};
+        level.texels.resize(static_cast<size_t>(level.width) * level.height * 4);
+        for (int y = 0; y != level.height; ++y) {
+            for (int x = 0; x != level.width; ++x) {
+                // a dimension that is already 1 only averages along the other one
+                int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+                for (int c = 0; c != 4; ++c) {
+                    int sum = source.texels[(y0 * source.width + x0) * 4 + c] +
+                              source.texels[(y0 * source.width + x1) * 4 + c] +
+                              source.texels[(y1 * source.width + x0) * 4 + c] +
+                              source.texels[(y1 * source.width + x1) * 4 + c];
+                    level.texels[(y * level.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        this->levels.push_back(std::move(level));
+    }
+}
+
+size_t SoftwareTexture::get_size() const {
+    size_t size = 0;
+    for (const Level &level : this->levels) {
+        size += level.texels.size();
+    }
+    return size;
+}
+
+vec4 SoftwareTexture::sample_level(unsigned level_index, GLenum filter, const vec2 &coords) const {
+    const Level &level = this->levels[level_index];
+    auto texel = [&](int x, int y) {
+        const unsigned char *t = &level.texels[(static_cast<size_t>(y) * level.width + x) * 4];
+        return vec4(t[0], t[1], t[2], t[3]) / 255.0F;
+    };
+    float u = coords.x * static_cast<float>(level.width);
+    float v = coords.y * static_cast<float>(level.height);
+    if (filter == GL_NEAREST) {
+        return texel(wrap_coordinate(floor_to_int(u), level.width, this->wrap_s),
+                     wrap_coordinate(floor_to_int(v), level.height, this->wrap_t));
+    }
+    u -= 0.5F;
+    v -= 0.5F;
+    int i = floor_to_int(u), j = floor_to_int(v);
+    float alpha = u - std::floor(u), beta = v - std::floor(v);
+    int i0 = wrap_coordinate(i, level.width, this->wrap_s), i1 = wrap_coordinate(i + 1, level.width, this->wrap_s);
+    int j0 = wrap_coordinate(j, level.height, this->wrap_t), j1 = wrap_coordinate(j + 1, level.height, this->wrap_t);
+    return glm::mix(glm::mix(texel(i0, j0), texel(i1, j0), alpha),
+                    glm::mix(texel(i0, j1), texel(i1, j1), alpha), beta);
+}
+
+void SoftwareTexture::sample_quad(const vec2 *coords, vec4 *colors) const {
+    if (this->levels.empty()) {
+        std::fill(colors, colors + 4, vec4(0.0F, 0.0F, 0.0F, 1.0F));
+        return;
+    }
+    // the scale factor of the GL spec from the differences across the quad, one level of detail for all 4 pixels
+    vec2 size(static_cast<float>(this->levels[0].width), static_cast<float>(this->levels[0].height));
+    float rho = std::max(glm::length((coords[1] - coords[0]) * size), glm::length((coords[2] - coords[0]) * size));
+    float lambda = rho > 0 ? std::log2(rho) : -1000.0F;
+    bool min_nearest_level = this->min_filter == GL_NEAREST_MIPMAP_NEAREST ||
+                             this->min_filter == GL_LINEAR_MIPMAP_NEAREST;
+    float c = this->mag_filter == GL_LINEAR && min_nearest_level ? 0.5F : 0.0F;
+
+    auto last_level = static_cast<unsigned>(this->levels.size() - 1);
+    GLenum filter = this->min_filter;
+    unsigned level = 0, next_level = 0;
+    float blend = 0;
+    if (lambda <= c) {
+        filter = this->mag_filter;
+    } else if (this->min_filter != GL_NEAREST && this->min_filter != GL_LINEAR) {
+        bool nearest_texel = this->min_filter == GL_NEAREST_MIPMAP_NEAREST ||
+                             this->min_filter == GL_NEAREST_MIPMAP_LINEAR;
+        filter = nearest_texel ? GL_NEAREST : GL_LINEAR;
+        if (min_nearest_level) {
+            level = lambda <= 0.5F ? 0 : static_cast<unsigned>(std::min(std::ceil(lambda + 0.5F) - 1.0F,
+                                                                         static_cast<float>(last_level)));
+            next_level = level;
+        } else {
+            float clamped = std::min(lambda, static_cast<float>(last_level));
+            level = static_cast<unsigned>(clamped);
+            next_level = std::min(level + 1, last_level);
+            blend = clamped - static_cast<float>(level);
+        }
+    }
+    for (int i = 0; i != 4; ++i) {
+        colors[i] = this->sample_level(level, filter, coords[i]);
+        if (next_level != level && blend > 0) {
+            colors[i] = glm::mix(colors[i], this->sample_level(next_level, filter, coords[i]), blend);
+        }
+    }
+}
+
+unsigned SoftwareShaderPort::get_varying_floats() const {
+    unsigned floats = 0;
+    for (const Varying &varying : this->varyings) {
+        floats += varying.components;
+    }
+    return floats;
+}
+
+static mat4 block_mat4(const unsigned char *block, size_t offset) {
+    float values[16];
+    std::memcpy(values, block + offset, sizeof(values));
+    return glm::make_mat4(values);
+}
+
+static vec4 block_vec4(const unsigned char *block, size_t offset) {
+    float values[4];
+    std::memcpy(values, block + offset, sizeof(values));
+    return glm::make_vec4(values);
+}
+
+// crosshair_vertex_shader.glsl
+static void crosshair_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position,
+                             float *varyings) {
+    position = vec4(vec3(attributes[0]), 1.0F);
+}
+
+// crosshair_fragment_shader.glsl, light_source_fragment_shader.glsl
+static void white_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                           vec4 *colors) {
+    std::fill(colors, colors + 4, vec4(1.0F, 1.0F, 1.0F, 1.0F));
+}
+
+// bounding_box_vertex_shader.glsl
+static void bounding_box_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position,
+                                float *varyings) {
+    mat4 view_projection_matrix = glm::make_mat4(state.uniforms[0]);
+    vec3 box_center = glm::make_vec3(state.uniforms[1]);
+    vec3 box_extent = glm::make_vec3(state.uniforms[2]);
+    position = view_projection_matrix * vec4(box_center + vec3(attributes[0]) * 2.0F * box_extent, 1.0F);
+}
+
+// bounding_box_fragment_shader.glsl
+static void bounding_box_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                                  vec4 *colors) {
+    std::fill(colors, colors + 4, vec4(1.0F, 0.0F, 1.0F, 1.0F));
+}
+
+// cube_vertex_shader.glsl
+static void cube_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position, float *varyings) {
+    mat4 model_matrix = glm::make_mat4(state.uniforms[0]);
+    mat4 view_matrix = block_mat4(state.blocks[0], FRAME_DATA_VIEW_MATRIX);
+    mat4 projection_matrix = block_mat4(state.blocks[0], FRAME_DATA_PROJECTION_MATRIX);
+    position = projection_matrix * view_matrix * model_matrix * vec4(vec3(attributes[0]), 1.0F);
+    // tex_coords
+    varyings[0] = attributes[1].x;
+    varyings[1] = attributes[1].y;
+}
+
+// cube_fragment_shader.glsl
+static void cube_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                          vec4 *colors) {
+    vec2 tex_coords[4];
+    for (int i = 0; i != 4; ++i) {
+        tex_coords[i] = vec2(varyings[i][0], varyings[i][1]);
+    }
+    vec4 colors0[4], colors1[4];
+    state.textures[0]->sample_quad(tex_coords, colors0);
+    state.textures[1]->sample_quad(tex_coords, colors1);
+    for (int i = 0; i != 4; ++i) {
+        colors[i] = glm::mix(colors0[i], colors1[i], 1.0F);
+    }
+}
+
+// lighting_cube_vertex_shader.glsl
+static void lighting_cube_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position,
+                                 float *varyings) {
+    mat4 model_matrix = glm::make_mat4(state.uniforms[0]);
+    mat3 normal_matrix = glm::make_mat3(state.uniforms[1]);
+    mat4 view_matrix = block_mat4(state.blocks[0], FRAME_DATA_VIEW_MATRIX);
+    mat4 projection_matrix = block_mat4(state.blocks[0], FRAME_DATA_PROJECTION_MATRIX);
+    // transform the normal vector to the view space
+    vec3 normal = glm::normalize(normal_matrix * vec3(attributes[1]));
+    vec3 world_position = vec3(model_matrix * vec4(vec3(attributes[0]), 1.0F));
+    position = projection_matrix * view_matrix * model_matrix * vec4(vec3(attributes[0]), 1.0F);
+    std::memcpy(varyings, glm::value_ptr(normal), sizeof(normal));
+    std::memcpy(varyings + 3, glm::value_ptr(world_position), sizeof(world_position));
+}
+
+// lighting_cube_fragment_shader.glsl
+static void lighting_cube_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                                   vec4 *colors) {
+    vec3 object_color = glm::make_vec3(state.uniforms[0]);
+    vec3 light_color = glm::make_vec3(state.uniforms[1]);
+    vec3 light_position = glm::make_vec3(state.uniforms[2]);
+    vec4 view_position = block_vec4(state.blocks[0], FRAME_DATA_VIEW_POSITION);
+    for (int i = 0; i != 4; ++i) {
+        vec3 normal = glm::make_vec3(varyings[i]);
+        vec3 position = glm::make_vec3(varyings[i] + 3);
+        // ambient lighting
+        float ambient_strength = 0.1F;
+        vec3 ambient_light = ambient_strength * light_color;
+
+        // diffuse lighting
+        vec3 light_direction = glm::normalize(light_position - position);
+        float diffuse_factor = std::max(glm::dot(normal, light_direction), 0.0F);
+        vec3 diffuse_light = diffuse_factor * light_color;
+
+        // specular lighting
+        float specular_strength = 0.5F;
+        vec3 view_direction = glm::normalize(vec3(view_position) - position);
+        vec3 reflect_direction = glm::reflect(-light_direction, normal);
+        float specular_factor = std::pow(std::max(glm::dot(view_direction, reflect_direction), 0.0F), 32.0F);
+        vec3 specular_light = specular_strength * specular_factor * light_color;
+
+        vec3 result = (ambient_light + diffuse_light + specular_light) * object_color;
+        colors[i] = vec4(result, 1.0F);
+    }
+}
+
+// depth_vertex_shader.glsl, the position has to come out bit for bit like in the ports of the shaders it pre-passes
+static void depth_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position, float *varyings) {
+    mat4 model_matrix = glm::make_mat4(state.uniforms[0]);
+    mat4 view_matrix = block_mat4(state.blocks[0], FRAME_DATA_VIEW_MATRIX);
+    mat4 projection_matrix = block_mat4(state.blocks[0], FRAME_DATA_PROJECTION_MATRIX);
+    position = projection_matrix * view_matrix * model_matrix * vec4(vec3(attributes[0]), 1.0F);
+}
+
+// depth_fragment_shader.glsl has no output, its draws mask color writes off
+static void depth_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                           vec4 *colors) {
+    std::fill(colors, colors + 4, vec4(0.0F, 0.0F, 0.0F, 1.0F));
+}
+
+// line_vertex_shader.glsl
+static void line_vertex(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position, float *varyings) {
+    mat4 model_matrix = glm::make_mat4(state.uniforms[0]);
+    mat4 view_matrix = block_mat4(state.blocks[0], FRAME_DATA_VIEW_MATRIX);
+    mat4 projection_matrix = block_mat4(state.blocks[0], FRAME_DATA_PROJECTION_MATRIX);
+    vec3 in_pos = vec3(attributes[0]);
+    position = projection_matrix * view_matrix * model_matrix * vec4(in_pos, 1.0F);
+    // the GLSL leaves the color undefined at the origin
+    vec4 color(0.0F);
+    if (in_pos.x != 0) {
+        color = vec4(1.0F, 0.0F, 0.0F, 1.0F);
+    } else if (in_pos.y != 0) {
+        color = vec4(0.0F, 1.0F, 0.0F, 1.0F);
+    } else if (in_pos.z != 0) {
+        color = vec4(0.0F, 0.0F, 1.0F, 1.0F);
+    }
+    std::memcpy(varyings, glm::value_ptr(color), sizeof(color));
+}
+
+// line_fragment_shader.glsl
+static void line_fragment(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS],
+                          vec4 *colors) {
+    for (int i = 0; i != 4; ++i) {
+        colors[i] = glm::make_vec4(varyings[i]);
+    }
+}
+
+// fullscreen_vertex_shader.glsl and hiz_reduce_fragment_shader.glsl only serve the depth pyramid, which needs GL
+static const SoftwareShaderPort ports[] = {
+        {"crosshair_vertex_shader.glsl", GL_VERTEX_SHADER, {}, {}, {}, {}, crosshair_vertex, nullptr},
+        {"crosshair_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {}, {}, {}, nullptr, white_fragment},
+        {"bounding_box_vertex_shader.glsl", GL_VERTEX_SHADER,
+                {"view_projection_matrix", "box_center", "box_extent"}, {}, {}, {}, bounding_box_vertex, nullptr},
+        {"bounding_box_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {}, {}, {}, nullptr, bounding_box_fragment},
+        {"cube_vertex_shader.glsl", GL_VERTEX_SHADER, {"model_matrix"}, {}, {"FrameData"}, {{"tex_coords", 2}},
+                cube_vertex, nullptr},
+        {"cube_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {"texture0", "texture1"}, {}, {{"tex_coords", 2}},
+                nullptr, cube_fragment},
+        {"light_source_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {}, {}, {}, nullptr, white_fragment},
+        {"depth_vertex_shader.glsl", GL_VERTEX_SHADER, {"model_matrix"}, {}, {"FrameData"}, {}, depth_vertex, nullptr},
+        {"depth_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {}, {}, {}, nullptr, depth_fragment},
+        {"lighting_cube_vertex_shader.glsl", GL_VERTEX_SHADER, {"model_matrix", "normal_matrix"}, {}, {"FrameData"},
+                {{"normal", 3}, {"position", 3}}, lighting_cube_vertex, nullptr},
+        {"lighting_cube_fragment_shader.glsl", GL_FRAGMENT_SHADER, {"object_color", "light_color", "light_position"},
+                {}, {"FrameData"}, {{"normal", 3}, {"position", 3}}, nullptr, lighting_cube_fragment},
+        {"line_vertex_shader.glsl", GL_VERTEX_SHADER, {"model_matrix"}, {}, {"FrameData"}, {{"color", 4}},
+                line_vertex, nullptr},
+        {"line_fragment_shader.glsl", GL_FRAGMENT_SHADER, {}, {}, {}, {{"color", 4}}, nullptr, line_fragment},
+};
+
+const SoftwareShaderPort *SoftwareShaderPort::find(const string &path) {
+    size_t separator = path.find_last_of("/\\");
+    string name = separator == string::npos ? path : path.substr(separator + 1);
+    for (const SoftwareShaderPort &port : ports) {
+        if (name == port.name) {
+            return &port;
+        }
+    }
+    return nullptr;
+}
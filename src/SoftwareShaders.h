@@ -0,0 +1,88 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_SOFTWARESHADERS_H
+#define LEARNOPENGL_SOFTWARESHADERS_H
+
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "RenderDevice.h"
+
+using glm::vec2;
+
+// vertex attribute locations a port can read
+#define SOFTWARE_MAX_ATTRIBUTES 4
+// floats a vertex shader can pass on to the fragment shader
+#define SOFTWARE_MAX_VARYINGS 8
+// uniforms, samplers and uniform blocks a single port can read
+#define SOFTWARE_MAX_PORT_UNIFORMS 4
+#define SOFTWARE_MAX_PORT_SAMPLERS 2
+#define SOFTWARE_MAX_PORT_BLOCKS 1
+
+// an RGBA8 texture with its mip chain and the sampler parameters that GL keeps in the texture object
+struct SoftwareTexture {
+    struct Level {
+        int width;
+        int height;
+        std::vector<unsigned char> texels;
+    };
+
+    std::vector<Level> levels;
+    GLenum wrap_s = GL_REPEAT;
+    GLenum wrap_t = GL_REPEAT;
+    GLenum min_filter = GL_NEAREST_MIPMAP_LINEAR;
+    GLenum mag_filter = GL_LINEAR;
+
+    // format is GL_RGB or GL_RGBA, the chain is built by averaging 2x2 texels like glGenerateMipmap
+    void set_image(int width, int height, GLenum format, const unsigned char *pixels);
+    size_t get_size() const;
+    // texture() for the 4 pixels of a quad, the level of detail comes from the differences between their coordinates
+    void sample_quad(const vec2 *coords, vec4 *colors) const;
+
+private:
+    vec4 sample_level(unsigned level, GLenum filter, const vec2 &coords) const;
+};
+
+// what a port reads, in the order the port lists them
+struct SoftwareShaderState {
+    // the data of every uniform, see UniformValue
+    const float *uniforms[SOFTWARE_MAX_PORT_UNIFORMS];
+    // the texture bound to the unit of every sampler, nullptr samples as (0, 0, 0, 1) like an incomplete texture
+    const SoftwareTexture *textures[SOFTWARE_MAX_PORT_SAMPLERS];
+    // std140 data of every uniform block
+    const unsigned char *blocks[SOFTWARE_MAX_PORT_BLOCKS];
+};
+
+// a C++ port of one of the GLSL shaders in resource/shader, the names are the ones the GLSL declares, so the device can
+// check a port against its source and link the stages by name like GL does
+struct SoftwareShaderPort {
+    struct Varying {
+        const char *name;
+        unsigned components;
+    };
+
+    // the file name of the GLSL source
+    const char *name;
+    GLenum stage;
+    std::vector<const char *> uniforms;
+    std::vector<const char *> samplers;
+    std::vector<const char *> blocks;
+    // the outputs of a vertex shader or the inputs of a fragment shader, packed in this order
+    std::vector<Varying> varyings;
+    // the attributes by location to the clip space position and the varyings
+    void (*vertex)(const SoftwareShaderState &state, const vec4 *attributes, vec4 &position, float *varyings);
+    // shades a 2x2 quad, lane i is the pixel (i & 1, i >> 1) of the quad
+    void (*fragment)(const SoftwareShaderState &state, const float (*varyings)[SOFTWARE_MAX_VARYINGS], vec4 *colors);
+
+    unsigned get_varying_floats() const;
+
+    // the port of a shader file, the directories are ignored, nullptr if there is none
+    static const SoftwareShaderPort *find(const string &path);
+};
+
+
+#endif //LEARNOPENGL_SOFTWARESHADERS_H
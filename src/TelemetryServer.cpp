@@ -0,0 +1,355 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "TelemetryServer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "CpuProfiler.h"
+#include "MemoryTracker.h"
+
+// a request bigger than this is not a scrape
+#define MAX_REQUEST_SIZE 4096
+// how long a client may take to send its request and read the response, in milliseconds
+#define REQUEST_TIMEOUT 1000
+// connections waiting to be accepted
+#define LISTEN_BACKLOG 8
+#define UNIX_ADDRESS_PREFIX "unix:"
+
+std::atomic<bool> TelemetryServer::running{false};
+
+static void write_metric_header(std::ostream &out, const string &name, const char *type, const char *help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+static void write_gauge(std::ostream &out, const string &name, const char *help, double value) {
+    write_metric_header(out, name, "gauge", help);
+    out << name << " " << value << "\n";
+}
+
+void TelemetryServer::write_metrics(std::ostream &out, const RenderStats::Frame &frame) {
+    std::streamsize precision = out.precision();
+    out.precision(10);
+
+    write_metric_header(out, "learnopengl_frames_total", "counter", "Frames the renderer finished.");
+    out << "learnopengl_frames_total " << frame.index << "\n";
+    write_metric_header(out, "learnopengl_frame_time_seconds", "histogram",
+                        "Time between the ends of consecutive frames.");
+    for (int bucket = 0; bucket != RenderStats::FRAME_TIME_BUCKET_COUNT; ++bucket) {
+        out << "learnopengl_frame_time_seconds_bucket{le=\"" << RenderStats::FRAME_TIME_BUCKETS[bucket] / 1000.0
+            << "\"} " << frame.frame_ms_buckets[bucket] << "\n";
+    }
+    out << "learnopengl_frame_time_seconds_bucket{le=\"+Inf\"} " << frame.frame_ms_count << "\n";
+    out << "learnopengl_frame_time_seconds_sum " << frame.frame_ms_sum / 1000.0 << "\n";
+    out << "learnopengl_frame_time_seconds_count " << frame.frame_ms_count << "\n";
+    write_gauge(out, "learnopengl_last_frame_time_seconds", "Time of the last frame.", frame.frame_ms / 1000.0);
+
+    // the draw counters of the last frame
+    const RenderDevice::Counters &counters = frame.counters;
+    const struct {
+        const char *name;
+        const char *help;
+        unsigned long long value;
+    } frame_counters[] = {
+            {"draws", "Draw calls of the last frame.", counters.draws},
+            {"vertices", "Vertices drawn in the last frame.", counters.vertices},
+            {"triangles", "Triangles drawn in the last frame.", counters.triangles},
+            {"program_binds", "Program switches of the last frame.", counters.program_binds},
+            {"vertex_array_binds", "Vertex array switches of the last frame.", counters.vertex_array_binds},
+            {"texture_binds", "Texture switches of the last frame.", counters.texture_binds},
+            {"uniform_calls", "Uniforms set in the last frame.", counters.uniform_calls},
+            {"buffer_updates", "Buffer updates of the last frame.", counters.buffer_updates},
+            {"uploaded_bytes", "Bytes uploaded in the last frame.", counters.bytes_uploaded},
+            {"clears", "Clears of the last frame.", counters.clears},
+            {"fence_waits", "Fence waits of the last frame.", counters.fence_waits},
+            {"query_reads", "Query results read back in the last frame.", counters.query_reads},
+    };
+    for (const auto &counter : frame_counters) {
+        write_gauge(out, string("learnopengl_frame_") + counter.name, counter.help,
+                    static_cast<double>(counter.value));
+    }
+
+    // the objects alive at the end of the last frame
+    write_metric_header(out, "learnopengl_device_objects", "gauge", "Objects alive on the render device.");
+    const struct {
+        const char *type;
+        unsigned value;
+    } objects[] = {
+            {"shaders", counters.shaders},
+            {"programs", counters.programs},
+            {"buffers", counters.buffers},
+            {"vertex_arrays", counters.vertex_arrays},
+            {"framebuffers", counters.framebuffers},
+            {"textures", counters.textures},
+    };
+    for (const auto &object : objects) {
+        out << "learnopengl_device_objects{type=\"" << object.type << "\"} " << object.value << "\n";
+    }
+    write_metric_header(out, "learnopengl_device_object_bytes", "gauge",
+                        "Bytes of the objects alive on the render device.");
+    out << "learnopengl_device_object_bytes{type=\"buffers\"} " << counters.buffer_bytes << "\n";
+    out << "learnopengl_device_object_bytes{type=\"textures\"} " << counters.texture_bytes << "\n";
+
+    // the memory tracker at the end of the last frame
+    const MemoryTracker::Stats *stats = frame.memory;
+    const struct {
+        const char *name;
+        const char *help;
+        size_t MemoryTracker::Stats::*value;
+    } memory_metrics[] = {
+            {"learnopengl_memory_bytes", "Bytes held per memory tag.", &MemoryTracker::Stats::bytes},
+            {"learnopengl_memory_peak_bytes", "Most bytes ever held per memory tag.",
+             &MemoryTracker::Stats::peak_bytes},
+            {"learnopengl_memory_allocations", "Allocations or objects alive per memory tag.",
+             &MemoryTracker::Stats::allocations},
+    };
+    for (const auto &metric : memory_metrics) {
+        write_metric_header(out, metric.name, "gauge", metric.help);
+        for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+            out << metric.name << "{tag=\"" << MemoryTracker::get_tag_name(static_cast<MemoryTag>(tag)) << "\"} "
+                << stats[tag].*metric.value << "\n";
+        }
+    }
+    // only the tags that have a budget
+    write_metric_header(out, "learnopengl_memory_budget_bytes", "gauge", "Budget per memory tag.");
+    for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+        if (stats[tag].budget) {
+            out << "learnopengl_memory_budget_bytes{tag=\"" << MemoryTracker::get_tag_name(static_cast<MemoryTag>(tag))
+                << "\"} " << stats[tag].budget << "\n";
+        }
+    }
+    out.precision(precision);
+}
+
+const string &TelemetryServer::get_address() const {
+    return this->address;
+}
+
+#ifdef _WIN32
+
+TelemetryServer::TelemetryServer(const string &address) {
+    throw std::runtime_error("The telemetry server is not supported on Windows!");
+}
+
+TelemetryServer::~TelemetryServer() = default;
+
+void TelemetryServer::serve() {}
+
+void TelemetryServer::answer(int connection) {}
+
+void TelemetryServer::close() {}
+
+#else
+
+static std::runtime_error socket_error(const string &what) {
+    return std::runtime_error("Telemetry server failed to " + what + ": " + std::strerror(errno) + "!");
+}
+
+// waits until the connection is ready for events, false once the deadline passed or the wake pipe woke us up, which
+// is left for serve() to see
+static bool wait_for(int connection, short events, int wake, std::chrono::steady_clock::time_point deadline) {
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            return false;
+        }
+        pollfd descriptors[] = {{connection, events, 0}, {wake, POLLIN, 0}};
+        int ready = poll(descriptors, 2, static_cast<int>(left.count()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready > 0 && !descriptors[1].revents;
+    }
+}
+
+TelemetryServer::TelemetryServer(const string &address) {
+    if (running.exchange(true)) {
+        throw std::runtime_error("Only one telemetry server may run at a time!");
+    }
+    try {
+        if (address.compare(0, std::strlen(UNIX_ADDRESS_PREFIX), UNIX_ADDRESS_PREFIX) == 0) {
+            string path = address.substr(std::strlen(UNIX_ADDRESS_PREFIX));
+            sockaddr_un socket_address{};
+            if (path.empty() || path.size() >= sizeof(socket_address.sun_path)) {
+                throw std::runtime_error("Invalid telemetry socket path " + path + "!");
+            }
+            socket_address.sun_family = AF_UNIX;
+            std::strcpy(socket_address.sun_path, path.c_str());
+            this->listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (this->listen_socket < 0) {
+                throw socket_error("create a socket");
+            }
+            // a socket left behind by a server that did not shut down, anything else at the path is left alone
+            struct stat status{};
+            if (stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+                unlink(path.c_str());
+            }
+            if (bind(this->listen_socket, reinterpret_cast<sockaddr *>(&socket_address), sizeof(socket_address))) {
+                throw socket_error("bind to " + path);
+            }
+            this->socket_path = path;
+            this->address = path;
+        } else {
+            size_t end;
+            unsigned long port = std::stoul(address, &end);
+            if (end != address.size() || port > 65535) {
+                throw std::invalid_argument(address);
+            }
+            sockaddr_in socket_address{};
+            socket_address.sin_family = AF_INET;
+            socket_address.sin_port = htons(static_cast<uint16_t>(port));
+            socket_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            this->listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+            if (this->listen_socket < 0) {
+                throw socket_error("create a socket");
+            }
+            int reuse = 1;
+            setsockopt(this->listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (bind(this->listen_socket, reinterpret_cast<sockaddr *>(&socket_address), sizeof(socket_address))) {
+                throw socket_error("bind to port " + address);
+            }
+            socklen_t length = sizeof(socket_address);
+            getsockname(this->listen_socket, reinterpret_cast<sockaddr *>(&socket_address), &length);
+            this->address = "127.0.0.1:" + std::to_string(ntohs(socket_address.sin_port));
+        }
+        if (listen(this->listen_socket, LISTEN_BACKLOG)) {
+            throw socket_error("listen");
+        }
+        if (pipe(this->wake_pipe)) {
+            throw socket_error("create a pipe");
+        }
+    } catch (const std::logic_error &) {
+        this->close();
+        throw std::runtime_error("Invalid telemetry address " + address + "!");
+    } catch (...) {
+        this->close();
+        throw;
+    }
+    RenderStats::set_publishing(true);
+    this->thread = std::thread(&TelemetryServer::serve, this);
+}
+
+TelemetryServer::~TelemetryServer() {
+    if (this->thread.joinable()) {
+        char wake = 0;
+        while (write(this->wake_pipe[1], &wake, 1) < 0 && errno == EINTR) {}
+        this->thread.join();
+        RenderStats::set_publishing(false);
+    }
+    this->close();
+}
+
+void TelemetryServer::close() {
+    for (int descriptor : {this->listen_socket, this->wake_pipe[0], this->wake_pipe[1]}) {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+    }
+    this->listen_socket = this->wake_pipe[0] = this->wake_pipe[1] = -1;
+    if (!this->socket_path.empty()) {
+        unlink(this->socket_path.c_str());
+        this->socket_path.clear();
+    }
+    running = false;
+}
+
+void TelemetryServer::serve() {
+    CpuProfiler::set_thread_name("telemetry");
+    while (true) {
+        pollfd descriptors[] = {{this->listen_socket, POLLIN, 0}, {this->wake_pipe[0], POLLIN, 0}};
+        if (poll(descriptors, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (descriptors[1].revents) {
+            return;
+        }
+        int connection = accept(this->listen_socket, nullptr, nullptr);
+        if (connection >= 0) {
+            this->answer(connection);
+            ::close(connection);
+        }
+    }
+}
+
+void TelemetryServer::answer(int connection) {
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    // a client that trickles its request or does not read the response must not hold up the thread, or the destructor
+    // that waits for it, so nothing blocks and the whole exchange has one deadline
+    fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) | O_NONBLOCK);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT);
+
+    // the request line is all that matters, the headers are read up to their end and ignored
+    string request;
+    char buffer[512];
+    while (request.find("\r\n\r\n") == string::npos && request.find("\n\n") == string::npos) {
+        if (request.size() > MAX_REQUEST_SIZE || !wait_for(connection, POLLIN, this->wake_pipe[0], deadline)) {
+            return;
+        }
+        ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+        if (received < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    std::ostringstream response;
+    string request_line = request.substr(0, request.find_first_of("\r\n"));
+    if (request_line.compare(0, 13, "GET /metrics ") == 0 || request_line.compare(0, 6, "GET / ") == 0) {
+        // the newest frame the renderer published, the last one taken if nothing new came since
+        RenderStats::acquire_published_frame();
+        std::ostringstream body;
+        write_metrics(body, RenderStats::get_published_frame());
+        response << "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                 << body.str().size() << "\r\n\r\n" << body.str();
+    } else {
+        response << "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n\r\nnot found\n";
+    }
+
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    string text = response.str();
+    size_t sent = 0;
+    while (sent != text.size()) {
+        if (!wait_for(connection, POLLOUT, this->wake_pipe[0], deadline)) {
+            return;
+        }
+        ssize_t written = send(connection, text.data() + sent, text.size() - sent, flags);
+        if (written < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(written);
+    }
+}
+
+#endif
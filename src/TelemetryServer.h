@@ -0,0 +1,57 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_TELEMETRYSERVER_H
+#define LEARNOPENGL_TELEMETRYSERVER_H
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "RenderStats.h"
+
+using std::string;
+
+// serves the frame time histogram, the render counters of the last frame and the memory of every tag with its budget
+// in the Prometheus text format over HTTP, on localhost TCP or a Unix domain socket, from its own thread: the render
+// thread publishes its frames to it through RenderStats without locks and never waits for a scrape, which only reads
+// the published frame, only one server may run at a time
+class TelemetryServer {
+
+public:
+    // address is a port on 127.0.0.1, 0 for any free one, or unix:path for a Unix domain socket, throws if it cannot
+    // listen there
+    explicit
+    TelemetryServer(const string &address);
+    ~TelemetryServer();
+
+    TelemetryServer(const TelemetryServer &) = delete;
+    TelemetryServer &operator=(const TelemetryServer &) = delete;
+
+    // where it listens, 127.0.0.1:port with the port it got or the path of the socket
+    const string &get_address() const;
+
+    // what a scrape of /metrics returns, without the HTTP around it
+    static void write_metrics(std::ostream &out, const RenderStats::Frame &frame);
+
+private:
+    int listen_socket = -1;
+    // the destructor writes to the second one to wake the thread up
+    int wake_pipe[2] = {-1, -1};
+    string address;
+    // empty for TCP
+    string socket_path;
+    std::thread thread;
+
+    static std::atomic<bool> running;
+
+    void serve();
+    void answer(int connection);
+    // closes what is open and removes the socket file, lets the next server start
+    void close();
+};
+
+
+#endif //LEARNOPENGL_TELEMETRYSERVER_H
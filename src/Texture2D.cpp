@@ -4,35 +4,41 @@
 
 #include "Texture2D.h"
 
+#include "CpuProfiler.h"
+#include "MemoryTracker.h"
+
 #define STBI_FAILURE_USERMSG
 
-Texture2D::Texture2D(const string &path, bool flip, GLenum format) {
+Texture2D::Texture2D(const string &path, bool flip, GLenum format) : device(RenderDevice::get_current()) {
+    CPU_PROFILE_ZONE("Texture2D::Texture2D");
+    // the image and the texture are both the path's
+    MemoryTracker::Scope memory_scope(path);
     stbi_set_flip_vertically_on_load(flip);
-    unsigned char *data = stbi_load(path.c_str(), &this->width, &this->height,
-                                    &this->color_channels, 0);
+    unsigned char *data;
+    {
+        CPU_PROFILE_ZONE("stbi_load");
+        data = stbi_load(path.c_str(), &this->width, &this->height, &this->color_channels, 0);
+    }
     if (!data) {
         throw std::runtime_error(stbi_failure_reason());
     }
-    glGenTextures(1, &this->id);
-    glBindTexture(GL_TEXTURE_2D, this->id);
-    // default parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, format, this->width, this->height,
-                 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // stb allocates the image itself, so it is charged by hand for as long as it lives
+    size_t image_bytes = static_cast<size_t>(this->width) * this->height * this->color_channels;
+    MemoryTracker::Consumer *image_memory = MemoryTracker::charge(MEMORY_CPU_IMAGES, image_bytes);
+    // default parameters are REPEAT and NEAREST_MIPMAP_NEAREST / NEAREST
+    this->id = this->device.create_texture_2d(this->width, this->height, format, data);
+    MemoryTracker::release(image_memory, image_bytes);
     stbi_image_free(data);
 }
 
+Texture2D::~Texture2D() {
+    this->device.destroy_texture(this->id);
+}
+
 void Texture2D::bind(GLenum tex_unit) const {
-    glActiveTexture(tex_unit);
-    glBindTexture(GL_TEXTURE_2D, this->id);
+    this->device.bind_texture(tex_unit - GL_TEXTURE0, this->id);
 }
 
 void Texture2D::set_parameter(GLenum parameter, int value) {
-    glTexParameteri(GL_TEXTURE_2D, parameter, value);
+    this->device.set_texture_parameter(this->id, parameter, value);
 }
-
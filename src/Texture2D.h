@@ -10,6 +10,8 @@
 #include <stb_image.h>
 #include <stdexcept>
 
+#include "RenderDevice.h"
+
 using std::string;
 
 class Texture2D {
@@ -20,9 +22,18 @@ public:
     int color_channels = 0;
     unsigned int id = 0;
 
+    // the texture is created on the current render device
     Texture2D(const string &path, bool flip = true, GLenum format = GL_RGBA);
+    ~Texture2D();
+
+    Texture2D(const Texture2D &) = delete;
+    Texture2D &operator=(const Texture2D &) = delete;
+
     void bind(GLenum tex_unit = GL_TEXTURE0) const;
     void set_parameter(GLenum parameter, int value);
+
+private:
+    RenderDevice &device;
 };
 
 
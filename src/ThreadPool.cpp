@@ -0,0 +1,140 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include "ThreadPool.h"
+
+#include "CpuProfiler.h"
+
+static unsigned long long make_range(unsigned begin, unsigned end) {
+    return static_cast<unsigned long long>(end) << 32 | begin;
+}
+
+static unsigned range_begin(unsigned long long range) {
+    return static_cast<unsigned>(range);
+}
+
+static unsigned range_end(unsigned long long range) {
+    return static_cast<unsigned>(range >> 32);
+}
+
+ThreadPool::ThreadPool(unsigned worker_count) {
+    if (worker_count == 0) {
+        worker_count = 1;
+    }
+    this->ranges = std::vector<Range>(worker_count);
+    // the calling thread is worker 0, so we only spawn the remaining ones
+    for (unsigned i = 1; i < worker_count; ++i) {
+        this->threads.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->job_ready.notify_all();
+    for (auto &thread : this->threads) {
+        thread.join();
+    }
+}
+
+unsigned ThreadPool::get_worker_count() const {
+    return static_cast<unsigned>(this->threads.size()) + 1;
+}
+
+void ThreadPool::parallel_for(unsigned count, const Task &job) {
+    if (count == 0) {
+        return;
+    }
+    // not worth waking anybody up for a single task
+    if (count == 1 || this->threads.empty()) {
+        for (unsigned i = 0; i != count; ++i) {
+            job(i, 0);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = &job;
+        // neighbouring tasks tend to touch neighbouring data, so every worker starts on a contiguous share
+        auto worker_count = static_cast<unsigned long long>(this->ranges.size());
+        for (unsigned i = 0; i != this->ranges.size(); ++i) {
+            auto begin = static_cast<unsigned>(count * i / worker_count);
+            auto end = static_cast<unsigned>(count * (i + 1) / worker_count);
+            this->ranges[i].bounds.store(make_range(begin, end), std::memory_order_relaxed);
+        }
+        this->busy_workers = static_cast<unsigned>(this->threads.size());
+        ++this->generation;
+    }
+    this->job_ready.notify_all();
+    this->run_tasks(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->job_done.wait(lock, [this] { return this->busy_workers == 0; });
+    this->task = nullptr;
+}
+
+void ThreadPool::worker_loop(unsigned worker_index) {
+    CpuProfiler::set_thread_name("pool worker " + std::to_string(worker_index));
+    unsigned long long seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_ready.wait(lock, [&] {
+                return this->stopping || this->generation != seen_generation;
+            });
+            if (this->stopping) {
+                return;
+            }
+            seen_generation = this->generation;
+        }
+        this->run_tasks(worker_index);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            --this->busy_workers;
+        }
+        this->job_done.notify_one();
+    }
+}
+
+unsigned long long ThreadPool::get_steal_count() const {
+    return this->steals.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::run_tasks(unsigned worker_index) {
+    std::atomic<unsigned long long> &bounds = this->ranges[worker_index].bounds;
+    do {
+        // tasks are taken one at a time from the front so uneven tasks still balance across the workers
+        unsigned long long range = bounds.load(std::memory_order_acquire);
+        while (range_begin(range) < range_end(range)) {
+            unsigned i = range_begin(range);
+            if (bounds.compare_exchange_weak(range, make_range(i + 1, range_end(range)),
+                                             std::memory_order_acq_rel)) {
+                (*this->task)(i, worker_index);
+                range = bounds.load(std::memory_order_acquire);
+            }
+        }
+    } while (this->steal(worker_index));
+}
+
+bool ThreadPool::steal(unsigned worker_index) {
+    auto worker_count = static_cast<unsigned>(this->ranges.size());
+    for (unsigned offset = 1; offset != worker_count; ++offset) {
+        std::atomic<unsigned long long> &victim = this->ranges[(worker_index + offset) % worker_count].bounds;
+        unsigned long long range = victim.load(std::memory_order_acquire);
+        while (range_begin(range) < range_end(range)) {
+            // the back half, the victim keeps working from the front
+            unsigned begin = range_begin(range), end = range_end(range);
+            unsigned middle = begin + (end - begin) / 2;
+            if (victim.compare_exchange_weak(range, make_range(begin, middle), std::memory_order_acq_rel)) {
+                // our own range is empty, so nobody can take anything from it until we store the stolen part
+                this->ranges[worker_index].bounds.store(make_range(middle, end), std::memory_order_release);
+                this->steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
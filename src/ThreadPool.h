@@ -0,0 +1,60 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_THREADPOOL_H
+#define LEARNOPENGL_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads that execute parallel_for jobs, the calling thread joins in as worker 0, every worker
+// starts on its own contiguous range of the tasks and steals half of what is left of another range once it runs dry
+class ThreadPool {
+
+public:
+    // task index, worker index
+    typedef std::function<void(unsigned, unsigned)> Task;
+
+    explicit
+    ThreadPool(unsigned worker_count = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned get_worker_count() const;
+    // runs task(i, worker) for every i in [0, task_count) and blocks until all of them are done
+    void parallel_for(unsigned task_count, const Task &task);
+    // how many ranges were stolen since the pool was created
+    unsigned long long get_steal_count() const;
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    // the range of tasks a worker has left, begin in the low and end in the high 32 bits, on its own cache line so
+    // the owner popping from the front does not slow down the others
+    struct alignas(64) Range {
+        std::atomic<unsigned long long> bounds{0};
+    };
+
+    const Task *task = nullptr;
+    std::vector<Range> ranges;
+    std::atomic<unsigned long long> steals{0};
+    unsigned busy_workers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    void worker_loop(unsigned worker_index);
+    void run_tasks(unsigned worker_index);
+    bool steal(unsigned worker_index);
+};
+
+
+#endif //LEARNOPENGL_THREADPOOL_H
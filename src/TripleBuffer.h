@@ -0,0 +1,59 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#ifndef LEARNOPENGL_TRIPLEBUFFER_H
+#define LEARNOPENGL_TRIPLEBUFFER_H
+
+#include <atomic>
+
+// hands the newest value from one producer thread to one consumer thread without locks or waiting: the producer writes
+// into its own buffer and swaps it with the middle one, the consumer swaps the middle one with its own when something
+// new was published, values the consumer was too slow to pick up are simply overwritten
+template<typename T>
+class TripleBuffer {
+
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // producer side, the buffer belongs to the producer until publish()
+    T &get_write_buffer() {
+        return this->buffers[this->write_index];
+    }
+
+    void publish() {
+        // release makes the writes to the buffer visible to the consumer that acquires it
+        unsigned previous = this->middle.exchange(this->write_index | NEW_BIT, std::memory_order_acq_rel);
+        this->write_index = previous & INDEX_MASK;
+    }
+
+    // consumer side, returns whether a newer value than the current read buffer was taken
+    bool acquire() {
+        if (!(this->middle.load(std::memory_order_relaxed) & NEW_BIT)) {
+            return false;
+        }
+        unsigned previous = this->middle.exchange(this->read_index, std::memory_order_acq_rel);
+        this->read_index = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T &get_read_buffer() const {
+        return this->buffers[this->read_index];
+    }
+
+private:
+    static const unsigned INDEX_MASK = 3;
+    static const unsigned NEW_BIT = 4;
+
+    T buffers[3];
+    // the index of the buffer in the middle, plus NEW_BIT if the producer put it there after the last acquire()
+    alignas(64) std::atomic<unsigned> middle{1};
+    alignas(64) unsigned write_index = 0;
+    alignas(64) unsigned read_index = 2;
+};
+
+
+#endif //LEARNOPENGL_TRIPLEBUFFER_H
@@ -0,0 +1,387 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include <glad/glad.h>
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <glm/glm.hpp>
+
+#include "CameraSpline.h"
+#include "CpuProfiler.h"
+#include "FramePipeline.h"
+#include "GlRenderDevice.h"
+#include "HeadlessContext.h"
+#include "Json.h"
+#include "MemoryTracker.h"
+#include "NullRenderDevice.h"
+#include "RenderDevice.h"
+#include "Scene.h"
+#include "SoftwareRenderDevice.h"
+
+#define DEFAULT_BENCH_FRAMES 600
+#define DEFAULT_WARMUP_FRAMES 60
+// simulated steps per second, every run flies the same path with the same frames however fast it renders
+#define BENCH_STEP_RATE 60.0
+#define DEFAULT_FLIGHT_SECONDS 10.0
+// what the process exits with
+#define EXIT_BUDGET_EXCEEDED 1
+#define EXIT_USAGE 2
+#define EXIT_FAILED 3
+
+using std::string;
+
+struct BenchOptions {
+    string device = "gl";
+    unsigned long long frames = DEFAULT_BENCH_FRAMES;
+    unsigned long long warmup_frames = DEFAULT_WARMUP_FRAMES;
+    int width = WINDOW_WIDTH;
+    int height = WINDOW_HEIGHT;
+    unsigned threads = 0;
+    SceneDescription scene;
+    string path_file;
+    double flight_seconds = DEFAULT_FLIGHT_SECONDS;
+    bool hiz = false;
+    bool occlusion_queries = false;
+    DepthPrepassController::Mode depth_prepass = DepthPrepassController::MODE_AUTO;
+    // negative keeps the dynamic resolution off, so every frame has the same pixels
+    double gpu_target_ms = -1;
+    string output;
+    string image;
+    string trace;
+    // negative for no budget
+    double max_p95_ms = -1;
+    // bytes by tag, 0 for no budget
+    size_t memory_budgets[MEMORY_TAG_COUNT] = {};
+    // print what the memory tracker holds at the last frame
+    bool memory_dump = false;
+};
+
+// frame times and what they are summed up to
+struct FrameTimes {
+    double min = 0, mean = 0, stddev = 0, p50 = 0, p90 = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+static void print_usage() {
+    std::cerr << "usage: LearnOpenGL_bench [options]\n"
+                 "  --device gl|software|null  what renders, gl needs EGL (default gl)\n"
+                 "  --frames N                 measured frames (default " << DEFAULT_BENCH_FRAMES << ")\n"
+                 "  --warmup N                 frames rendered before measuring (default "
+              << DEFAULT_WARMUP_FRAMES << ")\n"
+                 "  --size WxH                 framebuffer size (default " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT
+              << ")\n"
+                 "  --threads N                threads of the software device (default all)\n"
+                 "  --cubes N                  lighting cubes in the scene (default " << DEFAULT_CUBE_COUNT << ")\n"
+                 "  --path FILE                camera keys, a line of position and target each\n"
+                 "  --flight-seconds S         simulated seconds of one loop of the path (default "
+              << DEFAULT_FLIGHT_SECONDS << ")\n"
+                 "  --hiz, --occlusion-queries GPU culling of the GL device\n"
+                 "  --depth-prepass off|on|auto\n"
+                 "  --dynamic-resolution MS    let the resolution hold a GPU time, off by default\n"
+                 "  --output FILE              the JSON results (default stdout)\n"
+                 "  --image FILE               the last frame as a PPM\n"
+                 "  --trace FILE               a Chrome trace of the CPU zones\n"
+                 "  --max-p95-ms MS            exit with " << EXIT_BUDGET_EXCEEDED
+              << " if the 95th percentile frame time is above\n"
+                 "  --memory-budget TAG=MIB    exit with " << EXIT_BUDGET_EXCEEDED
+              << " if the tag, e.g. gpu/textures, ever holds more, repeatable\n"
+                 "  --memory-dump              print the memory of the tags and the top consumers at the last frame\n"
+                 "exits with " << EXIT_USAGE << " on bad arguments and " << EXIT_FAILED << " if it cannot run"
+              << std::endl;
+}
+
+static BenchOptions parse_options(int argc, char **argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 == argc) {
+                throw std::invalid_argument(argument + " needs a value");
+            }
+            return argv[++i];
+        };
+        if (argument == "--device") {
+            options.device = value();
+            if (options.device != "gl" && options.device != "software" && options.device != "null") {
+                throw std::invalid_argument("unknown device " + options.device);
+            }
+        } else if (argument == "--frames") {
+            options.frames = std::stoull(value());
+        } else if (argument == "--warmup") {
+            options.warmup_frames = std::stoull(value());
+        } else if (argument == "--size") {
+            string size = value();
+            size_t x = size.find('x');
+            if (x == string::npos) {
+                throw std::invalid_argument("the size is WxH");
+            }
+            options.width = std::stoi(size.substr(0, x));
+            options.height = std::stoi(size.substr(x + 1));
+        } else if (argument == "--threads") {
+            options.threads = static_cast<unsigned>(std::stoul(value()));
+        } else if (argument == "--cubes") {
+            options.scene.cube_count = static_cast<unsigned>(std::stoul(value()));
+        } else if (argument == "--path") {
+            options.path_file = value();
+        } else if (argument == "--flight-seconds") {
+            options.flight_seconds = std::stod(value());
+        } else if (argument == "--hiz") {
+            options.hiz = true;
+        } else if (argument == "--occlusion-queries") {
+            options.occlusion_queries = true;
+        } else if (argument == "--depth-prepass") {
+            string mode = value();
+            int m = DepthPrepassController::MODE_OFF;
+            while (mode != DepthPrepassController::get_mode_name(static_cast<DepthPrepassController::Mode>(m))) {
+                if (++m > DepthPrepassController::MODE_AUTO) {
+                    throw std::invalid_argument("unknown depth pre-pass mode " + mode);
+                }
+            }
+            options.depth_prepass = static_cast<DepthPrepassController::Mode>(m);
+        } else if (argument == "--dynamic-resolution") {
+            options.gpu_target_ms = std::stod(value());
+        } else if (argument == "--output") {
+            options.output = value();
+        } else if (argument == "--image") {
+            options.image = value();
+        } else if (argument == "--trace") {
+            options.trace = value();
+        } else if (argument == "--max-p95-ms") {
+            options.max_p95_ms = std::stod(value());
+        } else if (argument == "--memory-budget") {
+            string budget = value();
+            size_t equals = budget.find('=');
+            int tag = 0;
+            while (tag != MEMORY_TAG_COUNT && budget.substr(0, equals) !=
+                                              MemoryTracker::get_tag_name(static_cast<MemoryTag>(tag))) {
+                ++tag;
+            }
+            if (equals == string::npos || tag == MEMORY_TAG_COUNT) {
+                throw std::invalid_argument("the memory budget is a tag and MiB, e.g. gpu/textures=64");
+            }
+            options.memory_budgets[tag] = static_cast<size_t>(std::stod(budget.substr(equals + 1)) * 1024 * 1024);
+        } else if (argument == "--memory-dump") {
+            options.memory_dump = true;
+        } else {
+            throw std::invalid_argument("unknown argument " + argument);
+        }
+    }
+    if (options.frames == 0 || options.width <= 0 || options.height <= 0 || options.flight_seconds <= 0) {
+        throw std::invalid_argument("the frames, the size and the flight must be positive");
+    }
+    return options;
+}
+
+// nearest rank percentiles of the sorted times
+static FrameTimes summarize(std::vector<double> times) {
+    FrameTimes summary;
+    if (times.empty()) {
+        return summary;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) {
+        auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(times.size())));
+        return times[std::max<size_t>(rank, 1) - 1];
+    };
+    double sum = 0, squares = 0;
+    for (double time : times) {
+        sum += time;
+        squares += time * time;
+    }
+    auto count = static_cast<double>(times.size());
+    summary.min = times.front();
+    summary.max = times.back();
+    summary.mean = sum / count;
+    summary.stddev = std::sqrt(std::max(squares / count - summary.mean * summary.mean, 0.0));
+    summary.p50 = percentile(50);
+    summary.p90 = percentile(90);
+    summary.p95 = percentile(95);
+    summary.p99 = percentile(99);
+    return summary;
+}
+
+static void write_results(std::ostream &out, const BenchOptions &options, const string &renderer,
+                          const FrameTimes &times, double seconds, const SceneResults &results, bool passed) {
+    auto frames = static_cast<double>(options.frames);
+    const RenderDevice::Counters &counters = results.counters;
+    out << "{\n"
+        << "  \"benchmark\": \"flythrough\",\n"
+        << "  \"device\": " << json_string(options.device) << ",\n"
+        << "  \"renderer\": " << json_string(renderer) << ",\n"
+        << "  \"width\": " << options.width << ",\n"
+        << "  \"height\": " << options.height << ",\n"
+        << "  \"cubes\": " << options.scene.cube_count << ",\n"
+        << "  \"frames\": " << options.frames << ",\n"
+        << "  \"warmup_frames\": " << options.warmup_frames << ",\n"
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"frames_per_second\": " << (times.mean > 0 ? 1000.0 / times.mean : 0.0) << ",\n"
+        << "  \"frame_ms\": {\"min\": " << times.min << ", \"mean\": " << times.mean << ", \"stddev\": "
+        << times.stddev << ", \"p50\": " << times.p50 << ", \"p90\": " << times.p90 << ", \"p95\": " << times.p95
+        << ", \"p99\": " << times.p99 << ", \"max\": " << times.max << "},\n"
+        << "  \"passes\": [";
+    // the GPU zones are over the last frames only, see GpuProfiler
+    for (size_t i = 0; i != results.gpu_zones.size(); ++i) {
+        const GpuProfiler::ZoneStats &zone = results.gpu_zones[i];
+        out << (i ? "," : "") << "\n    {\"name\": " << json_string(zone.name) << ", \"depth\": " << zone.depth
+            << ", \"min_ms\": " << zone.min_ms << ", \"average_ms\": " << zone.average_ms << ", \"p99_ms\": "
+            << zone.p99_ms << "}";
+    }
+    out << (results.gpu_zones.empty() ? "" : "\n  ") << "],\n"
+        << "  \"counters_per_frame\": {\"draws\": " << counters.draws / frames << ", \"triangles\": "
+        << counters.triangles / frames << ", \"vertices\": " << counters.vertices / frames << ", \"program_binds\": "
+        << counters.program_binds / frames
+        << ", \"vertex_array_binds\": " << counters.vertex_array_binds / frames << ", \"texture_binds\": "
+        << counters.texture_binds / frames << ", \"uniform_calls\": " << counters.uniform_calls / frames
+        << ", \"buffer_updates\": " << counters.buffer_updates / frames << ", \"bytes_uploaded\": "
+        << counters.bytes_uploaded / frames << ", \"clears\": " << counters.clears / frames << ", \"fence_waits\": "
+        << counters.fence_waits / frames << ", \"query_reads\": " << counters.query_reads / frames << "},\n"
+        << "  \"max_p95_ms\": " << (options.max_p95_ms < 0 ? "null" : std::to_string(options.max_p95_ms)) << ",\n"
+        << "  \"memory_peak_bytes\": {";
+    for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+        out << (tag ? ", " : "") << json_string(MemoryTracker::get_tag_name(static_cast<MemoryTag>(tag))) << ": "
+            << MemoryTracker::get_stats(static_cast<MemoryTag>(tag)).peak_bytes;
+    }
+    out << "},\n"
+        << "  \"passed\": " << (passed ? "true" : "false") << "\n"
+        << "}" << std::endl;
+}
+
+// renders the warmup and the measured frames of the flight on device, the times between the presents of the
+// measured frames go to frame_ms
+static SceneResults run_flight(RenderDevice &device, const BenchOptions &options, const CameraSpline &spline,
+                               const std::function<void()> &present, std::vector<double> &frame_ms) {
+    RenderDevice::set_current(&device);
+    SceneResults results;
+    FrameSnapshot snapshot;
+    unsigned long long total_frames = options.warmup_frames + options.frames;
+    unsigned long long presented = 0;
+    double last_present = options.warmup_frames == 0 ? FramePipeline::get_time() : -1;
+    render_scene(device, [&](bool) -> const FrameSnapshot * {
+        if (snapshot.step == total_frames) {
+            return nullptr;
+        }
+        snapshot.step += 1;
+        snapshot.measured = snapshot.step > options.warmup_frames;
+        snapshot.time = static_cast<float>(static_cast<double>(snapshot.step) / BENCH_STEP_RATE);
+        snapshot.light_time = snapshot.time;
+        snapshot.sample_time = FramePipeline::get_time();
+        double t = snapshot.time / options.flight_seconds;
+        glm::vec3 target;
+        spline.sample(t, snapshot.camera_position, target);
+        snapshot.view_matrix = spline.get_view_matrix(t);
+        snapshot.framebuffer_width = options.width;
+        snapshot.framebuffer_height = options.height;
+        snapshot.hiz_enabled = options.hiz;
+        snapshot.gpu_occlusion_enabled = options.occlusion_queries;
+        snapshot.depth_prepass_mode = options.depth_prepass;
+        snapshot.dynamic_resolution_enabled = options.gpu_target_ms > 0;
+        snapshot.gpu_target_ms = options.gpu_target_ms > 0 ? options.gpu_target_ms : GPU_TARGET_MS;
+        return &snapshot;
+    }, [&](double) {
+        present();
+        double now = FramePipeline::get_time();
+        // the first measured frame starts at the present of the last warmup frame, or at the start without warmup
+        if (last_present >= 0) {
+            frame_ms.push_back((now - last_present) * 1000.0);
+        }
+        if (++presented >= options.warmup_frames) {
+            last_present = now;
+        }
+        // everything is still alive, render_scene() frees it all before it returns
+        if (presented == total_frames && options.memory_dump) {
+            MemoryTracker::dump(std::cerr);
+        }
+    }, nullptr, options.scene, &results);
+    RenderDevice::set_current(nullptr);
+    return results;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "LearnOpenGL_bench: " << e.what() << std::endl;
+        print_usage();
+        return EXIT_USAGE;
+    }
+    try {
+        CpuProfiler::set_thread_name("main");
+        if (!options.trace.empty()) {
+            CpuProfiler::enable();
+        }
+        // a tag over its budget fails the run, the callback may be called on any thread that allocates
+        std::atomic<bool> memory_over_budget{false};
+        MemoryTracker::set_budget_callback([&memory_over_budget](MemoryTag tag, size_t bytes, size_t budget) {
+            memory_over_budget = true;
+            std::cerr << "LearnOpenGL_bench: " << MemoryTracker::get_tag_name(tag) << " holds " << bytes
+                      << " bytes, over its budget of " << budget << std::endl;
+        });
+        for (int tag = 0; tag != MEMORY_TAG_COUNT; ++tag) {
+            MemoryTracker::set_budget(static_cast<MemoryTag>(tag), options.memory_budgets[tag]);
+        }
+        CameraSpline spline = options.path_file.empty() ? CameraSpline::get_default() :
+                              CameraSpline::load(options.path_file);
+        std::vector<double> frame_ms;
+        SceneResults results;
+        string renderer = options.device;
+        std::vector<unsigned char> image;
+        double start = FramePipeline::get_time();
+        if (options.device == "gl") {
+            HeadlessContext context(options.width, options.height);
+            renderer = context.get_renderer();
+            {
+                GlRenderDevice device;
+                results = run_flight(device, options, spline, [] {}, frame_ms);
+            }
+            if (!options.image.empty()) {
+                image = context.read_pixels();
+            }
+        } else if (options.device == "software") {
+            SoftwareRenderDevice device(options.width, options.height,
+                                        options.threads ? options.threads : std::thread::hardware_concurrency());
+            results = run_flight(device, options, spline, [&device] { device.flush(); }, frame_ms);
+            if (!options.image.empty()) {
+                const unsigned char *pixels = device.get_color_buffer();
+                image.assign(pixels, pixels + static_cast<size_t>(options.width) * options.height * 4);
+            }
+        } else {
+            NullRenderDevice device;
+            results = run_flight(device, options, spline, [] {}, frame_ms);
+        }
+        double seconds = FramePipeline::get_time() - start;
+
+        FrameTimes times = summarize(frame_ms);
+        bool passed = (options.max_p95_ms < 0 || times.p95 <= options.max_p95_ms) && !memory_over_budget;
+        if (options.output.empty()) {
+            write_results(std::cout, options, renderer, times, seconds, results, passed);
+        } else {
+            std::ofstream file(options.output);
+            if (!file) {
+                throw std::runtime_error("Failed to open " + options.output + "!");
+            }
+            write_results(file, options, renderer, times, seconds, results, passed);
+        }
+        if (!image.empty()) {
+            write_ppm(options.image, image.data(), options.width, options.height);
+        }
+        if (!options.trace.empty()) {
+            CpuProfiler::write_chrome_trace(options.trace);
+        }
+        std::cerr << options.frames << " frames on " << renderer << ": mean " << times.mean << " ms, p95 "
+                  << times.p95 << " ms, p99 " << times.p99 << " ms" << (passed ? "" : ", over the budget")
+                  << std::endl;
+        return passed ? 0 : EXIT_BUDGET_EXCEEDED;
+    } catch (const std::exception &e) {
+        std::cerr << "LearnOpenGL_bench: " << e.what() << std::endl;
+        return EXIT_FAILED;
+    }
+}
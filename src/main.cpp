@@ -2,33 +2,126 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <stdexcept>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "Shader.h"
-#include "Texture2D.h"
 #include "Camera.h"
-
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 800
+#include "DepthPrepassController.h"
+#include "CpuProfiler.h"
+#include "FramePacer.h"
+#include "MouseAccumulator.h"
+#include "TripleBuffer.h"
+#include "FramePipeline.h"
+#include "MemoryTracker.h"
+#include "RenderDevice.h"
+#include "GlRenderDevice.h"
+#include "NullRenderDevice.h"
+#include "SoftwareRenderDevice.h"
+#include "RedrawScheduler.h"
+#include "RenderStats.h"
+#include "TelemetryServer.h"
+#include "Scene.h"
+
+// how often the main thread steps the simulation when the renderer has its own thread
+#define SIMULATION_RATE 1000
+// the longest the render thread sleeps between looking for a new snapshot, in microseconds
+#define MAX_RENDER_THREAD_SLEEP 4000
+// how many frames --null renders when no count is given
+#define DEFAULT_HEADLESS_FRAMES 2000
+// and how many --software renders with each thread count
+#define DEFAULT_SOFTWARE_FRAMES 200
+// updates per second of the light animation, frames in between would show the light at the same place
+#define LIGHT_ANIMATION_RATE 60
+// the longest an idle on demand loop sleeps in the event loop before it looks again
+#define MAX_IDLE_WAIT 1.0
+#define WINDOW_TITLE "LearnOpenGL"
+// seconds between updates of the statistics in the title, any faster and they cannot be read
+#define STATS_HUD_INTERVAL 0.25
+// press B to print the memory of every tag and this many of its biggest consumers
+#define MEMORY_DUMP_CONSUMERS 10
 
 
 using std::string;
 
 // camera
 Camera camera;
+// the mouse movement of the event callbacks, the simulation turns the camera by it once per step
+MouseAccumulator mouse_input;
+glm::dvec2 mouse_consumed;
+// press K to toggle turning the camera by the mouse movement since a frame was sampled right before it is drawn
+bool late_latch_enabled = true;
 
 // timing
 float delta_time = 0;
 float last_frame_time = 0;
 
+// press P to print the per frame statistics once, the renderer prints whenever the count changes
+unsigned report_requests = 0;
+// press O to toggle the hardware occlusion queries
+bool gpu_occlusion_enabled = false;
+// press H to toggle culling against the depth pyramid of the previous frames
+bool hiz_enabled = false;
+// press left alt to toggle wireframe rendering
+bool wireframe = false;
+// press L to cycle through the frame pipeline depths
+unsigned pipeline_depth = DEFAULT_PIPELINE_DEPTH;
+// press V to toggle the overview from above in the top right corner
+bool overview_enabled = false;
+// press Z to cycle the depth pre-pass between off, on and picked by its GPU time
+DepthPrepassController::Mode depth_prepass_mode = DepthPrepassController::MODE_AUTO;
+// press U to toggle rendering the scene at a lower resolution when the GPU cannot keep up
+bool dynamic_resolution_enabled = true;
+double gpu_target_ms = GPU_TARGET_MS;
+// press G to toggle the GPU times of the passes in the top left corner, the target above is the width of the bars
+bool gpu_profiler_overlay = false;
+// press T to toggle the render device counters of the last frame in the title of the window
+bool stats_hud_enabled = false;
+double stats_hud_updated = -1;
+// press F to cycle through the frame pacing modes, the cap is the refresh rate of the display unless --fps is given
+FramePacer::Mode pacing_mode = FramePacer::PACING_VSYNC;
+double frame_rate_cap = 0;
+double display_refresh_rate = 60;
+// whether negative swap intervals, i.e. adaptive vsync, are supported
+bool swap_tear_control = false;
+// press R to toggle drawing on demand, only when something changed, instead of as fast as possible
+bool on_demand = false;
+// what needs a frame when drawing on demand, press M to pause the light animation
+RedrawScheduler redraw_scheduler;
+unsigned light_animation = redraw_scheduler.add_animation("light", LIGHT_ANIMATION_RATE);
+
+// --trace path writes the CPU zones of the run to path as a Chrome trace when it ends
+string trace_path;
+
+// the size the window currently renders at
+int framebuffer_width = WINDOW_WIDTH, framebuffer_height = WINDOW_HEIGHT;
+
+RateCounter simulation_counter;
+unsigned long long simulation_steps = 0;
+
 // mouse
 bool first_move = true;
 float last_x = WINDOW_WIDTH / 2.0F, last_y = WINDOW_HEIGHT / 2.0F;
 
 // a callback function that is called everytime the window is resized
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
-    glViewport(0, 0, width, height);
+    // the renderer applies it to the viewport, the context may be current on another thread
+    framebuffer_width = width;
+    framebuffer_height = height;
+    redraw_scheduler.request_redraw();
+}
+
+// the window system lost the contents of the window, e.g. because it was uncovered
+void window_refresh_callback(GLFWwindow *window) {
+    redraw_scheduler.request_redraw();
 }
 
 void mouse_callback(GLFWwindow *window, double dx_pos, double dy_pos) {
@@ -44,7 +137,82 @@ void mouse_callback(GLFWwindow *window, double dx_pos, double dy_pos) {
     last_x = x_pos;
     last_y = y_pos;
 
-    camera.process_mouse_input(delta_x, delta_y);
+    // the camera turns once per simulation step, by everything that moved since the last one
+    mouse_input.add(delta_x, delta_y);
+    redraw_scheduler.request_redraw();
+}
+
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    // every toggle changes the frame or, like P, needs one
+    if (action == GLFW_PRESS) {
+        redraw_scheduler.request_redraw();
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        ++report_requests;
+    }
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        gpu_occlusion_enabled = !gpu_occlusion_enabled;
+    }
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        hiz_enabled = !hiz_enabled;
+    }
+    if (key == GLFW_KEY_LEFT_ALT && action == GLFW_PRESS) {
+        wireframe = !wireframe;
+    }
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        pipeline_depth = pipeline_depth % MAX_PIPELINE_DEPTH + 1;
+        std::cout << "frame pipeline depth " << pipeline_depth << std::endl;
+    }
+    if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+        overview_enabled = !overview_enabled;
+    }
+    if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+        depth_prepass_mode = static_cast<DepthPrepassController::Mode>((depth_prepass_mode + 1) % 3);
+        std::cout << "depth pre-pass " << DepthPrepassController::get_mode_name(depth_prepass_mode) << std::endl;
+    }
+    if (key == GLFW_KEY_U && action == GLFW_PRESS) {
+        dynamic_resolution_enabled = !dynamic_resolution_enabled;
+    }
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        gpu_profiler_overlay = !gpu_profiler_overlay;
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        stats_hud_enabled = !stats_hud_enabled;
+        stats_hud_updated = -1;
+        if (!stats_hud_enabled) {
+            glfwSetWindowTitle(window, WINDOW_TITLE);
+        }
+    }
+    if (key == GLFW_KEY_B && action == GLFW_PRESS) {
+        // the tracker is locked, so it does not matter that the render thread keeps allocating
+        MemoryTracker::dump(std::cout, MEMORY_DUMP_CONSUMERS);
+    }
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+        pacing_mode = static_cast<FramePacer::Mode>((pacing_mode + 1) % FramePacer::PACING_MODE_COUNT);
+        std::cout << "frame pacing " << FramePacer::get_mode_name(pacing_mode) << std::endl;
+    }
+    if (key == GLFW_KEY_K && action == GLFW_PRESS) {
+        late_latch_enabled = !late_latch_enabled;
+    }
+    if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+        on_demand = !on_demand;
+        std::cout << (on_demand ? "drawing on demand" : "drawing continuously") << std::endl;
+    }
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        redraw_scheduler.set_animation_running(light_animation, !redraw_scheduler.is_animation_running(light_animation),
+                                               glfwGetTime());
+    }
+}
+
+// whether a key that moves the camera is held, the camera then changes every frame without any events
+bool is_camera_moving(GLFWwindow *window) {
+    const int keys[] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_SPACE, GLFW_KEY_LEFT_SHIFT};
+    for (int key : keys) {
+        if (glfwGetKey(window, key) == GLFW_PRESS) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void process_inputs(GLFWwindow *window) {
@@ -70,14 +238,6 @@ void process_inputs(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
-    if (glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS) {
-        int mode;
-        glGetIntegerv(GL_POLYGON_MODE, &mode);
-        if (mode == GL_FILL)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        else
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
 }
 
 GLFWwindow *initialize() {
@@ -93,7 +253,7 @@ GLFWwindow *initialize() {
 
     // create the window object
     GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
-                                          "LearnOpenGL", nullptr, nullptr);
+                                          WINDOW_TITLE, nullptr, nullptr);
     if (window == nullptr) {
         glfwTerminate();
         throw std::runtime_error("Failed to create GLFWwindow object!");
@@ -110,370 +270,377 @@ GLFWwindow *initialize() {
     }
 
     // tell OpenGL the size of our rendering window
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    glViewport(0, 0, framebuffer_width, framebuffer_height);
     // register the change window size callback
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     // register the mouse callback
     glfwSetCursorPosCallback(window, mouse_callback);
+    // register the key callback for one shot actions
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    // what the frame pacing needs to know about the display
+    const GLFWvidmode *video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (video_mode && video_mode->refreshRate > 0) {
+        display_refresh_rate = video_mode->refreshRate;
+    }
+    swap_tear_control = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                        glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    // requests from other threads wake the event loop up
+    redraw_scheduler.set_wake_callback([] { glfwPostEmptyEvent(); });
 
     return window;
 }
 
-unsigned int init_cube_vao() {
-    // create a vertex array object to store our VBOs
-    unsigned vao_id;
-    glGenVertexArrays(1, &vao_id);
-    glBindVertexArray(vao_id);
-    // vertex data and VBO
-    float vertices[] = {
-            // 3 positions,                2 tex coords
-            // front
-            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            -0.5, 0.5, 0.5, 0.0, 1.0, // left top
-            0.5, 0.5, 0.5, 1.0, 1.0, // right top
-            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            0.5, 0.5, 0.5, 1.0, 1.0, // right top
-            0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
-            // back
-            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
-            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            0.5, -0.5, -0.5, 1.0, 0.0, // right bottom
-            // left
-            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
-            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
-            -0.5, 0.5, 0.5, 1.0, 1.0, // right top
-            -0.5, -0.5, -0.5, 0.0, 0.0, // left bottom
-            -0.5, 0.5, 0.5, 1.0, 1.0, // right top
-            -0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
-            // right
-            0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            0.5, 0.5, 0.5, 0.0, 1.0, // left top
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            0.5, -0.5, -0.5, 1.0, 0.0, // right bottom
-            // top
-            -0.5, 0.5, 0.5, 0.0, 0.0, // left bottom
-            -0.5, 0.5, -0.5, 0.0, 1.0, // left top
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            -0.5, 0.5, 0.5, 0.0, 0.0, // left bottom
-            0.5, 0.5, -0.5, 1.0, 1.0, // right top
-            0.5, 0.5, 0.5, 1.0, 0.0, // right bottom
-            // bottom
-            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            -0.5, -0.5, -0.5, 0.0, 1.0, // left top
-            0.5, -0.5, -0.5, 1.0, 1.0, // right top
-            -0.5, -0.5, 0.5, 0.0, 0.0, // left bottom
-            0.5, -0.5, -0.5, 1.0, 1.0, // right top
-            0.5, -0.5, 0.5, 1.0, 0.0, // right bottom
-    };
-    // our first vertex buffer object
-    unsigned vbo_id;
-    glGenBuffers(1, &vbo_id);
-    // OpenGL has many buffer types, and VBO has GL_ARRAY_BUFFER as its type
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    // copy the previously defined vertex data to the buffer's memory
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // right now, we have the data and a program to process the data, we still need a way to
-    // pass the data into the program
-    // location, size of vertex attributes, types of the data, normalize?, stride, offset
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), static_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    return vao_id;
+// the statistics of the last frame in the title of the window, the renderer may be on another thread
+void update_stats_hud(GLFWwindow *window, double now) {
+    if (!stats_hud_enabled || (stats_hud_updated >= 0 && now - stats_hud_updated < STATS_HUD_INTERVAL)) {
+        return;
+    }
+    stats_hud_updated = now;
+    RenderStats::Frame frame = RenderStats::get_last_frame();
+    const RenderDevice::Counters &counters = frame.counters;
+    string title = string(WINDOW_TITLE) + " | frame " + std::to_string(frame.index) + ": " +
+                   std::to_string(counters.draws) + " draws, " + std::to_string(counters.triangles) + " triangles, " +
+                   std::to_string(counters.program_binds) + "/" + std::to_string(counters.vertex_array_binds) + "/" +
+                   std::to_string(counters.texture_binds) + " program/VAO/texture binds, " +
+                   std::to_string(counters.uniform_calls) + " uniforms, " + std::to_string(counters.bytes_uploaded) +
+                   " bytes uploaded, " + std::to_string(counters.fence_waits) + " fence waits, " +
+                   std::to_string(counters.query_reads) + " query reads";
+    glfwSetWindowTitle(window, title.c_str());
+}
+
+// one simulation step: timing, inputs and the camera, the result is written into snapshot
+void simulate(GLFWwindow *window, FrameSnapshot &snapshot) {
+    CPU_PROFILE_ZONE("simulate");
+    auto current_time = static_cast<float>(glfwGetTime());
+    delta_time = current_time - last_frame_time;
+    last_frame_time = current_time;
+    // process inputs, the mouse movement of all the events since the last step at once
+    glm::dvec2 mouse_total = mouse_input.get_total();
+    if (mouse_total != mouse_consumed) {
+        camera.process_mouse_input(static_cast<float>(mouse_total.x - mouse_consumed.x),
+                                   static_cast<float>(mouse_total.y - mouse_consumed.y));
+        mouse_consumed = mouse_total;
+    }
+    process_inputs(window);
+    update_stats_hud(window, current_time);
+    simulation_counter.tick(current_time);
+    redraw_scheduler.begin_frame(current_time);
+
+    snapshot.step = ++simulation_steps;
+    snapshot.time = current_time;
+    snapshot.light_time = static_cast<float>(redraw_scheduler.get_animation_time(light_animation));
+    snapshot.sample_time = FramePipeline::get_time();
+    snapshot.view_matrix = camera.get_view_matrix();
+    snapshot.camera_position = camera.position;
+    snapshot.camera_yaw = camera.yaw;
+    snapshot.camera_pitch = camera.pitch;
+    snapshot.camera_world_up = camera.world_up;
+    snapshot.mouse_total = mouse_total;
+    snapshot.late_latch = late_latch_enabled;
+    snapshot.framebuffer_width = framebuffer_width;
+    snapshot.framebuffer_height = framebuffer_height;
+    snapshot.gpu_occlusion_enabled = gpu_occlusion_enabled;
+    snapshot.hiz_enabled = hiz_enabled;
+    snapshot.wireframe = wireframe;
+    snapshot.overview_enabled = overview_enabled;
+    snapshot.depth_prepass_mode = depth_prepass_mode;
+    snapshot.dynamic_resolution_enabled = dynamic_resolution_enabled;
+    snapshot.gpu_target_ms = gpu_target_ms;
+    snapshot.gpu_profiler_overlay = gpu_profiler_overlay;
+    // the low latency pacing samples the input as late as it can, frames prepared ahead would undo that
+    snapshot.pipeline_depth = pacing_mode == FramePacer::PACING_LOW_LATENCY ? 1 : pipeline_depth;
+    snapshot.report_requests = report_requests;
+    snapshot.simulation_rate = simulation_counter.rate;
+    snapshot.on_demand = on_demand;
+    snapshot.redraw_stats = redraw_scheduler.get_stats();
+    snapshot.pacing_mode = pacing_mode;
+    snapshot.frame_rate = pacing_mode == FramePacer::PACING_CAP && frame_rate_cap > 0 ? frame_rate_cap :
+                          display_refresh_rate;
+}
+
+// whether the on demand mode has nothing to draw
+bool is_idle(GLFWwindow *window) {
+    return on_demand && !redraw_scheduler.is_due(glfwGetTime()) && !is_camera_moving(window);
 }
 
-unsigned int init_coordinates_vao() {
-    float line_vertices[] = {
-        // x-axis
-        -1.0, 0.0, 0.0,
-        1.0, 0.0, 0.0,
-        // y-axis
-        0.0, -1.0, 0.0,
-        0.0, 1.0, 0.0,
-        // z-axis
-        0.0, 0.0, -1.0,
-        0.0, 0.0, 1.0,
-    };
-    unsigned line_vao_id;
-    glGenVertexArrays(1, &line_vao_id);
-    glBindVertexArray(line_vao_id);
-    unsigned line_vbo_id;
-    glGenBuffers(1, &line_vbo_id);
-    glBindBuffer(GL_ARRAY_BUFFER, line_vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(line_vertices), line_vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    return line_vao_id;
+// sleeps in the event loop until something needs a frame or the window is closed
+void wait_for_redraw(GLFWwindow *window) {
+    double wait_start = glfwGetTime();
+    while (!glfwWindowShouldClose(window) && is_idle(window)) {
+        glfwWaitEventsTimeout(redraw_scheduler.get_timeout(glfwGetTime(), MAX_IDLE_WAIT));
+    }
+    double now = glfwGetTime();
+    redraw_scheduler.add_idle_time(now - wait_start);
+    // the camera did not move while nothing was held
+    last_frame_time = static_cast<float>(now);
 }
 
-unsigned int init_crosshair_vao() {
-    float vertices[] = {
-            -0.02, 0.0, 0.0,
-            0.02, 0.0, 0.0,
-            0.0, -0.02, 0.0,
-            0.0, 0.02, 0.0
-    };
-    unsigned vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    unsigned vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    return vao;
+// waits until the pacer lets the next frame start, with the pacing of the newest snapshot
+void start_paced_frame(FramePacer &pacer, const FrameSnapshot &newest) {
+    pacer.set_mode(newest.pacing_mode);
+    pacer.set_frame_rate(newest.frame_rate);
+    pacer.wait_for_frame_start();
 }
 
-unsigned int init_light_source_vao() {
-    unsigned vao_id;
-    glGenVertexArrays(1, &vao_id);
-    glBindVertexArray(vao_id);
-    float vertices[] = {
-            -0.5, -0.5, 0.5,
-            -0.5, 0.5, 0.5,
-            0.5, 0.5, 0.5,
-            -0.5, -0.5, 0.5,
-            0.5, 0.5, 0.5,
-            0.5, -0.5, 0.5,
-            -0.5, -0.5, -0.5,
-            -0.5, 0.5, -0.5,
-            0.5, 0.5, -0.5,
-            -0.5, -0.5, -0.5,
-            0.5, 0.5, -0.5,
-            0.5, -0.5, -0.5,
-            -0.5, -0.5, -0.5,
-            -0.5, 0.5, -0.5,
-            -0.5, 0.5, 0.5,
-            -0.5, -0.5, -0.5,
-            -0.5, 0.5, 0.5,
-            -0.5, -0.5, 0.5,
-            0.5, -0.5, 0.5,
-            0.5, 0.5, 0.5,
-            0.5, 0.5, -0.5,
-            0.5, -0.5, 0.5,
-            0.5, 0.5, -0.5,
-            0.5, -0.5, -0.5,
-            -0.5, 0.5, 0.5,
-            -0.5, 0.5, -0.5,
-            0.5, 0.5, -0.5,
-            -0.5, 0.5, 0.5,
-            0.5, 0.5, -0.5,
-            0.5, 0.5, 0.5,
-            -0.5, -0.5, 0.5,
-            -0.5, -0.5, -0.5,
-            0.5, -0.5, -0.5,
-            -0.5, -0.5, 0.5,
-            0.5, -0.5, -0.5,
-            0.5, -0.5, 0.5,
-    };
-    unsigned vbo_id;
-    glGenBuffers(1, &vbo_id);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    return vao_id;
+// swaps the buffers with the swap interval of the pacing mode, swap_interval is the one set last
+void present_paced(GLFWwindow *window, FramePacer &pacer, int &swap_interval, double sample_time) {
+    int interval = pacer.get_swap_interval(swap_tear_control);
+    if (interval != swap_interval) {
+        swap_interval = interval;
+        glfwSwapInterval(interval);
+    }
+    pacer.begin_present();
+    glfwSwapBuffers(window);
+    pacer.end_present(sample_time);
 }
 
-unsigned int init_lighting_cube_vao() {
-    unsigned vao_id;
-    glGenVertexArrays(1, &vao_id);
-    glBindVertexArray(vao_id);
-    float vertices[] = {
-            // front
-            -0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
-            -0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
-            0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
-            -0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
-            0.5, 0.5, 0.5, 0.0, 0.0, 1.0,
-            0.5, -0.5, 0.5, 0.0, 0.0, 1.0,
-            // back
-            -0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
-            -0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
-            0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
-            -0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
-            0.5, 0.5, -0.5, 0.0, 0.0, -1.0,
-            0.5, -0.5, -0.5, 0.0, 0.0, -1.0,
-            // left
-            -0.5, -0.5, -0.5, -1.0, 0.0, 0.0,
-            -0.5, 0.5, -0.5, -1.0, 0.0, 0.0,
-            -0.5, 0.5, 0.5, -1.0, 0.0, 0.0,
-            -0.5, -0.5, -0.5, -1.0, 0.0, 0.0,
-            -0.5, 0.5, 0.5, -1.0, 0.0, 0.0,
-            -0.5, -0.5, 0.5, -1.0, 0.0, 0.0,
-            // right
-            0.5, -0.5, 0.5, 1.0, 0.0, 0.0,
-            0.5, 0.5, 0.5, 1.0, 0.0, 0.0,
-            0.5, 0.5, -0.5, 1.0, 0.0, 0.0,
-            0.5, -0.5, 0.5, 1.0, 0.0, 0.0,
-            0.5, 0.5, -0.5, 1.0, 0.0, 0.0,
-            0.5, -0.5, -0.5, 1.0, 0.0, 0.0,
-            // top
-            -0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
-            -0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
-            0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
-            -0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
-            0.5, 0.5, -0.5, 0.0, 1.0, 0.0,
-            0.5, 0.5, 0.5, 0.0, 1.0, 0.0,
-            // bottom
-            -0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
-            -0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
-            0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
-            -0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
-            0.5, -0.5, -0.5, 0.0, -1.0, 0.0,
-            0.5, -0.5, 0.5, 0.0, -1.0, 0.0,
-    };
-    unsigned vbo_id;
-    glGenBuffers(1, &vbo_id);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), static_cast<void *>(0));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    return vao_id;
+// renders frames of a scripted camera flight on a device that needs no window, returns how many seconds it took, the
+// last frame is reported if report is set
+double run_headless(RenderDevice &device, unsigned long long frames, bool report,
+                    const std::function<void()> &present) {
+    RenderDevice::set_current(&device);
+    FrameSnapshot snapshot;
+    double start_time = FramePipeline::get_time();
+    render_scene(device, [&](bool) -> const FrameSnapshot * {
+        if (snapshot.step == frames) {
+            return nullptr;
+        }
+        // circle the scene at 60 simulated frames per second
+        snapshot.step += 1;
+        snapshot.time = static_cast<float>(snapshot.step) / 60.0F;
+        snapshot.light_time = snapshot.time;
+        snapshot.sample_time = FramePipeline::get_time();
+        float angle = snapshot.time * 0.5F;
+        snapshot.camera_position = glm::vec3(std::cos(angle) * 12.0F, 2.0F, std::sin(angle) * 12.0F);
+        snapshot.view_matrix = glm::lookAt(snapshot.camera_position, glm::vec3(2.0F), glm::vec3(0.0F, 1.0F, 0.0F));
+        snapshot.report_requests = report && snapshot.step == frames ? 1 : 0;
+        snapshot.depth_prepass_mode = depth_prepass_mode;
+        snapshot.gpu_target_ms = gpu_target_ms;
+        snapshot.gpu_profiler_overlay = gpu_profiler_overlay;
+        return &snapshot;
+    }, [&present](double) { present(); });
+    RenderDevice::set_current(nullptr);
+    return FramePipeline::get_time() - start_time;
+}
+
+void print_headless_timing(const string &name, unsigned long long frames, double seconds) {
+    std::cout << name << ": " << frames << " frames in " << seconds * 1000.0 << " ms, "
+              << seconds * 1000.0 / static_cast<double>(frames) << " ms per frame, "
+              << static_cast<double>(frames) / seconds << " frames/s" << std::endl;
+}
+
+// renders the flight on the software rasterizer with 1, 2, 4, ... threads up to the hardware concurrency, the last
+// frame of the last run is written to image_path unless it is empty
+void run_software(unsigned long long frames, const string &image_path) {
+    unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        bool last = threads == max_threads;
+        SoftwareRenderDevice device(WINDOW_WIDTH, WINDOW_HEIGHT, threads);
+        double seconds = run_headless(device, frames, last, [&device] { device.flush(); });
+        const SoftwareRenderDevice::Stats &stats = device.get_stats();
+        print_headless_timing("software device, " + std::to_string(threads) + " threads", frames, seconds);
+        std::cout << "  rasterized in " << stats.raster_ms / static_cast<double>(frames) << " ms per frame, "
+                  << stats.triangles / frames << " triangles, " << stats.lines / frames << " lines, "
+                  << stats.bin_entries / frames << " bin entries, " << stats.quads_shaded / frames
+                  << " quads per frame, " << device.get_steal_count() << " steals" << std::endl;
+        if (last) {
+            if (!image_path.empty()) {
+                write_ppm(image_path, device.get_color_buffer(), device.get_width(), device.get_height());
+            }
+            break;
+        }
+    }
+}
+
+// writes the CPU zones recorded so far to the --trace file, if one was given
+void write_trace() {
+    if (trace_path.empty()) {
+        return;
+    }
+    CpuProfiler::Stats stats = CpuProfiler::get_stats();
+    CpuProfiler::write_chrome_trace(trace_path);
+    std::cout << "cpu trace: " << stats.zones - stats.overwritten_zones << " of " << stats.zones << " zones on "
+              << stats.threads << " threads written to " << trace_path << std::endl;
+}
+
+// the mode of a --pacing argument, the name of the mode with dashes for spaces
+FramePacer::Mode parse_pacing_mode(const string &name) {
+    for (int mode = 0; mode != FramePacer::PACING_MODE_COUNT; ++mode) {
+        string mode_name = FramePacer::get_mode_name(static_cast<FramePacer::Mode>(mode));
+        std::replace(mode_name.begin(), mode_name.end(), ' ', '-');
+        if (mode_name == name) {
+            return static_cast<FramePacer::Mode>(mode);
+        }
+    }
+    throw std::runtime_error("Unknown frame pacing mode " + name + "!");
 }
 
-int main() {
+int main(int argc, char **argv) {
+    // with --render-thread the GL context lives on its own thread and the main thread only handles events and the
+    // simulation, they exchange snapshots through a triple buffer, with --on-demand frames are only drawn when
+    // something changed, --depth-prepass always draws the depth pre-pass, e.g. on backends that cannot time it,
+    // --gpu-target ms sets the GPU time of a frame the dynamic resolution holds, --pacing mode picks the frame pacing
+    // (off, vsync, adaptive-vsync, capped or low-latency), --fps rate the rate of the cap, --trace path records a
+    // Chrome trace of the CPU zones and --telemetry port or --telemetry unix:path serves the metrics to Prometheus,
+    // all of them can be given
+    bool render_thread = false;
+    string telemetry_address;
+    CpuProfiler::set_thread_name("main");
+    for (int i = 1; i != argc; ++i) {
+        if (string(argv[i]) == "--trace" && i + 1 != argc) {
+            trace_path = argv[i + 1];
+            CpuProfiler::enable();
+        }
+        if (string(argv[i]) == "--gpu-target" && i + 1 != argc) {
+            gpu_target_ms = std::stod(argv[i + 1]);
+        }
+        if (string(argv[i]) == "--pacing" && i + 1 != argc) {
+            pacing_mode = parse_pacing_mode(argv[i + 1]);
+        }
+        if (string(argv[i]) == "--fps" && i + 1 != argc) {
+            frame_rate_cap = std::stod(argv[i + 1]);
+        }
+        if (string(argv[i]) == "--telemetry" && i + 1 != argc) {
+            telemetry_address = argv[i + 1];
+        }
+        render_thread = render_thread || string(argv[i]) == "--render-thread";
+        on_demand = on_demand || string(argv[i]) == "--on-demand";
+        if (string(argv[i]) == "--depth-prepass") {
+            depth_prepass_mode = DepthPrepassController::MODE_ON;
+        }
+    }
+    // serves until main returns, whichever way the frames are rendered
+    std::unique_ptr<TelemetryServer> telemetry;
+    if (!telemetry_address.empty()) {
+        telemetry.reset(new TelemetryServer(telemetry_address));
+        std::cout << "Serving telemetry on " << telemetry->get_address() << std::endl;
+    }
+    // with --null [frames] nothing is opened at all, the renderer runs on the null device to benchmark the CPU side
+    if (argc > 1 && string(argv[1]) == "--null") {
+        unsigned long long frames = argc > 2 ? std::stoull(argv[2]) : DEFAULT_HEADLESS_FRAMES;
+        NullRenderDevice device;
+        print_headless_timing("null device", frames, run_headless(device, frames, true, [] {}));
+        write_trace();
+        return 0;
+    }
+    // with --software [frames] [image.ppm] the frames are rasterized on the CPU with every thread count
+    if (argc > 1 && string(argv[1]) == "--software") {
+        run_software(argc > 2 ? std::stoull(argv[2]) : DEFAULT_SOFTWARE_FRAMES, argc > 3 ? argv[3] : "");
+        write_trace();
+        return 0;
+    }
     auto *window = initialize();
+    // what next_frame returns when there is nothing new to draw
+    FrameSnapshot idle_snapshot;
+    idle_snapshot.idle = true;
+
+    if (!render_thread) {
+        GlRenderDevice device;
+        RenderDevice::set_current(&device);
+        FramePacer pacer(device);
+        // none is set yet, so the first frame sets the one of its mode
+        int swap_interval = -2;
+        FrameSnapshot snapshot;
+        render_scene(device, [&](bool may_block) -> const FrameSnapshot * {
+            start_paced_frame(pacer, snapshot);
+            // process events like keyboard and window updates callbacks
+            glfwPollEvents();
+            if (is_idle(window)) {
+                if (!may_block) {
+                    return &idle_snapshot;
+                }
+                wait_for_redraw(window);
+            }
+            if (glfwWindowShouldClose(window)) {
+                return nullptr;
+            }
+            simulate(window, snapshot);
+            snapshot.paced = true;
+            snapshot.pacing_stats = pacer.get_stats();
+            return &snapshot;
+        }, [&](double sample_time) { present_paced(window, pacer, swap_interval, sample_time); },
+        [](glm::dvec2 &mouse_total) {
+            // the events since the frame was sampled
+            glfwPollEvents();
+            mouse_total = mouse_input.get_total();
+            return true;
+        });
+        RenderDevice::set_current(nullptr);
+        glfwTerminate();
+        write_trace();
+        return 0;
+    }
 
-    // matrices
-    glm::mat4 projection_matrix(glm::perspective(glm::radians(45.0F),
-                                                 static_cast<float>(WINDOW_WIDTH) / WINDOW_HEIGHT,
-                                                 0.1F, 300.0F));
-    glm::mat4 view_matrix = camera.get_view_matrix();
-
-    // crosshair
-    Shader crosshair_shader("resource/shader/crosshair_vertex_shader.glsl",
-                            "resource/shader/crosshair_fragment_shader.glsl");
-    unsigned crosshair_vao = init_crosshair_vao();
-
-    // coordinate line
-    Shader coordinate_shader("resource/shader/line_vertex_shader.glsl",
-                             "resource/shader/line_fragment_shader.glsl");
-    glm::mat4 line_model_matrix = glm::scale(glm::mat4(1.0F), glm::vec3(10000.0F));
-    coordinate_shader.use();
-    coordinate_shader.set_uniform("model_matrix", line_model_matrix);
-    coordinate_shader.set_uniform("view_matrix", view_matrix);
-    coordinate_shader.set_uniform("projection_matrix", projection_matrix);
-    unsigned coordinate_vao = init_coordinates_vao();
-
-    // cube initialization
-    Texture2D cube_texture1("resource/texture/grass_block_side.png");
-    Texture2D cube_texture2("resource/texture/oak_planks.png");
-    cube_texture1.bind(GL_TEXTURE0);
-    cube_texture2.bind(GL_TEXTURE1);
-    Shader cube_shader("resource/shader/cube_vertex_shader.glsl",
-                       "resource/shader/cube_fragment_shader.glsl");
-    cube_shader.use();
-    cube_shader.set_uniform("texture0", 0);
-    cube_shader.set_uniform("texture1", 1);
-    glm::mat4 cube_model_matrix = glm::translate(glm::mat4(1.0F), glm::vec3(0.5F));
-    cube_shader.set_uniform("model_matrix", cube_model_matrix);
-    cube_shader.set_uniform("view_matrix", view_matrix);
-    cube_shader.set_uniform("projection_matrix", projection_matrix);
-    unsigned cube_vao = init_cube_vao();
-
-    // light source
-    Shader light_source_shader("resource/shader/cube_vertex_shader.glsl",
-                              "resource/shader/light_source_fragment_shader.glsl");
-    light_source_shader.use();
-    glm::vec3 light_source_position = glm::vec3(2.0F, 3.0F, -10.0F);
-    glm::mat4 light_source_model_matrix = glm::translate(glm::mat4(1.0F), light_source_position);
-    light_source_shader.set_uniform("model_matrix", light_source_model_matrix);
-    light_source_shader.set_uniform("view_matrix", view_matrix);
-    light_source_shader.set_uniform("projection_matrix", projection_matrix);
-    unsigned light_source_vao = init_light_source_vao();
-
-    // lighting object
-    Shader lighting_cube_shader("resource/shader/lighting_cube_vertex_shader.glsl",
-                              "resource/shader/lighting_cube_fragment_shader.glsl");
-    lighting_cube_shader.use();
-    glm::mat4 lighting_cube_model_matrix = glm::translate(cube_model_matrix, glm::vec3(0, 0, 0));
-    lighting_cube_shader.set_uniform("model_matrix", lighting_cube_model_matrix); //glm::mat4(1.0F)
-    lighting_cube_shader.set_uniform("view_matrix", view_matrix);
-    lighting_cube_shader.set_uniform("projection_matrix", projection_matrix);
-    lighting_cube_shader.set_uniform("light_color", 1.0F, 1.0F, 1.0F);
-    lighting_cube_shader.set_uniform("object_color", 1.0F, 0.5F, 0.31F);
-    lighting_cube_shader.set_uniform("light_position", light_source_position);
-    unsigned lighting_cube_vao = init_lighting_cube_vao();
-
-    glEnable(GL_DEPTH_TEST);
-    // the render loop
-    while (!glfwWindowShouldClose(window)) {
-        glClearColor(0.2F, 0.3F, 0.3F, 1.0F);
-        // reset color and depth information
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        // timing
-        auto current_time = static_cast<float>(glfwGetTime());
-        delta_time = current_time - last_frame_time;
-        last_frame_time = current_time;
-//        std::cout << "FPS: " << 1 / delta_time << std::endl;
-        // process inputs
-        process_inputs(window);
-        // update view matrix
-        view_matrix = camera.get_view_matrix();
-
-        // light source
-        light_source_shader.use();
-        light_source_shader.set_uniform("view_matrix", view_matrix);
-        glm::vec3 translation = glm::vec3(static_cast<float>(sin(glfwGetTime())) * 30, 0.0, 0.0);
-        glm::mat4 model_matrix = glm::translate(light_source_model_matrix, translation);
-        light_source_shader.set_uniform("model_matrix", model_matrix);
-        glBindVertexArray(light_source_vao);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // lighting cube
-        lighting_cube_shader.use();
-        lighting_cube_shader.set_uniform("view_matrix", view_matrix);
-        lighting_cube_shader.set_uniform("light_position", light_source_position + translation);
-        lighting_cube_shader.set_uniform("view_position", camera.position);
-        for (int i = 0; i != 5; ++i) {
-            glm::mat4 temp_matrix = glm::translate(lighting_cube_model_matrix, vec3(i, i, i));
-            lighting_cube_shader.set_uniform("model_matrix", temp_matrix);
-            glm::mat3 normal_matrix = glm::mat3(glm::transpose(glm::inverse(temp_matrix)));
-            lighting_cube_shader.set_uniform("normal_matrix", normal_matrix);
-            glBindVertexArray(lighting_cube_vao);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+    TripleBuffer<FrameSnapshot> snapshots;
+    std::atomic<bool> running{true};
+    std::exception_ptr render_error;
+    glfwMakeContextCurrent(nullptr);
+    std::thread renderer([&] {
+        glfwMakeContextCurrent(window);
+        CpuProfiler::set_thread_name("render");
+        try {
+            GlRenderDevice device;
+            RenderDevice::set_current(&device);
+            FramePacer pacer(device);
+            // none is set yet, so the first frame sets the one of its mode
+            int swap_interval = -2;
+            FrameSnapshot snapshot;
+            render_scene(device, [&](bool may_block) -> const FrameSnapshot * {
+                start_paced_frame(pacer, snapshot);
+                // a frame is only worth drawing if the simulation moved on, the sleeps get longer while it does not,
+                // e.g. because it waits for a change on demand
+                auto sleep = std::chrono::microseconds(100);
+                while (!snapshots.acquire()) {
+                    if (!running.load(std::memory_order_relaxed)) {
+                        return nullptr;
+                    }
+                    if (!may_block) {
+                        return &idle_snapshot;
+                    }
+                    std::this_thread::sleep_for(sleep);
+                    sleep = std::min(sleep * 2, std::chrono::microseconds(MAX_RENDER_THREAD_SLEEP));
+                }
+                snapshot = snapshots.get_read_buffer();
+                snapshot.paced = true;
+                snapshot.pacing_stats = pacer.get_stats();
+                return &snapshot;
+            }, [&](double sample_time) { present_paced(window, pacer, swap_interval, sample_time); },
+            [](glm::dvec2 &mouse_total) {
+                // the main thread keeps handling the events in the meantime
+                mouse_total = mouse_input.get_total();
+                return true;
+            });
+        } catch (...) {
+            render_error = std::current_exception();
+            glfwSetWindowShouldClose(window, true);
         }
+        RenderDevice::set_current(nullptr);
+        glfwMakeContextCurrent(nullptr);
+    });
 
-        // render cube
-//        cube_shader.use();;
-//        cube_shader.set_uniform("view_matrix", view_matrix);
-//        glBindVertexArray(cube_vao);
-//        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // crosshair
-        crosshair_shader.use();
-        glBindVertexArray(crosshair_vao);
-        glDrawArrays(GL_LINES, 0, 4);
-        // render coordinate
-        coordinate_shader.use();
-        coordinate_shader.set_uniform("view_matrix", view_matrix);
-        glBindVertexArray(coordinate_vao);
-        glDrawArrays(GL_LINES, 0, 6);
-
-        // swap the double buffer
-        glfwSwapBuffers(window);
+    auto step_duration = std::chrono::microseconds(1000000 / SIMULATION_RATE);
+    auto next_step = std::chrono::steady_clock::now();
+    while (!glfwWindowShouldClose(window)) {
         // process events like keyboard and window updates callbacks
         glfwPollEvents();
+        if (is_idle(window)) {
+            wait_for_redraw(window);
+            next_step = std::chrono::steady_clock::now();
+            continue;
+        }
+        simulate(window, snapshots.get_write_buffer());
+        snapshots.publish();
+        next_step += step_duration;
+        std::this_thread::sleep_until(next_step);
     }
-
+    running.store(false, std::memory_order_relaxed);
+    renderer.join();
     glfwTerminate();
+    write_trace();
+    if (render_error) {
+        std::rethrow_exception(render_error);
+    }
+    return 0;
 }
@@ -0,0 +1,307 @@
+//
+// Created by Scott on 2026/10/19.
+//
+
+#include <glad/glad.h>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+
+#include "Camera.h"
+#include "GlRenderDevice.h"
+#include "HeadlessContext.h"
+#include "MicroBenchmark.h"
+#include "NullRenderDevice.h"
+#include "RenderDevice.h"
+#include "Scene.h"
+#include "Shader.h"
+
+// a repetition whose coefficient of variation is above this is flagged as unstable
+#define DEFAULT_MAX_CV 0.05
+// model matrices the normal matrix benchmark cycles through, a power of two
+#define MODEL_MATRIX_COUNT 64
+// what the process exits with
+#define EXIT_USAGE 2
+#define EXIT_FAILED 3
+
+using std::string;
+
+struct MicroBenchOptions {
+    MicroBenchmark::Options run;
+    string device;
+    string output;
+    double max_cv = DEFAULT_MAX_CV;
+    bool list = false;
+};
+
+static void print_usage() {
+    std::cerr << "usage: LearnOpenGL_microbench [options]\n"
+                 "  --device gl|null      the render device of the shader and mesh benchmarks, gl needs EGL (default "
+              << (HeadlessContext::is_supported() ? "gl" : "null") << ")\n"
+                 "  --filter TEXT         only the benchmarks whose name contains it\n"
+                 "  --repetitions N       timed repetitions of every benchmark (default "
+              << MicroBenchmark::Options().repetitions << ")\n"
+                 "  --repetition-ms MS    the least time of one repetition (default "
+              << MicroBenchmark::Options().repetition_seconds * 1000.0 << ")\n"
+                 "  --warmup-ms MS        the least time of the warmup (default "
+              << MicroBenchmark::Options().warmup_seconds * 1000.0 << ")\n"
+                 "  --max-cv CV           flag the results whose coefficient of variation is above (default "
+              << DEFAULT_MAX_CV << ")\n"
+                 "  --output FILE         the results as JSON\n"
+                 "  --list                print the names of the benchmarks\n"
+                 "exits with " << EXIT_USAGE << " on bad arguments and " << EXIT_FAILED << " if it cannot run"
+              << std::endl;
+}
+
+static MicroBenchOptions parse_options(int argc, char **argv) {
+    MicroBenchOptions options;
+    options.device = HeadlessContext::is_supported() ? "gl" : "null";
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 == argc) {
+                throw std::invalid_argument(argument + " needs a value");
+            }
+            return argv[++i];
+        };
+        if (argument == "--device") {
+            options.device = value();
+            if (options.device != "gl" && options.device != "null") {
+                throw std::invalid_argument("unknown device " + options.device);
+            }
+        } else if (argument == "--filter") {
+            options.run.filter = value();
+        } else if (argument == "--repetitions") {
+            options.run.repetitions = static_cast<unsigned>(std::stoul(value()));
+        } else if (argument == "--repetition-ms") {
+            options.run.repetition_seconds = std::stod(value()) / 1000.0;
+        } else if (argument == "--warmup-ms") {
+            options.run.warmup_seconds = std::stod(value()) / 1000.0;
+        } else if (argument == "--max-cv") {
+            options.max_cv = std::stod(value());
+        } else if (argument == "--output") {
+            options.output = value();
+        } else if (argument == "--list") {
+            options.list = true;
+        } else {
+            throw std::invalid_argument("unknown argument " + argument);
+        }
+    }
+    if (options.run.repetitions < 2 || options.run.repetition_seconds <= 0) {
+        throw std::invalid_argument("a coefficient of variation needs two repetitions of some length");
+    }
+    return options;
+}
+
+static std::vector<unsigned char> read_file(const string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void add_camera_benchmarks(MicroBenchmark &benchmarks) {
+    // the private update() runs on every mouse movement, the pitch goes up and down so it is never clamped
+    benchmarks.add("camera/process_mouse_input", [](unsigned long long iterations) {
+        Camera camera(vec3(0.0F, 0.0F, 3.0F));
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            camera.process_mouse_input(1.0F, i & 1 ? 1.0F : -1.0F);
+        }
+        MicroBenchmark::keep(camera.direction);
+    });
+    benchmarks.add("camera/get_view_matrix", [](unsigned long long iterations) {
+        Camera camera(vec3(0.0F, 0.0F, 3.0F));
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            camera.position.x = static_cast<float>(i & 15);
+            mat4 view_matrix = camera.get_view_matrix();
+            MicroBenchmark::keep(view_matrix);
+        }
+    });
+    // what the render thread computes from a snapshot
+    benchmarks.add("camera/get_view_matrix from yaw and pitch", [](unsigned long long iterations) {
+        vec3 world_up(0.0F, 1.0F, 0.0F);
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            mat4 view_matrix = Camera::get_view_matrix(vec3(0.0F, 0.0F, 3.0F), static_cast<float>(i & 255), 10.0F,
+                                                       world_up);
+            MicroBenchmark::keep(view_matrix);
+        }
+    });
+}
+
+static void add_scene_benchmarks(MicroBenchmark &benchmarks) {
+    // rotated, scaled and translated like nothing in the scene is yet, so the inverse does all of its work
+    auto model_matrices = std::make_shared<std::vector<mat4>>();
+    for (unsigned i = 0; i != MODEL_MATRIX_COUNT; ++i) {
+        auto angle = static_cast<float>(i);
+        mat4 model_matrix = glm::translate(mat4(1.0F), vec3(angle, -angle, 2.0F * angle));
+        model_matrix = glm::rotate(model_matrix, angle, glm::normalize(vec3(1.0F, angle, 0.5F)));
+        model_matrices->push_back(glm::scale(model_matrix, vec3(1.0F + angle * 0.1F, 1.0F, 0.5F)));
+    }
+    benchmarks.add("scene/get_normal_matrix", [model_matrices](unsigned long long iterations) {
+        const std::vector<mat4> &matrices = *model_matrices;
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            glm::mat3 normal_matrix = get_normal_matrix(matrices[i & (MODEL_MATRIX_COUNT - 1)]);
+            MicroBenchmark::keep(normal_matrix);
+        }
+    });
+}
+
+static void add_image_benchmarks(MicroBenchmark &benchmarks) {
+    for (const char *name : {"grass_block_side.png", "oak_planks.png"}) {
+        auto encoded = std::make_shared<std::vector<unsigned char>>(read_file(string("resource/texture/") + name));
+        // what Texture2D does but from memory, so the file system is left out
+        benchmarks.add(string("stb_image/decode ") + name, [encoded](unsigned long long iterations) {
+            stbi_set_flip_vertically_on_load(true);
+            for (unsigned long long i = 0; i != iterations; ++i) {
+                int width, height, channels;
+                unsigned char *pixels = stbi_load_from_memory(encoded->data(), static_cast<int>(encoded->size()),
+                                                              &width, &height, &channels, 0);
+                if (!pixels) {
+                    throw std::runtime_error(stbi_failure_reason());
+                }
+                MicroBenchmark::keep(pixels[0]);
+                stbi_image_free(pixels);
+            }
+        });
+    }
+}
+
+// the shader and mesh benchmarks, the shader belongs to the caller and must outlive them
+static void add_device_benchmarks(MicroBenchmark &benchmarks, RenderDevice &device, const Shader &shader) {
+    RenderDevice *device_pointer = &device;
+    const Shader *shader_pointer = &shader;
+    benchmarks.add("shader/set_uniform mat4 by name", [shader_pointer](unsigned long long iterations) {
+        shader_pointer->use();
+        mat4 model_matrix(1.0F);
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            model_matrix[3][0] = static_cast<float>(i & 15);
+            shader_pointer->set_uniform("model_matrix", model_matrix);
+        }
+    });
+    benchmarks.add("shader/set_uniform mat3 by name", [shader_pointer](unsigned long long iterations) {
+        shader_pointer->use();
+        glm::mat3 normal_matrix(1.0F);
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            normal_matrix[0][0] = static_cast<float>(i & 15);
+            shader_pointer->set_uniform("normal_matrix", normal_matrix);
+        }
+    });
+    benchmarks.add("shader/set_uniform vec3 by name", [shader_pointer](unsigned long long iterations) {
+        shader_pointer->use();
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            shader_pointer->set_uniform("object_color", vec3(static_cast<float>(i & 15), 0.5F, 0.31F));
+        }
+    });
+    // what the render queue does with the locations it resolved once
+    benchmarks.add("shader/set_uniform mat4 by location", [device_pointer, shader_pointer](
+            unsigned long long iterations) {
+        shader_pointer->use();
+        int location = shader_pointer->get_uniform_location("model_matrix");
+        mat4 model_matrix(1.0F);
+        for (unsigned long long i = 0; i != iterations; ++i) {
+            model_matrix[3][0] = static_cast<float>(i & 15);
+            device_pointer->set_uniform(UniformValue(location, model_matrix));
+        }
+    });
+
+    typedef unsigned (*InitVao)(RenderDevice &, unsigned *);
+    const std::pair<const char *, InitVao> meshes[] = {
+            {"mesh/upload cube", init_cube_vao},
+            {"mesh/upload light source", init_light_source_vao},
+            {"mesh/upload lighting cube", init_lighting_cube_vao}
+    };
+    for (const auto &mesh : meshes) {
+        InitVao init_vao = mesh.second;
+        // fills the vertices and copies them to a new buffer, destroyed right away so the driver can reuse the memory
+        benchmarks.add(mesh.first, [device_pointer, init_vao](unsigned long long iterations) {
+            for (unsigned long long i = 0; i != iterations; ++i) {
+                unsigned vertex_buffer;
+                unsigned vertex_array = init_vao(*device_pointer, &vertex_buffer);
+                device_pointer->destroy_vertex_array(vertex_array);
+                device_pointer->destroy_buffer(vertex_buffer);
+            }
+            // the uploads are done once the device is
+            void *fence = device_pointer->insert_fence();
+            device_pointer->wait_fence(fence);
+            device_pointer->destroy_fence(fence);
+        });
+    }
+}
+
+// the time in UTC like 2026-10-19T12:00:00Z
+static string get_utc_time() {
+    std::time_t now = std::time(nullptr);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return text;
+}
+
+int main(int argc, char **argv) {
+    MicroBenchOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "LearnOpenGL_microbench: " << e.what() << std::endl;
+        print_usage();
+        return EXIT_USAGE;
+    }
+    try {
+        // the context goes before the device, and the device before the shader
+        std::unique_ptr<HeadlessContext> context;
+        std::unique_ptr<RenderDevice> device;
+        string renderer = options.device;
+        if (options.device == "gl") {
+            context.reset(new HeadlessContext(WINDOW_WIDTH, WINDOW_HEIGHT));
+            renderer = context->get_renderer();
+            device.reset(new GlRenderDevice());
+        } else {
+            device.reset(new NullRenderDevice());
+        }
+        RenderDevice::set_current(device.get());
+        std::unique_ptr<Shader> shader(new Shader("resource/shader/lighting_cube_vertex_shader.glsl",
+                                                  "resource/shader/lighting_cube_fragment_shader.glsl"));
+
+        MicroBenchmark benchmarks;
+        add_camera_benchmarks(benchmarks);
+        add_scene_benchmarks(benchmarks);
+        add_image_benchmarks(benchmarks);
+        add_device_benchmarks(benchmarks, *device, *shader);
+        if (options.list) {
+            for (const string &name : benchmarks.get_names()) {
+                std::cout << name << "\n";
+            }
+            return 0;
+        }
+
+        std::vector<MicroBenchmark::Result> results = benchmarks.run(options.run);
+        MicroBenchmark::write_table(std::cout, results, options.max_cv);
+        if (!options.output.empty()) {
+            std::ofstream file(options.output);
+            if (!file) {
+                throw std::runtime_error("Failed to open " + options.output + "!");
+            }
+#ifdef NDEBUG
+            string build = "release";
+#else
+            string build = "debug";
+#endif
+            MicroBenchmark::write_json(file, results, {{"time", get_utc_time()}, {"device", options.device},
+                                                       {"renderer", renderer}, {"build", build}});
+        }
+        shader.reset();
+        RenderDevice::set_current(nullptr);
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "LearnOpenGL_microbench: " << e.what() << std::endl;
+        return EXIT_FAILED;
+    }
+}